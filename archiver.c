@@ -0,0 +1,181 @@
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "tftp_archive.h"
+#include "tftp_version.h"
+
+// Construit une archive pour l'option -A des serveurs à partir d'un
+// répertoire (en général .tftp/) : ./archiver <dossier> <archive>
+//
+// L'archive est écrite à côté sous un nom temporaire puis renommée : un
+// serveur qui projette l'ancienne continue de la servir.
+
+#define NOM_MAX 255     // Nom de fichier le plus long d'un RRQ
+
+typedef struct {
+    char *nom;
+    uint64_t taille;
+    int64_t mtime;
+} fichier_t;
+
+static fichier_t *fichiers = NULL;
+static size_t nb_fichiers = 0, cap_fichiers = 0;
+
+static int ajouter(const char *nom, const struct stat *st) {
+    if (nb_fichiers == cap_fichiers) {
+        size_t cap = cap_fichiers ? cap_fichiers * 2 : 256;
+        fichier_t *f = realloc(fichiers, cap * sizeof(*f));
+        if (!f) return -1;
+        fichiers = f;
+        cap_fichiers = cap;
+    }
+    fichiers[nb_fichiers].nom = strdup(nom);
+    if (!fichiers[nb_fichiers].nom) return -1;
+    fichiers[nb_fichiers].taille = st->st_size;
+    fichiers[nb_fichiers].mtime = st->st_mtime;
+    nb_fichiers++;
+    return 0;
+}
+
+// Parcourt 'racine/relatif' ; les liens sont suivis comme le serveur le
+// ferait pour un fichier du répertoire
+static int parcourir(const char *racine, const char *relatif) {
+    char dossier[4096];
+    snprintf(dossier, sizeof(dossier), "%s/%s", racine, relatif);
+    DIR *d = opendir(dossier);
+    if (!d) {
+        perror(dossier);
+        return -1;
+    }
+    struct dirent *de;
+    int ret = 0;
+    while (ret == 0 && (de = readdir(d))) {
+        if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0) continue;
+        // Versions en cours d'écriture du serveur, si 'racine' est son dépôt
+        if (!*relatif && strcmp(de->d_name, VERSION_ENCOURS) == 0) continue;
+        char nom[4096], chemin[8192];
+        snprintf(nom, sizeof(nom), "%s%s%s", relatif, *relatif ? "/" : "", de->d_name);
+        snprintf(chemin, sizeof(chemin), "%s/%s", racine, nom);
+        struct stat st;
+        if (stat(chemin, &st) < 0) continue;
+        if (S_ISDIR(st.st_mode))
+            ret = parcourir(racine, nom);
+        else if (S_ISREG(st.st_mode) && strlen(nom) <= NOM_MAX)
+            ret = ajouter(nom, &st);
+        else if (S_ISREG(st.st_mode))
+            fprintf(stderr, "ignoré (nom trop long pour un RRQ) : %s\n", nom);
+    }
+    closedir(d);
+    return ret;
+}
+
+static uint64_t aligner(uint64_t n, uint64_t a) {
+    return (n + a - 1) / a * a;
+}
+
+static int ecrire(int fd, const void *buf, size_t len, uint64_t offset) {
+    return pwrite(fd, buf, len, offset) == (ssize_t)len ? 0 : -1;
+}
+
+// Copie un contenu à sa place ; sa taille doit être celle du parcours
+static int copier(int dst, const char *chemin, uint64_t offset, uint64_t taille) {
+    int src = open(chemin, O_RDONLY);
+    if (src < 0) return -1;
+    char buf[65536];
+    uint64_t copie = 0;
+    ssize_t n;
+    while (copie < taille && (n = read(src, buf, sizeof(buf))) > 0) {
+        if ((uint64_t)n > taille - copie) n = taille - copie;
+        if (ecrire(dst, buf, n, offset + copie) < 0) break;
+        copie += n;
+    }
+    close(src);
+    return copie == taille ? 0 : -1;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <dossier> <archive>\n", argv[0]);
+        return 1;
+    }
+    const char *racine = argv[1], *sortie = argv[2];
+    if (parcourir(racine, "") < 0) return 1;
+    if (nb_fichiers > UINT32_MAX / 4) {
+        fprintf(stderr, "Trop de fichiers\n");
+        return 1;
+    }
+
+    archive_entete_t e;
+    memset(&e, 0, sizeof(e));
+    memcpy(e.magie, ARCHIVE_MAGIE, sizeof(e.magie));
+    e.version = ARCHIVE_VERSION;
+    e.nb_fichiers = nb_fichiers;
+    e.nb_seaux = 16;
+    while (e.nb_seaux < 2 * nb_fichiers) e.nb_seaux *= 2;
+    e.page = ARCHIVE_PAGE;
+    e.seaux = sizeof(e);
+    e.entrees = aligner(e.seaux + (uint64_t)e.nb_seaux * sizeof(uint32_t), 8);
+    e.noms = e.entrees + nb_fichiers * sizeof(archive_entree_t);
+    for (size_t i = 0; i < nb_fichiers; i++) e.taille_noms += strlen(fichiers[i].nom) + 1;
+
+    uint32_t *seaux = calloc(e.nb_seaux, sizeof(uint32_t));
+    archive_entree_t *entrees = calloc(nb_fichiers ? nb_fichiers : 1, sizeof(archive_entree_t));
+    char *noms = malloc(e.taille_noms ? e.taille_noms : 1);
+    if (!seaux || !entrees || !noms) {
+        perror("malloc");
+        return 1;
+    }
+
+    // Contenus après les tables, chacun sur sa propre page
+    uint64_t position = aligner(e.noms + e.taille_noms, ARCHIVE_PAGE), nom = 0;
+    for (size_t i = 0; i < nb_fichiers; i++) {
+        archive_entree_t *a = &entrees[i];
+        a->offset = position;
+        a->taille = fichiers[i].taille;
+        a->hachage = archive_hachage(fichiers[i].nom);
+        a->nom = nom;
+        a->mtime = fichiers[i].mtime;
+        strcpy(noms + nom, fichiers[i].nom);
+        nom += strlen(fichiers[i].nom) + 1;
+        position = aligner(position + a->taille, ARCHIVE_PAGE);
+
+        uint32_t s = a->hachage & (e.nb_seaux - 1);
+        while (seaux[s]) s = (s + 1) & (e.nb_seaux - 1);
+        seaux[s] = i + 1;
+    }
+    e.taille = position;
+
+    char temporaire[4096];
+    snprintf(temporaire, sizeof(temporaire), "%s.tmp", sortie);
+    int fd = open(temporaire, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror(temporaire);
+        return 1;
+    }
+    int ret = ecrire(fd, &e, sizeof(e), 0);
+    if (ret == 0) ret = ecrire(fd, seaux, e.nb_seaux * sizeof(uint32_t), e.seaux);
+    if (ret == 0) ret = ecrire(fd, entrees, nb_fichiers * sizeof(archive_entree_t), e.entrees);
+    if (ret == 0) ret = ecrire(fd, noms, e.taille_noms, e.noms);
+    for (size_t i = 0; ret == 0 && i < nb_fichiers; i++) {
+        char chemin[8192];
+        snprintf(chemin, sizeof(chemin), "%s/%s", racine, fichiers[i].nom);
+        ret = copier(fd, chemin, entrees[i].offset, entrees[i].taille);
+        if (ret < 0) fprintf(stderr, "%s : modifié ou illisible pendant la copie\n", chemin);
+    }
+    // Fin de la dernière page : la taille du fichier est e.taille
+    if (ret == 0) ret = ftruncate(fd, e.taille);
+    if (ret == 0) ret = fsync(fd);
+    close(fd);
+    if (ret < 0 || rename(temporaire, sortie) < 0) {
+        perror(sortie);
+        unlink(temporaire);
+        return 1;
+    }
+    printf("%s : %zu fichiers, %llu octets\n", sortie, nb_fichiers, (unsigned long long)e.taille);
+    return 0;
+}
@@ -1,16 +1,84 @@
+#define _GNU_SOURCE
 #include <arpa/inet.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <sys/socket.h>
 #include <unistd.h>
 #include <errno.h>
 #include <sys/time.h>
+#include <time.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <sys/stat.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <poll.h>
+
+#include "tftp_client.h"
+#include "tftp_lz4.h"
+#include "tftp_netascii.h"
+#include "tftp_options.h"
+#include "tftp_pmtu.h"
 
 #define PORT 69
 #define MAX_BUF 516
 #define TFTP_TIMEOUT_SEC 5
 #define TFTP_MAX_RETRIES 5
+#define SEGMENTS_MAX 8            // Sessions parallèles au plus (-p)
+#define SEGMENT_MIN (1024 * 1024) // Taille minimale d'un segment
+
+// Valeur de l'option rollover demandée (-r), -1 si non demandée : le bloc
+// suivant 65535 est alors 0
+int rollover_demande = -1;
+
+// Option -m : demande un transfert multicast (RFC 2090) pour get
+int multicast_demande = 0;
+
+// Option -a : transfert en mode netascii (fins de ligne CR LF sur le fil)
+int netascii_demande = 0;
+
+// Option -z : get demande le flux compressé lz4 (option compress), décompressé
+// à la réception. Sans effet avec -a, -c ou -p.
+int compression_demande = 0;
+
+// Option -b : taille de bloc demandée (RFC 2348) ; 0 = la plus grande qui
+// passe sans fragmentation sur le chemin vers le serveur
+int blksize_demande = 0;
+
+// Option -c : reprend un téléchargement à la taille du fichier local partiel
+int reprise_demande = 0;
+
+// Option -p : nombre de segments téléchargés en parallèle (0 : un seul flux)
+int segments_demandes = 0;
+
+// Option -o : fichier local distinct du nom distant, "-" pour stdout (get)
+// ou stdin (put). Le transfert passe alors par la bibliothèque non
+// bloquante (tftp_client.c) et les messages vont sur stderr.
+const char *local_demande = NULL;
+
+// Option -f : manifeste d'opérations get/put exécutées en lot ("-" : stdin),
+// -j transferts simultanés au plus
+const char *manifeste_demande = NULL;
+#define LOT_PARALLELE_DEFAUT 8
+#define LOT_PARALLELE_MAX 256
+int parallele_demande = LOT_PARALLELE_DEFAUT;
+
+// Portion du fichier demandée par get() : tout le fichier, la suite d'un
+// fichier partiel (-c), ou un segment d'un téléchargement parallèle (-p)
+// écrit dans un fichier déjà ouvert
+typedef struct {
+    int fd;                      // Fichier local partagé entre segments, -1 sinon
+    unsigned long long debut;    // Option offset (demandée si > 0, ou pour un segment)
+    unsigned long long longueur; // Option length, 0 : jusqu'à la fin du fichier
+} plage_t;
+
+// Taille de bloc demandée : -b, sinon la plus grande qui passe sans
+// fragmentation sur le chemin vers le serveur
+int blksize_chemin(const struct sockaddr_in *serveur) {
+    return blksize_demande ? blksize_demande : pmtu_blksize(pmtu_mesurer(serveur));
+}
 
 typedef struct { 
     const char *ip;
@@ -19,7 +87,7 @@ typedef struct {
     int type ; // 1 pour get , 2 pour put
 } requete_tftp_t;
 
-void send_request(int sockfd, struct sockaddr_in *server_addr, uint16_t opcode_val, const char *fichier) {
+void send_request(int sockfd, struct sockaddr_in *server_addr, uint16_t opcode_val, const char *fichier, const tftp_options_t *opts) {
     char buffer[MAX_BUF];
     memset(buffer, 0, MAX_BUF); // Limpiamos el buffer por seguridad
     
@@ -38,8 +106,8 @@ void send_request(int sockfd, struct sockaddr_in *server_addr, uint16_t opcode_v
     // 3. Primer delimitador nulo (1 byte)
     buffer[idx++] = '\0';
 
-    // 4. Mode (octet)
-    const char *mode = "octet";
+    // 4. Mode (octet, ou netascii avec -a)
+    const char *mode = netascii_demande ? "netascii" : "octet";
     size_t mode_len = strlen(mode);
     memcpy(buffer + idx, mode, mode_len);
     idx += mode_len;
@@ -47,6 +115,9 @@ void send_request(int sockfd, struct sockaddr_in *server_addr, uint16_t opcode_v
     // 5. Segundo delimitador nulo (1 byte)
     buffer[idx++] = '\0';
 
+    // 6. Options RFC 2347 (tsize, timeout...)
+    if (opts) idx += options_write(buffer + idx, MAX_BUF - idx, opts);
+
     // Enviamos exactamente 'idx' bytes
     if (sendto(sockfd, buffer, idx, 0, (struct sockaddr *)server_addr, (socklen_t)sizeof(*server_addr)) < 0) {
         perror("[ERROR] send_request failed");
@@ -63,330 +134,558 @@ void send_request(int sockfd, struct sockaddr_in *server_addr, uint16_t opcode_v
     sendto(sockfd, err_packet, len, 0, (struct sockaddr *)peer, peer_len);
 }
 
-int get(int sockfd, struct sockaddr_in *server_addr, const char *fichier) {
-    // Configurer le timeout sur la socket
-    struct timeval tv = {TFTP_TIMEOUT_SEC, 0};
-    
-    // Appel à une fonction système (System Call) pour configurer le timeout de réception sur la socket.
-    //  sockfd : Identificateur du socket du client
-    //  SOL_SOCKET : Cela indique que l'option à modifier se situe au niveau général du <<socket>>; cela ne spécifie pas de protocole TCP or UDP.
-    //  SO_RCVTIMEO :   Option de socket pour définir le délai d'attente pour les opérations de réception (recvfrom).
-    //                  Cela signifie (Receive Timeout - Delai d'attente de réception)
-    //  &tv : Pointeur vers la structure timeval
-    //  
-    setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+// Transfert de la bibliothèque (tftp_client.c) avec les options de la
+// ligne de commande : get, put, -o et le mode lot passent tous par elle
+void preparer_transfert(transfert_t *t, int blksize) {
+    transfert_init(t);
+    t->netascii = netascii_demande;
+    t->compression = compression_demande;
+    t->rollover = rollover_demande;
+    t->blksize = blksize;
+    t->timeout = TFTP_TIMEOUT_SEC;
+}
 
-    char *buffer_final = NULL;
-    size_t taille_totale = 0;
-    char buffer[MAX_BUF];
-    ssize_t n;
-    socklen_t addr_len = sizeof(*server_addr);
-    int is_valid = 1;
-    uint16_t dernier_lock_recu = 0; // Pour savoir quel ACK renvoyer
-    uint16_t server_tid = 0; // le port TID du serveur une fois connu
+// Mène un transfert à son terme, socket du groupe multicast comprise
+void attendre_transfert(transfert_t *t) {
+    while (t->etat == TRANSFERT_EN_COURS) {
+        struct pollfd p[2] = { { .fd = transfert_fd(t), .events = POLLIN },
+                               { .fd = transfert_fd_groupe(t), .events = POLLIN } };
+        if (poll(p, 2, transfert_delai(t)) < 0 && errno != EINTR) break;
+        transfert_avancer(t);
+    }
+    transfert_fermer(t);
+}
 
-    printf("[GET] Téléchargement de '%s'...\n", fichier);
+// Puits de get() : chaque bloc est écrit à sa place dans le fichier local
+// (pwrite), ce qui sert la reprise (-c), les segments (-p) et le
+// multicast (-m), dont les blocs arrivent dans le désordre
+typedef struct {
+    int fd;
+    const transfert_t *t;
+    bool prealloue;
+    bool groupe_annonce;
+    bool maitre;
+} fichier_local_t;
+
+static ssize_t ecrire_local(void *ctx, const char *donnees, size_t len, uint64_t position) {
+    fichier_local_t *f = ctx;
+    if (!f->prealloue) {
+        // Préallocation à la taille annoncée, sauf pour un flux lz4 (tsize
+        // est alors la taille sur le fil)
+        if (f->t->stats.taille > 0 && !f->t->compresse) fallocate(f->fd, FALLOC_FL_KEEP_SIZE, 0, f->t->stats.taille);
+        f->prealloue = true;
+    }
+    ssize_t n = pwrite(f->fd, donnees, len, position);
+    if (n < 0) perror("pwrite");
+    return n;
+}
 
+// Rôle multicast : groupe rejoint, puis promotion au rang de maître
+static void suivre_groupe(void *ctx, const transfert_t *t) {
+    fichier_local_t *f = ctx;
+    if (!t->groupe_adr.sin_port) return;
+    if (!f->groupe_annonce) {
+        printf("[GET] Groupe %s:%d rejoint (%s)\n", inet_ntoa(t->groupe_adr.sin_addr), ntohs(t->groupe_adr.sin_port),
+               t->maitre ? "maître" : "à l'écoute");
+        f->groupe_annonce = true;
+    } else if (t->maitre && !f->maitre) {
+        printf("[GET] Promu maître, blocs contigus : %u\n", t->contigu);
+    }
+    f->maitre = t->maitre;
+}
+
+int get(struct sockaddr_in *server_addr, const char *fichier, const plage_t *plage) {
+    int segment = plage->fd >= 0;
+    fichier_local_t local = { .fd = plage->fd, .prealloue = segment };
+    if (!segment) {
+        // Une reprise garde le début déjà reçu
+        local.fd = open(fichier, O_WRONLY | O_CREAT | (plage->debut ? 0 : O_TRUNC) | O_CLOEXEC, 0666);
+        if (local.fd < 0) {
+            perror(fichier);
+            return -1;
+        }
+        printf("[GET] Téléchargement de '%s'...\n", fichier);
+    }
+
+    transfert_t t;
+    preparer_transfert(&t, blksize_chemin(server_addr));
+    t.multicast = multicast_demande;
+    t.offset = plage->debut;
+    t.longueur = plage->longueur;
+    t.ecrire = ecrire_local;
+    t.progression = suivre_groupe;
+    t.ctx = &local;
+    local.t = &t;
+    transfert_get(&t, server_addr, fichier);
+    attendre_transfert(&t);
+
+    int ok = t.etat == TRANSFERT_TERMINE;
+    // Reprise : un fichier local plus long que le fichier distant est coupé,
+    // comme la fin d'un fichier réécrit depuis le début (offset refusé)
+    if (ok && !segment && plage->debut > 0 && ftruncate(local.fd, t.position) < 0) perror("ftruncate");
+    if (!segment) close(local.fd);
+    if (!ok) {
+        // Pas de fichier partiel, sauf avec -c où il servira à reprendre
+        if (!segment && (!reprise_demande || (plage->debut == 0 && t.stats.octets == 0))) unlink(fichier);
+        printf("[GET] ERREUR : Le transfert de '%s' a échoué : %s.\n", fichier, t.erreur);
+        return -1;
+    }
+    if (t.compresse) printf("[GET] Flux lz4 : %llu octets sur le fil\n", t.stats.taille);
+    printf("[GET] Fichier '%s' reçu et formé (%llu octets).\n", fichier, t.stats.octets);
+    return 0;
+}
+
+// Taille du fichier distant, lue dans l'OACK d'un RRQ aussitôt abandonné
+// par un ERROR 8 (RFC 2347). -1 si le serveur ne gère pas les plages
+// (offset absent de l'OACK), -2 si la requête échoue.
+long long taille_distante(int sockfd, struct sockaddr_in *server_addr, const char *fichier) {
+    struct timeval tv = {TFTP_TIMEOUT_SEC, 0};
+    setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    tftp_options_t demande = { .presentes = TFTP_OPT_TSIZE | TFTP_OPT_OFFSET, .tsize = 0, .offset = 0 };
+    char buffer[TFTP_BLKSIZE_MAX + 4];
     struct sockaddr_in peer_addr;
     socklen_t peer_len = sizeof(peer_addr);
-    int peer_set = 0;
-    memset(&peer_addr, 0, sizeof(peer_addr));
-
-    do {
-        int tentatives = 0;
-        int recu_ok = 0;
-
-        while (tentatives < TFTP_MAX_RETRIES && !recu_ok) {
-            //  recvfrom : Fonction système pour recevoir des données sur une socket UDP
-            //  Si le serveur répond, on reçoit un paquet et on vérifie son contenu.
-            n = recvfrom(sockfd, buffer, MAX_BUF, 0, (struct sockaddr *)&peer_addr, &peer_len);
-
-            if (n >= 4) {
-                if (!peer_set) {
-                    if (peer_addr.sin_addr.s_addr != server_addr->sin_addr.s_addr) {
-                        printf("[WARNING] Reçu paquet depuis %s (attendu %s) -> envoi ERROR(5)\n",
-                            inet_ntoa(peer_addr.sin_addr), inet_ntoa(server_addr->sin_addr));
-                        send_error_client(sockfd, &peer_addr, peer_len, 5, "Unknown transfer ID");
-                        continue;
-                    }
-                    server_tid = peer_addr.sin_port;
-                    peer_set = 1;
-                    printf("[GET] Serveur TID identifié: %d\n", ntohs(server_tid));
-                    recu_ok = 1;
-                } else {
-                    if (peer_addr.sin_port != server_tid) {
-                        printf("[WARNING] Paquet depuis TID incorrect -> envoi ERROR(5)\n");
-                        send_error_client(sockfd, &peer_addr, peer_len, 5, "Unknown transfer ID");
-                        continue;
-                    }
-                    recu_ok = 1;
-                }
-            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
-                tentatives++;
-                printf("[TIMEOUT] Tentative %d/%d ... Renvoi du dernier message.\n", tentatives, TFTP_MAX_RETRIES);
-                if (dernier_lock_recu == 0) {
-                    send_request(sockfd, server_addr, 1, fichier); // Operation Code 1 = RRQ (Read Request)
-                } else {
-                    if (peer_set) {
-                        uint16_t blk_net = htons(dernier_lock_recu);
-                        char ack_retry[4] = {0, 4, ((char*)&blk_net)[0], ((char*)&blk_net)[1]};
-                        peer_addr.sin_port = server_tid;
-                        if (sendto(sockfd, ack_retry, 4, 0, (struct sockaddr *)& peer_addr, peer_len) < 0) {
-                            perror("sendto");
-                            break;
-                        }
-                    } else {
-                        send_request(sockfd, server_addr, 1, fichier);
-                    }
-                }
-            } else {
-                if (n < 0) perror("recvfrom");
-                is_valid = 0;
-                break;
-            }
-        }
 
-        if (!recu_ok) { is_valid = 0; break; } // Abandon après 5 échecs
+    for (int tentatives = 0; tentatives < TFTP_MAX_RETRIES; tentatives++) {
+        send_request(sockfd, server_addr, 1, fichier, &demande);
+        ssize_t n = recvfrom(sockfd, buffer, sizeof(buffer), 0, (struct sockaddr *)&peer_addr, &peer_len);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) continue;
+        if (n < 2 || peer_addr.sin_addr.s_addr != server_addr->sin_addr.s_addr) return -2;
 
-        // VERIFICATION SI C'EST UN PAQUET D'ERREUR (Opcode 5)
         uint16_t opcode = ntohs(*(uint16_t *)buffer);
-        if (opcode == 5) { is_valid = 0; break; }
-
-        size_t data_len = n - 4;
-        uint16_t block_num = ntohs(*(uint16_t *)(buffer + 2));
-
-        if (block_num == dernier_lock_recu + 1) {
-            buffer_final = realloc(buffer_final, taille_totale + data_len);
-            memcpy(buffer_final + taille_totale, buffer + 4, data_len);
-            taille_totale += data_len;
-            dernier_lock_recu = block_num; // On mémorise le nouveau bloc
-        } else if (block_num == dernier_lock_recu) {
-            printf("[GET] Doublon reçu (bloc %d), renvoi de l'ACK sans écriture.\n", block_num);
-        }
-        // Si c'est un autre bloc (avance rapide ou vieux), on ignore ou on ack le dernier reçu. 
-        // Ici on va juste ACK le block_num reçu si c'est le doublon ou le nouveau.
-        
-        char ack[4] = {0, 4, buffer[2], buffer[3]};
-        if (peer_set) {
-            peer_addr.sin_port = server_tid;
-            if (sendto(sockfd, ack, 4, 0, (struct sockaddr *)&peer_addr, peer_len) < 0) perror("sendto");
-        } else {
-            if (sendto(sockfd, ack, 4, 0, (struct sockaddr *)server_addr, addr_len) < 0) perror("sendto");
+        if (opcode == 5) {
+            printf("[GET] ERREUR SERVEUR: %.*s\n", (int)(n > 4 ? n - 4 : 0), buffer + 4);
+            return -2;
         }
-        printf("[GET] ACK %d envoyé\n", block_num);
+        tftp_options_t accord;
+        long long taille = -1;
+        if (opcode == TFTP_OACK && options_parse(buffer + 2, n - 2, &accord) == 0 &&
+            (accord.presentes & TFTP_OPT_TSIZE) && (accord.presentes & TFTP_OPT_OFFSET))
+            taille = (long long)accord.tsize;
+        send_error_client(sockfd, &peer_addr, peer_len, 8, "size probe");
+        return taille;
+    }
+    return -2;
+}
 
-    } while (n == 516);
+typedef struct {
+    struct sockaddr_in serveur;
+    const char *fichier;
+    plage_t plage;
+    int res;
+} segment_t;
+
+void *thread_segment(void *arg) {
+    segment_t *s = arg;
+    s->res = get(&s->serveur, s->fichier, &s->plage);
+    return NULL;
+}
 
-    if (is_valid) {
-        FILE *f = fopen(fichier, "wb");
-        if (f) {
-            fwrite(buffer_final, 1, taille_totale, f);
-            fclose(f);
-            printf("[GET] Fichier '%s' reçu et formé (%zu octets).\n", fichier, taille_totale);
-        }
-    } else {
-        // Message d'erreur si is_valid est passé à 0
+// Téléchargement en 'n' segments (-p) : chaque segment est une session
+// RRQ avec offset/length, dans son propre thread, qui écrit ses blocs à
+// leur place (pwrite) dans le fichier préalloué. Sans plages côté serveur,
+// ou pour un petit fichier, on revient à un seul flux.
+int get_parallele(int sockfd, struct sockaddr_in *server_addr, const char *fichier, int n) {
+    long long taille = taille_distante(sockfd, server_addr, fichier);
+    if (taille == -2) {
         printf("[GET] ERREUR : Le transfert a échoué (erreur serveur).\n");
+        return -1;
+    }
+    if (taille >= 0 && n > taille / SEGMENT_MIN) n = taille / SEGMENT_MIN;
+    if (taille < 0 || n < 2) {
+        plage_t plage = { .fd = -1, .debut = 0, .longueur = 0 };
+        return get(server_addr, fichier, &plage);
     }
-    free(buffer_final);
+
+    int fd = open(fichier, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (fd < 0) {
+        perror("open");
+        return -1;
+    }
+    fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, taille);
+
+    // Segments alignés sur 64 Ko, le dernier prend le reste
+    unsigned long long part = ((taille + n - 1) / n + 65535) & ~65535ULL;
+    segment_t segments[SEGMENTS_MAX];
+    pthread_t threads[SEGMENTS_MAX];
+    int lances = 0;
+    printf("[GET] '%s' : %lld octets en %d segments\n", fichier, taille, n);
+    for (int i = 0; i < n && (long long)(i * part) < taille; i++) {
+        segment_t *s = &segments[i];
+        s->serveur = *server_addr;
+        s->fichier = fichier;
+        s->plage.fd = fd;
+        s->plage.debut = i * part;
+        s->plage.longueur = taille - s->plage.debut < part ? taille - s->plage.debut : part;
+        if (pthread_create(&threads[i], NULL, thread_segment, s) != 0) {
+            s->res = -1;
+            break;
+        }
+        lances++;
+    }
+
+    int ok = lances > 0;
+    for (int i = 0; i < lances; i++) {
+        pthread_join(threads[i], NULL);
+        if (segments[i].res < 0) ok = 0;
+    }
+    if (lances < n && (long long)(lances * part) < taille) ok = 0;
+    close(fd);
+    if (!ok) {
+        unlink(fichier);
+        printf("[GET] ERREUR : Le téléchargement segmenté de '%s' a échoué.\n", fichier);
+        return -1;
+    }
+    printf("[GET] Fichier '%s' reçu en %d segments (%lld octets).\n", fichier, lances, taille);
     return 0;
 }
 
-int put(int sockfd, struct sockaddr_in *server_addr, const char *fichier) {
-    struct timeval tv = {TFTP_TIMEOUT_SEC, 0};
-    setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
-    
-    FILE *f = fopen(fichier, "rb");
-    if (!f) {
+// Source de put() : lecture à la position demandée (pread), sans copie du
+// fichier en mémoire quelle que soit sa taille
+static ssize_t lire_local(void *ctx, char *donnees, size_t cap, uint64_t position) {
+    ssize_t n = pread(*(int *)ctx, donnees, cap, position);
+    if (n < 0) perror("pread");
+    return n;
+}
+
+int put(struct sockaddr_in *server_addr, const char *fichier) {
+    int fd = open(fichier, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0) {
         fprintf(stderr, "[PUT] ERREUR : Le fichier '%s' n'existe pas.\n", fichier);
-        return -1; 
+        if (fd >= 0) close(fd);
+        return -1;
     }
 
-    fseek(f, 0, SEEK_END);
-    long fsize = ftell(f);
-    fseek(f, 0, SEEK_SET);
-    char *full_data = malloc(fsize);
-    fread(full_data, 1, fsize, f);
-    fclose(f);
+    transfert_t t;
+    preparer_transfert(&t, blksize_chemin(server_addr));
+    t.lire = lire_local;
+    t.ctx = &fd;
+    // Taille annoncée au serveur : il peut refuser tout de suite (quota,
+    // espace disque) et préallouer la destination
+    transfert_put(&t, server_addr, fichier, st.st_size);
+    attendre_transfert(&t);
+    close(fd);
+    if (t.etat != TRANSFERT_TERMINE) {
+        printf("[PUT] ERREUR : Le transfert de '%s' a échoué : %s.\n", fichier, t.erreur);
+        return -1;
+    }
+    printf("[PUT] Envoi de '%s' terminé.\n", fichier);
+    return 0;
+}
 
-    // Phase 1 : Envoi WRQ et attente ACK 0 (avec timeout/retries)
-    struct sockaddr_in peer_addr;
-    socklen_t peer_len = sizeof(peer_addr);
-    char buffer[MAX_BUF];
-    int tentatives = 0;
-    int recu_ok = 0;
-    memset(&peer_addr, 0, sizeof(peer_addr));
-    int peer_set = 0;
-
-    while (tentatives < TFTP_MAX_RETRIES && !recu_ok) {
-        send_request(sockfd, server_addr, 2, fichier);
-        ssize_t r = recvfrom(sockfd, buffer, MAX_BUF, 0, (struct sockaddr *)&peer_addr, &peer_len);
-        if (r >= 4) {
-            if (ntohs(*(uint16_t *)buffer) == 4 && ntohs(*(uint16_t *)(buffer + 2)) == 0) {
-                recu_ok = 1;
-                peer_set = 1;
-                printf("[PUT] ACK 0 reçu, TID: %d\n", ntohs(peer_addr.sin_port));
-            }
-        } else if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
-            tentatives++;
-            printf("[TIMEOUT] Tentative %d/%d... Renvoi de la requête WRQ.\n", tentatives, TFTP_MAX_RETRIES);
-        } else {
-            if (r < 0) perror("recvfrom");
-            break;
-        }
+// Fichier local d'un transfert de la bibliothèque : créé pour get, lu pour
+// put ('taille' : sa taille si c'est un fichier ordinaire, pour tsize)
+int ouvrir_local(int type, const char *local, unsigned long long *taille) {
+    *taille = 0;
+    if (strcmp(local, "-") == 0) return type == 1 ? STDOUT_FILENO : STDIN_FILENO;
+    if (type == 1) return open(local, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    int fd = open(local, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd >= 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) *taille = st.st_size;
+    return fd;
+}
+
+// Démarre un transfert de la bibliothèque avec les options de la ligne de commande
+int demarrer_transfert(transfert_t *t, struct sockaddr_in *server_addr, int type, const char *fichier,
+                       int fd, unsigned long long taille, int blksize) {
+    preparer_transfert(t, blksize);
+    if (type == 1) {
+        transfert_vers_fd(t, fd);
+        return transfert_get(t, server_addr, fichier);
     }
-    if (!recu_ok) { free(full_data); return -1; }
-
-    // peer_addr already contains the correct TID from ACK 0 response - do NOT overwrite
-
-
-    // Phase 2 : Envoi des blocs DATA avec timeout/retries
-    size_t sent = 0;
-    uint16_t block = 1;
-    do {
-        // 1. Preparación del tamaño y limpieza
-        size_t to_send = (fsize - sent > 512) ? 512 : (fsize - sent);
-        memset(buffer, 0, MAX_BUF); // Evitar basura de bloques anteriores
-
-        // 2. Construcción del encabezado DATA (Opcode 3)
-        uint16_t op = htons(3);
-        uint16_t blk = htons(block);
-        memcpy(buffer, &op, 2);
-        memcpy(buffer + 2, &blk, 2);
-        
-        // Copiamos los datos del archivo solo si hay algo que enviar
-        if (to_send > 0) {
-            memcpy(buffer + 4, full_data + sent, to_send);
-        }
+    transfert_depuis_fd(t, fd);
+    return transfert_put(t, server_addr, fichier, taille);
+}
 
-        tentatives = 0;
-        recu_ok = 0;
-        
-        while (tentatives < TFTP_MAX_RETRIES && !recu_ok) {
-            if (sendto(sockfd, buffer, to_send + 4, 0, (struct sockaddr *)&peer_addr, peer_len) < 0) {
-                perror("sendto");
-                break;
-            }
-            printf("[PUT] Envoi du bloc %d (%zu octets)...\n", block, to_send);
-
-            struct sockaddr_in ack_addr;
-            socklen_t ack_len = sizeof(ack_addr);
-            
-            ssize_t r = recvfrom(sockfd, buffer, MAX_BUF, 0, (struct sockaddr *)&ack_addr, &ack_len);
-            
-            if (r >= 4) {
-                uint16_t received_opcode = ntohs(*(uint16_t *)buffer);
-                uint16_t received_block = ntohs(*(uint16_t *)(buffer + 2));
-
-                if (received_opcode == 5) {
-                    printf("[PUT] ERROR SERVEUR: %s\n", buffer + 4);
-                    free(full_data);
-                    return -1; 
-                }
-
-                if (received_opcode == 4) {
-                    if (ack_addr.sin_port == peer_addr.sin_port) {
-                        if (received_block == block) {
-                            recu_ok = 1;
-                            printf("[PUT] ACK %d reçu\n", received_block);
-                        }
-                    } else {
-                        send_error_client(sockfd, &ack_addr, ack_len, 5, "Unknown transfer ID");
-                    }
-                }
-            } else if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
-                tentatives++;
-                printf("[TIMEOUT] Bloc %d non acquitté, tentative %d/%d...\n", block, tentatives, TFTP_MAX_RETRIES);
-            } else {
-                if (r < 0) perror("recvfrom");
+// Transfert en flux par la bibliothèque client (-o) : le fichier distant
+// est écrit dans 'local' ou lu depuis 'local', "-" désignant stdout/stdin.
+// get -o - | gunzip décompresse pendant le téléchargement.
+int transfert_local(struct sockaddr_in *server_addr, int type, const char *fichier, const char *local) {
+    const char *nom_cmd = type == 1 ? "GET" : "PUT";
+    bool flux = strcmp(local, "-") == 0;
+    unsigned long long taille;
+    int fd = ouvrir_local(type, local, &taille);
+    if (fd < 0) {
+        perror(local);
+        return -1;
+    }
+
+    transfert_t t;
+    demarrer_transfert(&t, server_addr, type, fichier, fd, taille, blksize_chemin(server_addr));
+    attendre_transfert(&t);
+    if (!flux) close(fd);
+
+    if (t.etat != TRANSFERT_TERMINE) {
+        fprintf(stderr, "[%s] ERREUR : %s\n", nom_cmd, t.erreur);
+        if (type == 1 && !flux) unlink(local);
+        return -1;
+    }
+    fprintf(stderr, "[%s] '%s' : %llu octets en %.3f s (blocs de %d octets, %lu paquets, %lu retransmissions)\n",
+            nom_cmd, fichier, t.stats.octets, t.stats.fin - t.stats.debut, t.stats.blksize,
+            t.stats.paquets, t.stats.retransmissions);
+    return 0;
+}
+
+// Une ligne du manifeste de -f : "get|put <fichier> [local]"
+typedef struct {
+    int type;
+    char fichier[256];
+    char local[256];
+} operation_t;
+
+// Lit le manifeste ("-" : stdin). Lignes vides et commentaires (#) ignorés.
+// Renvoie le nombre d'opérations, -1 en cas d'erreur.
+int lire_manifeste(const char *chemin, operation_t **ops) {
+    FILE *f = strcmp(chemin, "-") == 0 ? stdin : fopen(chemin, "r");
+    if (!f) {
+        perror(chemin);
+        return -1;
+    }
+    int n = 0, cap = 0, ligne_num = 0;
+    char ligne[1024];
+    *ops = NULL;
+    while (fgets(ligne, sizeof(ligne), f)) {
+        ligne_num++;
+        char cmd[8], fichier[256], local[256];
+        char *debut = ligne + strspn(ligne, " \t");
+        if (*debut == '#' || *debut == '\n' || *debut == '\0') continue;
+        int champs = sscanf(debut, "%7s %255s %255s", cmd, fichier, local);
+        int type = strcasecmp(cmd, "get") == 0 ? 1 : strcasecmp(cmd, "put") == 0 ? 2 : 0;
+        if (champs < 2 || !type || strcmp(champs == 3 ? local : fichier, "-") == 0) {
+            fprintf(stderr, "%s:%d : ligne invalide (get|put <fichier> [local])\n", chemin, ligne_num);
+            n = -1;
+            break;
+        }
+        if (n == cap) {
+            cap = cap ? cap * 2 : 32;
+            operation_t *plus = realloc(*ops, cap * sizeof(**ops));
+            if (!plus) {
+                perror("realloc");
+                n = -1;
                 break;
             }
+            *ops = plus;
         }
+        (*ops)[n].type = type;
+        snprintf((*ops)[n].fichier, sizeof((*ops)[n].fichier), "%s", fichier);
+        snprintf((*ops)[n].local, sizeof((*ops)[n].local), "%s", champs == 3 ? local : fichier);
+        n++;
+    }
+    if (f != stdin) fclose(f);
+    if (n < 0) {
+        free(*ops);
+        *ops = NULL;
+    }
+    return n;
+}
 
-        if (!recu_ok) break;
-
-        sent += to_send;
-        block++;
-
-        // La condición de salida: si enviamos un bloque de menos de 512, termina.
-        // Si el archivo es múltiplo de 512, se enviará un último paquete con to_send = 0.
-    } while (sent < fsize || (sent == fsize && (fsize % 512 == 0) && fsize > 0));
+double horloge(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
 
-    /*
+double debit_mo(unsigned long long octets, double duree) {
+    return duree > 0 ? octets / duree / 1e6 : 0;
+}
 
-    // Phase 2 : Envoi des blocs DATA avec timeout/retries
-    size_t sent = 0;
-    uint16_t block = 1;
-    do {
-        size_t to_send = (fsize - sent > 512) ? 512 : (fsize - sent);
-        uint16_t op = htons(3);
-        uint16_t blk = htons(block);
+// Mode lot (-f) : toutes les opérations du manifeste dans une seule boucle
+// d'événements, 'parallele' transferts à la fois au plus (-j). Le temps
+// total est proche de celui du plus long transfert, et non de leur somme.
+int lot(struct sockaddr_in *server_addr, const char *manifeste, int parallele) {
+    operation_t *ops;
+    int n = lire_manifeste(manifeste, &ops);
+    if (n < 0) return -1;
+    if (parallele > n) parallele = n;
+
+    transfert_t *slots = malloc((size_t)parallele * sizeof(transfert_t));
+    int *op_slot = malloc((size_t)parallele * sizeof(int));        // Opération en cours, -1 : libre
+    int *fd_slot = malloc((size_t)parallele * sizeof(int));
+    struct pollfd *pfd = malloc((size_t)parallele * sizeof(struct pollfd));
+    int *actif = malloc((size_t)parallele * sizeof(int));
+    if (n > 0 && (!slots || !op_slot || !fd_slot || !pfd || !actif)) {
+        perror("malloc");
+        free(slots);
+        free(op_slot);
+        free(fd_slot);
+        free(pfd);
+        free(actif);
+        free(ops);
+        return -1;
+    }
+    for (int i = 0; i < parallele; i++) op_slot[i] = -1;
+
+    // Même chemin pour tous les fichiers : le MTU est mesuré une fois
+    int blksize = blksize_chemin(server_addr);
+    int suivante = 0, en_cours = 0, reussis = 0;
+    unsigned long long total = 0;
+    double debut = horloge();
+
+    while (suivante < n || en_cours > 0) {
+        // Les places libres prennent les opérations suivantes
+        for (int i = 0; i < parallele && suivante < n; i++) {
+            if (op_slot[i] >= 0) continue;
+            operation_t *op = &ops[suivante++];
+            unsigned long long taille;
+            int fd = ouvrir_local(op->type, op->local, &taille);
+            if (fd < 0) {
+                printf("[LOT] %s '%s' : ERREUR : %s : %s\n", op->type == 1 ? "get" : "put", op->fichier,
+                       op->local, strerror(errno));
+                continue;
+            }
+            demarrer_transfert(&slots[i], server_addr, op->type, op->fichier, fd, taille, blksize);
+            op_slot[i] = op - ops;
+            fd_slot[i] = fd;
+            en_cours++;
+        }
 
-        memcpy(buffer, &op, 2);
-        memcpy(buffer + 2, &blk, 2);
-        memcpy(buffer + 4, full_data + sent, to_send);
+        int k = 0, delai = 1000;
+        for (int i = 0; i < parallele; i++) {
+            if (op_slot[i] < 0) continue;
+            int d = transfert_delai(&slots[i]);
+            if (d < delai) delai = d;
+            pfd[k] = (struct pollfd){ .fd = transfert_fd(&slots[i]), .events = POLLIN };
+            actif[k++] = i;
+        }
+        if (k == 0) continue;
+        if (poll(pfd, k, delai) < 0 && errno != EINTR) {
+            perror("poll");
+            break;
+        }
 
-        tentatives = 0;
-        recu_ok = 0;
-        while (tentatives < TFTP_MAX_RETRIES && !recu_ok) {
-            if (sendto(sockfd, buffer, to_send + 4, 0, (struct sockaddr *)&peer_addr, peer_len) < 0) {
-                perror("sendto");
-                break;
-            }
-            printf("[PUT] Envoi du bloc %d (%zu octets)...\n", block, to_send);
-
-            struct sockaddr_in ack_addr;
-            socklen_t ack_len = sizeof(ack_addr);
-            ssize_t r = recvfrom(sockfd, buffer, MAX_BUF, 0, (struct sockaddr *)&ack_addr, &ack_len);
-            if (r >= 4) {
-                // Vérifier l'ACK et qu'il vient du même peer (TID)
-                if (ack_addr.sin_addr.s_addr == peer_addr.sin_addr.s_addr && ack_addr.sin_port == peer_addr.sin_port) {
-                    uint16_t ack_received = ntohs(*(uint16_t *)(buffer + 2));
-                    if (ack_received == block) {
-                        recu_ok = 1;
-                        printf("[PUT] ACK %d reçu\n", ack_received);
-                    }
-                } // sinon ack pour un autre bloc -> ignorer
-            } else if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
-                tentatives++;
-                printf("[TIMEOUT] Bloc %d non acquitté, tentative %d/%d...\n", block, tentatives, TFTP_MAX_RETRIES);
+        for (int j = 0; j < k; j++) {
+            int i = actif[j];
+            transfert_t *t = &slots[i];
+            if (transfert_avancer(t) == TRANSFERT_EN_COURS) continue;
+
+            operation_t *op = &ops[op_slot[i]];
+            const char *nom_cmd = op->type == 1 ? "get" : "put";
+            transfert_fermer(t);
+            close(fd_slot[i]);
+            if (t->etat == TRANSFERT_TERMINE) {
+                double duree = t->stats.fin - t->stats.debut;
+                printf("[LOT] %s '%s' : %llu octets en %.3f s (%.1f Mo/s)\n", nom_cmd, op->fichier,
+                       t->stats.octets, duree, debit_mo(t->stats.octets, duree));
+                total += t->stats.octets;
+                reussis++;
             } else {
-                if (r < 0) perror("recvfrom");
-                break;
+                printf("[LOT] %s '%s' : ERREUR : %s\n", nom_cmd, op->fichier, t->erreur);
+                if (op->type == 1) unlink(op->local);
             }
+            op_slot[i] = -1;
+            en_cours--;
         }
+    }
 
-        if (!recu_ok) break;
-        sent += to_send;
-        block++;
-    } while (sent < fsize || (sent == fsize && (fsize % 512 == 0) && fsize > 0)); 
+    // Interruption (poll) : les transferts encore ouverts sont abandonnés
+    for (int i = 0; i < parallele && en_cours > 0; i++) {
+        if (op_slot[i] < 0) continue;
+        transfert_fermer(&slots[i]);
+        close(fd_slot[i]);
+        if (ops[op_slot[i]].type == 1) unlink(ops[op_slot[i]].local);
+    }
 
-    */
-    printf("[PUT] Envoi de '%s' terminé.\n", fichier);
-    free(full_data);
-    return 0;
+    double duree = horloge() - debut;
+    printf("[LOT] %d/%d fichiers, %llu octets en %.3f s (%.1f Mo/s, %d en parallèle)\n",
+           reussis, n, total, duree, debit_mo(total, duree), parallele);
+    free(slots);
+    free(op_slot);
+    free(fd_slot);
+    free(pfd);
+    free(actif);
+    free(ops);
+    return reussis == n ? 0 : -1;
+}
+
+void usage(const char *prog) {
+    printf("Usage: %s [-r 0|1] [-m] [-a] [-z] [-b blksize] [-c] [-p segments] [-o local|-] <ip> <get|put> <fichier> [port]\n", prog);
+    printf("       %s [-r 0|1] [-a] [-z] [-b blksize] [-j parallèles] -f manifeste|- <ip> [port]\n", prog);
 }
 
-int main(int argc, char const *argv[]) {
-    if (argc < 4 || argc > 5) {
-        printf("Usage: %s <ip> <get|put> <fichier> [port]\n", argv[0]);
+int main(int argc, char *argv[]) {
+    int opt;
+    while ((opt = getopt(argc, argv, "r:mazb:cp:o:f:j:")) != -1) {
+        switch (opt) {
+        case 'r':
+            // Rollover des numéros de bloc après 65535 (0 ou 1)
+            if (strcmp(optarg, "0") != 0 && strcmp(optarg, "1") != 0) {
+                usage(argv[0]);
+                return 1;
+            }
+            rollover_demande = atoi(optarg);
+            break;
+        case 'm':
+            multicast_demande = 1;
+            break;
+        case 'a':
+            netascii_demande = 1;
+            break;
+        case 'z':
+            compression_demande = 1;
+            break;
+        case 'b':
+            // Taille de bloc imposée (8 à 65464), sinon choisie d'après le MTU
+            blksize_demande = atoi(optarg);
+            if (blksize_demande < TFTP_BLKSIZE_MIN || blksize_demande > TFTP_BLKSIZE_MAX) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'c':
+            reprise_demande = 1;
+            break;
+        case 'p':
+            // Téléchargement en plusieurs sessions parallèles (2 à SEGMENTS_MAX)
+            segments_demandes = atoi(optarg);
+            if (segments_demandes < 2 || segments_demandes > SEGMENTS_MAX) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'o':
+            local_demande = optarg;
+            break;
+        case 'f':
+            manifeste_demande = optarg;
+            break;
+        case 'j':
+            // Transferts simultanés du mode lot (1 à LOT_PARALLELE_MAX)
+            parallele_demande = atoi(optarg);
+            if (parallele_demande < 1 || parallele_demande > LOT_PARALLELE_MAX) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    int nb_args = argc - optind;
+    if (manifeste_demande ? (nb_args < 1 || nb_args > 2) : (nb_args < 3 || nb_args > 4)) {
+        usage(argv[0]);
         return 1;
     }
     
-    // User requested syntax: ./client <ip> <get|put> <file> <port>
-    // Argv mapping:
-    //   argv[1]: ip
-    //   argv[2]: get|put
-    //   argv[3]: fichier
-    //   argv[4]: port (optional) (default 69)
-
-    const char *ip = argv[1];
-    const char *cmd = argv[2];
-    const char *filename = argv[3];
+    // User requested syntax: ./client [options] <ip> <get|put> <file> <port>
+    // Argv mapping (après les options):
+    //   argv[optind]: ip
+    //   argv[optind+1]: get|put
+    //   argv[optind+2]: fichier
+    //   argv[optind+3]: port (optional) (default 69)
+    // En mode lot (-f) : <ip> [port], les opérations viennent du manifeste
+
+    const char *ip = argv[optind];
+    const char *cmd = manifeste_demande ? "get" : argv[optind + 1];
+    const char *filename = manifeste_demande ? NULL : argv[optind + 2];
     int port = PORT;
     
-    if (argc == 5) {
-        port = atoi(argv[4]);
+    if (manifeste_demande && nb_args == 2) {
+        port = atoi(argv[optind + 1]);
+    } else if (nb_args == 4) {
+        port = atoi(argv[optind + 3]);
     }
     
     int type = 0;
@@ -418,11 +717,22 @@ int main(int argc, char const *argv[]) {
         return 1;
     }
 
-    if (type == 1) 
-        get(client_fd, &server_addr, filename);
-    else 
-        put(client_fd, &server_addr, filename);
+    int res;
+    if (manifeste_demande) {
+        res = lot(&server_addr, manifeste_demande, parallele_demande);
+    } else if (local_demande) {
+        res = transfert_local(&server_addr, type, filename, local_demande);
+    } else if (type == 1 && segments_demandes) {
+        res = get_parallele(client_fd, &server_addr, filename, segments_demandes);
+    } else if (type == 1) {
+        // -c : la suite d'un fichier partiel est demandée à partir de sa taille
+        plage_t plage = { .fd = -1, .debut = 0, .longueur = 0 };
+        struct stat st;
+        if (reprise_demande && stat(filename, &st) == 0) plage.debut = st.st_size;
+        res = get(&server_addr, filename, &plage);
+    } else 
+        res = put(&server_addr, filename);
 
     close(client_fd);
-    return 0;
+    return res < 0 ? 1 : 0;
 }
\ No newline at end of file
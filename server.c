@@ -178,7 +178,7 @@ void traitement_rrq(struct sockaddr_in *client_addr, socklen_t addr_len, const c
         }
 
         if (!ack_recu) break; // On arrête tout si le client ne répond plus
-        block_num++;
+        block_num++; // 65535 -> 0 (rollover), uint16_t
     } while (read_len == 512);
 
     printf("  [GET] Transfert de '%s' terminé.\n", fichier);
@@ -232,6 +232,7 @@ void traitement_wrq(struct sockaddr_in *client_addr, socklen_t addr_len, const c
 
     do {
         int tentatives = 0;
+        recu_ok = 0;
 
         while (tentatives < TFTP_MAX_ESSAI && !recu_ok) {
             ssize_t r = recvfrom(sockfd, buffer_reception, MAX_BUF, 0, (struct sockaddr *)&peer_addr, &peer_len);
@@ -250,7 +251,8 @@ void traitement_wrq(struct sockaddr_in *client_addr, socklen_t addr_len, const c
                 }
 
                 uint16_t block_recu = ntohs(*(uint16_t *)(buffer_reception + 2));
-                if (block_recu == dernier_block_recu + 1) {
+                // Le bloc suivant 65535 est 0 (rollover) : comparaison sur 16 bits
+                if (block_recu == (uint16_t)(dernier_block_recu + 1)) {
                     recu_ok = 1; // Nouveau bloc reçu
                     n = r;
                 } else if (block_recu == dernier_block_recu) {
@@ -261,7 +263,7 @@ void traitement_wrq(struct sockaddr_in *client_addr, socklen_t addr_len, const c
                 }
             } else if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
                 tentatives++;
-                printf("  [TIMEOUT] Attente bloc %d, tentative %d/%d... Renvoi dernier ACK.\n", dernier_block_recu + 1, tentatives, TFTP_MAX_ESSAI);
+                printf("  [TIMEOUT] Attente bloc %d, tentative %d/%d... Renvoi dernier ACK.\n", (uint16_t)(dernier_block_recu + 1), tentatives, TFTP_MAX_ESSAI);
                 // renvoyer le dernier ACK connu
                 if (peer_set) {
                     if (sendto(sockfd, ack, 4, 0, (struct sockaddr *)&peer_addr, peer_len) < 0) perror("sendto");
@@ -1,427 +1,1445 @@
-#include <arpa/inet.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <sys/socket.h>
-#include <sys/stat.h>
-#include <unistd.h>
-#include <errno.h>
-#include <sys/time.h>
-#include <time.h>
-#include <fcntl.h>
-#include <sys/select.h>
-#include <stdbool.h>
-
-#define PORT 69
-#define REPOSITORY ".tftp/"
-#define MAX_BUF 516
-#define MAX_CLIENTS 10
-#define TFTP_TIMEOUT_SEC 5
-#define MAX_RETRIES 5
-#define MAX_FILES 128
-
-// --- Structures ---
-
-typedef enum {
-    STATE_NONE,
-    STATE_RRQ, // Server sending data
-    STATE_WRQ  // Server receiving data
-} ClientState;
-
-typedef struct {
-    int sockfd;
-    struct sockaddr_in client_addr;
-    socklen_t addr_len;
-    
-    ClientState state;
-    char filename[256];
-    FILE *fp;
-    
-    uint16_t block_num;      // Next block to send (RRQ) or expected block (WRQ)
-    char buffer[MAX_BUF];    // Data buffer
-    int buffer_len;
-    
-    time_t last_activity;
-    int retries;
-    
-    bool active;
-} ClientContext;
-
-typedef struct {
-    char filename[256];
-    bool in_use;
-} FileLock;
-
-FileLock file_locks[MAX_FILES];
-ClientContext clients[MAX_CLIENTS];
-
-// --- Helpers ---
-
-void init_globals() {
-    for (int i = 0; i < MAX_FILES; i++) file_locks[i].in_use = false;
-    for (int i = 0; i < MAX_CLIENTS; i++) clients[i].active = false;
-}
-
-bool lock_file(const char *filename) {
-    // Check if already locked
-    for (int i = 0; i < MAX_FILES; i++) {
-        if (file_locks[i].in_use && strcmp(file_locks[i].filename, filename) == 0) {
-            return false;
-        }
-    }
-    // Find free slot
-    for (int i = 0; i < MAX_FILES; i++) {
-        if (!file_locks[i].in_use) {
-            strncpy(file_locks[i].filename, filename, 255);
-            file_locks[i].in_use = true;
-            return true;
-        }
-    }
-    return false; // No slots
-}
-
-void unlock_file(const char *filename) {
-    for (int i = 0; i < MAX_FILES; i++) {
-        if (file_locks[i].in_use && strcmp(file_locks[i].filename, filename) == 0) {
-            file_locks[i].in_use = false;
-            return;
-        }
-    }
-}
-
-void send_error(int sockfd, struct sockaddr_in *addr, socklen_t len, uint16_t code, const char *msg) {
-    char buf[MAX_BUF];
-    uint16_t opcode = htons(5);
-    uint16_t err = htons(code);
-    memcpy(buf, &opcode, 2);
-    memcpy(buf+2, &err, 2);
-    int slen = sprintf(buf+4, "%s", msg) + 1 + 4;
-    sendto(sockfd, buf, slen, 0, (struct sockaddr*)addr, len);
-}
-
-void cleanup_client(int index) {
-    if (!clients[index].active) return;
-    
-    if (clients[index].fp) fclose(clients[index].fp);
-    if (clients[index].sockfd > 0) close(clients[index].sockfd);
-    
-    if (strlen(clients[index].filename) > 0) {
-        unlock_file(clients[index].filename);
-        printf("[SELECT] Client %d: Closed transfer for '%s'\n", index, clients[index].filename);
-    }
-    
-    clients[index].active = false;
-}
-
-// --- Logic ---
-
-void handle_new_request(int server_fd) {
-    struct sockaddr_in client_addr;
-    socklen_t addr_len = sizeof(client_addr);
-    char buffer[MAX_BUF];
-    
-    ssize_t n = recvfrom(server_fd, buffer, MAX_BUF, 0, (struct sockaddr*)&client_addr, &addr_len);
-    if (n < 4) return;
-    
-    uint16_t opcode = ntohs(*(uint16_t*)buffer);
-    
-    if (opcode != 1 && opcode != 2) return; // Only RRQ/WRQ
-
-    // Validate packet: Opcode | Filename | 0 | Mode | 0
-    char *filename = buffer + 2;
-    char *mode = NULL;
-    char *end = buffer + n;
-    
-    char *p = filename;
-    while (p < end && *p) p++;
-    if (p >= end - 1) {
-         // Malformed
-         send_error(server_fd, &client_addr, addr_len, 4, "Malformed packet");
-         return;
-    }
-    mode = p + 1;
-    p = mode;
-    while (p < end && *p) p++;
-    if (p >= end) {
-         send_error(server_fd, &client_addr, addr_len, 4, "Malformed packet");
-         return;
-    }
-    
-    // Validate Mode
-    if (strcasecmp(mode, "octet") != 0) {
-         send_error(server_fd, &client_addr, addr_len, 4, "Only octet mode supported");
-         return;
-    }
-    
-    // Find free client slot
-    int cid = -1;
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (!clients[i].active) {
-            cid = i;
-            break;
-        }
-    }
-    
-    if (cid == -1) {
-        printf("[SELECT] Server full, dropping request from %s\n", inet_ntoa(client_addr.sin_addr));
-        return;
-    }
-    
-    // Create new socket for this client
-    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
-    if (sockfd < 0) {
-        perror("socket");
-        return;
-    }
-
-    // Try to lock file
-    if (!lock_file(filename)) {
-        printf("[SELECT] File '%s' busy, rejecting.\n", filename);
-        send_error(sockfd, &client_addr, addr_len, 0, "File busy"); 
-        close(sockfd);
-        return;
-    }
-    
-    // Initialize Client Context
-    ClientContext *c = &clients[cid];
-    c->active = true;
-    c->sockfd = sockfd;
-    c->client_addr = client_addr;
-    c->addr_len = addr_len;
-    strncpy(c->filename, filename, 255);
-    c->filename[255] = '\0'; // Ensure null-terminated even if long
-    c->last_activity = time(NULL);
-    c->retries = 0;
-    
-    char path[512];
-    snprintf(path, sizeof(path), REPOSITORY "%s", filename);
-    
-    if (opcode == 1) { // RRQ (Read Request)
-        c->state = STATE_RRQ;
-        c->fp = fopen(path, "rb");
-        if (!c->fp) {
-            send_error(c->sockfd, &c->client_addr, c->addr_len, 1, "File not found");
-            cleanup_client(cid);
-            return;
-        }
-        c->block_num = 1;
-        
-        // Prepare first block
-        uint16_t op = htons(3);
-        uint16_t blk = htons(1);
-        memcpy(c->buffer, &op, 2);
-        memcpy(c->buffer+2, &blk, 2);
-        size_t bytes = fread(c->buffer+4, 1, 512, c->fp);
-        c->buffer_len = bytes + 4;
-        
-        sendto(c->sockfd, c->buffer, c->buffer_len, 0, (struct sockaddr*)&c->client_addr, c->addr_len);
-        printf("[SELECT] Client %d: Started RRQ for '%s'\n", cid, filename);
-
+#define _GNU_SOURCE
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/time.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/select.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <getopt.h>
+
+#include "tftp_archive.h"
+#include "tftp_cpu.h"
+#include "tftp_durabilite.h"
+#include "tftp_fdcache.h"
+#include "tftp_filtre.h"
+#include "tftp_index.h"
+#include "tftp_options.h"
+#include "tftp_pacer.h"
+#include "tftp_pmtu.h"
+#include "tftp_relais.h"
+#include "tftp_sched.h"
+#include "tftp_session.h"
+#include "tftp_stockage.h"
+#include "tftp_trace.h"
+#include "tftp_variantes.h"
+#include "tftp_version.h"
+#include "tftp_xdp.h"
+
+#define PORT 69
+#define REPOSITORY ".tftp/"
+#define MAX_BUF 516
+#define MAX_CLIENTS 10
+#define TFTP_TIMEOUT_SEC 5
+#define MAX_RETRIES 5
+#define MAX_FILES 128
+#define MAX_GROUPS 8
+#define MAX_MEMBERS 64
+#define MCAST_PORT 1758   // tftp-mcast
+#define PACER_BURST (2 * MAX_BUF) // Bucket depth: at most two DATA packets back to back
+#define XDP_PORT_BASE 50000      // With -X, client slot i uses UDP port XDP_PORT_BASE + i
+
+// --- Structures ---
+
+typedef enum {
+    STATE_NONE,
+    STATE_RRQ, // Server sending data
+    STATE_WRQ  // Server receiving data
+} ClientState;
+
+typedef struct {
+    int sockfd;
+    
+    ClientState state;
+    char filename[256];
+    stockage_objet_t dst;    // WRQ destination: new version, committed when complete
+    durabilite_demande_t commit; // -D group: publication handed to the committer thread
+    bool commit_pending;     // ...final ACK held back until it is durable
+    int commit_act;          // Actions left to run once it is
+    stockage_objet_t src;    // RRQ source, kept open until the end (no store when served from the archive)
+    fdcache_entry_t *variant; // RRQ with the compress option: lz4 variant sent instead of the source
+    session_t session;       // Protocol state machine shared with server_thread (tftp_session.c)
+    bool via_xdp;            // Request came through AF_XDP: replies are built on the XDP port
+    xdp_chemin_t path;       // ...along the addresses learned from the request frame
+    
+    token_bucket_t bucket;   // Per-session rate limit (RRQ DATA)
+    bool send_pending;       // DATA held back by the pacer until send_at
+    double send_at;
+    
+    time_t last_activity;    // Last packet sent or received: the retransmission timer
+    
+    bool active;
+} ClientContext;
+
+// Held by a WRQ for its whole upload so that writers of a name take turns.
+// RRQs never lock: they read the version published when they started.
+typedef struct {
+    char filename[256];
+    bool in_use;
+} FileLock;
+
+// Multicast transfer (RFC 2090): one file streamed once to a group. Only
+// the master member ACKs; the others pick blocks off the group and wait to
+// be promoted to fill in what they missed.
+typedef struct {
+    struct sockaddr_in addr;
+    bool present;
+} McastMember;
+
+typedef struct {
+    bool active;
+    char filename[256];
+    stockage_objet_t src;
+    int sockfd;                 // Server TID shared by all members
+    struct sockaddr_in group;   // Destination of the DATA packets
+    uint32_t blocks;            // Blocks in the file, the last one is short
+    McastMember members[MAX_MEMBERS];
+    int master;                 // Index in members
+    char buffer[MAX_BUF];       // Last packet sent: DATA to the group or OACK to the master
+    int buffer_len;
+    bool to_group;
+    time_t last_activity;
+    int retries;
+} McastGroup;
+
+FileLock file_locks[MAX_FILES];
+ClientContext clients[MAX_CLIENTS];
+McastGroup groups[MAX_GROUPS];
+
+// Maximum upload size in bytes (0 = unlimited), set with -q
+unsigned long long upload_quota = 0;
+
+// Pacing of outgoing DATA, in bytes/s (0 = unlimited), set with -B / -b / -F
+double global_rate = 0;
+double client_rate = 0;
+bool fair_share = false;        // Split global_rate evenly between active reads
+token_bucket_t global_bucket;
+
+// Order in which sessions with a DATA ready get send credit, set with -S
+// (round-robin by default)
+sched_policy_t scheduler = sched_round_robin;
+sched_key_t sched_keys[MAX_CLIENTS];
+unsigned long long session_seq = 0;
+unsigned long long serve_tick = 0;
+
+// AF_XDP packet path (-X ifname[:queue], -g for generic XDP). Sessions
+// then own fixed ports xdp_port_base + slot, so that the XDP program can
+// steer them; their kernel sockets stay bound as the fallback path.
+bool xdp_enabled = false;
+xdp_port_t xdp;
+uint16_t xdp_port_base = XDP_PORT_BASE;
+// Frame being handled when a packet came through AF_XDP (NULL for kernel
+// sockets): error replies go back along its addresses
+const xdp_chemin_t *xdp_frame = NULL;
+
+// Core placement (-C) and busy polling (-L). The reactor is a single
+// thread: it runs on the first CPU of the profile.
+cpu_profil_t cpu_profile;
+
+// First multicast group address, set with -m (INADDR_ANY = multicast disabled);
+// group g uses mcast_base + g
+struct in_addr mcast_base;
+// Groups still streamed by a previous process that kept its transfers
+// (hot restart without handover): their addresses stay unused here
+uint32_t mcast_reserved = 0;
+
+// Where served files live, set with -M: the directory, deduplicated or
+// not, or memory
+const stockage_t *storage = &stockage_dossier;
+
+// Hot restart (-H path): the Unix socket a newer process connects to in
+// order to take over. Once it holds port 69 without the sessions, this
+// process drains: it finishes its transfers, then exits.
+const char *handoff_path = NULL;
+int handoff_fd = -1;
+bool draining = false;
+
+// --- Helpers ---
+
+void init_globals() {
+    for (int i = 0; i < MAX_FILES; i++) file_locks[i].in_use = false;
+    for (int i = 0; i < MAX_CLIENTS; i++) clients[i].active = false;
+    for (int i = 0; i < MAX_GROUPS; i++) groups[i].active = false;
+}
+
+bool lock_file(const char *filename) {
+    // Check if already locked
+    for (int i = 0; i < MAX_FILES; i++) {
+        if (file_locks[i].in_use && strcmp(file_locks[i].filename, filename) == 0) {
+            return false;
+        }
+    }
+    // Find free slot
+    for (int i = 0; i < MAX_FILES; i++) {
+        if (!file_locks[i].in_use) {
+            strncpy(file_locks[i].filename, filename, 255);
+            file_locks[i].filename[255] = '\0';
+            file_locks[i].in_use = true;
+            return true;
+        }
+    }
+    return false; // No slots
+}
+
+void unlock_file(const char *filename) {
+    for (int i = 0; i < MAX_FILES; i++) {
+        if (file_locks[i].in_use && strcmp(file_locks[i].filename, filename) == 0) {
+            file_locks[i].in_use = false;
+            return;
+        }
+    }
+}
+
+void send_error(int sockfd, struct sockaddr_in *addr, socklen_t len, uint16_t code, const char *msg) {
+    char buf[MAX_BUF];
+    uint16_t opcode = htons(5);
+    uint16_t err = htons(code);
+    memcpy(buf, &opcode, 2);
+    memcpy(buf+2, &err, 2);
+    int slen = sprintf(buf+4, "%s", msg) + 1 + 4;
+    if (xdp_frame)
+        xdp_envoyer(&xdp, xdp_frame, buf, slen);
+    else
+        sendto(sockfd, buf, slen, 0, (struct sockaddr*)addr, len);
+}
+
+// Sends from the session's TID: its socket, or a frame on the AF_XDP port
+ssize_t client_send(ClientContext *c, const void *buf, size_t len) {
+    if (c->via_xdp) return xdp_envoyer(&xdp, &c->path, buf, len);
+    return sendto(c->sockfd, buf, len, 0, (struct sockaddr*)&c->session.client, sizeof(c->session.client));
+}
+
+// Checks an upload of 'size' bytes against the quota and the room left in
+// the store (free disk space for dir and cas, available memory for mem)
+bool has_room_for(unsigned long long size) {
+    if (upload_quota && size > upload_quota) return false;
+    return stockage_place(storage, REPOSITORY, size);
+}
+
+int build_oack(char *buf, const tftp_options_t *opts) {
+    uint16_t op = htons(TFTP_OACK);
+    memcpy(buf, &op, 2);
+    return 2 + options_write(buf + 2, MAX_BUF - 2, opts);
+}
+
+// Session rate: the -b limit, capped in fair-share mode by an equal
+// share of the global rate so that one greedy reader cannot starve others
+void update_fair_share() {
+    int readers = 0;
+    for (int i = 0; i < MAX_CLIENTS; i++)
+        if (clients[i].active && clients[i].state == STATE_RRQ) readers++;
+
+    double now = pacer_now();
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        if (!clients[i].active || clients[i].state != STATE_RRQ) continue;
+        double rate = client_rate;
+        if (fair_share && global_rate > 0) {
+            double share = global_rate / readers;
+            if (rate == 0 || share < rate) rate = share;
+        }
+        bucket_set_rate(&clients[i].bucket, rate, now);
+    }
+}
+
+// Queues the DATA packet in c->buffer: it leaves from flush_paced_sends(),
+// where the scheduler decides who gets send credit first
+void send_data(int index) {
+    clients[index].send_pending = true;
+    clients[index].send_at = 0;
+}
+
+// Sends a queued DATA packet if both the global and the session buckets
+// hold enough tokens; otherwise the send is pushed back to send_at and the
+// main loop wakes up in time for it
+void try_send_data(int index, double now) {
+    ClientContext *c = &clients[index];
+    session_t *s = &c->session;
+    double wait = bucket_wait(&global_bucket, s->paquet_len, now);
+    double own = bucket_wait(&c->bucket, s->paquet_len, now);
+    if (own > wait) wait = own;
+
+    if (wait > 0) {
+        c->send_pending = true;
+        c->send_at = now + wait;
+        return;
+    }
+    bucket_take(&global_bucket, s->paquet_len);
+    bucket_take(&c->bucket, s->paquet_len);
+    c->send_pending = false;
+    sched_keys[index].last_served = ++serve_tick;
+    TRACE_DATA_SEND(s->id, s->bloc, (long)(s->paquet_len - 4), s->essais);
+    if (client_send(c, s->paquet, s->paquet_len) < 0 &&
+        errno == EMSGSIZE && (session_emsgsize(s) & SESSION_FRAGMENTER)) {
+        // The kernel learned a smaller path MTU (ICMP): this transfer goes on
+        // fragmented, later ones with this peer get smaller blocks
+        pmtu_fragmentation(c->sockfd, true);
+        client_send(c, s->paquet, s->paquet_len);
+    }
+    c->last_activity = time(NULL); // Retransmission timer starts when the packet leaves
+}
+
+// Due sends are served in scheduler order, so the preferred session takes
+// the global tokens first when the link is saturated
+void flush_paced_sends() {
+    int ids[MAX_CLIENTS];
+    int n = 0;
+    double now = pacer_now();
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        if (clients[i].active && clients[i].send_pending && clients[i].send_at <= now) {
+            const session_t *s = &clients[i].session;
+            off_t end = s->fin >= 0 ? s->fin : s->taille;
+            sched_keys[i].remaining = end > s->offset ? end - s->offset : 0;
+            ids[n++] = i;
+        }
+    }
+    sched_sort(ids, n, sched_keys, scheduler);
+    for (int k = 0; k < n; k++) try_send_data(ids[k], now);
+}
+
+// Select timeout: the regular 1 s tick, or earlier if a deferred send is due
+struct timeval next_wakeup() {
+    double delay = 1.0;
+    double now = pacer_now();
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        if (clients[i].active && clients[i].send_pending && clients[i].send_at - now < delay)
+            delay = clients[i].send_at - now;
+    }
+    if (delay < 0) delay = 0;
+    struct timeval tv = { (time_t)delay, (suseconds_t)((delay - (time_t)delay) * 1e6) };
+    return tv;
+}
+
+void cleanup_client(int index) {
+    if (!clients[index].active) return;
+    
+    TRACE_SESSION_END(clients[index].session.id, clients[index].session.termine, session_octets(&clients[index].session));
+    stockage_abandonner(&clients[index].dst); // No-op once committed
+    stockage_fermer(&clients[index].src);
+    if (clients[index].variant) fdcache_release(clients[index].variant);
+    if (clients[index].sockfd > 0) close(clients[index].sockfd);
+    
+    if (clients[index].state == STATE_WRQ) unlock_file(clients[index].filename);
+    printf("[SELECT] Client %d: Closed transfer for '%s'\n", index, clients[index].filename);
+    
+    clients[index].variant = NULL;
+    clients[index].send_pending = false;
+    clients[index].active = false;
+    if (clients[index].state == STATE_RRQ) update_fair_share();
+}
+
+// --- Multicast (RFC 2090) ---
+
+void mcast_close(int g) {
+    McastGroup *grp = &groups[g];
+    printf("[SELECT] Group %d: Closed multicast transfer for '%s'\n", g, grp->filename);
+    close(grp->sockfd);
+    stockage_fermer(&grp->src);
+    grp->active = false;
+}
+
+// Unicast OACK telling a member where the group is and whether it is master
+void mcast_send_oack(int g, int m, const tftp_options_t *requested) {
+    McastGroup *grp = &groups[g];
+    tftp_options_t opts;
+    memset(&opts, 0, sizeof(opts));
+    if (requested && (requested->presentes & TFTP_OPT_TSIZE)) {
+        opts.presentes |= TFTP_OPT_TSIZE;
+        opts.tsize = grp->src.taille;
+    }
+    opts.presentes |= TFTP_OPT_MULTICAST;
+    inet_ntop(AF_INET, &grp->group.sin_addr, opts.mc_addr, sizeof(opts.mc_addr));
+    opts.mc_port = ntohs(grp->group.sin_port);
+    opts.mc_master = (m == grp->master);
+
+    char buf[MAX_BUF];
+    int len = build_oack(buf, &opts);
+    sendto(grp->sockfd, buf, len, 0, (struct sockaddr*)&grp->members[m].addr, sizeof(grp->members[m].addr));
+    if (m == grp->master) {
+        memcpy(grp->buffer, buf, len);
+        grp->buffer_len = len;
+        grp->to_group = false;
+        grp->last_activity = time(NULL);
+        grp->retries = 0;
+    }
+}
+
+// The oldest remaining member becomes master and ACKs what it is missing;
+// the group closes when nobody is left
+void mcast_promote(int g) {
+    McastGroup *grp = &groups[g];
+    grp->master = -1;
+    for (int m = 0; m < MAX_MEMBERS; m++) {
+        if (grp->members[m].present) {
+            grp->master = m;
+            printf("[SELECT] Group %d: Master is now %s:%d\n", g,
+                   inet_ntoa(grp->members[m].addr.sin_addr), ntohs(grp->members[m].addr.sin_port));
+            mcast_send_oack(g, m, NULL);
+            return;
+        }
+    }
+    mcast_close(g);
+}
+
+void mcast_remove(int g, int m) {
+    McastGroup *grp = &groups[g];
+    grp->members[m].present = false;
+    if (m == grp->master) mcast_promote(g);
+}
+
+void mcast_send_block(int g, uint16_t block) {
+    McastGroup *grp = &groups[g];
+    uint16_t op = htons(3);
+    uint16_t blk = htons(block);
+    memcpy(grp->buffer, &op, 2);
+    memcpy(grp->buffer+2, &blk, 2);
+    ssize_t bytes = stockage_lire(&grp->src, grp->buffer+4, 512, (off_t)(block - 1) * 512);
+    grp->buffer_len = (bytes > 0 ? bytes : 0) + 4;
+    grp->to_group = true;
+    sendto(grp->sockfd, grp->buffer, grp->buffer_len, 0, (struct sockaddr*)&grp->group, sizeof(grp->group));
+    grp->last_activity = time(NULL);
+    grp->retries = 0;
+}
+
+// Local address used to reach 'peer': the group is sent out on that interface
+struct in_addr local_addr_for(const struct sockaddr_in *peer) {
+    struct in_addr local = { htonl(INADDR_ANY) };
+    struct sockaddr_in sa;
+    socklen_t len = sizeof(sa);
+    int s = socket(AF_INET, SOCK_DGRAM, 0);
+    if (s < 0) return local;
+    if (connect(s, (const struct sockaddr*)peer, sizeof(*peer)) == 0 &&
+        getsockname(s, (struct sockaddr*)&sa, &len) == 0)
+        local = sa.sin_addr;
+    close(s);
+    return local;
+}
+
+// Adds an RRQ carrying the multicast option to the group streaming the
+// file, creating the group if needed. Returns false to fall back to a
+// unicast transfer (multicast disabled, no room, or file too large for
+// 16-bit block numbers: late joiners could not place wrapped blocks).
+// Archived names are always served from the archive, hence in unicast.
+bool mcast_join(struct sockaddr_in *client_addr, const char *filename, const tftp_options_t *opts) {
+    if (mcast_base.s_addr == htonl(INADDR_ANY) || strstr(filename, "..") || archive_chercher(filename, NULL))
+        return false;
+
+    int g = -1;
+    for (int i = 0; i < MAX_GROUPS; i++) {
+        if (groups[i].active && strcmp(groups[i].filename, filename) == 0) {
+            g = i;
+            break;
+        }
+    }
+
+    if (g == -1) {
+        for (int i = 0; i < MAX_GROUPS && g == -1; i++)
+            if (!groups[i].active && !(mcast_reserved & (1u << i))) g = i;
+        if (g == -1) return false;
+
+        char path[512];
+        snprintf(path, sizeof(path), REPOSITORY "%s", filename);
+        McastGroup *grp = &groups[g];
+        if (stockage_ouvrir(storage, &grp->src, path) < 0) return false;
+        if (grp->src.taille / 512 + 1 > UINT16_MAX) {
+            stockage_fermer(&grp->src);
+            return false;
+        }
+        grp->sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+        if (grp->sockfd < 0) {
+            perror("socket");
+            stockage_fermer(&grp->src);
+            return false;
+        }
+        struct in_addr ifaddr = local_addr_for(client_addr);
+        setsockopt(grp->sockfd, IPPROTO_IP, IP_MULTICAST_IF, &ifaddr, sizeof(ifaddr));
+
+        memset(&grp->group, 0, sizeof(grp->group));
+        grp->group.sin_family = AF_INET;
+        grp->group.sin_addr.s_addr = htonl(ntohl(mcast_base.s_addr) + g);
+        grp->group.sin_port = htons(MCAST_PORT);
+        strncpy(grp->filename, filename, 255);
+        grp->filename[255] = '\0';
+        grp->blocks = grp->src.taille / 512 + 1;
+        grp->master = -1;
+        for (int m = 0; m < MAX_MEMBERS; m++) grp->members[m].present = false;
+        grp->active = true;
+        printf("[SELECT] Group %d: Started multicast transfer for '%s' on %s:%d\n",
+               g, filename, inet_ntoa(grp->group.sin_addr), MCAST_PORT);
+    }
+
+    McastGroup *grp = &groups[g];
+    int m = -1;
+    for (int i = 0; i < MAX_MEMBERS; i++) {
+        // Retransmitted RRQ: answer again with the same OACK
+        if (grp->members[i].present && grp->members[i].addr.sin_addr.s_addr == client_addr->sin_addr.s_addr &&
+            grp->members[i].addr.sin_port == client_addr->sin_port) {
+            m = i;
+            break;
+        }
+    }
+    for (int i = 0; i < MAX_MEMBERS && m == -1; i++) {
+        if (!grp->members[i].present) {
+            m = i;
+            grp->members[i].addr = *client_addr;
+            grp->members[i].present = true;
+        }
+    }
+    if (m == -1) {
+        if (grp->master == -1) mcast_close(g);
+        return false;
+    }
+
+    if (grp->master == -1) grp->master = m;
+    mcast_send_oack(g, m, opts);
+    return true;
+}
+
+void mcast_handle_io(int g) {
+    McastGroup *grp = &groups[g];
+    char recv_buf[MAX_BUF];
+    struct sockaddr_in sender;
+    socklen_t slen = sizeof(sender);
+
+    ssize_t n = recvfrom(grp->sockfd, recv_buf, MAX_BUF, 0, (struct sockaddr*)&sender, &slen);
+    if (n < 4) return;
+
+    int m = -1;
+    for (int i = 0; i < MAX_MEMBERS; i++) {
+        if (grp->members[i].present && grp->members[i].addr.sin_addr.s_addr == sender.sin_addr.s_addr &&
+            grp->members[i].addr.sin_port == sender.sin_port) {
+            m = i;
+            break;
+        }
+    }
+    if (m == -1) {
+        send_error(grp->sockfd, &sender, slen, 5, "Unknown transfer ID");
+        return;
+    }
+
+    uint16_t opcode = ntohs(*(uint16_t*)recv_buf);
+    uint16_t block = ntohs(*(uint16_t*)(recv_buf+2));
+
+    if (opcode == 5) {
+        mcast_remove(g, m);
+    } else if (opcode == 4 && block == grp->blocks) {
+        // ACK of the last block: this member has the whole file
+        mcast_remove(g, m);
+    } else if (opcode == 4 && m == grp->master && block < grp->blocks) {
+        // The master ACKs its last contiguous block and asks for the next one
+        mcast_send_block(g, block + 1);
+    }
+}
+
+void mcast_check_timeouts() {
+    time_t now = time(NULL);
+    for (int g = 0; g < MAX_GROUPS; g++) {
+        McastGroup *grp = &groups[g];
+        if (!grp->active || difftime(now, grp->last_activity) < TFTP_TIMEOUT_SEC) continue;
+        if (++grp->retries > MAX_RETRIES) {
+            printf("[SELECT] Group %d: Master timed out, promoting another member.\n", g);
+            mcast_remove(g, grp->master);
+            continue;
+        }
+        if (grp->to_group)
+            sendto(grp->sockfd, grp->buffer, grp->buffer_len, 0, (struct sockaddr*)&grp->group, sizeof(grp->group));
+        else
+            sendto(grp->sockfd, grp->buffer, grp->buffer_len, 0, (struct sockaddr*)&grp->members[grp->master].addr, sizeof(grp->members[grp->master].addr));
+        grp->last_activity = now;
+    }
+}
+
+// --- Logic ---
+
+void run_actions(int index, int act, struct sockaddr_in *sender);
+
+// Parses and starts a request received on port 69, from the listening
+// socket or through AF_XDP (xdp_frame set)
+void handle_request(int server_fd, char *buffer, ssize_t n, struct sockaddr_in client_addr) {
+    socklen_t addr_len = sizeof(client_addr);
+    if (n < 4) return;
+    
+    uint16_t opcode = ntohs(*(uint16_t*)buffer);
+    
+    if (opcode != 1 && opcode != 2) return; // Only RRQ/WRQ
+
+    // Validate packet: Opcode | Filename | 0 | Mode | 0
+    char *filename = buffer + 2;
+    char *mode = NULL;
+    char *end = buffer + n;
+    
+    char *p = filename;
+    while (p < end && *p) p++;
+    if (p >= end - 1) {
+         // Malformed
+         send_error(server_fd, &client_addr, addr_len, 4, "Malformed packet");
+         return;
+    }
+    mode = p + 1;
+    p = mode;
+    while (p < end && *p) p++;
+    if (p >= end) {
+         send_error(server_fd, &client_addr, addr_len, 4, "Malformed packet");
+         return;
+    }
+    
+    // Validate Mode
+    bool netascii = strcasecmp(mode, "netascii") == 0;
+    if (!netascii && strcasecmp(mode, "octet") != 0) {
+         send_error(server_fd, &client_addr, addr_len, 4, "Only octet and netascii modes supported");
+         return;
+    }
+
+    // RFC 2347 options follow the mode
+    tftp_options_t opts;
+    if (options_parse(p + 1, end - (p + 1), &opts) < 0) {
+         send_error(server_fd, &client_addr, addr_len, 4, "Malformed packet");
+         return;
+    }
+    
+    // Names outside the repository, or in-flight uploads under it
+    if (strstr(filename, "..") || version_interne(filename)) {
+        send_error(server_fd, &client_addr, addr_len, 2, "Access violation");
+        return;
+    }
+
+    // Negative lookups are answered from the directory index: no slot,
+    // no socket and no file lock for names that do not exist
+    if (opcode == 1 && !archive_chercher(filename, NULL) &&
+        index_lookup(filename, NULL) == INDEX_ABSENT) {
+        send_error(server_fd, &client_addr, addr_len, 1, "File not found");
+        return;
+    }
+
+    // Netascii RRQs: the wire size depends on the content (no tsize, no
+    // ranges) and groups only carry raw octet blocks (no multicast).
+    // Ranges (offset/length) are for reads only and are served in unicast.
+    if (netascii || opcode == 2) opts.presentes &= ~(TFTP_OPT_OFFSET | TFTP_OPT_LENGTH);
+    if (netascii && opcode == 1) opts.presentes &= ~TFTP_OPT_TSIZE;
+    if (opts.presentes & TFTP_OPT_MULTICAST) {
+        if (opcode == 1 && !netascii && !(opts.presentes & (TFTP_OPT_OFFSET | TFTP_OPT_LENGTH)) && mcast_join(&client_addr, filename, &opts)) return;
+        opts.presentes &= ~TFTP_OPT_MULTICAST; // Declined: plain unicast transfer
+    }
+
+    // Find free client slot
+    int cid = -1;
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        if (!clients[i].active) {
+            cid = i;
+            break;
+        }
+    }
+    
+    if (cid == -1) {
+        printf("[SELECT] Server full, dropping request from %s\n", inet_ntoa(client_addr.sin_addr));
+        return;
+    }
+    
+    // Create new socket for this client
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sockfd < 0) {
+        perror("socket");
+        return;
+    }
+    if (xdp_enabled) {
+        // Fixed TID for the slot: the port the XDP program steers
+        struct sockaddr_in tid;
+        memset(&tid, 0, sizeof(tid));
+        tid.sin_family = AF_INET;
+        tid.sin_addr.s_addr = INADDR_ANY;
+        tid.sin_port = htons(xdp_port_base + cid);
+        if (bind(sockfd, (struct sockaddr*)&tid, sizeof(tid)) < 0) {
+            // Port held by another process: the client is told rather than
+            // left retransmitting its request
+            printf("[SELECT] Cannot bind slot port %d for '%s': %s\n", xdp_port_base + cid, filename, strerror(errno));
+            send_error(server_fd, &client_addr, addr_len, 0, "Transfer port unavailable");
+            close(sockfd);
+            return;
+        }
+    }
+    cpu_busy_poll(&cpu_profile, sockfd);
+
+    // Announced upload size: reject before any data flows
+    if (opcode == 2 && (opts.presentes & TFTP_OPT_TSIZE) && !has_room_for(opts.tsize)) {
+        printf("[SELECT] Upload of '%s' refused (%llu bytes).\n", filename, (unsigned long long)opts.tsize);
+        send_error(sockfd, &client_addr, addr_len, 3, "Disk full or allocation exceeded");
+        close(sockfd);
+        return;
+    }
+
+    // Writers take turns on a name (never blocks here: a busy file is
+    // refused); readers do not lock and are never refused
+    unsigned long long sid = ++session_seq;
+    if (opcode == 2) {
+        TRACE_LOCK_WAIT_START(sid, filename);
+        bool locked = lock_file(filename);
+        TRACE_LOCK_WAIT_DONE(sid, filename, locked);
+        if (!locked) {
+            printf("[SELECT] File '%s' busy, rejecting.\n", filename);
+            send_error(sockfd, &client_addr, addr_len, 0, "File busy"); 
+            close(sockfd);
+            return;
+        }
+    }
+    
+    // Initialize Client Context
+    ClientContext *c = &clients[cid];
+    c->sockfd = sockfd;
+    strncpy(c->filename, filename, 255);
+    c->filename[255] = '\0'; // Ensure null-terminated even if long
+    c->dst = (stockage_objet_t){ .fd = -1 };
+    c->src = (stockage_objet_t){ .fd = -1 };
+    c->variant = NULL;
+    c->send_pending = false;
+    c->commit_pending = false;
+    c->via_xdp = xdp_frame != NULL;
+    if (c->via_xdp) {
+        c->path = *xdp_frame;
+        c->path.port_local = htons(xdp_port_base + cid);
+        // No fragmentation on the XDP path: a block fits in one frame
+        if ((opts.presentes & TFTP_OPT_BLKSIZE) && opts.blksize > xdp.donnees_max - 4)
+            opts.blksize = xdp.donnees_max - 4;
+    }
+    bucket_init(&c->bucket, client_rate, PACER_BURST);
+    sched_keys[cid].arrival = sid;
+    sched_keys[cid].last_served = 0;
+    
+    char path[512];
+    snprintf(path, sizeof(path), REPOSITORY "%s", filename);
+    
+    int act;
+    if (opcode == 1) { // RRQ (Read Request)
+        c->state = STATE_RRQ;
+        // Mapped archive (-A) first: blocks are copied out of it, no syscall
+        archive_fichier_t image = { NULL, 0, 0, 0, 0 };
+        const char *source = path;
+        if (archive_chercher(filename, &image)) {
+            c->src.taille = image.taille;
+            c->src.image = image.donnees;
+            c->src.dev = image.dev;
+            c->src.inode = image.inode;
+            c->src.mtime = image.mtime;
+            source = filename;
+        } else if (stockage_ouvrir(storage, &c->src, path) < 0) {
+            send_error(sockfd, &client_addr, addr_len, 1, "File not found");
+            close(sockfd);
+            return;
+        }
+        TRACE_SESSION_START(sid, 1, c->filename, (unsigned long long)c->src.taille);
+        // compress option: the cached lz4 variant, an object outside any
+        // store, replaces the source. It is built by the variant thread,
+        // never in this loop: until it is ready the file is sent as is.
+        stockage_objet_t sent = c->src;
+        c->variant = variante_lz4(&opts, netascii, source, &c->src);
+        if (c->variant) sent = (stockage_objet_t){ .fd = c->variant->fd, .taille = c->variant->size };
+        // Options accepted: the state machine sends an OACK and waits for
+        // ACK 0 before block 1; otherwise block 1 is queued right away
+        act = session_rrq(&c->session, sid, &client_addr, &sent, netascii, &opts);
+        // Large DATA leave with Don't Fragment set
+        if (c->session.df) pmtu_fragmentation(sockfd, false);
+        printf("[SELECT] Client %d: Started RRQ for '%s'%s\n", cid, filename,
+               c->variant ? " (OACK, lz4)" : opts.presentes ? " (OACK)" : "");
+
     } else { // WRQ (Write Request)
         c->state = STATE_WRQ;
-        c->fp = NULL; // Will be opened when first DATA block arrives
-        c->block_num = 0;
-        
-        // Send ACK 0
-        uint16_t op = htons(4);
-        uint16_t blk = htons(0);
-        char ack[4];
-        memcpy(ack, &op, 2);
-        memcpy(ack+2, &blk, 2);
-        sendto(c->sockfd, ack, 4, 0, (struct sockaddr*)&c->client_addr, c->addr_len);
-        printf("[SELECT] Client %d: '%s'\n Started WRQ for", cid, filename);
-    }
-}
-
-void handle_client_io(int index) {
-    ClientContext *c = &clients[index];
-    char recv_buf[MAX_BUF];
-    struct sockaddr_in sender;
-    socklen_t slen = sizeof(sender);
-    
-    ssize_t n = recvfrom(c->sockfd, recv_buf, MAX_BUF, 0, (struct sockaddr*)&sender, &slen);
-    if (n < 4) return;
-    
-    // Verify Sender (TID)
-    if (sender.sin_addr.s_addr != c->client_addr.sin_addr.s_addr || sender.sin_port != c->client_addr.sin_port) {
-        send_error(c->sockfd, &sender, slen, 5, "Unknown transfer ID");
-        return;
-    }
-    
-    c->last_activity = time(NULL);
-    c->retries = 0; // Reset retries on successful packet
-    
-    uint16_t opcode = ntohs(*(uint16_t*)recv_buf);
-    uint16_t block = ntohs(*(uint16_t*)(recv_buf+2));
-    
-    if (c->state == STATE_RRQ) {
-        // Expecting ACK for c->block_num
-        if (opcode == 4 && block == c->block_num) {
-            // ACK received for current block.
-            // Check if it was the last block (buffer length < 516)
-            if (c->buffer_len < 516) {
-                printf("[SELECT] Client %d: Transfer complete.\n", index);
-                cleanup_client(index);
-                return;
-            }
-            
-            // Read next block
-            c->block_num++;
-            uint16_t op = htons(3);
-            uint16_t blk = htons(c->block_num);
-            memcpy(c->buffer, &op, 2);
-            memcpy(c->buffer+2, &blk, 2);
-            size_t bytes = fread(c->buffer+4, 1, 512, c->fp);
-            c->buffer_len = bytes + 4;
-            
-            sendto(c->sockfd, c->buffer, c->buffer_len, 0, (struct sockaddr*)&c->client_addr, c->addr_len);
-        }
-        else if (opcode == 4 && block == c->block_num - 1) {
-             // Duplicate ACK, ignore or retransmit? 
-             // Logic says if we receive dup ACK, maybe our data got lost?
-             // Usually we just wait for timeout to retransmit.
-        }
-        
-    } else if (c->state == STATE_WRQ) {
-        // Expecting DATA with block == c->block_num + 1
-        if (opcode == 3) {
-            if (block == c->block_num + 1) {
-                // First DATA block - open file
-                if (!c->fp) {
-                    char path[512];
-                    snprintf(path, sizeof(path), REPOSITORY "%s", c->filename);
-                    c->fp = fopen(path, "wb");
-                    if (!c->fp) {
-                        send_error(c->sockfd, &c->client_addr, c->addr_len, 2, "Access denied");
-                        cleanup_client(index);
-                        return;
-                    }
+        TRACE_SESSION_START(sid, 2, c->filename, (unsigned long long)opts.tsize);
+        // New version next to the current one, which RRQs keep reading;
+        // an announced size is reserved up front
+        off_t expected = (opts.presentes & TFTP_OPT_TSIZE) ? (off_t)opts.tsize : 0;
+        if (stockage_creer(storage, &c->dst, path, expected) < 0) {
+            send_error(sockfd, &client_addr, addr_len, 2, "Access denied");
+            unlock_file(c->filename);
+            TRACE_SESSION_END(sid, 0, 0ULL);
+            close(sockfd);
+            return;
+        }
+
+        // OACK, or ACK 0 when no option was accepted
+        act = session_wrq(&c->session, sid, &client_addr, &c->dst, netascii, upload_quota, &opts);
+        printf("[SELECT] Client %d: Started WRQ for '%s'\n", cid, filename);
+    }
+    c->active = true;
+    if (c->state == STATE_RRQ) update_fair_share();
+    run_actions(cid, act, NULL);
+}
+
+void handle_new_request(int server_fd) {
+    struct sockaddr_in client_addr;
+    socklen_t addr_len = sizeof(client_addr);
+    char buffer[MAX_BUF];
+    
+    ssize_t n = recvfrom(server_fd, buffer, MAX_BUF, 0, (struct sockaddr*)&client_addr, &addr_len);
+    handle_request(server_fd, buffer, n, client_addr);
+}
+
+// The upload was committed (result 0) or lost: the index learns the new
+// version, if any
+int published(int index, int act, int result) {
+    ClientContext *c = &clients[index];
+    index_refresh(c->filename);
+    if (result < 0) act = session_erreur(&c->session, 3, "Disk full or allocation exceeded");
+    return act;
+}
+
+// Committer thread (-D group): the rest of the upload's content, such as
+// the unchanged prefix a cas upload copies from the previous version
+int complete_upload(void *dst) {
+    return stockage_completer(dst);
+}
+
+// Runs what the session state machine asked for, in the order documented
+// in tftp_session.h
+void run_actions(int index, int act, struct sockaddr_in *sender) {
+    ClientContext *c = &clients[index];
+    session_t *s = &c->session;
+
+    if (act & SESSION_TID) {
+        send_error(c->sockfd, sender, sizeof(*sender), 5, "Unknown transfer ID");
+        return;
+    }
+    if (act & SESSION_FRAGMENTER) pmtu_fragmentation(c->sockfd, true);
+
+    // Last block written: the new version is published before the final
+    // ACK, so a GET issued right after the PUT sees it
+    if (act & SESSION_PUBLIER) {
+        version_t *ver;
+        if (durabilite_mode() == DURABILITE_GROUPE && (ver = stockage_preparer(&c->dst))) {
+            // Batched with other finished uploads off the reactor thread;
+            // finish_commits() resumes the session
+            c->commit.ver = ver;
+            c->commit.avant = complete_upload;
+            c->commit.arg = &c->dst;
+            c->commit.ctx = (void *)(intptr_t)index;
+            c->commit_act = act & ~SESSION_PUBLIER;
+            c->commit_pending = true;
+            durabilite_soumettre(&c->commit);
+            return;
+        }
+        act = published(index, act, stockage_valider(&c->dst));
+    }
+
+    if (act & SESSION_DATA) {
+        send_data(index);
+    } else if (act & SESSION_ENVOYER) {
+        client_send(c, s->paquet, s->paquet_len);
+        c->last_activity = time(NULL);
+    }
+
+    if (act & SESSION_FIN) {
+        printf("[SELECT] Client %d: %s %s.\n", index, c->state == STATE_RRQ ? "Transfer" : "Upload",
+               s->termine ? "complete" : "aborted");
+        cleanup_client(index);
+    }
+}
+
+void handle_client_packet(int index, const char *buf, ssize_t n, struct sockaddr_in *sender) {
+    ClientContext *c = &clients[index];
+    // A resent last DATA while the upload is being committed: the final
+    // ACK must not go out before it is durable
+    if (n < 4 || c->commit_pending) return;
+
+    // The state machine checks the TID, then handles ACK (RRQ) or DATA (WRQ)
+    int act = session_paquet(&c->session, buf, n, sender);
+    if (!(act & SESSION_TID)) c->last_activity = time(NULL);
+    run_actions(index, act, sender);
+}
+
+void handle_client_io(int index) {
+    char recv_buf[TFTP_BLKSIZE_MAX + 4];
+    struct sockaddr_in sender;
+    socklen_t slen = sizeof(sender);
+    
+    ssize_t n = recvfrom(clients[index].sockfd, recv_buf, sizeof(recv_buf), 0, (struct sockaddr*)&sender, &slen);
+    handle_client_packet(index, recv_buf, n, &sender);
+}
+
+// Datagram steered to the AF_XDP port, read in place in the UMEM: a
+// request for port 69, or a packet for the slot owning the destination port
+void handle_xdp_packet(void *ctx, const xdp_chemin_t *path, const char *data, size_t len) {
+    (void)ctx;
+    struct sockaddr_in sender = path->distant;
+    uint16_t port = ntohs(path->port_local);
+    xdp_frame = path;
+    if (port == PORT) {
+        char buffer[MAX_BUF]; // Same truncation as recvfrom on the listening socket
+        if (len > MAX_BUF) len = MAX_BUF;
+        memcpy(buffer, data, len);
+        handle_request(-1, buffer, len, sender);
+    } else if (port >= xdp_port_base && port < xdp_port_base + MAX_CLIENTS && clients[port - xdp_port_base].active) {
+        handle_client_packet(port - xdp_port_base, data, len, &sender);
+    }
+    xdp_frame = NULL;
+}
+
+// -D group: uploads made durable by the committer get their final ACK
+void finish_commits() {
+    for (durabilite_demande_t *d = durabilite_terminees(), *next; d; d = next) {
+        next = d->suivant;
+        int index = (int)(intptr_t)d->ctx;
+        clients[index].commit_pending = false;
+        // New readers of the name reopen it
+        int result = stockage_publiee(&clients[index].dst, d->resultat);
+        run_actions(index, published(index, clients[index].commit_act, result), NULL);
+    }
+}
+
+void check_timeouts() {
+    time_t now = time(NULL);
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        // A DATA held back by the pacer has not been sent yet, an upload
+        // being committed waits for the committer: nothing to time out
+        if (!clients[i].active || clients[i].send_pending || clients[i].commit_pending) continue;
+        if (difftime(now, clients[i].last_activity) < clients[i].session.timeout) continue;
+
+        // The state machine resends its last packet (DATA through the pacer,
+        // OACK or ACK directly) or gives up after SESSION_ESSAIS_MAX tries
+        clients[i].last_activity = now;
+        int act = session_timeout(&clients[i].session);
+        if (act & SESSION_FIN)
+            printf("[SELECT] Client %d timed out. Aborting.\n", i);
+        else
+            printf("[SELECT] Client %d timeout. Retrying (%d/%d)...\n", i, clients[i].session.essais, SESSION_ESSAIS_MAX);
+        run_actions(i, act, NULL);
+    }
+}
+
+// --- Hot restart (-H) ---
+
+// A unicast session as handed to the new process. Pointers do not travel:
+// the socket and the file descriptor go alongside (SCM_RIGHTS), and an
+// archived file is looked up again by name.
+typedef struct {
+    ClientState state;
+    char filename[256];
+    char source[512];           // RRQ: path of the descriptor read (file or lz4 variant)
+    bool variant;
+    bool archived;              // RRQ read from the archive: no descriptor
+    version_t dst;              // WRQ: the version being written
+    session_t session;
+    token_bucket_t bucket;
+    bool send_pending;
+    double send_at;
+    sched_key_t key;
+} HandoffSession;
+
+typedef struct {
+    int index;                  // Same slot, hence same group address
+    McastGroup group;
+} HandoffGroup;
+
+// Gives port 69, then every session and group, to the process connected
+// on the handoff socket. Returns true once the socket is handed over:
+// this process then exits, or drains if the new one declined the
+// sessions (other engine or layout). False leaves everything unchanged.
+bool hand_over(int server_fd) {
+    int sock = relais_accepter(handoff_fd);
+    if (sock < 0) return false;
+
+    // Uploads being committed (-D group) get their final ACK from here first
+    for (;;) {
+        bool pending = false;
+        for (int i = 0; i < MAX_CLIENTS; i++) pending |= clients[i].active && clients[i].commit_pending;
+        if (!pending) break;
+        fd_set fds;
+        FD_ZERO(&fds);
+        FD_SET(durabilite_fd(), &fds);
+        struct timeval tv = { 1, 0 };
+        select(durabilite_fd() + 1, &fds, NULL, NULL, &tv);
+        finish_commits();
+    }
+
+    // Only files of the directory can go across: with -M mem or cas the new
+    // process declines the sessions (record size 0) and this one drains
+    relais_entete_t h = { RELAIS_MAGIE, RELAIS_VERSION, RELAIS_SELECT, sizeof(HandoffSession), sizeof(HandoffGroup), 0, 0, 0 };
+    if (storage != &stockage_dossier) h.taille_session = 0;
+    for (int i = 0; i < MAX_CLIENTS; i++) h.sessions += clients[i].active;
+    for (int g = 0; g < MAX_GROUPS; g++) {
+        if (!groups[g].active) continue;
+        h.groupes++;
+        h.groupes_actifs |= 1u << g;
+    }
+    char answer = 0;
+    int fds[RELAIS_FDS_MAX], nfds;
+    if (relais_envoyer(sock, &h, sizeof(h), &server_fd, 1) < 0 ||
+        relais_recevoir(sock, &answer, 1, fds, &nfds) < 0) {
+        printf("[SERVER-SELECT] Hot restart: no answer from the new process, still serving\n");
+        close(sock);
+        return false;
+    }
+    if (!answer) {
+        printf("[SERVER-SELECT] Hot restart: port %d handed over, draining %u sessions and %u groups\n",
+               PORT, h.sessions, h.groupes);
+        close(sock);
+        return true;
+    }
+
+    // From here on the new process owns the sessions, even if one of them
+    // fails to go across: both serving the same TID would be worse
+    HandoffSession *rec = malloc(sizeof(*rec));
+    unsigned sent = 0;
+    for (int i = 0; rec && i < MAX_CLIENTS; i++) {
+        ClientContext *c = &clients[i];
+        if (!c->active) continue;
+        memset(rec, 0, sizeof(*rec));
+        rec->state = c->state;
+        memcpy(rec->filename, c->filename, sizeof(rec->filename));
+        if (c->state == STATE_WRQ) rec->dst = *stockage_dossier_version(&c->dst);
+        rec->session = c->session;
+        // Pointers are only meaningful here: the new process rebuilds them
+        rec->session.src.magasin = NULL;
+        rec->session.src.image = NULL;
+        rec->session.src.priv = NULL;
+        rec->session.dst = NULL;
+        rec->bucket = c->bucket;
+        rec->send_pending = c->send_pending;
+        rec->send_at = c->send_at;
+        rec->key = sched_keys[i];
+        int out[2] = { c->sockfd, c->state == STATE_WRQ ? c->dst.fd : c->session.src.fd };
+        fdcache_entry_t *read_from = c->variant ? c->variant : stockage_dossier_entree(&c->src);
+        rec->variant = c->variant != NULL;
+        rec->archived = c->state == STATE_RRQ && !read_from;
+        if (read_from) snprintf(rec->source, sizeof(rec->source), "%s", read_from->chemin);
+        if (relais_envoyer(sock, rec, sizeof(*rec), out, rec->archived ? 1 : 2) == 0) sent++;
+    }
+    free(rec);
+    for (int g = 0; g < MAX_GROUPS; g++) {
+        if (!groups[g].active) continue;
+        HandoffGroup grp = { g, groups[g] };
+        memset(&grp.group.src, 0, sizeof(grp.group.src));
+        int out[2] = { groups[g].sockfd, groups[g].src.fd };
+        relais_envoyer(sock, &grp, sizeof(grp), out, 2);
+    }
+    close(sock);
+    printf("[SERVER-SELECT] Hot restart: port %d, %u/%u sessions and %u groups handed over, exiting\n",
+           PORT, sent, h.sessions, h.groupes);
+    exit(0);
+}
+
+// Puts a session received from the previous process in a free slot; it
+// resumes with its next packet or retransmission timeout
+void resume_session(HandoffSession *rec, int *fds, int nfds) {
+    bool archived = rec->state == STATE_RRQ && rec->archived;
+    int cid = -1;
+    for (int i = 0; i < MAX_CLIENTS && cid < 0; i++)
+        if (!clients[i].active) cid = i;
+    archive_fichier_t image = { NULL, 0, 0, 0, 0 };
+    if (cid < 0 || nfds != (archived ? 1 : 2) || (archived && !archive_chercher(rec->filename, &image))) {
+        if (nfds > 0)
+            send_error(fds[0], &rec->session.client, sizeof(rec->session.client), 0, "Server restarted");
+        while (nfds > 0) close(fds[--nfds]);
+        return;
+    }
+
+    ClientContext *c = &clients[cid];
+    memset(c, 0, sizeof(*c));
+    c->sockfd = fds[0];
+    c->state = rec->state;
+    memcpy(c->filename, rec->filename, sizeof(c->filename));
+    c->session = rec->session;
+    c->bucket = rec->bucket;
+    c->send_pending = rec->send_pending;
+    c->send_at = rec->send_at;
+    c->dst = (stockage_objet_t){ .fd = -1 };
+    c->src = (stockage_objet_t){ .fd = -1 };
+    c->last_activity = time(NULL);
+    sched_keys[cid] = rec->key;
+    if (c->session.id > session_seq) session_seq = c->session.id;
+
+    if (c->state == STATE_WRQ) {
+        if (stockage_dossier_reprendre(&c->dst, &rec->dst, fds[1]) < 0) {
+            close(fds[0]);
+            return;
+        }
+        c->session.src.fd = -1;
+        c->session.dst = &c->dst;
+        lock_file(c->filename);
+    } else if (archived) {
+        c->session.src.fd = -1;
+        c->session.src.image = image.donnees;
+    } else if (rec->variant) {
+        c->variant = fdcache_adopter(rec->source, fds[1]);
+        if (!c->variant) {
+            close(fds[0]);
+            return;
+        }
+        c->session.src.fd = c->variant->fd;
+    } else {
+        if (stockage_dossier_adopter(&c->src, rec->source, fds[1]) < 0) {
+            close(fds[0]);
+            return;
+        }
+        c->session.src = c->src;
+    }
+    c->active = true;
+    printf("[SELECT] Client %d: Resumed %s for '%s'\n", cid, c->state == STATE_RRQ ? "RRQ" : "WRQ", c->filename);
+}
+
+void resume_group(HandoffGroup *rec, int *fds, int nfds) {
+    if (nfds != 2 || rec->index < 0 || rec->index >= MAX_GROUPS || groups[rec->index].active) {
+        while (nfds > 0) close(fds[--nfds]);
+        return;
+    }
+    char path[512];
+    snprintf(path, sizeof(path), REPOSITORY "%s", rec->group.filename);
+    McastGroup *grp = &groups[rec->index];
+    *grp = rec->group;
+    grp->sockfd = fds[0];
+    if (stockage_dossier_adopter(&grp->src, path, fds[1]) < 0) {
+        close(fds[0]);
+        return;
+    }
+    grp->last_activity = time(NULL);
+    printf("[SELECT] Group %d: Resumed multicast transfer for '%s'\n", rec->index, grp->filename);
+}
+
+// Connected to a previous process: takes its port 69 socket and, if both
+// run this same build, its sessions. Returns the socket, or -1 to bind a
+// new one.
+int take_over(int sock) {
+    relais_entete_t h;
+    int fds[RELAIS_FDS_MAX], nfds;
+    if (relais_recevoir(sock, &h, sizeof(h), fds, &nfds) < 0 || nfds != 1 || h.magie != RELAIS_MAGIE) {
+        while (nfds > 0) close(fds[--nfds]);
+        close(sock);
+        return -1;
+    }
+    int server_fd = fds[0];
+    char answer = storage == &stockage_dossier && h.version == RELAIS_VERSION && h.moteur == RELAIS_SELECT &&
+                  h.taille_session == sizeof(HandoffSession) && h.taille_groupe == sizeof(HandoffGroup);
+    if (relais_envoyer(sock, &answer, 1, NULL, 0) < 0) {
+        close(server_fd);
+        close(sock);
+        return -1;
+    }
+    if (!answer) {
+        // The previous process keeps streaming its groups
+        mcast_reserved = h.groupes_actifs;
+        printf("[SERVER-SELECT] Took over port %d; the previous process finishes its transfers\n", PORT);
+        close(sock);
+        return server_fd;
+    }
+
+    HandoffSession *rec = malloc(sizeof(*rec));
+    for (uint32_t i = 0; rec && i < h.sessions; i++) {
+        if (relais_recevoir(sock, rec, sizeof(*rec), fds, &nfds) < 0) break;
+        resume_session(rec, fds, nfds);
+    }
+    free(rec);
+    for (uint32_t i = 0; i < h.groupes; i++) {
+        HandoffGroup grp;
+        if (relais_recevoir(sock, &grp, sizeof(grp), fds, &nfds) < 0) break;
+        resume_group(&grp, fds, nfds);
+    }
+    close(sock);
+    update_fair_share();
+    printf("[SERVER-SELECT] Took over port %d, %u sessions and %u groups\n", PORT, h.sessions, h.groupes);
+    return server_fd;
+}
+
+void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-q quota_bytes] [-B global_rate] [-b client_rate] [-F] [-S fifo|rr|srf] [-m group_addr] [-X ifname[:queue]] [-g] [-P first_port]\n"
+                    "       [-C cpus|numa:ifname] [-L busy_poll_us] [-A archive] [-D none|close|group] [-H handoff_socket]\n"
+                    "       [-M dir|mem|cas]\n", prog);
+    fprintf(stderr, "  rates in bytes/s, k/M/G suffixes accepted; -F shares -B fairly between reads\n");
+    fprintf(stderr, "  -S picks which ready read sends first: arrival order, round-robin, or shortest remaining file\n");
+    fprintf(stderr, "  -m enables multicast RRQs (RFC 2090) on consecutive groups from group_addr\n");
+    fprintf(stderr, "  -X serves port 69 and session ports through AF_XDP on ifname (queue 0 by default),\n");
+    fprintf(stderr, "     -g forcing generic XDP; sessions use ports %d.. (-P), kernel sockets stay the fallback\n", XDP_PORT_BASE);
+    fprintf(stderr, "  -C pins the reactor to the first CPU of a list (\"2-5\") or of ifname's NUMA node,\n");
+    fprintf(stderr, "     -L busy-polls sockets for that many microseconds (select() also needs net.core.busy_poll)\n");
+    fprintf(stderr, "  -A serves RRQs from an archive built by ./archiver first, then from the directory\n");
+    fprintf(stderr, "  -D makes uploads durable before their final ACK: never, one fsync each, or in batches\n");
+    fprintf(stderr, "  -H takes over port 69 and the transfers of the server listening on that Unix socket,\n");
+    fprintf(stderr, "     then listens there for the next restart (not with -X)\n");
+    fprintf(stderr, "  -M stores files in the " REPOSITORY " directory (default), in memory, empty at start,\n"
+                    "     or in the directory with each content stored once under " CAS_DOSSIER "\n");
+}
+
+int main(int argc, char *argv[]) {
+    int server_fd;
+    struct sockaddr_in server_addr;
+    int opt;
+    char *xdp_ifname = NULL;
+    int xdp_queue = 0;
+    bool xdp_generic = false;
+    const char *archive = NULL;
+    durabilite_mode_t durability = DURABILITE_AUCUNE;
+
+    while ((opt = getopt(argc, argv, "q:B:b:FS:m:X:gP:C:L:A:D:H:M:")) != -1) {
+        switch (opt) {
+        case 'q':
+            upload_quota = strtoull(optarg, NULL, 10);
+            break;
+        case 'B':
+            global_rate = pacer_parse_rate(optarg);
+            break;
+        case 'b':
+            client_rate = pacer_parse_rate(optarg);
+            break;
+        case 'F':
+            fair_share = true;
+            break;
+        case 'S':
+            scheduler = sched_lookup(optarg);
+            if (!scheduler) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'm':
+            if (inet_pton(AF_INET, optarg, &mcast_base) <= 0 || !IN_MULTICAST(ntohl(mcast_base.s_addr))) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'X': {
+            char *colon = strchr(optarg, ':');
+            if (colon) {
+                *colon = '\0';
+                xdp_queue = atoi(colon + 1);
+            }
+            xdp_ifname = optarg;
+            break;
+        }
+        case 'g':
+            xdp_generic = true;
+            break;
+        case 'P': {
+            int base = atoi(optarg);
+            if (base <= PORT || base > 65535 - MAX_CLIENTS) {
+                usage(argv[0]);
+                return 1;
+            }
+            xdp_port_base = base;
+            break;
+        }
+        case 'C':
+            if (cpu_profil_lire(&cpu_profile, optarg) < 0) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'L':
+            if (cpu_busy_poll_lire(&cpu_profile, optarg) < 0) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'A':
+            archive = optarg;
+            break;
+        case 'D':
+            if (durabilite_lire(optarg, &durability) < 0) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'H':
+            handoff_path = optarg;
+            break;
+        case 'M':
+            storage = stockage_chercher(optarg);
+            if (!storage) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    
+    // AF_XDP steers by slot port and keeps its own ring: sessions on it
+    // cannot move to another process
+    if (handoff_path && xdp_ifname) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    // Before the tables are first touched, so that they land on the
+    // preferred NUMA node
+    if (cpu_appliquer(&cpu_profile, true) == 0 && cpu_profile.actif) {
+        char desc[256];
+        cpu_decrire(&cpu_profile, desc, sizeof(desc));
+        printf("[SERVER-SELECT] Reactor pinned within %s\n", desc);
+    }
+    init_globals();
+    bucket_init(&global_bucket, global_rate, PACER_BURST);
+    if (archive) {
+        int count = archive_ouvrir(archive);
+        if (count >= 0) printf("[SERVER-SELECT] Archive '%s': %d files\n", archive, count);
+    }
+    // "close" fsyncs on the reactor thread and stalls every session while
+    // it runs; "group" hands uploads to a committer thread
+    if (durabilite_demarrer(durability) < 0) {
+        fprintf(stderr, "[SERVER-SELECT] Cannot start upload durability '%s'\n", durabilite_nom(durability));
+        return 1;
+    }
+    if (durability != DURABILITE_AUCUNE)
+        printf("[SERVER-SELECT] Upload durability: %s\n", durabilite_nom(durability));
+    // The memory store has no index (lookups go to its table) and no lz4
+    // variant cache. Uploads are staged under REPOSITORY VERSION_ENCOURS,
+    // swept of dead servers' leftovers.
+    if (storage != &stockage_memoire) {
+        mkdir(REPOSITORY, 0777);
+        version_demarrer(REPOSITORY);
+        index_init(REPOSITORY);
+        variantes_demarrer(REPOSITORY);
+    }
+    if (storage != &stockage_dossier) printf("[SERVER-SELECT] Storage: %s\n", storage->nom);
+    if (stockage_demarrer(storage) < 0) return 1;
+
+    // Hot restart: port 69 and the live transfers come from the running
+    // server, if there is one
+    server_fd = -1;
+    if (handoff_path) {
+        int sock = relais_connecter(handoff_path);
+        if (sock >= 0) server_fd = take_over(sock);
+    }
+    if (server_fd < 0) {
+        server_fd = socket(AF_INET, SOCK_DGRAM, 0);
+        if (server_fd < 0) { perror("socket"); return 1; }
+
+        memset(&server_addr, 0, sizeof(server_addr));
+        server_addr.sin_family = AF_INET;
+        server_addr.sin_addr.s_addr = INADDR_ANY;
+        server_addr.sin_port = htons(PORT);
+
+        if (bind(server_fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+            perror("bind");
+            return 1;
+        }
+    }
+
+    // Non-blocking server socket? Or just use select.
+    // Making it non-blocking shouldn't strictly be necessary if select says it's ready, 
+    // but good practice.
+    int flags = fcntl(server_fd, F_GETFL, 0);
+    fcntl(server_fd, F_SETFL, flags | O_NONBLOCK);
+    if (handoff_path) handoff_fd = relais_ecouter(handoff_path);
+
+    // Runts, stray ACK/DATA and other non-requests are dropped by the
+    // kernel: they no longer wake the reactor
+    int filter = filtre_attacher(server_fd);
+    cpu_busy_poll(&cpu_profile, server_fd);
+    if (filter >= 0) printf("[SERVER-SELECT] Request filter attached (%s)\n", filter ? "eBPF" : "classic BPF");
+
+    printf("[SERVER-SELECT] Listening on port %d...\n", PORT);
+
+    // Kernel bypass for the interface's traffic; the sockets above keep
+    // serving everything else, and everything if XDP is unavailable
+    if (xdp_ifname) {
+        xdp_enabled = xdp_ouvrir(&xdp, xdp_ifname, xdp_queue, PORT, xdp_port_base, MAX_CLIENTS, xdp_generic) == 0;
+        if (!xdp_enabled) printf("[SERVER-SELECT] AF_XDP unavailable on %s, using kernel sockets only\n", xdp_ifname);
+    }
+
+    while (1) {
+        fd_set readfds;
+        FD_ZERO(&readfds);
+        int max_fd = -1;
+        if (!draining) {
+            FD_SET(server_fd, &readfds);
+            max_fd = server_fd;
+        }
+        if (handoff_fd >= 0) {
+            FD_SET(handoff_fd, &readfds);
+            if (handoff_fd > max_fd) max_fd = handoff_fd;
+        }
+        if (xdp_enabled) {
+            FD_SET(xdp.fd, &readfds);
+            if (xdp.fd > max_fd) max_fd = xdp.fd;
+        }
+        int inotify_fd = index_fd();
+        if (inotify_fd >= 0) {
+            FD_SET(inotify_fd, &readfds);
+            if (inotify_fd > max_fd) max_fd = inotify_fd;
+        }
+        int commit_fd = durabilite_fd();
+        if (commit_fd >= 0) {
+            FD_SET(commit_fd, &readfds);
+            if (commit_fd > max_fd) max_fd = commit_fd;
+        }
+        for (int i = 0; i < MAX_CLIENTS; i++) {
+            if (clients[i].active) {
+                FD_SET(clients[i].sockfd, &readfds);
+                if (clients[i].sockfd > max_fd) max_fd = clients[i].sockfd;
+            }
+        }
+        for (int g = 0; g < MAX_GROUPS; g++) {
+            if (groups[g].active) {
+                FD_SET(groups[g].sockfd, &readfds);
+                if (groups[g].sockfd > max_fd) max_fd = groups[g].sockfd;
+            }
+        }
+
+        struct timeval tv = next_wakeup(); // Retransmit check, or next paced send
+        int activity = select(max_fd + 1, &readfds, NULL, NULL, &tv);
+
+        if (activity < 0 && errno != EINTR) {
+            perror("select");
+            continue;
+        }
+
+        if (activity > 0) {
+            // Apply directory changes before serving requests that may depend on them
+            if (inotify_fd >= 0 && FD_ISSET(inotify_fd, &readfds)) {
+                index_process_events();
+            }
+            if (commit_fd >= 0 && FD_ISSET(commit_fd, &readfds)) {
+                finish_commits();
+            }
+            if (!draining && FD_ISSET(server_fd, &readfds)) {
+                handle_new_request(server_fd);
+            }
+            // A newer process asks for port 69 (-H): it either takes every
+            // session and this process exits, or this one drains
+            if (handoff_fd >= 0 && FD_ISSET(handoff_fd, &readfds) && hand_over(server_fd)) {
+                close(server_fd);
+                close(handoff_fd);
+                handoff_fd = -1;
+                draining = true;
+            }
+            // One batch of frames per wakeup, parsed in place
+            if (xdp_enabled && FD_ISSET(xdp.fd, &readfds)) {
+                xdp_recevoir(&xdp, handle_xdp_packet, NULL);
+            }
+            
+            for (int i = 0; i < MAX_CLIENTS; i++) {
+                if (clients[i].active && FD_ISSET(clients[i].sockfd, &readfds)) {
+                    handle_client_io(i);
                 }
-                
-                // Good block
-                fwrite(recv_buf+4, 1, n-4, c->fp);
-                c->block_num++;
-                
-                // Send ACK
-                uint16_t op = htons(4);
-                uint16_t blk = htons(c->block_num);
-                char ack[4];
-                memcpy(ack, &op, 2);
-                memcpy(ack+2, &blk, 2);
-                sendto(c->sockfd, ack, 4, 0, (struct sockaddr*)&c->client_addr, c->addr_len);
-                
-                if (n < 516) {
-                    printf("[SELECT] Client %d: Upload complete.\n", index);
-                    cleanup_client(index);
+            }
+            for (int g = 0; g < MAX_GROUPS; g++) {
+                if (groups[g].active && FD_ISSET(groups[g].sockfd, &readfds)) {
+                    mcast_handle_io(g);
                 }
-            } else if (block == c->block_num) {
-                // Duplicate Data, re-send ACK for prev block
-                uint16_t op = htons(4);
-                uint16_t blk = htons(c->block_num);
-                char ack[4];
-                memcpy(ack, &op, 2);
-                memcpy(ack+2, &blk, 2);
-                sendto(c->sockfd, ack, 4, 0, (struct sockaddr*)&c->client_addr, c->addr_len);
+            }
+        }
+        
+        check_timeouts();
+        mcast_check_timeouts();
+        if (!draining) filtre_bilan(server_fd, "[SERVER-SELECT]");
+        flush_paced_sends();
+        if (xdp_enabled) xdp_emettre(&xdp); // Kick the frames queued in this pass
+
+        if (draining) {
+            bool busy = false;
+            for (int i = 0; i < MAX_CLIENTS; i++) busy |= clients[i].active;
+            for (int g = 0; g < MAX_GROUPS; g++) busy |= groups[g].active;
+            if (!busy) {
+                printf("[SERVER-SELECT] Drained, exiting\n");
+                return 0;
             }
         }
     }
-}
-
-void check_timeouts() {
-    time_t now = time(NULL);
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (clients[i].active) {
-            if (difftime(now, clients[i].last_activity) >= TFTP_TIMEOUT_SEC) {
-                clients[i].retries++;
-                if (clients[i].retries > MAX_RETRIES) {
-                    printf("[SELECT] Client %d timed out. Aborting.\n", i);
-                    cleanup_client(i);
-                } else {
-                    printf("[SELECT] Client %d timeout. Retrying (%d/%d)...\n", i, clients[i].retries, MAX_RETRIES);
-                    // Retransmit logic
-                    if (clients[i].state == STATE_RRQ) {
-                         // Resend current DATA buffer
-                         sendto(clients[i].sockfd, clients[i].buffer, clients[i].buffer_len, 0, (struct sockaddr*)&clients[i].client_addr, clients[i].addr_len);
-                    } else if (clients[i].state == STATE_WRQ) {
-                        // Resend last ACK
-                        uint16_t op = htons(4);
-                        uint16_t blk = htons(clients[i].block_num);
-                        char ack[4];
-                        memcpy(ack, &op, 2);
-                        memcpy(ack+2, &blk, 2);
-                        sendto(clients[i].sockfd, ack, 4, 0, (struct sockaddr*)&clients[i].client_addr, clients[i].addr_len);
-                    }
-                    clients[i].last_activity = now;
-                }
-            }
-        }
-    }
-}
-
-int main() {
-    int server_fd;
-    struct sockaddr_in server_addr;
-    
-    init_globals();
-    mkdir(REPOSITORY, 0777);
-
-    server_fd = socket(AF_INET, SOCK_DGRAM, 0);
-    if (server_fd < 0) { perror("socket"); return 1; }
-    
-    // Non-blocking server socket? Or just use select.
-    // Making it non-blocking shouldn't strictly be necessary if select says it's ready, 
-    // but good practice.
-    int flags = fcntl(server_fd, F_GETFL, 0);
-    fcntl(server_fd, F_SETFL, flags | O_NONBLOCK);
-
-    memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_addr.s_addr = INADDR_ANY;
-    server_addr.sin_port = htons(PORT);
-
-    if (bind(server_fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
-        perror("bind");
-        return 1;
-    }
-
-    printf("[SERVER-SELECT] Listening on port %d...\n", PORT);
-
-    while (1) {
-        fd_set readfds;
-        FD_ZERO(&readfds);
-        FD_SET(server_fd, &readfds);
-        
-        int max_fd = server_fd;
-        for (int i = 0; i < MAX_CLIENTS; i++) {
-            if (clients[i].active) {
-                FD_SET(clients[i].sockfd, &readfds);
-                if (clients[i].sockfd > max_fd) max_fd = clients[i].sockfd;
-            }
-        }
-
-        struct timeval tv = {1, 0}; // 1 sec timeout for loop to check retransmits
-        int activity = select(max_fd + 1, &readfds, NULL, NULL, &tv);
-
-        if (activity < 0 && errno != EINTR) {
-            perror("select");
-            continue;
-        }
-
-        if (activity > 0) {
-            if (FD_ISSET(server_fd, &readfds)) {
-                handle_new_request(server_fd);
-            }
-            
-            for (int i = 0; i < MAX_CLIENTS; i++) {
-                if (clients[i].active && FD_ISSET(clients[i].sockfd, &readfds)) {
-                    handle_client_io(i);
-                }
-            }
-        }
-        
-        check_timeouts();
-    }
-
-    close(server_fd);
-    return 0;
-}
+
+    close(server_fd);
+    return 0;
+}
@@ -1,415 +1,773 @@
-#include <arpa/inet.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <sys/socket.h>
-#include <sys/stat.h>
-#include <unistd.h>
-#include <errno.h>
-#include <sys/time.h>
-#include <pthread.h>
-#include <sys/types.h>
-#include <dirent.h>
-#include <stdint.h>
-#include <stdbool.h>
-
-#define MAX_FILES 128
-#define REPOSITORY ".tftp/"
-#define PORT 69
-#define MAX_BUF 516
-#define TFTP_TIMEOUT_SEC 5
-#define TFTP_MAX_ESSAI 5
-
-typedef struct {
-    char filename[256];
-    pthread_mutex_t mutex;
-    bool in_use;
-} file_mutex_t;
-
-file_mutex_t file_mutexes[MAX_FILES];
-pthread_mutex_t global_mutex = PTHREAD_MUTEX_INITIALIZER;
-
-// Get or create a mutex for a specific file
-file_mutex_t* get_file_mutex(const char* filename) {
-    pthread_mutex_lock(&global_mutex);
-    for (int i = 0; i < MAX_FILES; ++i) {
-        if (file_mutexes[i].in_use && strcmp(file_mutexes[i].filename, filename) == 0) {
-            pthread_mutex_unlock(&global_mutex);
-            return &file_mutexes[i];
-        }
-    }
-    // Not found, create new
-    for (int i = 0; i < MAX_FILES; ++i) {
-        if (!file_mutexes[i].in_use) {
-            strncpy(file_mutexes[i].filename, filename, 255);
-            file_mutexes[i].filename[255] = '\0';
-            pthread_mutex_init(&file_mutexes[i].mutex, NULL);
-            file_mutexes[i].in_use = true;
-            pthread_mutex_unlock(&global_mutex);
-            return &file_mutexes[i];
-        }
-    }
-    pthread_mutex_unlock(&global_mutex);
-    return NULL; // Should ideally handle this case better (e.g. increase MAX_FILES or fail gracefully)
-}
-
-void send_error(int sockfd, struct sockaddr_in *client_addr, socklen_t addr_len, uint16_t err_code, const char *err_msg) {
-    char err_packet[MAX_BUF];
-    uint16_t opcode = htons(5); 
-    uint16_t error_code = htons(err_code); 
-    memcpy(err_packet, &opcode, 2);
-    memcpy(err_packet + 2, &error_code, 2);
-    int len = 4 + sprintf(err_packet + 4, "%s", err_msg) + 1;
-    sendto(sockfd, err_packet, len, 0, (struct sockaddr *)client_addr, addr_len);
-}
-
-void traitement_rrq(struct sockaddr_in *client_addr, socklen_t addr_len, const char *fichier);
-void traitement_wrq(struct sockaddr_in *client_addr, socklen_t addr_len, const char *fichier);
-
-void* thread_rrq(void* arg) {
-    struct {
-        struct sockaddr_in client_addr;
-        socklen_t addr_len;
-        char fichier[MAX_BUF];
-    } *params = arg;
-    traitement_rrq(&params->client_addr, params->addr_len, params->fichier);
-    free(params);
-    return NULL;
-}
-
-void* thread_wrq(void* arg) {
-    struct {
-        struct sockaddr_in client_addr;
-        socklen_t addr_len;
-        char fichier[MAX_BUF];
-    } *params = arg;
-    traitement_wrq(&params->client_addr, params->addr_len, params->fichier);
-    free(params);
-    return NULL;
-}
-
-void traitement_rrq(struct sockaddr_in *client_addr, socklen_t addr_len, const char *fichier) {
-    int sockfd = socket(AF_INET, SOCK_DGRAM, 0); 
-    
-    if (sockfd < 0) {
-        perror("socket");
-        return;
-    }
-    
-    struct timeval tv = {TFTP_TIMEOUT_SEC, 0}; 
-    setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
-
-    const char *filename = fichier;
-    const char *mode = fichier + strlen(filename) + 1;
-
-    // Vérifications de base des noms de fichiers
-    if (strstr(filename, "..")) {
-        send_error(sockfd, client_addr, addr_len, 2, "Violation d'accès");
-        close(sockfd);
-        return;
-    }
-
-    char chemin[256];
-    snprintf(chemin, sizeof(chemin), REPOSITORY "%s", filename);
-    
-    file_mutex_t* mtx = get_file_mutex(filename);
-    if (mtx) pthread_mutex_lock(&mtx->mutex);
-    
-    FILE *f = fopen(chemin, "rb");
-
-    if (!f) {
-        if (mtx) pthread_mutex_unlock(&mtx->mutex);
-        send_error(sockfd, client_addr, addr_len, 1, "Fichier non trouvé");
-        close(sockfd);
-        return;
-    }
-
-    char buffer[MAX_BUF];
-    char ack_buf[4];
-    uint16_t block_num = 1;
-    size_t read_len;
-
-    do {
-        uint16_t opcode = htons(3);
-        uint16_t block = htons(block_num);
-        
-        memcpy(buffer, &opcode, 2);
-        memcpy(buffer + 2, &block, 2);
-        
-        read_len = fread(buffer + 4, 1, 512, f);
-
-        int tentatives = 0;
-        int ack_recu = 0;
-        struct sockaddr_in peer_addr;
-        socklen_t peer_len = sizeof(peer_addr);
-
-        while (tentatives < TFTP_MAX_ESSAI && !ack_recu) {
-            if (sendto(sockfd, buffer, read_len + 4, 0, (struct sockaddr *)client_addr, addr_len) < 0) {
-                perror("sendto");
-                break;
-            }
-            
-            ssize_t r = recvfrom(sockfd, ack_buf, 4, 0, (struct sockaddr *)&peer_addr, &peer_len);
-            if (r >= 4) {
-                if (peer_addr.sin_addr.s_addr != client_addr->sin_addr.s_addr || peer_addr.sin_port != client_addr->sin_port) {
-                    send_error(sockfd, &peer_addr, peer_len, 5, "Unknown transfer ID");
-                    continue; 
-                }
-                uint16_t op = ntohs(*(uint16_t *)ack_buf);
-                uint16_t ack_val = ntohs(*(uint16_t *)(ack_buf + 2));
-                if (op == 4 && ack_val == block_num) {
-                    ack_recu = 1;
-                }
-            } else if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
-                tentatives++;
-            } else {
-                break;
-            }
-        }
-
-        if (!ack_recu) break;
-        block_num++;
-    } while (read_len == 512);
-
-    printf("[THREAD] Download '%s' finished.\n", filename);
-    fclose(f);
-    if (mtx) pthread_mutex_unlock(&mtx->mutex);
-    close(sockfd);
-}
-
-void traitement_wrq(struct sockaddr_in *client_addr, socklen_t addr_len, const char *fichier) {
-    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
-    if (sockfd < 0) {
-        perror("socket");
-        return;
-    }
-
-    struct timeval tv = {TFTP_TIMEOUT_SEC, 0};
-    setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
-
-    const char *filename = fichier;
-    
-    if (strstr(filename, "..")) {
-        send_error(sockfd, client_addr, addr_len, 2, "Access violation");
-        close(sockfd);
-        return;
-    }
-
-    file_mutex_t* mtx = get_file_mutex(filename);
-    if (mtx) pthread_mutex_lock(&mtx->mutex);
-
-    // Initial ACK 0
-    char ack[4] = {0, 4, 0, 0}; // Opcode 4 (ACK), Block 0
-    if (sendto(sockfd, ack, 4, 0, (struct sockaddr *)client_addr, addr_len) < 0) perror("sendto");
-
-    char buffer_reception[MAX_BUF];
-    char *buffer_final = NULL;
-    size_t taille_totale = 0;
-    uint16_t dernier_block_recu = 0;
-    ssize_t n;
-    
-    struct sockaddr_in peer_addr;
-    socklen_t peer_len = sizeof(peer_addr);
-    int peer_set = 0;
-    int recu_ok = 0;
-
-    do {
-        int tentatives = 0;
-
-        while (tentatives < TFTP_MAX_ESSAI && !recu_ok) {
-            ssize_t r = recvfrom(sockfd, buffer_reception, MAX_BUF, 0, (struct sockaddr *)&peer_addr, &peer_len);
-
-            if (r >= 4) {
-                if (!peer_set) peer_set = 1;
-                
-                if (peer_addr.sin_addr.s_addr != client_addr->sin_addr.s_addr || peer_addr.sin_port != client_addr->sin_port) {
-                    send_error(sockfd, &peer_addr, peer_len, 5, "Unknown transfer ID");
-                    continue;
-                }
-
-                uint16_t op = ntohs(*(uint16_t *)buffer_reception);
-                uint16_t block_recu = ntohs(*(uint16_t *)(buffer_reception + 2));
-
-                if (op == 3) { // DATA
-                    if (block_recu == dernier_block_recu + 1) {
-                        recu_ok = 1;
-                        n = r;
-                    } else if (block_recu == dernier_block_recu) {
-                        // Resend ACK for duplicate data
-                        uint16_t ack_op = htons(4);
-                        uint16_t ack_blk = htons(dernier_block_recu);
-                        char re_ack[4];
-                        memcpy(re_ack, &ack_op, 2);
-                        memcpy(re_ack + 2, &ack_blk, 2);
-                        sendto(sockfd, re_ack, 4, 0, (struct sockaddr *)&peer_addr, peer_len);
-                    }
-                }
-            } else if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
-                tentatives++;
-                // Resend last ACK on timeout
-                uint16_t ack_op = htons(4);
-                uint16_t ack_blk = htons(dernier_block_recu);
-                char re_ack[4];
-                memcpy(re_ack, &ack_op, 2);
-                memcpy(re_ack + 2, &ack_blk, 2);
-                sendto(sockfd, re_ack, 4, 0, (struct sockaddr *)client_addr, addr_len);
-            } else {
-                break;
-            }
-        }
-
-        if (!recu_ok) break;
-
-        size_t taille_donnees = n - 4;
-        buffer_final = realloc(buffer_final, taille_totale + taille_donnees);
-        memcpy(buffer_final + taille_totale, buffer_reception + 4, taille_donnees);
-        taille_totale += taille_donnees;
-
-        dernier_block_recu++;
-        
-        uint16_t ack_op = htons(4);
-        uint16_t ack_blk = htons(dernier_block_recu);
-        char new_ack[4];
-        memcpy(new_ack, &ack_op, 2);
-        memcpy(new_ack + 2, &ack_blk, 2);
-        sendto(sockfd, new_ack, 4, 0, (struct sockaddr *)&peer_addr, peer_len);
-
-    } while (n == MAX_BUF);
-
-    if (!recu_ok) {
-        free(buffer_final);
-        if (mtx) pthread_mutex_unlock(&mtx->mutex);
-        close(sockfd);
-        return;
-    }
-
-    if (strstr(filename, "..")) {
-        printf("  [SERVER] Erreur : Tentative d'accès non autorisé '%s'.\n", filename);
-        free(buffer_final);
-        if (mtx) pthread_mutex_unlock(&mtx->mutex);
-        close(sockfd);
-        return;
-    }
-
-    mkdir(REPOSITORY, 0777);
-    char chemin[256];
-    snprintf(chemin, sizeof(chemin), REPOSITORY "%s", filename);
-    FILE *f = fopen(chemin, "wb");
-    if (f) {
-        fwrite(buffer_final, 1, taille_totale, f);
-        fclose(f);
-        printf("[THREAD] Upload '%s' finished.\n", filename);
-    } else {
-        perror("fopen");
-        send_error(sockfd, client_addr, addr_len, 2, "Access violation");
-    }
-
-    free(buffer_final);
-    if (mtx) pthread_mutex_unlock(&mtx->mutex);
-    close(sockfd);
-}
-
-int main() {
-    int server_fd;
-    
-    struct sockaddr_in server_addr;
-    struct sockaddr_in client_addr;
-
-    char buffer[MAX_BUF];
-    socklen_t addr_len = sizeof(client_addr);
-
-    server_fd = socket(AF_INET, SOCK_DGRAM, 0);
-    if (server_fd < 0) {
-        perror("Socket error");
-        return 1;
-    }
-
-    memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_addr.s_addr = INADDR_ANY;
-    server_addr.sin_port = htons(PORT);
-
-    if (bind(server_fd, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
-        perror("Bind failed");
-        return 1;
-    }
-
-    printf("[SERVER-THREAD] Waiting on port %d...\n", PORT);
-    while (1) {
-        ssize_t n = recvfrom(server_fd, buffer, MAX_BUF, 0, (struct sockaddr *)&client_addr, &addr_len);
-        if (n < 4) continue;
-        
-        uint16_t opcode = ntohs(*(uint16_t *)buffer);   //  (nhtons : Network to Host Short)
-                                                        //  16 bits, convertit de l'ordre réseau (big-endian) à l'ordre hôte (endianness de la machine)       
-        pthread_t tid;
-        
-        if (opcode == 1 || opcode == 2) {
-            //  Valider la structure du paquet: Opcode | Filename | 0 | Mode | 0
-            //  Le nom du fichier et le MODE se terminent par un caractère nul dans le tampon
-            char *filename = buffer + 2;
-            char *mode = NULL;
-            char *end = buffer + n;
-            
-            //  Vérifier la présence d'un caractère nul de fin de nom du fichier
-            char *p = filename;
-            while (p < end && *p) p++;
-            if (p >= end - 1) { 
-                //  MODE mal formaté ou manquant
-                const char *err = "Malformed packet";
-                send_error(server_fd, &client_addr, addr_len, 4, err); // 4 = Illegal TFTP operation
-                continue; 
-            }
-            
-            mode = p + 1;
-            //  Vérifier le terminateur nul du MODE
-            p = mode;
-            while (p < end && *p) p++;
-            if (p >= end) {
-                 const char *err = "Malformed packet";
-                 send_error(server_fd, &client_addr, addr_len, 4, err);
-                 continue;
-            }
-            
-            // Validate Mode "octet" (case-insensitive)
-            if (strcasecmp(mode, "octet") != 0) {
-                 const char *err = "Only octet mode supported";
-                 send_error(server_fd, &client_addr, addr_len, 4, err); // 4 = Illegal TFTP
-                 continue;
-            }
-
-            // Allouer de la memoire pour les arguments du thread
-            void* params = malloc(sizeof(
-                struct {
-                    struct sockaddr_in client_addr; 
-                    socklen_t addr_len; 
-                    char fichier[MAX_BUF];
-                }
-            ));
-            if (!params) {
-                perror("malloc");
-                continue; 
-            }
-            
-            memcpy(&((struct {struct sockaddr_in client_addr; socklen_t addr_len; char fichier[MAX_BUF];}*)params)->client_addr, &client_addr, sizeof(client_addr));
-            ((struct {struct sockaddr_in client_addr; socklen_t addr_len; char fichier[MAX_BUF];}*)params)->addr_len = addr_len;
-            
-            // Copie sécurisée de FILENAME + 0 + MODE + 0 dans le tampon (max MAX_BUF)
-            // We already validated format, but let's be safe.
-            // The logic in thread function uses: filename = fichier; mode = fichier + strlen + 1;
-            // So copying the raw buffer from offset 2 is fine, as validated above.
-            size_t data_len = (p + 1) - (buffer + 2);
-            if (data_len > MAX_BUF) data_len = MAX_BUF; // Should not happen given MAX_BUF=MAX_BUF and headers
-            
-            memset(((struct {struct sockaddr_in client_addr; socklen_t addr_len; char fichier[MAX_BUF];}*)params)->fichier, 0, MAX_BUF);
-            memcpy(((struct {struct sockaddr_in client_addr; socklen_t addr_len; char fichier[MAX_BUF];}*)params)->fichier, buffer + 2, data_len);
-
-            if (opcode == 1)
-                pthread_create(&tid, NULL, thread_rrq, params);
-            else
-                pthread_create(&tid, NULL, thread_wrq, params);
-            
-            pthread_detach(tid);
-        }
-    }
-    return 0;
-}
+#define _GNU_SOURCE
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/time.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <dirent.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <time.h>
+#include <sched.h>
+#include <semaphore.h>
+
+#include "tftp_archive.h"
+#include "tftp_cpu.h"
+#include "tftp_durabilite.h"
+#include "tftp_fdcache.h"
+#include "tftp_filtre.h"
+#include "tftp_index.h"
+#include "tftp_options.h"
+#include "tftp_pacer.h"
+#include "tftp_pmtu.h"
+#include "tftp_relais.h"
+#include "tftp_ring.h"
+#include "tftp_session.h"
+#include "tftp_stockage.h"
+#include "tftp_trace.h"
+#include "tftp_variantes.h"
+#include "tftp_version.h"
+
+#define MAX_FILES 128
+#define REPOSITORY ".tftp/"
+#define PORT 69
+#define MAX_BUF 516
+#define PACER_BURST (2 * MAX_BUF) // Profondeur des seaux : deux paquets DATA au plus d'affilée
+#define FILE_REQUETES 1024        // Requêtes en attente d'un ouvrier au plus
+#define OUVRIERS_DEFAUT 8         // Ouvriers gardés même inactifs (-w)
+#define OUVRIERS_MAX 1024         // Un ouvrier par transfert en cours, au plus
+#define OUVRIER_INACTIF_SEC 30    // Au-delà du minimum, un ouvrier inactif s'arrête
+
+// Verrou par fichier entre écrivains : deux WRQ sur un même nom se
+// succèdent. Les RRQ ne le prennent pas : ils lisent la version publiée
+// à leur début (copie sur écriture, tftp_version.c)
+typedef struct {
+    char filename[256];
+    pthread_mutex_t mutex;
+    bool in_use;
+} file_mutex_t;
+
+file_mutex_t file_mutexes[MAX_FILES];
+pthread_mutex_t global_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Taille maximale d'un upload en octets (0 = illimitée), option -q
+unsigned long long quota_upload = 0;
+
+// Limitation du débit des DATA en octets/s (0 = illimité), options -B / -b / -F.
+// Le seau global et le compteur de lecteurs sont partagés entre les threads.
+double debit_global = 0;
+double debit_client = 0;
+bool partage_equitable = false;
+token_bucket_t seau_global;
+int lecteurs_actifs = 0;
+pthread_mutex_t pacer_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Placement des threads et attente active des sockets, options -C / -L
+cpu_profil_t profil_cpu;
+
+// Magasin des fichiers servis, option -M : le répertoire, dédupliqué ou
+// non, ou la mémoire
+const stockage_t *magasin = &stockage_dossier;
+
+// Identifiant des sessions, porté par les sondes de trace
+unsigned long long compteur_sessions = 0;
+
+// Redémarrage à chaud, option -H : socket unix où un nouveau processus
+// demande le port 69. Les sessions restent sur la pile de leurs ouvriers :
+// seul le port passe, et ce processus termine ses transferts (vidange).
+const char *relais_chemin = NULL;
+int relais_fd = -1;
+
+// Descripteur de requête passé du listener aux ouvriers par la file :
+// la requête brute (filename\0mode\0options...) telle que reçue
+typedef struct {
+    uint16_t opcode;
+    struct sockaddr_in client_addr;
+    socklen_t addr_len;
+    char fichier[MAX_BUF];
+    size_t len;
+} requete_params_t;
+
+// Get or create a lock for a specific file
+file_mutex_t* get_file_mutex(const char* filename) {
+    pthread_mutex_lock(&global_mutex);
+    for (int i = 0; i < MAX_FILES; ++i) {
+        if (file_mutexes[i].in_use && strcmp(file_mutexes[i].filename, filename) == 0) {
+            pthread_mutex_unlock(&global_mutex);
+            return &file_mutexes[i];
+        }
+    }
+    // Not found, create new
+    for (int i = 0; i < MAX_FILES; ++i) {
+        if (!file_mutexes[i].in_use) {
+            strncpy(file_mutexes[i].filename, filename, 255);
+            file_mutexes[i].filename[255] = '\0';
+            pthread_mutex_init(&file_mutexes[i].mutex, NULL);
+            file_mutexes[i].in_use = true;
+            pthread_mutex_unlock(&global_mutex);
+            return &file_mutexes[i];
+        }
+    }
+    pthread_mutex_unlock(&global_mutex);
+    return NULL; // Should ideally handle this case better (e.g. increase MAX_FILES or fail gracefully)
+}
+
+void send_error(int sockfd, struct sockaddr_in *client_addr, socklen_t addr_len, uint16_t err_code, const char *err_msg) {
+    char err_packet[MAX_BUF];
+    uint16_t opcode = htons(5); 
+    uint16_t error_code = htons(err_code); 
+    memcpy(err_packet, &opcode, 2);
+    memcpy(err_packet + 2, &error_code, 2);
+    int len = 4 + sprintf(err_packet + 4, "%s", err_msg) + 1;
+    sendto(sockfd, err_packet, len, 0, (struct sockaddr *)client_addr, addr_len);
+}
+
+// Thread de mise à jour de l'index du répertoire (événements inotify)
+void* thread_index(void* arg) {
+    (void)arg;
+    struct pollfd pfd = { .fd = index_fd(), .events = POLLIN };
+    while (1) {
+        if (poll(&pfd, 1, -1) < 0 && errno != EINTR) {
+            perror("poll");
+            break;
+        }
+        index_process_events();
+    }
+    return NULL;
+}
+
+// Vérifie qu'un upload de 'taille' octets respecte le quota et la place
+// du magasin (disque pour dir et cas, mémoire disponible pour mem)
+bool espace_suffisant(unsigned long long taille) {
+    if (quota_upload && taille > quota_upload) return false;
+    return stockage_place(magasin, REPOSITORY, taille);
+}
+
+// Options de la requête : elles suivent le terminateur nul du mode
+void lire_options(const char *fichier, size_t len, tftp_options_t *opts) {
+    const char *mode = fichier + strlen(fichier) + 1;
+    const char *debut = mode + strlen(mode) + 1;
+    if (debut >= fichier + len || options_parse(debut, fichier + len - debut, opts) < 0)
+        memset(opts, 0, sizeof(*opts));
+    // Le multicast (RFC 2090) n'est servi que par server_select : l'option
+    // est déclinée et le transfert se fait en unicast
+    opts->presentes &= ~TFTP_OPT_MULTICAST;
+}
+
+// Débit d'une session : la limite -b, plafonnée en mode équitable par une
+// part égale du débit global pour qu'un client gourmand n'affame pas les autres
+static double debit_session(void) {
+    double debit = debit_client;
+    if (partage_equitable && debit_global > 0 && lecteurs_actifs > 0) {
+        double part = debit_global / lecteurs_actifs;
+        if (debit == 0 || part < debit) debit = part;
+    }
+    return debit;
+}
+
+// Bloque jusqu'à ce que le seau global et celui de la session permettent
+// d'envoyer 'len' octets, puis les consomme : les paquets sont espacés
+// au lieu de partir en rafale
+void attendre_jetons(token_bucket_t *seau, size_t len) {
+    while (1) {
+        double now = pacer_now();
+        pthread_mutex_lock(&pacer_mutex);
+        bucket_set_rate(seau, debit_session(), now);
+        double attente = bucket_wait(&seau_global, len, now);
+        double propre = bucket_wait(seau, len, now);
+        if (propre > attente) attente = propre;
+        if (attente <= 0) {
+            bucket_take(&seau_global, len);
+            bucket_take(seau, len);
+            pthread_mutex_unlock(&pacer_mutex);
+            return;
+        }
+        pthread_mutex_unlock(&pacer_mutex);
+
+        struct timespec ts = { (time_t)attente, (long)((attente - (time_t)attente) * 1e9) };
+        nanosleep(&ts, NULL);
+    }
+}
+
+void traitement_rrq(struct sockaddr_in *client_addr, socklen_t addr_len, const char *fichier, size_t len);
+void traitement_wrq(struct sockaddr_in *client_addr, socklen_t addr_len, const char *fichier, size_t len);
+
+// Pool d'ouvriers : le listener dépose les requêtes validées dans une
+// file sans verrou et compte chacune dans un sémaphore ; il ne fait ni
+// malloc ni pthread_create. Un ouvrier garde sa requête jusqu'à la fin du
+// transfert. Quand il prend la dernière place libre, c'est lui qui lance
+// un ouvrier de plus avant de traiter la sienne ; au-delà de -w, les
+// ouvriers inactifs depuis OUVRIER_INACTIF_SEC s'arrêtent.
+ring_t file_requetes;
+sem_t requetes_pretes;
+int ouvriers_min = OUVRIERS_DEFAUT;
+int ouvriers = 0;           // Threads ouvriers existants
+int ouvriers_libres = 0;    // Dont ceux qui attendent une requête
+
+void* thread_ouvrier(void* arg);
+
+// Réserve une place et lance un ouvrier (compté libre dès maintenant)
+static void lancer_ouvrier(void) {
+    int n = __atomic_load_n(&ouvriers, __ATOMIC_RELAXED);
+    do {
+        if (n >= OUVRIERS_MAX) return;
+    } while (!__atomic_compare_exchange_n(&ouvriers, &n, n + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    __atomic_add_fetch(&ouvriers_libres, 1, __ATOMIC_RELAXED);
+
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, thread_ouvrier, NULL) != 0) {
+        perror("pthread_create");
+        __atomic_sub_fetch(&ouvriers_libres, 1, __ATOMIC_RELAXED);
+        __atomic_sub_fetch(&ouvriers, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    pthread_detach(tid);
+}
+
+// Attente d'une requête ; faux si l'ouvrier, inactif et en surnombre, s'arrête
+static bool attendre_requete(void) {
+    for (;;) {
+        struct timespec echeance;
+        clock_gettime(CLOCK_REALTIME, &echeance);
+        echeance.tv_sec += OUVRIER_INACTIF_SEC;
+        if (sem_timedwait(&requetes_pretes, &echeance) == 0) return true;
+        if (errno != ETIMEDOUT) continue;
+        int n = __atomic_load_n(&ouvriers, __ATOMIC_RELAXED);
+        while (n > ouvriers_min) {
+            if (__atomic_compare_exchange_n(&ouvriers, &n, n - 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                __atomic_sub_fetch(&ouvriers_libres, 1, __ATOMIC_RELAXED);
+                return false;
+            }
+        }
+    }
+}
+
+void* thread_ouvrier(void* arg) {
+    (void)arg;
+    requete_params_t params;
+    while (attendre_requete()) {
+        // Le sémaphore garantit une requête ; elle peut ne pas être encore
+        // publiée si un autre producteur a réservé la case précédente
+        while (!ring_pop(&file_requetes, &params)) sched_yield();
+
+        if (__atomic_sub_fetch(&ouvriers_libres, 1, __ATOMIC_RELAXED) == 0) lancer_ouvrier();
+        if (params.opcode == 1)
+            traitement_rrq(&params.client_addr, params.addr_len, params.fichier, params.len);
+        else
+            traitement_wrq(&params.client_addr, params.addr_len, params.fichier, params.len);
+        __atomic_add_fetch(&ouvriers_libres, 1, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+// Exécute les actions demandées par la machine à états d'une session ;
+// renvoie faux quand la session est terminée. 'dst' est l'objet écrit par
+// un WRQ (NULL pour un RRQ).
+bool executer_actions(session_t *s, int act, int sockfd, token_bucket_t *seau, stockage_objet_t *dst,
+                      const char *filename, const struct sockaddr_in *emetteur) {
+    if (act & SESSION_TID) {
+        send_error(sockfd, (struct sockaddr_in *)emetteur, sizeof(*emetteur), 5, "Unknown transfer ID");
+        return true;
+    }
+    if (act & SESSION_FRAGMENTER) pmtu_fragmentation(sockfd, true);
+    if ((act & SESSION_PUBLIER) && dst) {
+        // Avec -D close ou group, l'ouvrier attend ici que la version soit
+        // sur disque : l'ACK final ne part qu'ensuite
+        int publie = stockage_valider(dst);
+        index_refresh(filename);
+        if (publie < 0) act = session_erreur(s, 3, "Disk full or allocation exceeded");
+    }
+    if (act & SESSION_ENVOYER) {
+        if (act & SESSION_DATA) attendre_jetons(seau, s->paquet_len);
+        ssize_t envoye = sendto(sockfd, s->paquet, s->paquet_len, 0, (struct sockaddr *)&s->client, sizeof(s->client));
+        if (envoye < 0 && errno == EMSGSIZE && (session_emsgsize(s) & SESSION_FRAGMENTER)) {
+            pmtu_fragmentation(sockfd, true);
+            envoye = sendto(sockfd, s->paquet, s->paquet_len, 0, (struct sockaddr *)&s->client, sizeof(s->client));
+        }
+        if (envoye < 0) {
+            perror("sendto");
+            return false;
+        }
+        if (act & SESSION_DATA) TRACE_DATA_SEND(s->id, s->bloc, (long)(s->paquet_len - 4), s->essais);
+    }
+    return !(act & SESSION_FIN);
+}
+
+// Boucle bloquante d'une session : chaque paquet reçu, ou l'expiration de
+// SO_RCVTIMEO, fait avancer la machine à états. Avec -C, l'ouvrier
+// rejoint le CPU qui reçoit le flux dès le premier paquet du client.
+void boucle_session(session_t *s, int act, int sockfd, token_bucket_t *seau, stockage_objet_t *dst,
+                    const char *filename) {
+    struct timeval tv = { s->timeout, 0 };
+    setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    if (s->df) pmtu_fragmentation(sockfd, false);
+    cpu_busy_poll(&profil_cpu, sockfd);
+    int cpu = -1;
+    bool suivi = false;
+
+    char buffer[TFTP_BLKSIZE_MAX + 4];
+    struct sockaddr_in peer_addr = s->client;
+    while (executer_actions(s, act, sockfd, seau, dst, filename, &peer_addr)) {
+        socklen_t peer_len = sizeof(peer_addr);
+        ssize_t r = recvfrom(sockfd, buffer, sizeof(buffer), 0, (struct sockaddr *)&peer_addr, &peer_len);
+        if (r >= 0) {
+            if (!suivi) {
+                cpu = cpu_suivre(&profil_cpu, sockfd);
+                suivi = true;
+            }
+            act = session_paquet(s, buffer, r, &peer_addr);
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK)
+            act = session_timeout(s);
+        else
+            break;
+    }
+    if (cpu >= 0) cpu_epingler(&profil_cpu, false);
+}
+
+void traitement_rrq(struct sockaddr_in *client_addr, socklen_t addr_len, const char *fichier, size_t len) {
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0); 
+    
+    if (sockfd < 0) {
+        perror("socket");
+        return;
+    }
+
+    const char *filename = fichier;
+    const char *mode = fichier + strlen(fichier) + 1;
+    bool netascii = strcasecmp(mode, "netascii") == 0;
+    unsigned long long sid = __atomic_add_fetch(&compteur_sessions, 1, __ATOMIC_RELAXED);
+
+    // Vérifications de base des noms de fichiers
+    if (strstr(filename, "..") || version_interne(filename)) {
+        send_error(sockfd, client_addr, addr_len, 2, "Violation d'accès");
+        close(sockfd);
+        return;
+    }
+
+    char chemin[256];
+    snprintf(chemin, sizeof(chemin), REPOSITORY "%s", filename);
+    
+    // Archive projetée (-A) d'abord, sans appel système. Sinon objet du
+    // magasin, gardé jusqu'à la fin même si un WRQ le remplace : avec dir,
+    // descripteur partagé avec les autres lecteurs de la même version
+    archive_fichier_t image = { NULL, 0, 0, 0, 0 };
+    stockage_objet_t src = { .fd = -1 };
+    const char *source = chemin;
+    if (archive_chercher(filename, &image)) {
+        src.taille = image.taille;
+        src.image = image.donnees;
+        src.dev = image.dev;
+        src.inode = image.inode;
+        src.mtime = image.mtime;
+        source = filename;
+    } else if (stockage_ouvrir(magasin, &src, chemin) < 0) {
+        send_error(sockfd, client_addr, addr_len, 1, "Fichier non trouvé");
+        close(sockfd);
+        return;
+    }
+
+    token_bucket_t seau;
+    TRACE_SESSION_START(sid, 1, filename, (unsigned long long)src.taille);
+    bucket_init(&seau, debit_client, PACER_BURST);
+    pthread_mutex_lock(&pacer_mutex);
+    lecteurs_actifs++;
+    pthread_mutex_unlock(&pacer_mutex);
+
+    // Options RFC 2347 : négociées par la machine à états, qui envoie un
+    // OACK acquitté par l'ACK 0 avant les données
+    tftp_options_t opts;
+    lire_options(fichier, len, &opts);
+
+    // Option compress : la variante lz4 du cache, objet hors magasin,
+    // remplace la source
+    stockage_objet_t lu = src;
+    fdcache_entry_t *v = variante_lz4(&opts, netascii, source, &src);
+    if (v) lu = (stockage_objet_t){ .fd = v->fd, .taille = v->size };
+
+    session_t s;
+    int act = session_rrq(&s, sid, client_addr, &lu, netascii, &opts);
+    boucle_session(&s, act, sockfd, &seau, NULL, filename);
+
+    printf("[THREAD] Download '%s' finished.\n", filename);
+    TRACE_SESSION_END(sid, s.termine, session_octets(&s));
+    pthread_mutex_lock(&pacer_mutex);
+    lecteurs_actifs--;
+    pthread_mutex_unlock(&pacer_mutex);
+    if (v) fdcache_release(v);
+    stockage_fermer(&src);
+    close(sockfd);
+}
+
+void traitement_wrq(struct sockaddr_in *client_addr, socklen_t addr_len, const char *fichier, size_t len) {
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sockfd < 0) {
+        perror("socket");
+        return;
+    }
+
+    const char *filename = fichier;
+    bool netascii = strcasecmp(fichier + strlen(fichier) + 1, "netascii") == 0;
+    unsigned long long sid = __atomic_add_fetch(&compteur_sessions, 1, __ATOMIC_RELAXED);
+    
+    if (strstr(filename, "..") || version_interne(filename)) {
+        send_error(sockfd, client_addr, addr_len, 2, "Access violation");
+        close(sockfd);
+        return;
+    }
+
+    // Taille annoncée (tsize) : refus immédiat, avant tout transfert, si
+    // elle dépasse le quota ou la place du magasin
+    tftp_options_t opts;
+    lire_options(fichier, len, &opts);
+    if ((opts.presentes & TFTP_OPT_TSIZE) && !espace_suffisant(opts.tsize)) {
+        printf("[THREAD] Upload '%s' refused (%llu bytes).\n", filename, (unsigned long long)opts.tsize);
+        send_error(sockfd, client_addr, addr_len, 3, "Disk full or allocation exceeded");
+        close(sockfd);
+        return;
+    }
+
+    TRACE_SESSION_START(sid, 2, filename, (unsigned long long)opts.tsize);
+    file_mutex_t* mtx = get_file_mutex(filename);
+    TRACE_LOCK_WAIT_START(sid, filename);
+    if (mtx) pthread_mutex_lock(&mtx->mutex);
+    TRACE_LOCK_WAIT_DONE(sid, filename, mtx != NULL);
+
+    if (magasin != &stockage_memoire) mkdir(REPOSITORY, 0777);
+    char chemin[256];
+    snprintf(chemin, sizeof(chemin), REPOSITORY "%s", filename);
+    // Nouvelle version écrite à côté de l'actuelle, que les RRQ continuent
+    // de lire ; la taille annoncée est réservée d'avance
+    stockage_objet_t dst;
+    if (stockage_creer(magasin, &dst, chemin, (opts.presentes & TFTP_OPT_TSIZE) ? (off_t)opts.tsize : 0) < 0) {
+        perror("open");
+        send_error(sockfd, client_addr, addr_len, 2, "Access violation");
+        if (mtx) pthread_mutex_unlock(&mtx->mutex);
+        TRACE_SESSION_END(sid, 0, 0ULL);
+        close(sockfd);
+        return;
+    }
+
+    session_t s;
+    int act = session_wrq(&s, sid, client_addr, &dst, netascii, quota_upload, &opts);
+    boucle_session(&s, act, sockfd, NULL, &dst, filename);
+
+    stockage_abandonner(&dst); // Sans effet si l'objet a été validé
+    if (s.termine)
+        printf("[THREAD] Upload '%s' finished (%llu bytes).\n", filename, s.transferes);
+    else
+        printf("[THREAD] Upload '%s' aborted.\n", filename);
+    TRACE_SESSION_END(sid, s.termine, s.transferes);
+
+    if (mtx) pthread_mutex_unlock(&mtx->mutex);
+    close(sockfd);
+}
+
+// Donne la socket du port 69 au processus connecté à relais_fd ; vrai
+// s'il l'a reçue. Il n'y a pas de sessions à transmettre (0 annoncée).
+bool ceder_port(int server_fd) {
+    int sock = relais_accepter(relais_fd);
+    if (sock < 0) return false;
+    relais_entete_t h = { RELAIS_MAGIE, RELAIS_VERSION, RELAIS_THREAD, 0, 0, 0, 0, 0 };
+    char reponse;
+    int fds[RELAIS_FDS_MAX], nb;
+    bool cede = relais_envoyer(sock, &h, sizeof(h), &server_fd, 1) == 0 &&
+                relais_recevoir(sock, &reponse, 1, fds, &nb) == 0;
+    close(sock);
+    if (!cede) printf("[SERVER-THREAD] Hot restart: no answer from the new process, still serving\n");
+    return cede;
+}
+
+// Prend la socket du port 69 d'un processus précédent ; -1 pour en lier
+// une nouvelle. Les sessions d'un server_select sont refusées (réponse 0) :
+// il les termine lui-même.
+int reprendre_port(int sock) {
+    relais_entete_t h;
+    int fds[RELAIS_FDS_MAX], nb;
+    char reponse = 0;
+    if (relais_recevoir(sock, &h, sizeof(h), fds, &nb) < 0 || nb != 1 || h.magie != RELAIS_MAGIE ||
+        relais_envoyer(sock, &reponse, 1, NULL, 0) < 0) {
+        while (nb > 0) close(fds[--nb]);
+        close(sock);
+        return -1;
+    }
+    close(sock);
+    printf("[SERVER-THREAD] Took over port %d; the previous process finishes its transfers\n", PORT);
+    return fds[0];
+}
+
+// Après ceder_port : plus de requêtes, on attend que les ouvriers aient
+// fini leurs transferts et vidé la file
+void vidanger(void) {
+    printf("[SERVER-THREAD] Hot restart: port %d handed over, draining\n", PORT);
+    fflush(stdout);
+    for (;;) {
+        int attente;
+        sem_getvalue(&requetes_pretes, &attente);
+        if (attente == 0 && __atomic_load_n(&ouvriers_libres, __ATOMIC_RELAXED) == __atomic_load_n(&ouvriers, __ATOMIC_RELAXED))
+            break;
+        sleep(1);
+    }
+    printf("[SERVER-THREAD] Drained, exiting\n");
+}
+
+void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-q quota_octets] [-B debit_global] [-b debit_client] [-F] [-w ouvriers]\n"
+                    "       [-C cpus|numa:interface] [-L busy_poll_us] [-A archive] [-D none|close|group] [-H socket_relais]\n"
+                    "       [-M dir|mem|cas]\n", prog);
+    fprintf(stderr, "  débits en octets/s (suffixes k/M/G) ; -F partage -B équitablement entre les lectures\n");
+    fprintf(stderr, "  -C épingle les threads (liste \"0-3,8\" ou nœud NUMA de la carte), -L attente active\n");
+    fprintf(stderr, "  -A sert d'abord les fichiers d'une archive construite par ./archiver\n");
+    fprintf(stderr, "  -D durabilité des uploads avant l'ACK final : aucune, fsync par upload, ou par lots\n");
+    fprintf(stderr, "  -H reprend le port 69 du serveur qui écoute sur cette socket unix, puis y attend le suivant\n");
+    fprintf(stderr, "  -M magasin des fichiers : le répertoire " REPOSITORY " (défaut), la mémoire (vide au départ),\n"
+                    "     ou le répertoire avec chaque contenu stocké une fois sous " CAS_DOSSIER "\n");
+}
+
+int main(int argc, char *argv[]) {
+    int server_fd;
+    int opt;
+    const char *archive = NULL;
+    durabilite_mode_t durabilite = DURABILITE_AUCUNE;
+
+    while ((opt = getopt(argc, argv, "q:B:b:Fw:C:L:A:D:H:M:")) != -1) {
+        switch (opt) {
+        case 'q':
+            quota_upload = strtoull(optarg, NULL, 10);
+            break;
+        case 'B':
+            debit_global = pacer_parse_rate(optarg);
+            break;
+        case 'b':
+            debit_client = pacer_parse_rate(optarg);
+            break;
+        case 'F':
+            partage_equitable = true;
+            break;
+        case 'w': {
+            char *fin;
+            long n = strtol(optarg, &fin, 10);
+            if (fin == optarg || *fin || n < 1 || n > OUVRIERS_MAX) {
+                usage(argv[0]);
+                return 1;
+            }
+            ouvriers_min = (int)n;
+            break;
+        }
+        case 'C':
+            if (cpu_profil_lire(&profil_cpu, optarg) < 0) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'L':
+            if (cpu_busy_poll_lire(&profil_cpu, optarg) < 0) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'A':
+            archive = optarg;
+            break;
+        case 'D':
+            if (durabilite_lire(optarg, &durabilite) < 0) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'H':
+            relais_chemin = optarg;
+            break;
+        case 'M':
+            magasin = stockage_chercher(optarg);
+            if (!magasin) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    
+    bucket_init(&seau_global, debit_global, PACER_BURST);
+
+    // Avant toute allocation et tout thread : ouvriers, index et file des
+    // requêtes héritent de l'affinité et du nœud mémoire préféré
+    if (cpu_appliquer(&profil_cpu, false) == 0 && profil_cpu.actif) {
+        char texte[256];
+        cpu_decrire(&profil_cpu, texte, sizeof(texte));
+        printf("[SERVER-THREAD] Pinned to %s\n", texte);
+    }
+
+    struct sockaddr_in server_addr;
+    struct sockaddr_in client_addr;
+
+    char buffer[MAX_BUF];
+    socklen_t addr_len = sizeof(client_addr);
+
+    // Redémarrage à chaud : le port 69 vient du serveur en place, s'il y en a un
+    server_fd = -1;
+    if (relais_chemin) {
+        int sock = relais_connecter(relais_chemin);
+        if (sock >= 0) server_fd = reprendre_port(sock);
+    }
+    if (server_fd < 0) {
+        server_fd = socket(AF_INET, SOCK_DGRAM, 0);
+        if (server_fd < 0) {
+            perror("Socket error");
+            return 1;
+        }
+
+        memset(&server_addr, 0, sizeof(server_addr));
+        server_addr.sin_family = AF_INET;
+        server_addr.sin_addr.s_addr = INADDR_ANY;
+        server_addr.sin_port = htons(PORT);
+
+        if (bind(server_fd, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
+            perror("Bind failed");
+            return 1;
+        }
+    }
+
+    // Les paquets qui ne sont pas des requêtes sont jetés par le noyau, sans
+    // réveiller ce thread. Le délai de réception ne sert qu'au bilan des rejets.
+    int filtre = filtre_attacher(server_fd);
+    if (filtre >= 0) printf("[SERVER-THREAD] Request filter attached (%s)\n", filtre ? "eBPF" : "classic BPF");
+    struct timeval periode = { FILTRE_PERIODE, 0 };
+    setsockopt(server_fd, SOL_SOCKET, SO_RCVTIMEO, &periode, sizeof(periode));
+    cpu_busy_poll(&profil_cpu, server_fd);
+
+    if (archive) {
+        int nb = archive_ouvrir(archive);
+        if (nb >= 0) printf("[SERVER-THREAD] Archive '%s': %d files\n", archive, nb);
+    }
+    if (durabilite_demarrer(durabilite) < 0) {
+        fprintf(stderr, "[SERVER-THREAD] Cannot start upload durability '%s'\n", durabilite_nom(durabilite));
+        return 1;
+    }
+    if (durabilite != DURABILITE_AUCUNE)
+        printf("[SERVER-THREAD] Upload durability: %s\n", durabilite_nom(durabilite));
+
+    // Index en mémoire de REPOSITORY, tenu à jour par un thread dédié. Le
+    // magasin mem n'a pas d'index (un nom absent est cherché dans sa table)
+    // ni de cache de variantes lz4. Les envois en cours sont écrits sous REPOSITORY VERSION_ENCOURS, purgé
+    // au démarrage de ceux d'un serveur mort.
+    if (magasin != &stockage_memoire) {
+        mkdir(REPOSITORY, 0777);
+        version_demarrer(REPOSITORY);
+        if (index_init(REPOSITORY) == 0) {
+            pthread_t index_tid;
+            if (pthread_create(&index_tid, NULL, thread_index, NULL) == 0)
+                pthread_detach(index_tid);
+        }
+        variantes_demarrer(REPOSITORY);
+    }
+    if (magasin != &stockage_dossier) printf("[SERVER-THREAD] Storage: %s\n", magasin->nom);
+    if (stockage_demarrer(magasin) < 0) return 1;
+
+    if (ring_init(&file_requetes, FILE_REQUETES, sizeof(requete_params_t)) < 0 ||
+        sem_init(&requetes_pretes, 0, 0) < 0) {
+        perror("File des requêtes");
+        return 1;
+    }
+    for (int i = 0; i < ouvriers_min; i++) lancer_ouvrier();
+
+    if (relais_chemin) relais_fd = relais_ecouter(relais_chemin);
+
+    printf("[SERVER-THREAD] Waiting on port %d...\n", PORT);
+    while (1) {
+        // -H : une demande de relais réveille aussi le listener
+        if (relais_fd >= 0) {
+            struct pollfd pfd[2] = { { server_fd, POLLIN, 0 }, { relais_fd, POLLIN, 0 } };
+            if (poll(pfd, 2, FILTRE_PERIODE * 1000) < 0 && errno != EINTR) perror("poll");
+            if ((pfd[1].revents & POLLIN) && ceder_port(server_fd)) {
+                close(server_fd);
+                close(relais_fd);
+                vidanger();
+                return 0;
+            }
+            if (!(pfd[0].revents & POLLIN)) {
+                filtre_bilan(server_fd, "[SERVER-THREAD]");
+                continue;
+            }
+        }
+        ssize_t n = recvfrom(server_fd, buffer, MAX_BUF, 0, (struct sockaddr *)&client_addr, &addr_len);
+        filtre_bilan(server_fd, "[SERVER-THREAD]");
+        if (n < 4) continue;
+        
+        uint16_t opcode = ntohs(*(uint16_t *)buffer);   //  (nhtons : Network to Host Short)
+                                                        //  16 bits, convertit de l'ordre réseau (big-endian) à l'ordre hôte (endianness de la machine)       
+        if (opcode == 1 || opcode == 2) {
+            //  Valider la structure du paquet: Opcode | Filename | 0 | Mode | 0
+            //  Le nom du fichier et le MODE se terminent par un caractère nul dans le tampon
+            char *filename = buffer + 2;
+            char *mode = NULL;
+            char *end = buffer + n;
+            
+            //  Vérifier la présence d'un caractère nul de fin de nom du fichier
+            char *p = filename;
+            while (p < end && *p) p++;
+            if (p >= end - 1) { 
+                //  MODE mal formaté ou manquant
+                const char *err = "Malformed packet";
+                send_error(server_fd, &client_addr, addr_len, 4, err); // 4 = Illegal TFTP operation
+                continue; 
+            }
+            
+            mode = p + 1;
+            //  Vérifier le terminateur nul du MODE
+            p = mode;
+            while (p < end && *p) p++;
+            if (p >= end) {
+                 const char *err = "Malformed packet";
+                 send_error(server_fd, &client_addr, addr_len, 4, err);
+                 continue;
+            }
+            
+            // Modes "octet" et "netascii" (insensibles à la casse)
+            if (strcasecmp(mode, "octet") != 0 && strcasecmp(mode, "netascii") != 0) {
+                 const char *err = "Only octet and netascii modes supported";
+                 send_error(server_fd, &client_addr, addr_len, 4, err); // 4 = Illegal TFTP
+                 continue;
+            }
+
+            // Les sondes PXE sur des noms inexistants sont refusées ici, à partir
+            // de l'index : ni thread, ni socket, ni verrou de fichier
+            if (opcode == 1 && !strstr(filename, "..") && !archive_chercher(filename, NULL) &&
+                index_lookup(filename, NULL) == INDEX_ABSENT) {
+                send_error(server_fd, &client_addr, addr_len, 1, "Fichier non trouvé");
+                continue;
+            }
+
+            requete_params_t params;
+            params.opcode = opcode;
+            params.client_addr = client_addr;
+            params.addr_len = addr_len;
+            
+            // Copie de FILENAME + 0 + MODE + 0 + options éventuelles, déjà validés
+            // ci-dessus ; le reste du tampon est mis à zéro.
+            params.len = n - 2;
+            memset(params.fichier, 0, MAX_BUF);
+            memcpy(params.fichier, buffer + 2, params.len);
+
+            // Dépôt dans la file des ouvriers ; pleine, la requête est refusée
+            // tout de suite plutôt que laissée au timeout du client
+            if (!ring_push(&file_requetes, &params)) {
+                send_error(server_fd, &client_addr, addr_len, 0, "Server busy");
+                continue;
+            }
+            sem_post(&requetes_pretes);
+        }
+    }
+    return 0;
+}
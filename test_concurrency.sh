@@ -33,23 +33,23 @@ wait $PID1
 wait $PID2
 echo -e "${GREEN}[OK] Descargas paralelas terminadas.${NC}"
 
-# 3. Prueba de Exclusión Mutua (Mismo Archivo)
-# El segundo cliente debería esperar al primero (si el mutex funciona)
-echo -e "\n${GREEN}[TEST 2] Exclusión Mutua (Mismo Archivo)${NC}"
+# 3. Prueba de Lectura Compartida (Mismo Archivo)
+# Los lectores comparten el archivo y su descriptor: ninguno espera al otro
+echo -e "\n${GREEN}[TEST 2] Lectura Compartida (Mismo Archivo)${NC}"
 echo "Iniciando Cliente 1 (file_A.bin)..."
 ./client $SERVER_IP get file_A.bin $PORT &
 PID1=$!
 
-# Pequeña pausa para asegurar que el 1 gane el lock
+# Pequeña pausa para que las dos lecturas se solapen
 sleep 0.2 
 
-echo "Iniciando Cliente 2 (file_A.bin) - Debería esperar..."
+echo "Iniciando Cliente 2 (file_A.bin) - En paralelo..."
 ./client $SERVER_IP get file_A.bin $PORT &
 PID2=$!
 
 wait $PID1
 wait $PID2
-echo -e "${GREEN}[OK] Test de exclusión mutua terminado.${NC}"
+echo -e "${GREEN}[OK] Test de lectura compartida terminado.${NC}"
 
 # Limpieza
 rm -f file_A.bin file_B.bin
@@ -0,0 +1,180 @@
+#!/bin/bash
+
+# Magasin dédupliqué (-M cas) sur les deux serveurs : un même contenu
+# envoyé sous deux noms, ou renvoyé à l'identique, n'est stocké qu'une
+# fois (liens durs vers .tftp_objets/) ; un contenu modifié au milieu
+# donne un nouvel objet, l'ancien est effacé quand son dernier nom est
+# remplacé, et ceux dont les noms ont été supprimés hors du serveur sont
+# effacés au démarrage. Deux uploads simultanés d'un même contenu nouveau
+# finissent aussi sur un seul objet.
+# Usage : ./test_dedup.sh [taille]   (défaut 3M ; lance lui-même les serveurs)
+
+# Configuration
+SERVER_IP="127.0.0.1"
+PORT=69
+REPO=".tftp"
+OBJETS=".tftp_objets"
+CLIENT_BIN="./client"
+TAILLE=${1:-3M}
+COURSES=5                 # Paires d'uploads simultanés d'un même contenu nouveau
+JOURNAL="/tmp/tftp_dedup_server.log"
+CLIENT_DIR="dedup_client"
+
+# Couleurs pour la lisibilité
+VERT='\033[0;32m'
+ROUGE='\033[0;31m'
+JAUNE='\033[1;33m'
+CYAN='\033[0;36m'
+NC='\033[0m'
+
+echo -e "${CYAN}==========================================================${NC}"
+echo -e "${CYAN}   PROTOCOLE DE TEST : MAGASIN DÉDUPLIQUÉ (-M cas)        ${NC}"
+echo -e "${CYAN}==========================================================${NC}"
+
+for bin in "$CLIENT_BIN" ./server_select ./server_thread; do
+    if [ ! -f "$bin" ]; then
+        echo -e "${ROUGE}[ERREUR] Le binaire '$bin' est introuvable. Tapez 'make'.${NC}"
+        exit 1
+    fi
+done
+
+SERVER_PID=""
+demarrer_serveur() {
+    stdbuf -oL ./$1 -M cas "${@:2}" > $JOURNAL 2>&1 &
+    SERVER_PID=$!
+    sleep 0.5
+}
+arreter_serveur() {
+    [ -n "$SERVER_PID" ] && kill $SERVER_PID 2>/dev/null && wait $SERVER_PID 2>/dev/null
+    SERVER_PID=""
+}
+# Objets (contenus) partagés par un nom servi
+effacer_objets() {
+    for nom in "$@"; do
+        [ -e "$REPO/$nom" ] && find $OBJETS -samefile "$REPO/$nom" -delete 2>/dev/null
+        rm -f "$REPO/$nom"
+    done
+}
+nettoyer() {
+    arreter_serveur
+    effacer_objets dd_a.bin dd_b.bin dd_c.bin dd_d.bin
+    rm -rf "$CLIENT_DIR"
+}
+trap nettoyer EXIT
+
+RESULTAT=true
+verifier() {
+    if cmp -s "$1" "$2"; then
+        echo -e "${VERT}[OK] $3${NC}"
+    else
+        echo -e "${ROUGE}[FAIL] $3${NC}"
+        RESULTAT=false
+    fi
+}
+verifier_vrai() {
+    if "${@:2}"; then
+        echo -e "${VERT}[OK] $1${NC}"
+    else
+        echo -e "${ROUGE}[FAIL] $1${NC}"
+        RESULTAT=false
+    fi
+}
+# PUT du fichier local $1 sous le nom $2
+envoyer() {
+    (cd "$CLIENT_DIR" && timeout 30 ../$CLIENT_BIN -o "$1" $SERVER_IP put "$2" $PORT > /dev/null 2>&1)
+    sleep 0.2
+}
+inode() {
+    stat -c %i "$REPO/$1"
+}
+liens() {
+    stat -c %h "$REPO/$1"
+}
+objet_present() {
+    [ -n "$(find $OBJETS -inum $1 2>/dev/null)" ]
+}
+
+# 1. Deux versions d'un même contenu : la seconde diffère au milieu
+echo -e "\n${JAUNE}[1/3] Génération de deux versions de $TAILLE...${NC}"
+rm -rf "$CLIENT_DIR"
+mkdir -p $REPO "$CLIENT_DIR"
+head -c "$TAILLE" /dev/urandom > "$CLIENT_DIR/v1.bin"
+cp "$CLIENT_DIR/v1.bin" "$CLIENT_DIR/v2.bin"
+N=$(stat -c %s "$CLIENT_DIR/v1.bin")
+printf 'MODIFIE' | dd of="$CLIENT_DIR/v2.bin" bs=1 seek=$((N / 2)) conv=notrunc status=none
+
+ETAPE=2
+for serveur in server_select server_thread; do
+    echo -e "\n${JAUNE}[$ETAPE/3] $serveur -M cas...${NC}"
+    effacer_objets dd_a.bin dd_b.bin
+    demarrer_serveur $serveur
+    verifier_vrai "magasin annoncé" grep -q "Storage: cas" $JOURNAL
+
+    # Premier envoi : un nom et son objet
+    envoyer v1.bin dd_a.bin
+    verifier "$CLIENT_DIR/v1.bin" "$REPO/dd_a.bin" "PUT de dd_a.bin"
+    V1=$(inode dd_a.bin)
+    verifier_vrai "dd_a.bin lié à son objet" objet_present $V1
+    verifier_vrai "deux liens, le nom et l'objet ($(liens dd_a.bin))" [ "$(liens dd_a.bin)" -eq 2 ]
+
+    # Même contenu sous un autre nom, puis renvoyé à l'identique : pas de copie
+    envoyer v1.bin dd_b.bin
+    verifier_vrai "dd_b.bin partage le contenu de dd_a.bin" [ "$(inode dd_b.bin)" = "$V1" -a "$(liens dd_b.bin)" -eq 3 ]
+    envoyer v1.bin dd_a.bin
+    verifier_vrai "renvoi identique : même contenu, pas de nouvel objet" [ "$(inode dd_a.bin)" = "$V1" -a "$(liens dd_a.bin)" -eq 3 ]
+
+    # Contenu modifié au milieu : nouvel objet, l'ancien reste pour dd_b.bin
+    envoyer v2.bin dd_a.bin
+    verifier "$CLIENT_DIR/v2.bin" "$REPO/dd_a.bin" "PUT de la version modifiée"
+    V2=$(inode dd_a.bin)
+    verifier_vrai "nouveau contenu pour la version modifiée" [ "$V2" != "$V1" ]
+    verifier_vrai "nouvel objet pour la version modifiée" objet_present $V2
+    verifier "$CLIENT_DIR/v1.bin" "$REPO/dd_b.bin" "dd_b.bin garde l'ancienne version"
+
+    # Dernier nom de l'ancien contenu remplacé : son objet est effacé
+    envoyer v2.bin dd_b.bin
+    verifier_vrai "dd_b.bin partage la nouvelle version" [ "$(inode dd_b.bin)" = "$V2" ]
+    verifier_vrai "ancien objet effacé" eval '! objet_present $V1'
+    rm -f "$CLIENT_DIR/dd_b.bin"
+    (cd "$CLIENT_DIR" && timeout 30 ../$CLIENT_BIN $SERVER_IP get dd_b.bin $PORT > /dev/null)
+    verifier "$CLIENT_DIR/v2.bin" "$CLIENT_DIR/dd_b.bin" "GET de dd_b.bin"
+    RESTES=$(ls -A "$REPO/.encours" 2>/dev/null | wc -l)
+    verifier_vrai "aucune version temporaire laissée ($RESTES)" [ "$RESTES" -eq 0 ]
+
+    # Noms supprimés hors du serveur : l'objet est effacé au démarrage
+    arreter_serveur
+    rm -f "$REPO/dd_a.bin" "$REPO/dd_b.bin"
+    demarrer_serveur $serveur
+    verifier_vrai "objet sans nom effacé au démarrage" eval '! objet_present $V2'
+    arreter_serveur
+
+    # Un même contenu nouveau envoyé en même temps sous deux noms : avec
+    # -D group, chacun prépare sa version avant que l'autre soit publiée,
+    # mais les deux noms doivent finir sur un seul objet
+    demarrer_serveur $serveur -D group
+    PARTAGES=0
+    for i in $(seq $COURSES); do
+        head -c 1000000 /dev/urandom > "$CLIENT_DIR/v3.bin"
+        envoyer v3.bin dd_c.bin &
+        C=$!
+        envoyer v3.bin dd_d.bin &
+        wait $C $!
+        if cmp -s "$CLIENT_DIR/v3.bin" "$REPO/dd_c.bin" && cmp -s "$CLIENT_DIR/v3.bin" "$REPO/dd_d.bin" &&
+           [ "$(inode dd_c.bin)" = "$(inode dd_d.bin)" -a "$(liens dd_c.bin)" -eq 3 ]; then
+            PARTAGES=$((PARTAGES + 1))
+        fi
+        effacer_objets dd_c.bin dd_d.bin
+    done
+    verifier_vrai "uploads simultanés : un seul objet ($PARTAGES/$COURSES)" [ $PARTAGES -eq $COURSES ]
+    arreter_serveur
+    ETAPE=$((ETAPE + 1))
+done
+
+echo -e "\n${CYAN}==========================================================${NC}"
+if [ "$RESULTAT" = true ]; then
+    echo -e "${VERT}RÉSULTAT FINAL : TEST RÉUSSI${NC}"
+else
+    echo -e "${ROUGE}RÉSULTAT FINAL : TEST ÉCHOUÉ${NC}"
+fi
+echo -e "${CYAN}==========================================================${NC}"
+[ "$RESULTAT" = true ]
@@ -0,0 +1,136 @@
+#!/bin/bash
+
+# Durabilité des uploads (-D none|close|group) sur les deux serveurs :
+# des PUT simultanés (mode lot) arrivent intacts, sans version temporaire
+# laissée, et avec close ou group aucune page des fichiers reçus n'est
+# encore sale ou en écriture quand le client a reçu son dernier ACK final.
+# Usage : ./test_durabilite.sh [uploads]   (défaut 40)
+# Lance lui-même chaque serveur ; nécessite python3. Les pages sales sont
+# comptées par l'appel système cachestat (Linux 6.5) : sur un noyau plus
+# ancien, ou un système de fichiers sans cache d'écriture, seule
+# l'intégrité est vérifiée.
+
+# Configuration
+SERVER_IP="127.0.0.1"
+PORT=69
+REPO=".tftp"
+CLIENT_BIN="./client"
+UPLOADS=${1:-40}
+SIMULTANES=16
+JOURNAL="/tmp/tftp_durabilite_server.log"
+CLIENT_DIR="durabilite_client"
+
+# Couleurs pour la lisibilité
+VERT='\033[0;32m'
+ROUGE='\033[0;31m'
+JAUNE='\033[1;33m'
+CYAN='\033[0;36m'
+NC='\033[0m'
+
+echo -e "${CYAN}==========================================================${NC}"
+echo -e "${CYAN}   PROTOCOLE DE TEST : DURABILITÉ DES UPLOADS (-D)        ${NC}"
+echo -e "${CYAN}==========================================================${NC}"
+
+for bin in "$CLIENT_BIN" ./server_select ./server_thread; do
+    if [ ! -f "$bin" ]; then
+        echo -e "${ROUGE}[ERREUR] Le binaire '$bin' est introuvable. Tapez 'make'.${NC}"
+        exit 1
+    fi
+done
+
+SERVER_PID=""
+arreter_serveur() {
+    [ -n "$SERVER_PID" ] && kill $SERVER_PID 2>/dev/null && wait $SERVER_PID 2>/dev/null
+    SERVER_PID=""
+}
+nettoyer() {
+    arreter_serveur
+    for f in "$CLIENT_DIR"/dur_*.bin; do
+        [ -e "$f" ] && rm -f "$REPO/$(basename "$f")"
+    done
+    rm -rf "$CLIENT_DIR"
+}
+trap nettoyer EXIT
+
+RESULTAT=true
+verifier_vrai() {
+    if "${@:2}"; then
+        echo -e "${VERT}[OK] $1${NC}"
+    else
+        echo -e "${ROUGE}[FAIL] $1${NC}"
+        RESULTAT=false
+    fi
+}
+
+# Pages sales ou en cours d'écriture des fichiers donnés ("-" sans cachestat)
+pages_sales() {
+    python3 - "$@" <<'FIN'
+import ctypes, os, sys
+libc = ctypes.CDLL(None, use_errno=True)
+class Plage(ctypes.Structure):
+    _fields_ = [("off", ctypes.c_uint64), ("len", ctypes.c_uint64)]
+class Etat(ctypes.Structure):
+    _fields_ = [(n, ctypes.c_uint64) for n in ("cache", "sales", "ecriture", "evincees", "recentes")]
+total = 0
+for chemin in sys.argv[1:]:
+    fd = os.open(chemin, os.O_RDONLY)
+    plage, etat = Plage(0, 0), Etat()
+    if libc.syscall(451, fd, ctypes.byref(plage), ctypes.byref(etat), 0) < 0:  # cachestat
+        print("-")
+        sys.exit()
+    os.close(fd)
+    total += etat.sales + etat.ecriture
+print(total)
+FIN
+}
+
+# 1. Fichiers à envoyer, de tailles variées, et leur manifeste
+echo -e "\n${JAUNE}[1/3] Génération de $UPLOADS fichiers...${NC}"
+rm -rf "$CLIENT_DIR"
+mkdir -p $REPO "$CLIENT_DIR"
+for i in $(seq $UPLOADS); do
+    head -c $((RANDOM * 8 + i)) /dev/urandom > "$CLIENT_DIR/dur_$i.bin"
+done
+(cd "$CLIENT_DIR" && printf 'put %s\n' dur_*.bin > manifeste)
+
+# 2. Chaque serveur dans chaque mode
+ETAPE=2
+for serveur in server_select server_thread; do
+    echo -e "\n${JAUNE}[$ETAPE/3] $serveur : $UPLOADS PUT simultanés par mode...${NC}"
+    for mode in none close group; do
+        for f in "$CLIENT_DIR"/dur_*.bin; do rm -f "$REPO/$(basename "$f")"; done
+        stdbuf -oL ./$serveur -D $mode > $JOURNAL 2>&1 &
+        SERVER_PID=$!
+        sleep 0.5
+        (cd "$CLIENT_DIR" && timeout 120 ../$CLIENT_BIN -j $SIMULTANES -f manifeste $SERVER_IP $PORT > /dev/null)
+        CODE=$?
+        SALES=$(pages_sales "$REPO"/dur_*.bin 2>/dev/null)
+        arreter_serveur
+
+        IDENTIQUES=0
+        for f in "$CLIENT_DIR"/dur_*.bin; do
+            cmp -s "$f" "$REPO/$(basename "$f")" && IDENTIQUES=$((IDENTIQUES + 1))
+        done
+        RESTES=$(ls -A "$REPO/.encours" 2>/dev/null | wc -l)
+        verifier_vrai "-D $mode : lot terminé (code $CODE), $IDENTIQUES/$UPLOADS fichiers identiques" \
+            [ $CODE -eq 0 -a $IDENTIQUES -eq $UPLOADS ]
+        verifier_vrai "-D $mode : aucune version temporaire laissée ($RESTES)" [ "$RESTES" -eq 0 ]
+        if [ "$SALES" = "-" ] || [ -z "$SALES" ]; then
+            echo -e "${JAUNE}[--] -D $mode : cachestat indisponible, pages sales non vérifiées${NC}"
+        elif [ $mode = none ]; then
+            echo "[--] -D none : $SALES pages encore à écrire après le dernier ACK (attendu)"
+        else
+            verifier_vrai "-D $mode : rien à écrire après le dernier ACK ($SALES pages)" [ "$SALES" -eq 0 ]
+        fi
+    done
+    ETAPE=$((ETAPE + 1))
+done
+
+echo -e "\n${CYAN}==========================================================${NC}"
+if [ "$RESULTAT" = true ]; then
+    echo -e "${VERT}RÉSULTAT FINAL : TEST RÉUSSI${NC}"
+else
+    echo -e "${ROUGE}RÉSULTAT FINAL : TEST ÉCHOUÉ${NC}"
+fi
+echo -e "${CYAN}==========================================================${NC}"
+[ "$RESULTAT" = true ]
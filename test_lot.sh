@@ -0,0 +1,118 @@
+#!/bin/bash
+
+# Mode lot du client (-f manifeste, -j parallèles) : plusieurs GET et PUT
+# d'un même manifeste dans une seule boucle d'événements.
+# Usage : ./test_lot.sh [fichiers] [parallèles]   (défaut 12 fichiers, -j 4)
+# Le serveur (server_thread ou server_select) doit tourner sur $PORT.
+
+# Configuration
+SERVER_IP="127.0.0.1"
+PORT=69
+REPO=".tftp"
+CLIENT_BIN="$(pwd)/client"
+FICHIERS=${1:-12}
+PARALLELES=${2:-4}
+TMP="lot_test"
+
+# Couleurs pour la lisibilité
+VERT='\033[0;32m'
+ROUGE='\033[0;31m'
+JAUNE='\033[1;33m'
+CYAN='\033[0;36m'
+NC='\033[0m'
+
+echo -e "${CYAN}==========================================================${NC}"
+echo -e "${CYAN}   PROTOCOLE DE TEST : MODE LOT (MANIFESTE)               ${NC}"
+echo -e "${CYAN}==========================================================${NC}"
+
+if [ ! -f "$CLIENT_BIN" ]; then
+    echo -e "${ROUGE}[ERREUR] Le binaire '$CLIENT_BIN' est introuvable. Tapez 'make'.${NC}"
+    exit 1
+fi
+
+# 1. Préparation : des fichiers à télécharger, d'autres à envoyer, de
+# tailles variées (vide, multiple exact d'un bloc, plusieurs blocs)
+echo -e "\n${JAUNE}[1/4] Génération de $FICHIERS fichiers dans chaque sens...${NC}"
+mkdir -p $REPO
+rm -rf $TMP
+mkdir -p $TMP
+for i in $(seq 1 $FICHIERS); do
+    case $((i % 3)) in
+        0) TAILLE=0 ;;
+        1) TAILLE=$((i * 512)) ;;
+        2) TAILLE=$((i * 37000)) ;;
+    esac
+    head -c $TAILLE /dev/urandom > "$REPO/lot_get_$i.bin"
+    head -c $TAILLE /dev/urandom > "$TMP/lot_put_$i.bin"
+done
+{
+    echo "# Manifeste du test : commentaires et lignes vides ignorés"
+    echo ""
+    for i in $(seq 1 $FICHIERS); do
+        echo "get lot_get_$i.bin"
+        echo "  put lot_put_$i.bin"
+    done
+} > $TMP/manifeste.txt
+RESULTAT=true
+
+verifier() {
+    if cmp -s "$1" "$2"; then
+        echo -e "${VERT}[OK] $3${NC}"
+    else
+        echo -e "${ROUGE}[FAIL] $3${NC}"
+        RESULTAT=false
+    fi
+}
+
+verifier_code() {
+    if [ "$1" = "$2" ]; then
+        echo -e "${VERT}[OK] $3${NC}"
+    else
+        echo -e "${ROUGE}[FAIL] $3 (code $1)${NC}"
+        RESULTAT=false
+    fi
+}
+
+# 2. Le manifeste complet, -j parallèles transferts à la fois
+echo -e "\n${JAUNE}[2/4] Lot de $((FICHIERS * 2)) transferts, $PARALLELES en parallèle...${NC}"
+(cd $TMP && $CLIENT_BIN -j $PARALLELES -f manifeste.txt $SERVER_IP $PORT > lot.log)
+verifier_code $? 0 "lot réussi"
+tail -1 $TMP/lot.log
+sleep 0.5
+for i in $(seq 1 $FICHIERS); do
+    verifier "$REPO/lot_get_$i.bin" "$TMP/lot_get_$i.bin" "get lot_get_$i.bin"
+    verifier "$TMP/lot_put_$i.bin" "$REPO/lot_put_$i.bin" "put lot_put_$i.bin"
+done
+
+# 3. Manifeste lu sur l'entrée standard, avec un nom local ; un fichier
+# absent fait échouer le lot, sans empêcher les autres transferts
+echo -e "\n${JAUNE}[3/4] Manifeste sur stdin, avec un fichier absent...${NC}"
+printf "get lot_get_1.bin copie.bin\nget lot_absent.bin\n" |
+    (cd $TMP && $CLIENT_BIN -f - $SERVER_IP $PORT > lot.log)
+verifier_code $? 1 "lot en échec"
+verifier "$REPO/lot_get_1.bin" "$TMP/copie.bin" "get vers un nom local"
+if [ -e "$TMP/lot_absent.bin" ]; then
+    echo -e "${ROUGE}[FAIL] fichier local laissé par un GET échoué${NC}"
+    RESULTAT=false
+fi
+
+# 4. Manifeste invalide : refusé avant tout transfert
+echo -e "\n${JAUNE}[4/4] Manifeste invalide...${NC}"
+rm -f "$TMP/lot_get_2.bin"
+printf "get lot_get_2.bin\ndelete lot_get_3.bin\n" |
+    (cd $TMP && $CLIENT_BIN -f - $SERVER_IP $PORT > /dev/null 2>&1)
+verifier_code $? 1 "manifeste refusé"
+if [ -e "$TMP/lot_get_2.bin" ]; then
+    echo -e "${ROUGE}[FAIL] transfert lancé malgré le manifeste invalide${NC}"
+    RESULTAT=false
+fi
+
+rm -rf $TMP "$REPO"/lot_get_*.bin "$REPO"/lot_put_*.bin
+
+echo -e "\n${CYAN}==========================================================${NC}"
+if [ "$RESULTAT" = true ]; then
+    echo -e "${VERT}RÉSULTAT FINAL : TEST RÉUSSI${NC}"
+else
+    echo -e "${ROUGE}RÉSULTAT FINAL : TEST ÉCHOUÉ${NC}"
+fi
+echo -e "${CYAN}==========================================================${NC}"
@@ -0,0 +1,145 @@
+// Aller-retour du flux lz4 de l'option compress (tftp_lz4.c) : le flux
+// produit trame par trame, comme le cache des variantes, est décodé en
+// morceaux de tailles quelconques, comme le client reçoit ses paquets.
+// Usage : make test_lz4 && ./test_lz4   (code de sortie 0 si tout passe)
+//
+// Couvre les trames stockées (données aléatoires), les tailles autour de
+// la plus petite séquence LZ4 (12, 13, 15, 16 octets) et de LZ4_BLOC, les
+// flux de plusieurs trames, un flux tronqué et des entêtes corrompus.
+
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tftp_lz4.h"
+
+#define TAILLE_MAX (3 * LZ4_BLOC + 7)
+
+static int echecs = 0;
+
+typedef struct {
+    char *buf;
+    size_t len;
+    size_t cap;
+} sortie_t;
+
+static ssize_t recevoir(void *ctx, const char *donnees, size_t len) {
+    sortie_t *s = ctx;
+    if (s->len + len > s->cap) return -1;
+    memcpy(s->buf + s->len, donnees, len);
+    s->len += len;
+    return len;
+}
+
+static void verifier(int ok, const char *quoi, size_t taille, const char *detail) {
+    if (ok) return;
+    printf("[FAIL] %s, %zu octets : %s\n", quoi, taille, detail);
+    echecs++;
+}
+
+// Flux complet de src[0..n), une trame par LZ4_BLOC ; 'stockees' compte
+// les trames brutes
+static size_t encoder(const char *src, size_t n, char *flux, int *stockees) {
+    size_t len = 0;
+    *stockees = 0;
+    for (size_t pos = 0; pos < n; pos += LZ4_BLOC) {
+        size_t k = n - pos < LZ4_BLOC ? n - pos : LZ4_BLOC;
+        size_t t = lz4_trame(src + pos, k, flux + len);
+        uint32_t c;
+        memcpy(&c, flux + len, 4);
+        if (ntohl(c) & LZ4_STOCKE) (*stockees)++;
+        len += t;
+    }
+    return len;
+}
+
+// Décode 'flux' en morceaux de 'morceau' octets (0 : tailles variées)
+static int decoder(const char *flux, size_t len, size_t morceau, sortie_t *s) {
+    static lz4_flux_t f; // ~200 Ko : hors de la pile
+    lz4_flux_init(&f);
+    s->len = 0;
+    size_t varies[] = { 1, 7, 8, 9, 512, 1428, 65464 };
+    for (size_t pos = 0, i = 0; pos < len; i++) {
+        size_t k = morceau ? morceau : varies[i % (sizeof(varies) / sizeof(varies[0]))];
+        if (k > len - pos) k = len - pos;
+        if (lz4_flux_decoder(&f, flux + pos, k, recevoir, s) < 0) return -1;
+        pos += k;
+    }
+    return lz4_flux_complet(&f) ? 0 : 1;
+}
+
+static void aller_retour(const char *quoi, const char *src, size_t n, int stockees_attendues) {
+    static char flux[TAILLE_MAX + (TAILLE_MAX / LZ4_BLOC + 1) * LZ4_TRAME_MAX];
+    static char sortie[TAILLE_MAX];
+    sortie_t s = { sortie, 0, sizeof(sortie) };
+    int stockees;
+    size_t len = encoder(src, n, flux, &stockees);
+    size_t trames = (n + LZ4_BLOC - 1) / LZ4_BLOC;
+    verifier(len <= n + trames * LZ4_ENTETE, quoi, n, "flux plus long que le fichier + entêtes");
+    if (stockees_attendues >= 0) verifier(stockees == stockees_attendues, quoi, n, "trames stockées inattendues");
+
+    size_t morceaux[] = { 0, 1, 3, 512, 65536, (size_t)-1 };
+    for (size_t i = 0; i < sizeof(morceaux) / sizeof(morceaux[0]); i++) {
+        size_t k = morceaux[i] == (size_t)-1 ? (len ? len : 1) : morceaux[i];
+        int r = decoder(flux, len, k, &s);
+        verifier(r == 0, quoi, n, "décodage en erreur ou incomplet");
+        verifier(r == 0 && s.len == n && memcmp(s.buf, src, n) == 0, quoi, n, "contenu différent");
+    }
+
+    // Tronqué : le décodeur attend la suite, le flux n'est pas complet
+    if (len > 0) verifier(decoder(flux, len - 1, 0, &s) == 1, quoi, n, "flux tronqué vu complet");
+}
+
+static void corrompu(const char *quoi, uint32_t charge, uint32_t brut, const char *charge_octets, size_t nb) {
+    char flux[64];
+    uint32_t c = htonl(charge), b = htonl(brut);
+    memcpy(flux, &c, 4);
+    memcpy(flux + 4, &b, 4);
+    memcpy(flux + LZ4_ENTETE, charge_octets, nb);
+    static char sortie[LZ4_BLOC];
+    sortie_t s = { sortie, 0, sizeof(sortie) };
+    verifier(decoder(flux, LZ4_ENTETE + nb, 0, &s) < 0, quoi, nb, "accepté");
+}
+
+int main(void) {
+    static char aleatoire[TAILLE_MAX], motif[TAILLE_MAX], zeros[TAILLE_MAX], mixte[TAILLE_MAX];
+    srand(12345);
+    for (size_t i = 0; i < TAILLE_MAX; i++) {
+        aleatoire[i] = (char)(rand() >> 7);
+        motif[i] = "TFTP-lz4/"[i % 9];
+        // Alternance de zones compressibles et aléatoires, par 4 Ko
+        mixte[i] = (i / 4096) % 2 ? aleatoire[i] : motif[i];
+    }
+
+    size_t tailles[] = { 0, 1, 4, 11, 12, 13, 15, 16, 17, 100, 4096, LZ4_BLOC - 1, LZ4_BLOC, LZ4_BLOC + 1,
+                         2 * LZ4_BLOC, TAILLE_MAX };
+    for (size_t i = 0; i < sizeof(tailles) / sizeof(tailles[0]); i++) {
+        size_t n = tailles[i];
+        int trames = (int)((n + LZ4_BLOC - 1) / LZ4_BLOC);
+        // Aléatoire : toutes les trames sont stockées brutes
+        aller_retour("aléatoire", aleatoire, n, trames);
+        // Compressibles : aucune trame stockée, sauf une dernière trop courte
+        // pour gagner quoi que ce soit (non vérifiée)
+        int reste = (int)(n % LZ4_BLOC);
+        int attendues = reste > 0 && reste < 64 ? -1 : 0;
+        aller_retour("motif", motif, n, attendues);
+        aller_retour("zéros", zeros, n, attendues);
+        aller_retour("mixte", mixte, n, -1);
+    }
+
+    // Entêtes et charges invalides : refusés, sans lecture ni écriture hors bornes
+    corrompu("trame plus longue que LZ4_BLOC", 4, LZ4_BLOC + 1, "abcd", 4);
+    corrompu("charge au-delà de la borne", LZ4_BORNE(LZ4_BLOC) + 1, 16, "", 0);
+    corrompu("stockée de longueur incohérente", LZ4_STOCKE | 4, 5, "abcd", 4);
+    corrompu("distance nulle", 4, 20, "\x10" "a" "\x00\x00", 4);
+    corrompu("distance avant le début", 4, 20, "\x10" "a" "\x05\x00", 4);
+    corrompu("longueur annoncée fausse", 2, 5, "\x10" "a", 2);
+
+    if (echecs) {
+        printf("RÉSULTAT FINAL : TEST ÉCHOUÉ (%d)\n", echecs);
+        return 1;
+    }
+    printf("RÉSULTAT FINAL : TEST RÉUSSI\n");
+    return 0;
+}
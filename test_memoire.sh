@@ -0,0 +1,183 @@
+#!/bin/bash
+
+# Magasin en mémoire (-M mem) sur les deux serveurs : la table est vide au
+# démarrage, même si le fichier existe dans .tftp/, se remplit par des PUT
+# (fichier vide, texte, binaire, en lot), sert les GET qui suivent, y
+# compris avec -z (ignoré), et remplace une version. Un WRQ dont la taille
+# annoncée (tsize) dépasse la mémoire disponible ou le quota -q est refusé,
+# quel que soit l'espace disque. Rien n'est écrit sur le disque.
+# Usage : ./test_memoire.sh   (lance lui-même les serveurs, depuis le dépôt)
+
+# Configuration
+SERVER_IP="127.0.0.1"
+PORT=69
+REPO=".tftp"
+CLIENT_BIN="./client"
+JOURNAL="/tmp/tftp_memoire_server.log"
+CLIENT_DIR="memoire_client"
+LOT=20
+QUOTA=200000              # Au-dessus des fichiers du lot (au plus 131071 octets)
+
+# Couleurs pour la lisibilité
+VERT='\033[0;32m'
+ROUGE='\033[0;31m'
+JAUNE='\033[1;33m'
+CYAN='\033[0;36m'
+NC='\033[0m'
+
+echo -e "${CYAN}==========================================================${NC}"
+echo -e "${CYAN}   PROTOCOLE DE TEST : MAGASIN EN MÉMOIRE (-M mem)        ${NC}"
+echo -e "${CYAN}==========================================================${NC}"
+
+for bin in "$CLIENT_BIN" ./server_select ./server_thread; do
+    if [ ! -f "$bin" ]; then
+        echo -e "${ROUGE}[ERREUR] Le binaire '$bin' est introuvable. Tapez 'make'.${NC}"
+        exit 1
+    fi
+done
+
+SERVER_PID=""
+arreter_serveur() {
+    [ -n "$SERVER_PID" ] && kill $SERVER_PID 2>/dev/null && wait $SERVER_PID 2>/dev/null
+    SERVER_PID=""
+}
+nettoyer() {
+    arreter_serveur
+    rm -rf "$CLIENT_DIR"
+    rm -f "$REPO/mem_disque.bin"
+}
+trap nettoyer EXIT
+
+RESULTAT=true
+verifier() {
+    if cmp -s "$1" "$2"; then
+        echo -e "${VERT}[OK] $3${NC}"
+    else
+        echo -e "${ROUGE}[FAIL] $3${NC}"
+        RESULTAT=false
+    fi
+}
+verifier_vrai() {
+    if "${@:2}"; then
+        echo -e "${VERT}[OK] $1${NC}"
+    else
+        echo -e "${ROUGE}[FAIL] $1${NC}"
+        RESULTAT=false
+    fi
+}
+# WRQ de 'taille' octets annoncés (tsize) ; affiche la réponse du serveur :
+# "oack", ou "error <code>"
+wrq_tsize() {
+    python3 - "$SERVER_IP" "$PORT" "$1" <<'FIN'
+import socket, struct, sys
+ip, port, taille = sys.argv[1], int(sys.argv[2]), sys.argv[3]
+s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+s.settimeout(3)
+s.sendto(struct.pack("!H", 2) + b"mem_tsize.bin\0octet\0tsize\0" + taille.encode() + b"\0", (ip, port))
+paquet, tid = s.recvfrom(1024)
+op, code = struct.unpack("!HH", paquet[:4])
+if op == 5:
+    print("error", code)
+else:
+    s.sendto(struct.pack("!HH", 5, 0) + b"abandon\0", tid)
+    print("oack")
+FIN
+}
+# Client lancé depuis un sous-répertoire : envoi/ pour les PUT, recu/ pour les GET
+client() {
+    (cd "$CLIENT_DIR/$1" && timeout 30 ../../$CLIENT_BIN "${@:2}" > /dev/null)
+}
+
+# 1. Préparation : un fichier présent seulement sur le disque, et les envois
+echo -e "\n${JAUNE}[1/3] Génération des fichiers...${NC}"
+rm -rf "$CLIENT_DIR"
+mkdir -p $REPO "$CLIENT_DIR/envoi" "$CLIENT_DIR/recu"
+head -c 50000 /dev/urandom > "$REPO/mem_disque.bin"
+head -c 300000 /dev/urandom > "$CLIENT_DIR/envoi/mem_a.bin"
+: > "$CLIENT_DIR/envoi/mem_vide.bin"
+yes "ligne de texte compressible" | head -c 200000 > "$CLIENT_DIR/envoi/mem_texte.txt"
+for i in $(seq $LOT); do
+    head -c $((RANDOM * 4 + i)) /dev/urandom > "$CLIENT_DIR/envoi/mem_lot_$i.bin"
+done
+(cd "$CLIENT_DIR/envoi" && printf 'put %s\n' mem_lot_*.bin > ../manifeste_put &&
+ printf 'get %s\n' mem_lot_*.bin > ../manifeste_get)
+AVANT=$(ls -A $REPO | sort | md5sum)
+
+ETAPE=2
+for serveur in server_select server_thread; do
+    echo -e "\n${JAUNE}[$ETAPE/3] $serveur -M mem...${NC}"
+    stdbuf -oL ./$serveur -M mem > $JOURNAL 2>&1 &
+    SERVER_PID=$!
+    sleep 0.5
+    verifier_vrai "magasin annoncé" grep -q "Storage: mem" $JOURNAL
+
+    # Table vide : le fichier du disque n'est pas servi
+    rm -f "$CLIENT_DIR/recu/mem_disque.bin"
+    client recu $SERVER_IP get mem_disque.bin $PORT
+    CODE=$?
+    verifier_vrai "fichier de .tftp/ non servi (code $CODE)" [ $CODE -ne 0 ]
+
+    # Aller-retour : binaire, vide, texte (et -z, sans effet sous mem)
+    rm -f "$CLIENT_DIR"/recu/*
+    for f in mem_a.bin mem_vide.bin mem_texte.txt; do
+        client envoi $SERVER_IP put $f $PORT
+        client recu $SERVER_IP get $f $PORT
+        verifier "$CLIENT_DIR/envoi/$f" "$CLIENT_DIR/recu/$f" "PUT puis GET de $f"
+    done
+    rm -f "$CLIENT_DIR/recu/mem_texte.txt"
+    client recu -z $SERVER_IP get mem_texte.txt $PORT
+    verifier "$CLIENT_DIR/envoi/mem_texte.txt" "$CLIENT_DIR/recu/mem_texte.txt" "GET -z de mem_texte.txt"
+
+    # Remplacement : la nouvelle version est servie
+    head -c 5000 /dev/urandom > "$CLIENT_DIR/envoi/mem_a.bin"
+    client envoi $SERVER_IP put mem_a.bin $PORT
+    rm -f "$CLIENT_DIR/recu/mem_a.bin"
+    client recu $SERVER_IP get mem_a.bin $PORT
+    verifier "$CLIENT_DIR/envoi/mem_a.bin" "$CLIENT_DIR/recu/mem_a.bin" "version remplacée"
+
+    # Lot : PUT puis GET simultanés
+    (cd "$CLIENT_DIR/envoi" && timeout 60 ../../$CLIENT_BIN -j 8 -f ../manifeste_put $SERVER_IP $PORT > /dev/null)
+    (cd "$CLIENT_DIR/recu" && timeout 60 ../../$CLIENT_BIN -j 8 -f ../manifeste_get $SERVER_IP $PORT > /dev/null)
+    IDENTIQUES=0
+    for i in $(seq $LOT); do
+        cmp -s "$CLIENT_DIR/envoi/mem_lot_$i.bin" "$CLIENT_DIR/recu/mem_lot_$i.bin" && IDENTIQUES=$((IDENTIQUES + 1))
+    done
+    verifier_vrai "lot : $IDENTIQUES/$LOT fichiers identiques" [ $IDENTIQUES -eq $LOT ]
+
+    # tsize entre la mémoire disponible et l'espace disque libre : seule la
+    # mémoire compte, que le disque ait plus ou moins de place
+    MEMOIRE=$(( $(awk '/^MemAvailable:/ { print $2 }' /proc/meminfo) * 1024 ))
+    DISQUE=$(( $(stat -f -c '%a * %S' $REPO) ))
+    TSIZE=$(( MEMOIRE / 2 + DISQUE / 2 ))
+    REPONSE=$(wrq_tsize $TSIZE)
+    if [ "$DISQUE" -gt "$MEMOIRE" ]; then
+        verifier_vrai "tsize de $TSIZE octets, plus que la mémoire : refusé ($REPONSE)" [ "$REPONSE" = "error 3" ]
+    else
+        verifier_vrai "tsize de $TSIZE octets, plus que le disque : accepté ($REPONSE)" [ "$REPONSE" = "oack" ]
+    fi
+    arreter_serveur
+
+    # Quota : le WRQ annoncé trop gros est refusé, le plus petit passe
+    stdbuf -oL ./$serveur -M mem -q $QUOTA > $JOURNAL 2>&1 &
+    SERVER_PID=$!
+    sleep 0.5
+    REPONSE=$(wrq_tsize $((QUOTA + 1)))
+    verifier_vrai "-q $QUOTA : tsize de $((QUOTA + 1)) octets refusé ($REPONSE)" [ "$REPONSE" = "error 3" ]
+    client envoi $SERVER_IP put mem_lot_1.bin $PORT
+    rm -f "$CLIENT_DIR/recu/mem_lot_1.bin"
+    client recu $SERVER_IP get mem_lot_1.bin $PORT
+    verifier "$CLIENT_DIR/envoi/mem_lot_1.bin" "$CLIENT_DIR/recu/mem_lot_1.bin" "-q $QUOTA : PUT sous le quota"
+    arreter_serveur
+
+    verifier_vrai "rien d'écrit dans $REPO/" [ "$(ls -A $REPO | sort | md5sum)" = "$AVANT" ]
+    ETAPE=$((ETAPE + 1))
+done
+
+echo -e "\n${CYAN}==========================================================${NC}"
+if [ "$RESULTAT" = true ]; then
+    echo -e "${VERT}RÉSULTAT FINAL : TEST RÉUSSI${NC}"
+else
+    echo -e "${ROUGE}RÉSULTAT FINAL : TEST ÉCHOUÉ${NC}"
+fi
+echo -e "${CYAN}==========================================================${NC}"
+[ "$RESULTAT" = true ]
@@ -0,0 +1,77 @@
+#!/bin/bash
+
+# Téléchargement multicast (RFC 2090) d'une même image par plusieurs clients
+# qui arrivent les uns après les autres : le fichier est diffusé une fois,
+# les retardataires récupèrent ensuite les blocs manqués.
+# Usage : ./test_multicast.sh [clients] [taille]   (défaut 5 clients, 30M)
+# Le serveur doit tourner avec le multicast activé : ./server_select -m 239.255.0.1
+# Sur loopback, le groupe est émis et rejoint sur lo ; sur un lien veth,
+# lancer les clients dans l'espace de noms réseau pair.
+
+# Configuration
+SERVER_IP="127.0.0.1"
+PORT=69
+REPO=".tftp"
+CLIENT_BIN="$(pwd)/client"
+CLIENTS=${1:-5}
+TAILLE=${2:-30M}
+FICHIER="boot_image.bin"
+TMP="mcast_test"
+
+# Couleurs pour la lisibilité
+VERT='\033[0;32m'
+ROUGE='\033[0;31m'
+JAUNE='\033[1;33m'
+CYAN='\033[0;36m'
+NC='\033[0m'
+
+echo -e "${CYAN}==========================================================${NC}"
+echo -e "${CYAN}   PROTOCOLE DE TEST : TÉLÉCHARGEMENT MULTICAST           ${NC}"
+echo -e "${CYAN}==========================================================${NC}"
+
+if [ ! -f "$CLIENT_BIN" ]; then
+    echo -e "${ROUGE}[ERREUR] Le binaire '$CLIENT_BIN' est introuvable. Tapez 'make'.${NC}"
+    exit 1
+fi
+
+# 1. Préparation
+echo -e "\n${JAUNE}[1/3] Génération d'une image de $TAILLE...${NC}"
+mkdir -p $REPO
+head -c "$TAILLE" /dev/urandom > "$REPO/$FICHIER"
+rm -rf $TMP
+
+# 2. Démarrages échelonnés : chaque client dans son propre répertoire
+echo -e "\n${JAUNE}[2/3] Lancement de $CLIENTS clients...${NC}"
+PIDS=""
+for i in $(seq 1 $CLIENTS); do
+    mkdir -p $TMP/$i
+    (cd $TMP/$i && $CLIENT_BIN -m $SERVER_IP get $FICHIER $PORT > log.txt 2>&1) &
+    PIDS="$PIDS $!"
+    sleep 0.2
+done
+wait $PIDS
+
+# 3. Vérification
+echo -e "\n${JAUNE}[3/3] Vérification des copies...${NC}"
+RESULTAT=true
+for i in $(seq 1 $CLIENTS); do
+    if cmp -s "$REPO/$FICHIER" "$TMP/$i/$FICHIER"; then
+        ROLE=$(grep -q "Promu" $TMP/$i/log.txt && echo "retardataire, promu maître" || echo "premier maître")
+        grep -q "rejoint" $TMP/$i/log.txt || ROLE="unicast : multicast refusé par le serveur"
+        echo -e "${VERT}[OK] Client $i ($ROLE)${NC}"
+    else
+        echo -e "${ROUGE}[FAIL] Client $i : copie différente ou absente (voir $TMP/$i/log.txt)${NC}"
+        RESULTAT=false
+    fi
+done
+
+[ "$RESULTAT" = true ] && rm -rf $TMP
+rm -f "$REPO/$FICHIER"
+
+echo -e "\n${CYAN}==========================================================${NC}"
+if [ "$RESULTAT" = true ]; then
+    echo -e "${VERT}RÉSULTAT FINAL : TEST RÉUSSI${NC}"
+else
+    echo -e "${ROUGE}RÉSULTAT FINAL : TEST ÉCHOUÉ${NC}"
+fi
+echo -e "${CYAN}==========================================================${NC}"
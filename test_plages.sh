@@ -0,0 +1,142 @@
+#!/bin/bash
+
+# Plages d'octets (options offset et length) : bornage par le serveur,
+# reprise (-c) et segments parallèles (-p) du client.
+# Usage : ./test_plages.sh [taille]   (défaut 3M)
+# Le serveur (server_thread ou server_select) doit tourner sur $PORT.
+# Les RRQ à plage arbitraire sont envoyés par un petit client python3,
+# le client C ne demandant que des plages cohérentes avec le fichier.
+
+# Configuration
+SERVER_IP="127.0.0.1"
+PORT=69
+REPO=".tftp"
+CLIENT_BIN="./client"
+TAILLE=${1:-3M}
+FICHIER="plages_test.bin"
+
+# Couleurs pour la lisibilité
+VERT='\033[0;32m'
+ROUGE='\033[0;31m'
+JAUNE='\033[1;33m'
+CYAN='\033[0;36m'
+NC='\033[0m'
+
+echo -e "${CYAN}==========================================================${NC}"
+echo -e "${CYAN}   PROTOCOLE DE TEST : PLAGES D'OCTETS (OFFSET, LENGTH)   ${NC}"
+echo -e "${CYAN}==========================================================${NC}"
+
+if [ ! -f "$CLIENT_BIN" ]; then
+    echo -e "${ROUGE}[ERREUR] Le binaire '$CLIENT_BIN' est introuvable. Tapez 'make'.${NC}"
+    exit 1
+fi
+
+RESULTAT=true
+verifier() {
+    if cmp -s "$1" "$2"; then
+        echo -e "${VERT}[OK] $3${NC}"
+    else
+        echo -e "${ROUGE}[FAIL] $3${NC}"
+        RESULTAT=false
+    fi
+}
+verifier_vrai() {
+    if "${@:2}"; then
+        echo -e "${VERT}[OK] $1${NC}"
+    else
+        echo -e "${ROUGE}[FAIL] $1${NC}"
+        RESULTAT=false
+    fi
+}
+
+# RRQ octet avec offset et length ; écrit les données reçues dans $3 et
+# affiche les valeurs accordées par l'OACK : "<offset> <length>"
+plage() {
+    python3 - "$1" "$2" "$3" "$SERVER_IP" "$PORT" "$FICHIER" <<'FIN'
+import socket, struct, sys
+offset, length, sortie, ip, port, nom = sys.argv[1:7]
+s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+s.settimeout(3)
+rrq = struct.pack("!H", 1) + b"\0".join([nom.encode(), b"octet", b"offset", offset.encode(),
+                                         b"length", length.encode()]) + b"\0"
+s.sendto(rrq, (ip, int(port)))
+paquet, tid = s.recvfrom(65536)
+if struct.unpack("!H", paquet[:2])[0] != 6:
+    sys.exit("pas d'OACK : " + repr(paquet[:64]))
+champs = paquet[2:].split(b"\0")
+accord = {champs[i].decode().lower(): champs[i + 1].decode() for i in range(0, len(champs) - 1, 2)}
+s.sendto(struct.pack("!HH", 4, 0), tid)
+attendu, donnees = 1, bytearray()
+while True:
+    paquet, _ = s.recvfrom(65536)
+    op, bloc = struct.unpack("!HH", paquet[:4])
+    if op != 3:
+        sys.exit("ERROR reçu : " + repr(paquet[4:]))
+    if bloc == attendu:
+        donnees += paquet[4:]
+        attendu = (attendu + 1) & 0xFFFF
+    s.sendto(struct.pack("!HH", 4, bloc), tid)
+    if bloc == (attendu - 1) & 0xFFFF and len(paquet) - 4 < 512:
+        break
+open(sortie, "wb").write(donnees)
+print(accord.get("offset", "-"), accord.get("length", "-"))
+FIN
+}
+
+# 1. Préparation : contenu aléatoire, pour qu'un octet décalé soit détecté
+echo -e "\n${JAUNE}[1/6] Génération d'un fichier de $TAILLE...${NC}"
+mkdir -p $REPO
+head -c "$TAILLE" /dev/urandom > "$REPO/$FICHIER"
+N=$(stat -c %s "$REPO/$FICHIER")
+rm -f "$FICHIER" plage.bin attendu.bin
+
+# 2. Plage intérieure : accordée telle quelle
+echo -e "\n${JAUNE}[2/6] Plage intérieure (offset 1000000, length 12345)...${NC}"
+ACCORD=$(plage 1000000 12345 plage.bin)
+tail -c +1000001 "$REPO/$FICHIER" | head -c 12345 > attendu.bin
+verifier_vrai "OACK offset 1000000 length 12345 ($ACCORD)" [ "$ACCORD" = "1000000 12345" ]
+verifier attendu.bin plage.bin "octets de la plage"
+
+# 3. length au-delà de la fin : ramenée à ce qui reste
+echo -e "\n${JAUNE}[3/6] length au-delà de la fin (offset N-100, length 5000)...${NC}"
+ACCORD=$(plage $((N - 100)) 5000 plage.bin)
+tail -c 100 "$REPO/$FICHIER" > attendu.bin
+verifier_vrai "OACK offset $((N - 100)) length 100 ($ACCORD)" [ "$ACCORD" = "$((N - 100)) 100" ]
+verifier attendu.bin plage.bin "100 derniers octets"
+
+# 4. offset au-delà de la fin : ramené à la taille, aucun octet envoyé
+echo -e "\n${JAUNE}[4/6] offset au-delà de la fin (offset N+5000)...${NC}"
+ACCORD=$(plage $((N + 5000)) 10 plage.bin)
+verifier_vrai "OACK offset $N length 0 ($ACCORD)" [ "$ACCORD" = "$N 0" ]
+verifier_vrai "aucun octet reçu" [ ! -s plage.bin ]
+
+# 5. Reprise : la suite d'un fichier partiel, puis un fichier local trop long
+echo -e "\n${JAUNE}[5/6] Reprise (-c)...${NC}"
+head -c 1234567 "$REPO/$FICHIER" > "$FICHIER"
+$CLIENT_BIN -c $SERVER_IP get $FICHIER $PORT > /dev/null
+verifier "$REPO/$FICHIER" "$FICHIER" "reprise à 1234567 octets"
+$CLIENT_BIN -c $SERVER_IP get $FICHIER $PORT > /dev/null
+verifier "$REPO/$FICHIER" "$FICHIER" "reprise d'un fichier déjà complet"
+head -c 1000 /dev/urandom >> "$FICHIER"
+cp "$FICHIER" attendu.bin
+$CLIENT_BIN -c $SERVER_IP get $FICHIER $PORT > /dev/null
+CODE=$?
+verifier_vrai "fichier local plus long refusé (code $CODE)" [ $CODE -ne 0 ]
+verifier attendu.bin "$FICHIER" "fichier local conservé"
+
+# 6. Segments parallèles, écrits à leur place dans le même fichier
+echo -e "\n${JAUNE}[6/6] Segments parallèles (-p 4)...${NC}"
+rm -f "$FICHIER"
+$CLIENT_BIN -p 4 $SERVER_IP get $FICHIER $PORT > /dev/null
+verifier "$REPO/$FICHIER" "$FICHIER" "GET en 4 segments"
+
+rm -f "$FICHIER" "$REPO/$FICHIER" plage.bin attendu.bin
+
+echo -e "\n${CYAN}==========================================================${NC}"
+if [ "$RESULTAT" = true ]; then
+    echo -e "${VERT}RÉSULTAT FINAL : TEST RÉUSSI${NC}"
+else
+    echo -e "${ROUGE}RÉSULTAT FINAL : TEST ÉCHOUÉ${NC}"
+fi
+echo -e "${CYAN}==========================================================${NC}"
+[ "$RESULTAT" = true ]
@@ -0,0 +1,166 @@
+#!/bin/bash
+
+# Redémarrage à chaud (-H) : un nouveau serveur reprend le port 69 pendant
+# des transferts. Entre deux server_select, les sessions en cours (un GET
+# et un PUT) sont passées au nouveau processus et vont au bout ; avec
+# server_thread, l'ancien processus termine les siennes (vidange). Dans
+# les deux cas une requête faite juste après l'échange aboutit.
+# Usage : ./test_relais.sh   (lance lui-même les serveurs, depuis le dépôt)
+# Nécessite python3.
+
+# Configuration
+SERVER_IP="127.0.0.1"
+PORT=69
+REPO=".tftp"
+CLIENT_BIN="./client"
+RELAIS="/tmp/tftp_relais_test.sock"
+DEBIT="600k"              # Débit par client : les transferts durent ~5 s
+JOURNAL_ANCIEN="/tmp/tftp_relais_ancien.log"
+JOURNAL_NOUVEAU="/tmp/tftp_relais_nouveau.log"
+CLIENT_DIR="relais_client"
+
+# Couleurs pour la lisibilité
+VERT='\033[0;32m'
+ROUGE='\033[0;31m'
+JAUNE='\033[1;33m'
+CYAN='\033[0;36m'
+NC='\033[0m'
+
+echo -e "${CYAN}==========================================================${NC}"
+echo -e "${CYAN}   PROTOCOLE DE TEST : REDÉMARRAGE À CHAUD (-H)           ${NC}"
+echo -e "${CYAN}==========================================================${NC}"
+
+for bin in "$CLIENT_BIN" ./server_select ./server_thread; do
+    if [ ! -f "$bin" ]; then
+        echo -e "${ROUGE}[ERREUR] Le binaire '$bin' est introuvable. Tapez 'make'.${NC}"
+        exit 1
+    fi
+done
+
+ANCIEN=""
+NOUVEAU=""
+arreter_serveurs() {
+    for pid in $ANCIEN $NOUVEAU; do kill $pid 2>/dev/null && wait $pid 2>/dev/null; done
+    ANCIEN=""
+    NOUVEAU=""
+    rm -f "$RELAIS"
+}
+nettoyer() {
+    arreter_serveurs
+    rm -rf "$CLIENT_DIR"
+    rm -f "$REPO/relais_get.bin" "$REPO/relais_apres.bin" "$REPO/relais_put.bin"
+}
+trap nettoyer EXIT
+
+RESULTAT=true
+verifier() {
+    if cmp -s "$1" "$2"; then
+        echo -e "${VERT}[OK] $3${NC}"
+    else
+        echo -e "${ROUGE}[FAIL] $3${NC}"
+        RESULTAT=false
+    fi
+}
+verifier_vrai() {
+    if "${@:2}"; then
+        echo -e "${VERT}[OK] $1${NC}"
+    else
+        echo -e "${ROUGE}[FAIL] $1${NC}"
+        RESULTAT=false
+    fi
+}
+# Processus sorti (zombie compris : le script ne l'a pas encore attendu)
+termine() {
+    ! grep -qs '^State:[[:space:]]*[^Z]' /proc/$1/status
+}
+client() {
+    (cd "$CLIENT_DIR" && timeout 60 ../$CLIENT_BIN "$@" > /dev/null)
+}
+
+# PUT lent, un bloc de 512 octets toutes les 5 ms : il est sûrement en
+# cours au moment de l'échange, quelle que soit la vitesse de la machine
+put_lent() {
+    python3 - "$SERVER_IP" "$PORT" "$1" "$CLIENT_DIR/$1" <<'FIN'
+import socket, struct, sys, time
+ip, port, nom, chemin = sys.argv[1], int(sys.argv[2]), sys.argv[3], sys.argv[4]
+donnees = open(chemin, "rb").read()
+s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+s.settimeout(1)
+def echanger(paquet, dest, bloc):
+    for essai in range(10):
+        s.sendto(paquet, dest)
+        try:
+            while True:
+                reponse, tid = s.recvfrom(1024)
+                op, n = struct.unpack("!HH", reponse[:4])
+                if op == 5: sys.exit("ERROR : " + repr(reponse[4:]))
+                if op == 4 and n == bloc: return tid
+        except socket.timeout:
+            pass
+    sys.exit("pas d'ACK %d" % bloc)
+tid = echanger(struct.pack("!H", 2) + nom.encode() + b"\0octet\0", (ip, port), 0)
+for bloc in range(1, len(donnees) // 512 + 2):
+    echanger(struct.pack("!HH", 3, bloc) + donnees[(bloc - 1) * 512:bloc * 512], tid, bloc)
+    time.sleep(0.005)
+FIN
+}
+
+# Un GET (limité par le débit du serveur) et un PUT lent en cours, puis le
+# nouveau serveur, lancé dans le même répertoire
+relayer() {
+    rm -f "$REPO/relais_put.bin" "$CLIENT_DIR/relais_get.bin" "$CLIENT_DIR/relais_apres.bin"
+    stdbuf -oL ./$1 -H "$RELAIS" -b $DEBIT > $JOURNAL_ANCIEN 2>&1 &
+    ANCIEN=$!
+    sleep 0.5
+    client $SERVER_IP get relais_get.bin $PORT &
+    GET_PID=$!
+    put_lent relais_put.bin &
+    PUT_PID=$!
+    sleep 1.5
+    stdbuf -oL ./$2 -H "$RELAIS" -b $DEBIT > $JOURNAL_NOUVEAU 2>&1 &
+    NOUVEAU=$!
+    sleep 0.5
+    client $SERVER_IP get relais_apres.bin $PORT
+    verifier "$REPO/relais_apres.bin" "$CLIENT_DIR/relais_apres.bin" "GET juste après l'échange"
+    wait $GET_PID
+    verifier "$REPO/relais_get.bin" "$CLIENT_DIR/relais_get.bin" "GET en cours pendant l'échange"
+    wait $PUT_PID
+    sleep 0.3
+    verifier "$CLIENT_DIR/relais_put.bin" "$REPO/relais_put.bin" "PUT en cours pendant l'échange"
+    sleep 1
+    verifier_vrai "l'ancien processus s'est arrêté" termine $ANCIEN
+    verifier_vrai "le nouveau processus sert le port" kill -0 $NOUVEAU
+    RESTES=$(ls -A "$REPO/.encours" 2>/dev/null | wc -l)
+    verifier_vrai "aucune version temporaire laissée ($RESTES)" [ "$RESTES" -eq 0 ]
+}
+
+# 1. Préparation : contenu aléatoire, pour qu'un bloc décalé soit détecté
+echo -e "\n${JAUNE}[1/3] Génération des fichiers...${NC}"
+mkdir -p $REPO "$CLIENT_DIR"
+rm -f "$RELAIS"
+head -c 3000000 /dev/urandom > "$REPO/relais_get.bin"
+head -c 300000 /dev/urandom > "$REPO/relais_apres.bin"
+head -c 600000 /dev/urandom > "$CLIENT_DIR/relais_put.bin"
+
+# 2. server_select -> server_select : les sessions passent au nouveau
+echo -e "\n${JAUNE}[2/3] server_select -> server_select (sessions passées)...${NC}"
+relayer server_select server_select
+verifier_vrai "deux sessions passées" grep -q "2/2 sessions and 0 groups handed over" $JOURNAL_ANCIEN
+verifier_vrai "sessions reprises par le nouveau" grep -q "Took over port $PORT, 2 sessions" $JOURNAL_NOUVEAU
+arreter_serveurs
+
+# 3. server_thread -> server_thread : vidange par l'ancien processus
+echo -e "\n${JAUNE}[3/3] server_thread -> server_thread (vidange)...${NC}"
+relayer server_thread server_thread
+verifier_vrai "vidange de l'ancien" grep -q "Drained, exiting" $JOURNAL_ANCIEN
+verifier_vrai "port repris par le nouveau" grep -q "Took over port $PORT" $JOURNAL_NOUVEAU
+arreter_serveurs
+
+echo -e "\n${CYAN}==========================================================${NC}"
+if [ "$RESULTAT" = true ]; then
+    echo -e "${VERT}RÉSULTAT FINAL : TEST RÉUSSI${NC}"
+else
+    echo -e "${ROUGE}RÉSULTAT FINAL : TEST ÉCHOUÉ${NC}"
+fi
+echo -e "${CYAN}==========================================================${NC}"
+[ "$RESULTAT" = true ]
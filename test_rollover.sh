@@ -0,0 +1,103 @@
+#!/bin/bash
+
+# Transfert de fichiers de plus de 32 Mo (65535 blocs de 512 octets) :
+# vérifie le rollover des numéros de bloc dans les deux sens, sur chacun
+# des serveurs donnés.
+# Usage : ./test_rollover.sh [taille] [serveurs]
+#   (défaut 4200M, soit > 4 Go, sur "server_select server_thread")
+# Lance lui-même chaque serveur. Compter ~7 min par serveur à 4200M sur
+# loopback, et trois fois la taille en espace disque libre.
+# Les blocs restent à 512 octets (-b 512) : sur loopback, la taille choisie
+# d'après le MTU ne laisserait pas dépasser 65535 blocs.
+
+# Configuration
+SERVER_IP="127.0.0.1"
+PORT=69
+REPO=".tftp"
+CLIENT_BIN="./client"
+CLIENT_OPTS="-b 512"
+TAILLE=${1:-4200M}
+SERVEURS=${2:-"server_select server_thread"}
+JOURNAL="/tmp/tftp_rollover_server.log"
+FICHIER="rollover_test.bin"
+
+# Couleurs pour la lisibilité
+VERT='\033[0;32m'
+ROUGE='\033[0;31m'
+JAUNE='\033[1;33m'
+CYAN='\033[0;36m'
+NC='\033[0m'
+
+echo -e "${CYAN}==========================================================${NC}"
+echo -e "${CYAN}   PROTOCOLE DE TEST : ROLLOVER DES NUMÉROS DE BLOC       ${NC}"
+echo -e "${CYAN}==========================================================${NC}"
+
+for bin in "$CLIENT_BIN" $(printf './%s ' $SERVEURS); do
+    if [ ! -f "$bin" ]; then
+        echo -e "${ROUGE}[ERREUR] Le binaire '$bin' est introuvable. Tapez 'make'.${NC}"
+        exit 1
+    fi
+done
+
+SERVER_PID=""
+arreter_serveur() {
+    [ -n "$SERVER_PID" ] && kill $SERVER_PID 2>/dev/null && wait $SERVER_PID 2>/dev/null
+    SERVER_PID=""
+}
+nettoyer() {
+    arreter_serveur
+    rm -f "$FICHIER" "$REPO/$FICHIER" "$REPO/$FICHIER.orig"
+}
+trap nettoyer EXIT
+
+RESULTAT=true
+verifier() {
+    if cmp -s "$1" "$2"; then
+        echo -e "${VERT}[OK] $3${NC}"
+    else
+        echo -e "${ROUGE}[FAIL] $3${NC}"
+        RESULTAT=false
+    fi
+}
+
+# 1. Préparation : contenu aléatoire, pour qu'un bloc décalé soit détecté
+ETAPES=$(( $(echo $SERVEURS | wc -w) + 1 ))
+echo -e "\n${JAUNE}[1/$ETAPES] Génération d'un fichier de $TAILLE...${NC}"
+mkdir -p $REPO
+head -c "$TAILLE" /dev/urandom > "$REPO/$FICHIER.orig"
+
+# 2. Chaque serveur : GET avec le rollover par défaut (65535 -> 0), puis
+# négocié (65535 -> 1), et PUT reçu par le serveur au-delà du bloc 65535
+ETAPE=2
+for serveur in $SERVEURS; do
+    echo -e "\n${JAUNE}[$ETAPE/$ETAPES] $serveur...${NC}"
+    cp "$REPO/$FICHIER.orig" "$REPO/$FICHIER"
+    rm -f "$FICHIER"
+    stdbuf -oL ./$serveur > $JOURNAL 2>&1 &
+    SERVER_PID=$!
+    sleep 0.5
+
+    time $CLIENT_BIN $CLIENT_OPTS $SERVER_IP get $FICHIER $PORT > /dev/null
+    verifier "$REPO/$FICHIER.orig" "$FICHIER" "$serveur : GET rollover 0"
+
+    rm -f "$FICHIER"
+    time $CLIENT_BIN $CLIENT_OPTS -r 1 $SERVER_IP get $FICHIER $PORT > /dev/null
+    verifier "$REPO/$FICHIER.orig" "$FICHIER" "$serveur : GET rollover 1"
+
+    rm -f "$REPO/$FICHIER"
+    time $CLIENT_BIN $CLIENT_OPTS $SERVER_IP put $FICHIER $PORT > /dev/null
+    sleep 0.5
+    verifier "$REPO/$FICHIER.orig" "$REPO/$FICHIER" "$serveur : PUT rollover 0"
+
+    arreter_serveur
+    ETAPE=$((ETAPE + 1))
+done
+
+echo -e "\n${CYAN}==========================================================${NC}"
+if [ "$RESULTAT" = true ]; then
+    echo -e "${VERT}RÉSULTAT FINAL : TEST RÉUSSI${NC}"
+else
+    echo -e "${ROUGE}RÉSULTAT FINAL : TEST ÉCHOUÉ${NC}"
+fi
+echo -e "${CYAN}==========================================================${NC}"
+[ "$RESULTAT" = true ]
@@ -0,0 +1,170 @@
+#!/bin/bash
+
+# Saturation du pool d'ouvriers de server_thread : une rafale de RRQ jamais
+# acquittés occupe tous les ouvriers (OUVRIERS_MAX) puis remplit la file
+# (FILE_REQUETES). Les requêtes en trop doivent recevoir tout de suite un
+# ERROR "Server busy", le serveur doit rester disponible une fois la
+# rafale abandonnée, et les ouvriers en surnombre s'arrêter ensuite.
+# Usage : ./test_saturation.sh [requetes]   (défaut 3000, plus que 2 x 1024)
+# Lance lui-même server_thread ; nécessite python3. Compter ~1 min :
+# l'arrêt des ouvriers inactifs prend OUVRIER_INACTIF_SEC (30 s).
+
+# Configuration
+SERVER_IP="127.0.0.1"
+PORT=69
+REPO=".tftp"
+CLIENT_BIN="./client"
+SERVER_BIN="./server_thread"
+OUVRIERS=8
+REQUETES=${1:-3000}
+JOURNAL="/tmp/tftp_saturation_server.log"
+FICHIER="saturation_test.bin"
+
+# Couleurs pour la lisibilité
+VERT='\033[0;32m'
+ROUGE='\033[0;31m'
+JAUNE='\033[1;33m'
+CYAN='\033[0;36m'
+NC='\033[0m'
+
+echo -e "${CYAN}==========================================================${NC}"
+echo -e "${CYAN}   PROTOCOLE DE TEST : SATURATION DU POOL D'OUVRIERS      ${NC}"
+echo -e "${CYAN}==========================================================${NC}"
+
+for bin in "$CLIENT_BIN" "$SERVER_BIN"; do
+    if [ ! -f "$bin" ]; then
+        echo -e "${ROUGE}[ERREUR] Le binaire '$bin' est introuvable. Tapez 'make'.${NC}"
+        exit 1
+    fi
+done
+
+SERVER_PID=""
+nettoyer() {
+    [ -n "$SERVER_PID" ] && kill $SERVER_PID 2>/dev/null && wait $SERVER_PID 2>/dev/null
+    rm -f "$FICHIER" "$REPO/$FICHIER"
+}
+trap nettoyer EXIT
+
+RESULTAT=true
+verifier() {
+    if cmp -s "$1" "$2"; then
+        echo -e "${VERT}[OK] $3${NC}"
+    else
+        echo -e "${ROUGE}[FAIL] $3${NC}"
+        RESULTAT=false
+    fi
+}
+verifier_vrai() {
+    if "${@:2}"; then
+        echo -e "${VERT}[OK] $1${NC}"
+    else
+        echo -e "${ROUGE}[FAIL] $1${NC}"
+        RESULTAT=false
+    fi
+}
+threads() {
+    awk '/^Threads:/ { print $2 }' /proc/$SERVER_PID/status
+}
+
+# 1. Serveur avec -w 8 ; un ouvrier par session et ses descripteurs
+echo -e "\n${JAUNE}[1/4] Démarrage de server_thread -w $OUVRIERS...${NC}"
+mkdir -p $REPO
+head -c 100000 /dev/urandom > "$REPO/$FICHIER"
+ulimit -n 8192
+stdbuf -oL $SERVER_BIN -w $OUVRIERS > $JOURNAL 2>&1 &
+SERVER_PID=$!
+sleep 0.5
+if ! kill -0 $SERVER_PID 2>/dev/null; then
+    echo -e "${ROUGE}[ERREUR] Le serveur ne démarre pas (voir $JOURNAL).${NC}"
+    exit 1
+fi
+AU_REPOS=$(threads)
+
+# 2. Rafale : chaque RRQ vient de sa propre socket (son propre TID) et
+# n'est jamais acquitté ; les DATA reçus sont abandonnés par un ERROR une
+# fois la rafale comptée, ce qui libère les ouvriers pour la file
+echo -e "\n${JAUNE}[2/4] Rafale de $REQUETES RRQ sans ACK...${NC}"
+BILAN=$(python3 - "$REQUETES" "$SERVER_IP" "$PORT" "$FICHIER" "$SERVER_PID" <<'FIN'
+import resource, select, socket, struct, sys, time
+n, ip, port, nom, pid = int(sys.argv[1]), sys.argv[2], int(sys.argv[3]), sys.argv[4], sys.argv[5]
+resource.setrlimit(resource.RLIMIT_NOFILE, (n + 64, resource.getrlimit(resource.RLIMIT_NOFILE)[1]))
+def threads():
+    for ligne in open("/proc/%s/status" % pid):
+        if ligne.startswith("Threads:"):
+            return int(ligne.split()[1])
+    return 0
+rrq = struct.pack("!H", 1) + nom.encode() + b"\0octet\0"
+abandon = struct.pack("!HH", 5, 0) + b"abandon\0"
+par_fd, envoi, ep = {}, {}, select.epoll()
+for i in range(n):
+    s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    s.setblocking(False)
+    s.sendto(rrq, (ip, port))
+    par_fd[s.fileno()] = s
+    envoi[s.fileno()] = time.time()
+    ep.register(s.fileno(), select.EPOLLIN)
+etat, tid_de = {}, {}   # Première réponse de chaque requête ; TID des sessions
+debut = dernier = time.time()
+pic, occupe_vite, liberes = 0, 0, False
+while time.time() - dernier < 3:
+    pic = max(pic, threads())
+    for fd, _ in ep.poll(0.1):
+        try:
+            paquet, tid = par_fd[fd].recvfrom(1024)
+        except BlockingIOError:
+            continue
+        dernier = time.time()
+        op, code = struct.unpack("!HH", paquet[:4])
+        if op == 3:
+            tid_de[fd] = tid
+            if liberes: par_fd[fd].sendto(abandon, tid)
+        if fd in etat: continue
+        if op == 3:
+            etat[fd] = "data"
+        elif op == 5 and code == 0 and b"busy" in paquet:
+            etat[fd] = "busy"
+            if time.time() - envoi[fd] < 1: occupe_vite += 1
+        else:
+            etat[fd] = "autre"
+    # Une rafale déborde le tampon de réception du port 69 : comme un
+    # client, on renvoie le RRQ resté sans réponse
+    for fd in par_fd:
+        if fd not in etat and time.time() - envoi[fd] > 1:
+            par_fd[fd].sendto(rrq, (ip, port))
+            envoi[fd] = time.time()
+    # Ouvriers tous pris, file pleine : les sessions ouvertes sont abandonnées
+    if not liberes and time.time() - debut > 1.5:
+        liberes = True
+        for fd, tid in tid_de.items(): par_fd[fd].sendto(abandon, tid)
+v = list(etat.values())
+print(v.count("data"), v.count("busy"), occupe_vite, v.count("autre"), n - len(v), pic)
+FIN
+)
+read DATA OCCUPE OCCUPE_VITE AUTRES MUETS PIC <<< "$BILAN"
+echo "DATA $DATA, Server busy $OCCUPE (dont $OCCUPE_VITE en moins d'une seconde), autres $AUTRES, sans réponse $MUETS ; pic de $PIC threads"
+verifier_vrai "file pleine : requêtes refusées par \"Server busy\"" [ "${OCCUPE:-0}" -gt 0 ]
+verifier_vrai "refus immédiats, sans attendre un ouvrier" [ "${OCCUPE_VITE:-0}" -eq "${OCCUPE:-0}" ]
+verifier_vrai "le pool a grandi jusqu'aux 1024 ouvriers ($PIC threads)" [ "${PIC:-0}" -ge 1024 -a "${PIC:-0}" -le $((AU_REPOS + 1024)) ]
+verifier_vrai "toute requête servie ou refusée" [ "${MUETS:-1}" -eq 0 -a "${AUTRES:-1}" -eq 0 ]
+verifier_vrai "toute requête acceptée servie ($DATA + $OCCUPE = $REQUETES)" [ $((DATA + OCCUPE)) -eq "$REQUETES" ]
+
+# 3. Rafale abandonnée : un transfert normal passe de nouveau
+echo -e "\n${JAUNE}[3/4] GET après la rafale...${NC}"
+rm -f "$FICHIER"
+timeout 30 $CLIENT_BIN $SERVER_IP get $FICHIER $PORT > /dev/null
+verifier "$REPO/$FICHIER" "$FICHIER" "GET après saturation"
+
+# 4. Les ouvriers en surnombre s'arrêtent après 30 s d'inactivité
+echo -e "\n${JAUNE}[4/4] Retour au minimum de $OUVRIERS ouvriers (35 s)...${NC}"
+sleep 35
+APRES=$(threads)
+verifier_vrai "$APRES threads, comme au repos ($AU_REPOS)" [ "$APRES" -le "$AU_REPOS" ]
+
+echo -e "\n${CYAN}==========================================================${NC}"
+if [ "$RESULTAT" = true ]; then
+    echo -e "${VERT}RÉSULTAT FINAL : TEST RÉUSSI${NC}"
+else
+    echo -e "${ROUGE}RÉSULTAT FINAL : TEST ÉCHOUÉ${NC}"
+fi
+echo -e "${CYAN}==========================================================${NC}"
+[ "$RESULTAT" = true ]
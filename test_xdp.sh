@@ -0,0 +1,145 @@
+#!/bin/bash
+
+# Chemin AF_XDP de server_select (-X) sur une paire veth : le serveur
+# écoute sur xs0 (XDP générique), le client tourne dans un espace de noms
+# réseau relié par xc0. Vérifie GET et PUT par XDP, puis le refus d'un RRQ
+# dont le port de session est déjà pris par un autre processus (ERROR
+# immédiate au client, ligne dans le journal du serveur).
+# Usage : sudo ./test_xdp.sh   (lance lui-même le serveur, depuis le dépôt)
+# Nécessite ip (iproute2) et python3 ; la paire veth et l'espace de noms
+# sont supprimés à la fin.
+
+# Configuration
+NETNS="tftp_xdp"
+IF_SERVEUR="xs0"
+IF_CLIENT="xc0"
+SERVER_IP="10.77.0.1"
+CLIENT_IP="10.77.0.2"
+PORT=69
+PORT_SESSION=50000
+REPO=".tftp"
+CLIENT_BIN="./client"
+SERVER_BIN="./server_select"
+JOURNAL="/tmp/tftp_xdp_server.log"
+FICHIER="xdp_test.bin"
+CLIENT_DIR="xdp_client"
+
+# Couleurs pour la lisibilité
+VERT='\033[0;32m'
+ROUGE='\033[0;31m'
+JAUNE='\033[1;33m'
+CYAN='\033[0;36m'
+NC='\033[0m'
+
+echo -e "${CYAN}==========================================================${NC}"
+echo -e "${CYAN}   PROTOCOLE DE TEST : AF_XDP SUR UNE PAIRE VETH          ${NC}"
+echo -e "${CYAN}==========================================================${NC}"
+
+if [ "$(id -u)" -ne 0 ]; then
+    echo -e "${ROUGE}[ERREUR] XDP, veth et espaces de noms demandent root.${NC}"
+    exit 1
+fi
+for bin in "$CLIENT_BIN" "$SERVER_BIN"; do
+    if [ ! -f "$bin" ]; then
+        echo -e "${ROUGE}[ERREUR] Le binaire '$bin' est introuvable. Tapez 'make'.${NC}"
+        exit 1
+    fi
+done
+
+SERVER_PID=""
+OCCUPANT_PID=""
+nettoyer() {
+    [ -n "$OCCUPANT_PID" ] && kill $OCCUPANT_PID 2>/dev/null
+    [ -n "$SERVER_PID" ] && kill $SERVER_PID 2>/dev/null && wait $SERVER_PID 2>/dev/null
+    ip link del $IF_SERVEUR 2>/dev/null
+    ip netns del $NETNS 2>/dev/null
+    rm -rf "$CLIENT_DIR" "$REPO/$FICHIER" "$REPO/$FICHIER.up"
+}
+trap nettoyer EXIT
+
+RESULTAT=true
+verifier() {
+    if cmp -s "$1" "$2"; then
+        echo -e "${VERT}[OK] $3${NC}"
+    else
+        echo -e "${ROUGE}[FAIL] $3${NC}"
+        RESULTAT=false
+    fi
+}
+verifier_vrai() {
+    if "${@:2}"; then
+        echo -e "${VERT}[OK] $1${NC}"
+    else
+        echo -e "${ROUGE}[FAIL] $1${NC}"
+        RESULTAT=false
+    fi
+}
+client() {
+    (cd "$CLIENT_DIR" && timeout 30 ip netns exec $NETNS ../$CLIENT_BIN "$@")
+}
+
+# 1. Paire veth, côté client dans son espace de noms, puis le serveur
+echo -e "\n${JAUNE}[1/5] Paire veth $IF_SERVEUR <-> $IF_CLIENT et démarrage du serveur...${NC}"
+nettoyer
+ip netns add $NETNS || exit 1
+ip link add $IF_SERVEUR type veth peer name $IF_CLIENT || exit 1
+ip link set $IF_CLIENT netns $NETNS
+ip addr add $SERVER_IP/24 dev $IF_SERVEUR
+ip link set $IF_SERVEUR up
+ip netns exec $NETNS ip addr add $CLIENT_IP/24 dev $IF_CLIENT
+ip netns exec $NETNS ip link set $IF_CLIENT up
+ip netns exec $NETNS ip link set lo up
+mkdir -p $REPO "$CLIENT_DIR"
+head -c 3000000 /dev/urandom > "$REPO/$FICHIER"
+stdbuf -oL $SERVER_BIN -X $IF_SERVEUR -g > $JOURNAL 2>&1 &
+SERVER_PID=$!
+sleep 1
+if grep -q "AF_XDP unavailable" $JOURNAL || ! kill -0 $SERVER_PID 2>/dev/null; then
+    echo -e "${ROUGE}[ERREUR] XDP indisponible (voir $JOURNAL).${NC}"
+    exit 1
+fi
+
+# 2. Téléchargement par XDP
+echo -e "\n${JAUNE}[2/5] GET par XDP...${NC}"
+client $SERVER_IP get $FICHIER $PORT > /dev/null
+verifier "$REPO/$FICHIER" "$CLIENT_DIR/$FICHIER" "GET par XDP"
+
+# 3. Envoi par XDP
+echo -e "\n${JAUNE}[3/5] PUT par XDP...${NC}"
+mv "$CLIENT_DIR/$FICHIER" "$CLIENT_DIR/$FICHIER.up"
+client $SERVER_IP put $FICHIER.up $PORT > /dev/null
+sleep 0.5
+verifier "$REPO/$FICHIER" "$REPO/$FICHIER.up" "PUT par XDP"
+
+# 4. Port de session pris : ERROR immédiate, pas de retransmissions
+echo -e "\n${JAUNE}[4/5] RRQ avec le port $PORT_SESSION occupé...${NC}"
+python3 -c "import socket, time
+s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+s.bind(('0.0.0.0', $PORT_SESSION))
+time.sleep(60)" &
+OCCUPANT_PID=$!
+sleep 0.3
+rm -f "$CLIENT_DIR/$FICHIER"
+DEBUT=$(date +%s)
+client $SERVER_IP get $FICHIER $PORT > /dev/null
+CODE=$?
+DUREE=$(( $(date +%s) - DEBUT ))
+verifier_vrai "GET refusé (code $CODE)" [ $CODE -ne 0 -a $CODE -ne 124 ]
+verifier_vrai "refus en ${DUREE}s, sans attendre les délais" [ $DUREE -lt 3 ]
+verifier_vrai "refus journalisé" grep -q "Cannot bind slot port $PORT_SESSION" $JOURNAL
+
+# 5. Port libéré : le même emplacement sert de nouveau
+echo -e "\n${JAUNE}[5/5] GET après libération du port...${NC}"
+kill $OCCUPANT_PID; wait $OCCUPANT_PID 2>/dev/null
+OCCUPANT_PID=""
+client $SERVER_IP get $FICHIER $PORT > /dev/null
+verifier "$REPO/$FICHIER" "$CLIENT_DIR/$FICHIER" "GET après libération"
+
+echo -e "\n${CYAN}==========================================================${NC}"
+if [ "$RESULTAT" = true ]; then
+    echo -e "${VERT}RÉSULTAT FINAL : TEST RÉUSSI${NC}"
+else
+    echo -e "${ROUGE}RÉSULTAT FINAL : TEST ÉCHOUÉ${NC}"
+fi
+echo -e "${CYAN}==========================================================${NC}"
+[ "$RESULTAT" = true ]
@@ -0,0 +1,130 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "tftp_archive.h"
+
+// Projection de l'archive, en lecture seule : partagée par tous les
+// threads sans verrou
+static struct {
+    const char *base;
+    size_t taille;
+    const archive_entete_t *entete;
+    const uint32_t *seaux;
+    const archive_entree_t *entrees;
+    const char *noms;
+    struct stat st;
+} arc;
+
+uint32_t archive_hachage(const char *nom) {
+    uint32_t h = 2166136261u; // FNV-1a, comme tftp_index.c
+    while (*nom) {
+        h ^= (unsigned char)*nom++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static bool dans(uint64_t offset, uint64_t longueur, uint64_t total) {
+    return offset <= total && longueur <= total - offset;
+}
+
+// Toutes les positions sont vérifiées ici, une fois : une recherche ne
+// peut plus sortir de la projection
+static bool valider(const char *base, size_t taille) {
+    const archive_entete_t *e = (const archive_entete_t *)base;
+    if (taille < sizeof(*e) || memcmp(e->magie, ARCHIVE_MAGIE, sizeof(e->magie)) != 0 ||
+        e->version != ARCHIVE_VERSION || e->taille != taille || e->page != ARCHIVE_PAGE)
+        return false;
+    if (e->nb_seaux == 0 || (e->nb_seaux & (e->nb_seaux - 1)) || e->nb_seaux < e->nb_fichiers ||
+        !dans(e->seaux, (uint64_t)e->nb_seaux * sizeof(uint32_t), taille) ||
+        !dans(e->entrees, (uint64_t)e->nb_fichiers * sizeof(archive_entree_t), taille) ||
+        !dans(e->noms, e->taille_noms, taille) || e->seaux % 4 || e->entrees % 8)
+        return false;
+    if (e->taille_noms > 0 && base[e->noms + e->taille_noms - 1] != '\0') return false;
+
+    const uint32_t *seaux = (const uint32_t *)(base + e->seaux);
+    const archive_entree_t *entrees = (const archive_entree_t *)(base + e->entrees);
+    for (uint32_t i = 0; i < e->nb_seaux; i++)
+        if (seaux[i] > e->nb_fichiers) return false;
+    for (uint32_t i = 0; i < e->nb_fichiers; i++)
+        if (entrees[i].nom >= e->taille_noms || !dans(entrees[i].offset, entrees[i].taille, taille)) return false;
+    return true;
+}
+
+// Projette l'archive ; renvoie le nombre de fichiers, -1 si elle est
+// illisible ou invalide (les serveurs servent alors le répertoire seul)
+int archive_ouvrir(const char *chemin) {
+    int fd = open(chemin, O_RDONLY);
+    if (fd < 0) {
+        perror(chemin);
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size == 0) {
+        close(fd);
+        return -1;
+    }
+    // La projection garde l'inode : remplacer l'archive (rename) ne
+    // perturbe pas le serveur, qui sert l'ancienne jusqu'au redémarrage
+    void *base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        perror("mmap");
+        return -1;
+    }
+    if (!valider(base, st.st_size)) {
+        fprintf(stderr, "%s : archive invalide\n", chemin);
+        munmap(base, st.st_size);
+        return -1;
+    }
+    // Tables et contenus lus d'avance : pas de défaut de page disque au
+    // premier RRQ de chaque fichier
+    madvise(base, st.st_size, MADV_WILLNEED);
+
+    arc.base = base;
+    arc.taille = st.st_size;
+    arc.st = st;
+    arc.entete = base;
+    arc.seaux = (const uint32_t *)(arc.base + arc.entete->seaux);
+    arc.entrees = (const archive_entree_t *)(arc.base + arc.entete->entrees);
+    arc.noms = arc.base + arc.entete->noms;
+    return arc.entete->nb_fichiers;
+}
+
+// Identité de l'archive ouverte (celle de ses fichiers) ; faux sans archive
+bool archive_version(dev_t *dev, ino_t *inode, time_t *mtime) {
+    if (!arc.base) return false;
+    *dev = arc.st.st_dev;
+    *inode = arc.st.st_ino;
+    *mtime = arc.st.st_mtime;
+    return true;
+}
+
+// Cherche 'nom' dans l'archive ouverte ; 'out' peut être NULL pour un
+// simple test de présence
+bool archive_chercher(const char *nom, archive_fichier_t *out) {
+    if (!arc.base) return false;
+    while (*nom == '/') nom++;
+    uint32_t h = archive_hachage(nom);
+    uint32_t masque = arc.entete->nb_seaux - 1;
+    for (uint32_t i = h & masque, essais = 0; essais <= masque; i = (i + 1) & masque, essais++) {
+        uint32_t s = arc.seaux[i];
+        if (s == 0) return false;
+        const archive_entree_t *e = &arc.entrees[s - 1];
+        if (e->hachage == h && strcmp(arc.noms + e->nom, nom) == 0) {
+            if (out) {
+                out->donnees = arc.base + e->offset;
+                out->taille = e->taille;
+                out->dev = arc.st.st_dev;
+                out->inode = arc.st.st_ino;
+                out->mtime = arc.st.st_mtime;
+            }
+            return true;
+        }
+    }
+    return false;
+}
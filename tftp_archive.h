@@ -0,0 +1,60 @@
+#ifndef TFTP_ARCHIVE_H
+#define TFTP_ARCHIVE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <time.h>
+
+// Archive en lecture seule d'une arborescence de fichiers (option -A des
+// serveurs, construite par ./archiver). Le serveur la projette en mémoire
+// (mmap) au démarrage : un RRQ y trouve son fichier par une table de
+// hachage, sans stat, open ni appel système par bloc.
+//
+// Format, entiers dans l'ordre de la machine qui l'a construite :
+//   entête (archive_entete_t)
+//   seaux : uint32_t[nb_seaux], indice d'entrée + 1 (0 : vide), sondage linéaire
+//   entrées : archive_entree_t[nb_fichiers]
+//   noms : chaînes terminées par un zéro, relatives à la racine ("pxelinux.cfg/default")
+//   contenus, chacun aligné sur ARCHIVE_PAGE
+
+#define ARCHIVE_MAGIE "TFTPARC"
+#define ARCHIVE_VERSION 1
+#define ARCHIVE_PAGE 4096
+
+typedef struct {
+    char magie[8];
+    uint32_t version;
+    uint32_t nb_fichiers;
+    uint32_t nb_seaux;          // Puissance de deux, au moins deux fois nb_fichiers
+    uint32_t page;
+    uint64_t taille;            // Taille totale, pour refuser une archive tronquée
+    uint64_t seaux;             // Positions des tables dans l'archive
+    uint64_t entrees;
+    uint64_t noms;
+    uint64_t taille_noms;
+} archive_entete_t;
+
+typedef struct {
+    uint64_t offset;            // Début du contenu, multiple de ARCHIVE_PAGE
+    uint64_t taille;
+    uint32_t hachage;
+    uint32_t nom;               // Position du nom dans la table des noms
+    int64_t mtime;
+} archive_entree_t;
+
+typedef struct {
+    const char *donnees;        // Contenu dans la projection
+    off_t taille;
+    dev_t dev;                  // Version de l'archive qui le contient
+    ino_t inode;
+    time_t mtime;
+} archive_fichier_t;
+
+uint32_t archive_hachage(const char *nom);
+
+int  archive_ouvrir(const char *chemin);
+bool archive_chercher(const char *nom, archive_fichier_t *out);
+bool archive_version(dev_t *dev, ino_t *inode, time_t *mtime);
+
+#endif
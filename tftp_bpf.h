@@ -0,0 +1,41 @@
+#ifndef TFTP_BPF_H
+#define TFTP_BPF_H
+
+#include <linux/bpf.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Assemblage de petits programmes eBPF sans compilateur ni libbpf : une
+// instruction par macro, les sauts étant résolus par l'appelant. Commun au
+// programme XDP (tftp_xdp.c) et au filtre de la socket d'écoute
+// (tftp_filtre.c).
+
+#ifndef BPF_ATOMIC
+#define BPF_ATOMIC 0xc0         // Ancien BPF_XADD
+#endif
+
+#define INSN(c, d, s, o, i) ((struct bpf_insn){ .code = (c), .dst_reg = (d), .src_reg = (s), .off = (o), .imm = (i) })
+#define MOV_REG(d, s)       INSN(BPF_ALU64 | BPF_MOV | BPF_X, d, s, 0, 0)
+#define MOV_IMM(d, i)       INSN(BPF_ALU64 | BPF_MOV | BPF_K, d, 0, 0, i)
+#define ALU_IMM(op, d, i)   INSN(BPF_ALU64 | (op) | BPF_K, d, 0, 0, i)
+#define CHARGER(t, d, s, o) INSN(BPF_LDX | (t) | BPF_MEM, d, s, o, 0)
+// Octets du paquet (filtres de socket, r6 = contexte), en ordre hôte dans r0
+#define PAQUET(t, o)        INSN(BPF_LD | (t) | BPF_ABS, 0, 0, 0, o)
+#define PAQUET_IND(t, s, o) INSN(BPF_LD | (t) | BPF_IND, 0, s, 0, o)
+#define STOCKER(t, d, s, o) INSN(BPF_STX | (t) | BPF_MEM, d, s, o, 0)
+#define AJOUTER(t, d, s, o) INSN(BPF_STX | (t) | BPF_ATOMIC, d, s, o, BPF_ADD)
+#define BE16(d)             INSN(BPF_ALU | BPF_END | BPF_TO_BE, d, 0, 0, 16)
+#define SAUT_REG(op, d, s)  INSN(BPF_JMP | (op) | BPF_X, d, s, 0, 0)
+#define SAUT_IMM(op, d, i)  INSN(BPF_JMP | (op) | BPF_K, d, 0, 0, i)
+#define APPEL(f)            INSN(BPF_JMP | BPF_CALL, 0, 0, 0, f)
+#define SORTIE()            INSN(BPF_JMP | BPF_EXIT, 0, 0, 0, 0)
+// Adresse d'une table, remplacée au chargement ; occupe deux instructions,
+// la seconde étant SUITE()
+#define CARTE(d, fd)        INSN(BPF_LD | BPF_DW | BPF_IMM, d, BPF_PSEUDO_MAP_FD, 0, fd)
+#define SUITE()             INSN(0, 0, 0, 0, 0)
+
+static inline int bpf(int cmd, union bpf_attr *attr) {
+    return syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+}
+
+#endif
@@ -0,0 +1,592 @@
+#define _GNU_SOURCE
+#include <arpa/inet.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "tftp_client.h"
+#include "tftp_pmtu.h"
+
+#define DELAI_DEFAUT 5      // Secondes avant retransmission sans option timeout
+#define ESSAIS_MAX 5        // Retransmissions d'un même paquet avant abandon
+#define REQUETE_MAX 512     // Taille d'un RRQ/WRQ
+
+static double maintenant(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void entete(char *paquet, uint16_t opcode, uint16_t bloc) {
+    uint16_t op = htons(opcode);
+    uint16_t blk = htons(bloc);
+    memcpy(paquet, &op, 2);
+    memcpy(paquet + 2, &blk, 2);
+}
+
+// Émet t->paquet et arme le minuteur de retransmission. Un DATA de put
+// part sans fragmentation jusqu'à ce que le MTU du chemin se révèle plus
+// petit que prévu (EMSGSIZE) ou que le même bloc se perde trop souvent
+// (trou noir PMTU probable) : la suite part alors fragmentée.
+static void emettre(transfert_t *t) {
+    if (t->df && t->pertes >= PMTU_PERTES_MAX) {
+        pmtu_fragmentation(t->sockfd, true);
+        t->df = false;
+    }
+    if (sendto(t->sockfd, t->paquet, t->paquet_len, 0, (struct sockaddr *)&t->serveur, sizeof(t->serveur)) < 0 &&
+        errno == EMSGSIZE && t->df) {
+        pmtu_fragmentation(t->sockfd, true);
+        t->df = false;
+        sendto(t->sockfd, t->paquet, t->paquet_len, 0, (struct sockaddr *)&t->serveur, sizeof(t->serveur));
+    }
+    t->echeance = maintenant() + t->delai;
+}
+
+static void finir(transfert_t *t, transfert_etat_t etat) {
+    t->etat = etat;
+    t->stats.fin = maintenant();
+    free(t->flux);
+    t->flux = NULL;
+    if (t->groupe >= 0) close(t->groupe);
+    t->groupe = -1;
+}
+
+static void echouer(transfert_t *t, const char *format, ...) {
+    va_list ap;
+    va_start(ap, format);
+    vsnprintf(t->erreur, sizeof(t->erreur), format, ap);
+    va_end(ap);
+    finir(t, TRANSFERT_ECHEC);
+}
+
+// ERROR vers 'dest', sans toucher au dernier paquet gardé
+static void envoyer_erreur(transfert_t *t, const struct sockaddr_in *dest, uint16_t code, const char *msg) {
+    char paquet[REQUETE_MAX];
+    entete(paquet, 5, code);
+    size_t len = snprintf(paquet + 4, sizeof(paquet) - 4, "%s", msg) + 1;
+    sendto(t->sockfd, paquet, 4 + len, 0, (const struct sockaddr *)dest, sizeof(*dest));
+}
+
+static void progresser(transfert_t *t) {
+    if (t->progression) t->progression(t->ctx, t);
+}
+
+void transfert_init(transfert_t *t) {
+    memset(t, 0, offsetof(transfert_t, brut));
+    t->rollover = -1;
+    t->sockfd = -1;
+    t->fd = -1;
+    t->groupe = -1;
+    t->etat = TRANSFERT_ECHEC;
+    snprintf(t->erreur, sizeof(t->erreur), "transfert non démarré");
+}
+
+// Versions _fd : écriture ou lecture en flux, la position est ignorée
+void transfert_vers_fd(transfert_t *t, int fd) {
+    t->fd = fd;
+    t->ecrire = NULL;
+}
+
+void transfert_depuis_fd(transfert_t *t, int fd) {
+    t->fd = fd;
+    t->lire = NULL;
+}
+
+static ssize_t ecrire(transfert_t *t, const char *donnees, size_t len) {
+    if (t->ecrire) return t->ecrire(t->ctx, donnees, len, t->position);
+    size_t fait = 0;
+    while (fait < len) {
+        ssize_t n = write(t->fd, donnees + fait, len - fait);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        fait += n;
+    }
+    return fait;
+}
+
+// Remplit 'cap' octets sauf à la fin de la source : un tube rend souvent moins
+static ssize_t lire(transfert_t *t, char *donnees, size_t cap, uint64_t position) {
+    size_t fait = 0;
+    while (fait < cap) {
+        ssize_t n = t->lire ? t->lire(t->ctx, donnees + fait, cap - fait, position + fait)
+                            : read(t->fd, donnees + fait, cap - fait);
+        if (n < 0 && errno == EINTR && !t->lire) continue;
+        if (n < 0) return -1;
+        if (n == 0) break;
+        fait += n;
+    }
+    return fait;
+}
+
+static int demarrer(transfert_t *t, int type, const struct sockaddr_in *serveur, const char *nom,
+                    unsigned long long taille) {
+    t->type = type;
+    t->serveur = *serveur;
+    t->tid_connu = false;
+    t->bloc = 0;
+    t->rollover_fil = 0;
+    t->en_vol = 0;
+    t->offset_accorde = false;
+    t->dernier = false;
+    t->df = false;
+    t->pertes = 0;
+    t->essais = 0;
+    t->position = 0;
+    t->compresse = false;
+    t->maitre = false;
+    memset(&t->groupe_adr, 0, sizeof(t->groupe_adr));
+    t->brut_len = 0;
+    t->brut_fin = false;
+    t->erreur[0] = '\0';
+    netascii_enc_init(&t->enc);
+    netascii_dec_init(&t->dec);
+    memset(&t->stats, 0, sizeof(t->stats));
+    t->stats.blksize = TFTP_BLKSIZE_DEFAUT;
+    t->stats.debut = maintenant();
+    t->delai = DELAI_DEFAUT;
+    t->etat = TRANSFERT_EN_COURS;
+
+    // Requête : opcode | nom | 0 | mode | 0 | options (RFC 2347)
+    const char *mode = t->netascii ? "netascii" : "octet";
+    size_t nom_len = strlen(nom) + 1;
+    size_t mode_len = strlen(mode) + 1;
+    if (2 + nom_len + mode_len > REQUETE_MAX) {
+        echouer(t, "nom de fichier trop long");
+        return -1;
+    }
+    tftp_options_t demande;
+    memset(&demande, 0, sizeof(demande));
+    if (type == 1 || taille > 0) {
+        demande.presentes |= TFTP_OPT_TSIZE;
+        demande.tsize = type == 1 ? 0 : taille;
+    }
+    if (t->blksize > 0 && t->blksize != TFTP_BLKSIZE_DEFAUT) {
+        demande.presentes |= TFTP_OPT_BLKSIZE;
+        demande.blksize = t->blksize;
+    }
+    if (t->timeout > 0) {
+        demande.presentes |= TFTP_OPT_TIMEOUT;
+        demande.timeout = t->timeout;
+    }
+    if (t->rollover >= 0) {
+        demande.presentes |= TFTP_OPT_ROLLOVER;
+        demande.rollover = t->rollover;
+    }
+    if (type == 1 && (t->offset > 0 || t->longueur > 0)) {
+        demande.presentes |= TFTP_OPT_OFFSET;
+        demande.offset = t->offset;
+    }
+    if (type == 1 && t->longueur > 0) {
+        demande.presentes |= TFTP_OPT_LENGTH;
+        demande.length = t->longueur;
+    }
+    bool plage = demande.presentes & TFTP_OPT_OFFSET;
+    if (type == 1 && t->compression && !t->netascii && !plage) demande.presentes |= TFTP_OPT_COMPRESS;
+    // Groupes en octet seulement, blocs reçus dans le désordre
+    if (type == 1 && t->multicast && t->ecrire && !t->netascii && !plage) demande.presentes |= TFTP_OPT_MULTICAST;
+    if (t->netascii) demande.presentes &= ~(TFTP_OPT_TSIZE | TFTP_OPT_OFFSET | TFTP_OPT_LENGTH);
+
+    entete(t->paquet, type, 0);
+    memcpy(t->paquet + 2, nom, nom_len);
+    memcpy(t->paquet + 2 + nom_len, mode, mode_len);
+    t->paquet_len = 2 + nom_len + mode_len;
+    t->paquet_len += options_write(t->paquet + t->paquet_len, REQUETE_MAX - t->paquet_len, &demande);
+    t->oack_attendu = demande.presentes != 0;
+
+    t->sockfd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (t->sockfd < 0) {
+        echouer(t, "socket : %s", strerror(errno));
+        return -1;
+    }
+    emettre(t);
+    return 0;
+}
+
+int transfert_get(transfert_t *t, const struct sockaddr_in *serveur, const char *nom) {
+    return demarrer(t, 1, serveur, nom, 0);
+}
+
+// 'taille' est annoncée dans tsize si elle est connue (non nulle) : le
+// serveur refuse alors d'emblée un fichier trop gros
+int transfert_put(transfert_t *t, const struct sockaddr_in *serveur, const char *nom, unsigned long long taille) {
+    return demarrer(t, 2, serveur, nom, taille);
+}
+
+int transfert_fd(const transfert_t *t) {
+    return t->sockfd;
+}
+
+// Socket du groupe multicast rejoint, à surveiller en lecture comme
+// transfert_fd ; -1 hors multicast
+int transfert_fd_groupe(const transfert_t *t) {
+    return t->groupe;
+}
+
+// Millisecondes avant la prochaine retransmission, délai d'attente de la
+// boucle de l'appelant
+int transfert_delai(const transfert_t *t) {
+    if (t->etat != TRANSFERT_EN_COURS) return 0;
+    double reste = t->echeance - maintenant();
+    return reste > 0 ? (int)(reste * 1000) + 1 : 0;
+}
+
+// Adresse locale utilisée pour joindre 'pair' : le groupe est rejoint sur
+// l'interface qui mène au serveur (lo pour un serveur local)
+static struct in_addr adresse_locale(const struct sockaddr_in *pair) {
+    struct in_addr locale = { htonl(INADDR_ANY) };
+    struct sockaddr_in sa;
+    socklen_t len = sizeof(sa);
+    int s = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (s < 0) return locale;
+    if (connect(s, (const struct sockaddr *)pair, sizeof(*pair)) == 0 &&
+        getsockname(s, (struct sockaddr *)&sa, &len) == 0)
+        locale = sa.sin_addr;
+    close(s);
+    return locale;
+}
+
+// Le maître acquitte le dernier bloc contigu : le serveur reprend au suivant
+static void acquitter_groupe(transfert_t *t) {
+    entete(t->paquet, 4, t->contigu);
+    t->paquet_len = 4;
+    t->essais = 0;
+    emettre(t);
+}
+
+// OACK multicast (RFC 2090) : les blocs arriveront sur le groupe. Seul le
+// maître acquitte ; les autres attendent la fin de la diffusion, ou d'être
+// promus quand le maître s'en va.
+static void rejoindre(transfert_t *t, const tftp_options_t *accord) {
+    struct sockaddr_in groupe;
+    memset(&groupe, 0, sizeof(groupe));
+    groupe.sin_family = AF_INET;
+    groupe.sin_port = htons(accord->mc_port);
+    if (inet_pton(AF_INET, accord->mc_addr, &groupe.sin_addr) <= 0) {
+        envoyer_erreur(t, &t->serveur, 8, "multicast refused");
+        echouer(t, "groupe multicast invalide '%s'", accord->mc_addr);
+        return;
+    }
+
+    // Plusieurs clients d'une même machine écoutent le même groupe
+    int s = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int un = 1;
+    struct ip_mreq mreq = { .imr_multiaddr = groupe.sin_addr, .imr_interface = adresse_locale(&t->serveur) };
+    if (s < 0 || setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &un, sizeof(un)) < 0 ||
+        bind(s, (struct sockaddr *)&groupe, sizeof(groupe)) < 0 ||
+        setsockopt(s, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+        int err = errno;
+        if (s >= 0) close(s);
+        envoyer_erreur(t, &t->serveur, 8, "multicast refused");
+        echouer(t, "groupe %s:%u : %s", accord->mc_addr, accord->mc_port, strerror(err));
+        return;
+    }
+    t->groupe = s;
+    t->groupe_adr = groupe;
+    t->maitre = accord->mc_master;
+    t->total = (accord->presentes & TFTP_OPT_TSIZE) ? accord->tsize / t->stats.blksize + 1 : 0;
+    t->contigu = 0;
+    memset(t->recus, 0, sizeof(t->recus));
+    progresser(t);
+    if (t->maitre) acquitter_groupe(t); // ACK 0 : acquitte l'OACK
+    else t->echeance = maintenant() + t->delai;
+}
+
+// OACK renvoyé à un membre du groupe : le serveur lui donne ou retire le
+// rôle de maître
+static void changer_role(transfert_t *t, const char *buf, size_t len) {
+    tftp_options_t maj;
+    if (options_parse(buf, len, &maj) < 0 || !(maj.presentes & TFTP_OPT_MULTICAST)) return;
+    bool promu = maj.mc_master && !t->maitre;
+    t->maitre = maj.mc_master;
+    if (t->maitre) acquitter_groupe(t);
+    if (promu) progresser(t);
+}
+
+// Options accordées par l'OACK
+static void appliquer_oack(transfert_t *t, const char *buf, size_t len) {
+    tftp_options_t accord;
+    if (options_parse(buf, len, &accord) < 0) return;
+    if ((accord.presentes & TFTP_OPT_BLKSIZE) && accord.blksize <= (t->blksize ? t->blksize : TFTP_BLKSIZE_MAX))
+        t->stats.blksize = accord.blksize;
+    if (accord.presentes & TFTP_OPT_TIMEOUT) t->delai = accord.timeout;
+    if (accord.presentes & TFTP_OPT_ROLLOVER) t->rollover_fil = accord.rollover;
+    if (accord.presentes & TFTP_OPT_TSIZE) t->stats.taille = accord.tsize;
+    if (accord.presentes & TFTP_OPT_OFFSET) {
+        if (accord.offset < t->offset) {
+            // Offset ramené à la taille distante : le fichier demandé est
+            // plus court que ce que l'appelant croit en avoir
+            envoyer_erreur(t, &t->serveur, 8, "offset beyond end of file");
+            echouer(t, "le fichier distant ne fait que %llu octets", (unsigned long long)accord.offset);
+            return;
+        }
+        t->position = accord.offset;
+        t->offset_accorde = true;
+    }
+    if ((accord.presentes & TFTP_OPT_COMPRESS) && t->type == 1 && t->compression && !t->flux) {
+        t->flux = malloc(sizeof(*t->flux));
+        if (!t->flux) {
+            envoyer_erreur(t, &t->serveur, 8, "compress refused");
+            echouer(t, "mémoire insuffisante pour la décompression");
+            return;
+        }
+        lz4_flux_init(t->flux);
+        t->compresse = true;
+    }
+    if ((accord.presentes & TFTP_OPT_MULTICAST) && accord.mc_addr[0] && t->type == 1 && t->multicast)
+        rejoindre(t, &accord);
+}
+
+// put : prépare le DATA suivant depuis la source
+static void charger_data(transfert_t *t) {
+    size_t blksize = t->stats.blksize;
+    size_t len;
+    t->bloc = bloc_suivant(t->bloc, t->rollover_fil);
+    entete(t->paquet, 3, t->bloc);
+    if (t->netascii) {
+        // Octets lus d'avance gardés d'un bloc à l'autre : la conversion
+        // n'en consomme pas toujours autant qu'elle en reçoit
+        if (!t->brut_fin && t->brut_len < blksize) {
+            ssize_t n = lire(t, t->brut + t->brut_len, blksize - t->brut_len, t->position + t->brut_len);
+            if (n < 0) {
+                envoyer_erreur(t, &t->serveur, 0, "Read error");
+                echouer(t, "lecture de la source");
+                return;
+            }
+            if ((size_t)n < blksize - t->brut_len) t->brut_fin = true;
+            t->brut_len += n;
+        }
+        size_t consomme;
+        len = netascii_encode(&t->enc, t->brut, t->brut_len, &consomme, t->paquet + 4, blksize);
+        memmove(t->brut, t->brut + consomme, t->brut_len - consomme);
+        t->brut_len -= consomme;
+        t->en_vol = consomme;
+    } else {
+        ssize_t n = lire(t, t->paquet + 4, blksize, t->position);
+        if (n < 0) {
+            envoyer_erreur(t, &t->serveur, 0, "Read error");
+            echouer(t, "lecture de la source");
+            return;
+        }
+        len = n;
+        t->en_vol = len;
+    }
+    t->dernier = len < blksize;
+    t->paquet_len = len + 4;
+    t->essais = 0;
+    t->pertes = 0;
+    t->stats.paquets++;
+    emettre(t);
+}
+
+// Octets du fichier vers le puits ; en cas d'échec le transfert est
+// abandonné (ERROR 3)
+static ssize_t livrer(void *ctx, const char *donnees, size_t len) {
+    transfert_t *t = ctx;
+    if (ecrire(t, donnees, len) != (ssize_t)len) {
+        envoyer_erreur(t, &t->serveur, 3, "Disk full or allocation exceeded");
+        echouer(t, "écriture : %s", strerror(errno));
+        return -1;
+    }
+    t->position += len;
+    t->stats.octets += len;
+    return len;
+}
+
+static void recevoir_data(transfert_t *t, uint16_t bloc, const char *donnees, size_t len) {
+    if (bloc == t->bloc && t->stats.paquets > 0) {
+        // Notre ACK s'est perdu : le renvoyer
+        t->stats.retransmissions++;
+        emettre(t);
+        return;
+    }
+    if (bloc != bloc_suivant(t->bloc, t->rollover_fil)) return;
+
+    // Le numéro de bloc repasse par 0 avec le rollover : le premier DATA
+    // se reconnaît au compteur de paquets
+    if (t->stats.paquets == 0) {
+        // Pas d'OACK : le serveur ignore les options, valeurs par défaut
+        t->oack_attendu = false;
+        if ((t->offset > 0 || t->longueur > 0) && !t->offset_accorde) {
+            // Un segment (length) ne peut pas devenir le fichier entier
+            if (!t->ecrire || t->longueur > 0) {
+                envoyer_erreur(t, &t->serveur, 8, "offset option refused");
+                echouer(t, "le serveur ne gère pas l'option offset");
+                return;
+            }
+            t->position = 0; // Un puits positionnel reçoit le fichier depuis le début
+        }
+    }
+
+    bool fin = len < (size_t)t->stats.blksize;
+    char texte[TFTP_BLKSIZE_MAX + 1]; // Bloc converti depuis netascii (+1 : CR reporté)
+    if (t->netascii) {
+        size_t n = netascii_decode(&t->dec, donnees, len, texte);
+        if (fin) n += netascii_decode_end(&t->dec, texte + n);
+        donnees = texte;
+        len = n;
+    }
+    if (t->flux) {
+        // Flux lz4 : le puits reçoit les trames décompressées
+        if (lz4_flux_decoder(t->flux, donnees, len, livrer, t) < 0 || (fin && !lz4_flux_complet(t->flux))) {
+            if (t->etat != TRANSFERT_EN_COURS) return; // Échec du puits, déjà signalé
+            envoyer_erreur(t, &t->serveur, 0, "Corrupt compressed stream");
+            echouer(t, "flux compressé invalide");
+            return;
+        }
+    } else if (livrer(t, donnees, len) != (ssize_t)len) {
+        return;
+    }
+    t->stats.paquets++;
+    t->bloc = bloc;
+    t->essais = 0;
+    entete(t->paquet, 4, bloc);
+    t->paquet_len = 4;
+    emettre(t);
+    progresser(t);
+    if (fin) finir(t, TRANSFERT_TERMINE);
+}
+
+static void recevoir_ack(transfert_t *t, uint16_t bloc) {
+    if (bloc != t->bloc) {
+        // ACK en double : on attend le bon (Sorcerer's Apprentice), mais le
+        // serveur réclame le bloc en vol
+        if (bloc_suivant(bloc, t->rollover_fil) == t->bloc) t->pertes++;
+        return;
+    }
+    if (t->stats.paquets == 0) {
+        t->oack_attendu = false; // ACK 0 sans OACK : options ignorées
+    } else {
+        t->position += t->en_vol;
+        t->stats.octets += t->en_vol;
+        progresser(t);
+        if (t->dernier) {
+            finir(t, TRANSFERT_TERMINE);
+            return;
+        }
+    }
+    charger_data(t);
+}
+
+// DATA diffusé sur le groupe : dans n'importe quel ordre pour un client
+// arrivé en cours de diffusion, chaque bloc va à sa place, une seule fois
+static void recevoir_groupe(transfert_t *t, const char *buf, size_t n, const struct sockaddr_in *de) {
+    if (n < 4 || de->sin_addr.s_addr != t->serveur.sin_addr.s_addr || ntohs(*(const uint16_t *)buf) != 3) return;
+    uint16_t bloc = ntohs(*(const uint16_t *)(buf + 2));
+    t->essais = 0;
+    if (bloc == 0 || (t->recus[bloc / 8] & (1 << (bloc % 8)))) return; // Doublon : pas d'ACK
+
+    t->position = (uint64_t)(bloc - 1) * t->stats.blksize;
+    if (livrer(t, buf + 4, n - 4) != (ssize_t)(n - 4)) return;
+    t->recus[bloc / 8] |= 1 << (bloc % 8);
+    t->stats.paquets++;
+    if (n - 4 < (size_t)t->stats.blksize) t->total = bloc;
+    while (t->contigu < UINT16_MAX && (t->recus[(t->contigu + 1) / 8] & (1 << ((t->contigu + 1) % 8)))) t->contigu++;
+    if (t->maitre) acquitter_groupe(t);
+    progresser(t);
+    if (t->total && t->contigu == t->total) {
+        // Un client qui a tout reçu sans être maître quitte le groupe par
+        // un ACK du dernier bloc
+        if (!t->maitre) acquitter_groupe(t);
+        finir(t, TRANSFERT_TERMINE);
+    }
+}
+
+static void recevoir(transfert_t *t, const char *buf, size_t n, const struct sockaddr_in *de) {
+    if (n < 4 || de->sin_addr.s_addr != t->serveur.sin_addr.s_addr) return;
+    // La première réponse fixe le TID du serveur ; les autres ports sont refusés
+    if (!t->tid_connu) {
+        t->serveur.sin_port = de->sin_port;
+        t->tid_connu = true;
+    } else if (de->sin_port != t->serveur.sin_port) {
+        envoyer_erreur(t, de, 5, "Unknown transfer ID");
+        return;
+    }
+
+    uint16_t opcode = ntohs(*(const uint16_t *)buf);
+    uint16_t bloc = ntohs(*(const uint16_t *)(buf + 2));
+    if (opcode == 5) {
+        echouer(t, "erreur serveur %u : %.*s", bloc, (int)(n - 4), buf + 4);
+    } else if (opcode == TFTP_OACK && t->oack_attendu && t->stats.paquets == 0) {
+        appliquer_oack(t, buf + 2, n - 2);
+        if (t->etat != TRANSFERT_EN_COURS) return;
+        t->oack_attendu = false;
+        if (t->groupe >= 0) return; // Le maître a déjà acquitté l'OACK
+        if (t->type == 1) {
+            entete(t->paquet, 4, 0);
+            t->paquet_len = 4;
+            t->essais = 0;
+            emettre(t);
+        } else {
+            // Gros blocs envoyés avec DF : un MTU trop petit se voit au lieu
+            // de fragmenter en silence
+            if (t->stats.blksize > TFTP_BLKSIZE_DEFAUT) {
+                pmtu_fragmentation(t->sockfd, false);
+                t->df = true;
+            }
+            charger_data(t);
+        }
+    } else if (opcode == TFTP_OACK && t->groupe >= 0) {
+        t->essais = 0;
+        changer_role(t, buf + 2, n - 2);
+    } else if (opcode == TFTP_OACK && t->type == 2 && t->stats.paquets == 1) {
+        t->pertes++; // OACK renvoyé : le bloc 1 n'est pas arrivé
+    } else if (opcode == 3 && t->type == 1 && t->groupe < 0) {
+        recevoir_data(t, bloc, buf + 4, n - 4);
+    } else if (opcode == 4 && t->type == 2) {
+        recevoir_ack(t, bloc);
+    }
+}
+
+// Traite les datagrammes en attente puis le minuteur ; à appeler quand la
+// socket est lisible ou que transfert_delai est écoulé
+transfert_etat_t transfert_avancer(transfert_t *t) {
+    char buf[TFTP_BLKSIZE_MAX + 4];
+    while (t->etat == TRANSFERT_EN_COURS) {
+        struct sockaddr_in de;
+        socklen_t de_len = sizeof(de);
+        ssize_t n = recvfrom(t->sockfd, buf, sizeof(buf), 0, (struct sockaddr *)&de, &de_len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) echouer(t, "recvfrom : %s", strerror(errno));
+            break;
+        }
+        recevoir(t, buf, n, &de);
+    }
+    while (t->etat == TRANSFERT_EN_COURS && t->groupe >= 0) {
+        struct sockaddr_in de;
+        socklen_t de_len = sizeof(de);
+        ssize_t n = recvfrom(t->groupe, buf, sizeof(buf), 0, (struct sockaddr *)&de, &de_len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) echouer(t, "recvfrom : %s", strerror(errno));
+            break;
+        }
+        recevoir_groupe(t, buf, n, &de);
+    }
+    if (t->etat == TRANSFERT_EN_COURS && maintenant() >= t->echeance) {
+        // Dans un groupe, le maître relance son ACK et les autres attendent
+        // d'être promus, plus longtemps
+        if (++t->essais > (t->groupe >= 0 && !t->maitre ? 2 * ESSAIS_MAX : ESSAIS_MAX)) {
+            echouer(t, "pas de réponse du serveur");
+        } else if (t->groupe >= 0 && !t->maitre) {
+            t->echeance = maintenant() + t->delai;
+        } else {
+            t->stats.retransmissions++;
+            t->pertes++;
+            emettre(t);
+        }
+    }
+    return t->etat;
+}
+
+void transfert_fermer(transfert_t *t) {
+    if (t->sockfd >= 0) close(t->sockfd);
+    t->sockfd = -1;
+    if (t->etat == TRANSFERT_EN_COURS) echouer(t, "transfert interrompu");
+}
@@ -0,0 +1,133 @@
+#ifndef TFTP_CLIENT_H
+#define TFTP_CLIENT_H
+
+#include <netinet/in.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "tftp_lz4.h"
+#include "tftp_netascii.h"
+#include "tftp_options.h"
+
+// Bibliothèque client TFTP non bloquante, pour embarquer des transferts
+// dans la boucle d'événements de l'appelant (libtftpclient.a). Chaque
+// transfert a sa socket ; l'appelant la surveille (transfert_fd, en
+// lecture) avec un délai de transfert_delai millisecondes, puis appelle
+// transfert_avancer. Des centaines de transferts tiennent dans un seul
+// processus, sans fork ni thread :
+//
+//   transfert_t t;
+//   transfert_init(&t);
+//   transfert_vers_fd(&t, STDOUT_FILENO);
+//   transfert_get(&t, &serveur, "image.gz");
+//   while (t.etat == TRANSFERT_EN_COURS) {
+//       struct pollfd p = { transfert_fd(&t), POLLIN, 0 };
+//       poll(&p, 1, transfert_delai(&t));
+//       transfert_avancer(&t);
+//   }
+//
+// Les données passent par des fonctions de rappel : un puits pour get,
+// une source pour put, avec la position dans le fichier. Les rappels sont
+// synchrones : un puits lent ralentit les ACK, donc le serveur. Les
+// versions _fd lisent ou écrivent en flux un descripteur quelconque
+// (fichier, tube, stdout), ce qui permet de décompresser à la volée.
+//
+// Un get multicast (RFC 2090) reçoit ses blocs sur un groupe, dans le
+// désordre pour un client arrivé en cours de diffusion : il lui faut un
+// puits positionnel, et l'appelant surveille aussi transfert_fd_groupe
+// une fois le groupe rejoint.
+
+typedef enum {
+    TRANSFERT_EN_COURS,
+    TRANSFERT_TERMINE,
+    TRANSFERT_ECHEC
+} transfert_etat_t;
+
+// Puits (get) : écrit 'len' octets à 'position' ; renvoie moins que 'len' en cas d'erreur
+typedef ssize_t (*transfert_ecrire_t)(void *ctx, const char *donnees, size_t len, uint64_t position);
+// Source (put) : lit au plus 'cap' octets à 'position' ; 0 à la fin, -1 en cas d'erreur
+typedef ssize_t (*transfert_lire_t)(void *ctx, char *donnees, size_t cap, uint64_t position);
+
+typedef struct {
+    unsigned long long octets;      // Octets livrés au puits (get) ou acquittés (put)
+    unsigned long long taille;      // Taille annoncée (tsize, sur le fil : compressée avec lz4), 0 si inconnue
+    unsigned long paquets;          // DATA reçus (get) ou émis (put)
+    unsigned long retransmissions;
+    int blksize;                    // Taille de bloc accordée
+    double debut;                   // Horloge monotone (s)
+    double fin;                     // 0 tant que le transfert est en cours
+} transfert_stats_t;
+
+typedef struct transfert transfert_t;
+typedef void (*transfert_progression_t)(void *ctx, const transfert_t *t);
+
+struct transfert {
+    // Paramètres, fixés par l'appelant entre transfert_init et le démarrage
+    int blksize;                    // Demandé (RFC 2348), 0 : 512 sans option
+    int timeout;                    // Délai de retransmission demandé (s), 0 : 5 sans option
+    int rollover;                   // Bloc suivant 65535 demandé, -1 : pas d'option
+    bool netascii;
+    bool compression;               // get : demande le flux lz4 (option compress), décompressé à la réception
+    bool multicast;                 // get : demande un groupe (RFC 2090), puits positionnel seulement
+    unsigned long long offset;      // get : premier octet demandé (option offset), 0 : tout
+    unsigned long long longueur;    // get : octets demandés à partir d'offset (option length), 0 : jusqu'à la fin
+    transfert_ecrire_t ecrire;
+    transfert_lire_t lire;
+    transfert_progression_t progression;    // Après chaque bloc et à chaque changement de rôle multicast, NULL : aucun rappel
+    void *ctx;
+
+    // État, en lecture seule pour l'appelant
+    transfert_etat_t etat;
+    char erreur[128];               // Cause d'un échec
+    transfert_stats_t stats;
+    uint64_t position;              // Octet du fichier où va le prochain bloc
+    bool compresse;                 // get : l'OACK a accordé le flux lz4
+    struct sockaddr_in groupe_adr;  // multicast : groupe rejoint (port 0 : aucun)
+    bool maitre;                    // multicast : ce client acquitte les blocs
+
+    // Interne
+    int type;                       // 1 : get, 2 : put
+    int sockfd;
+    int fd;                         // Descripteur des versions _fd
+    struct sockaddr_in serveur;     // Port 69, puis TID du serveur
+    bool tid_connu;
+    uint16_t bloc;                  // Dernier bloc acquitté (get) ou émis (put)
+    int rollover_fil;               // Rollover accordé (0 sans option)
+    size_t en_vol;                  // put : octets du fichier portés par le DATA non acquitté
+    bool oack_attendu;              // Options envoyées, OACK pas encore reçu
+    bool offset_accorde;
+    bool dernier;                   // put : le dernier DATA est parti
+    bool df;                        // put : DATA émis sans fragmentation (blksize > 512)
+    int pertes;                     // put : timeouts et ACK en double du bloc en vol
+    int delai;                      // Secondes avant retransmission
+    int essais;
+    int groupe;                     // multicast : socket du groupe, -1 sinon
+    uint32_t total;                 // multicast : nombre de blocs, 0 tant qu'inconnu
+    uint32_t contigu;               // multicast : dernier bloc reçu sans trou avant lui
+    double echeance;                // Prochaine retransmission (horloge monotone)
+    netascii_enc_t enc;
+    netascii_dec_t dec;
+    lz4_flux_t *flux;               // get : décodeur, alloué si l'OACK accorde la compression
+    char brut[TFTP_BLKSIZE_MAX];    // put netascii : octets lus pas encore convertis
+    size_t brut_len;
+    bool brut_fin;                  // put netascii : la source est épuisée
+    char paquet[TFTP_BLKSIZE_MAX + 4];  // Dernier paquet émis, gardé pour les retransmissions
+    size_t paquet_len;
+    uint8_t recus[65536 / 8];       // multicast : blocs déjà reçus
+};
+
+void transfert_init(transfert_t *t);
+void transfert_vers_fd(transfert_t *t, int fd);
+void transfert_depuis_fd(transfert_t *t, int fd);
+
+int  transfert_get(transfert_t *t, const struct sockaddr_in *serveur, const char *nom);
+int  transfert_put(transfert_t *t, const struct sockaddr_in *serveur, const char *nom, unsigned long long taille);
+
+int  transfert_fd(const transfert_t *t);
+int  transfert_fd_groupe(const transfert_t *t);
+int  transfert_delai(const transfert_t *t);
+transfert_etat_t transfert_avancer(transfert_t *t);
+void transfert_fermer(transfert_t *t);
+
+#endif
@@ -0,0 +1,147 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <limits.h>
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "tftp_cpu.h"
+
+// Liste au format du noyau ("0-3,8,10-11"), comme dans sysfs
+static int lire_liste(const char *liste, cpu_set_t *cpus) {
+    CPU_ZERO(cpus);
+    const char *p = liste;
+    while (*p && *p != '\n') {
+        char *fin;
+        long debut = strtol(p, &fin, 10), dernier = debut;
+        if (fin == p) return -1;
+        if (*fin == '-') {
+            p = fin + 1;
+            dernier = strtol(p, &fin, 10);
+            if (fin == p) return -1;
+        }
+        if (debut < 0 || dernier < debut || dernier >= CPU_SETSIZE) return -1;
+        for (long c = debut; c <= dernier; c++) CPU_SET(c, cpus);
+        p = fin;
+        if (*p == ',') p++;
+        else if (*p && *p != '\n') return -1;
+    }
+    return CPU_COUNT(cpus) > 0 ? 0 : -1;
+}
+
+static int lire_fichier(const char *chemin, char *texte, size_t cap) {
+    FILE *f = fopen(chemin, "r");
+    if (!f) return -1;
+    bool ok = fgets(texte, cap, f) != NULL;
+    fclose(f);
+    return ok ? 0 : -1;
+}
+
+// Nœud et CPU de la carte 'interface'. Une carte sans nœud (machine à un
+// seul nœud, interface virtuelle) garde les CPU permis au processus.
+static int lire_numa(cpu_profil_t *p, const char *interface) {
+    char chemin[256], texte[1024];
+    snprintf(chemin, sizeof(chemin), "/sys/class/net/%s", interface);
+    if (access(chemin, F_OK) != 0) {
+        fprintf(stderr, "cpu: interface inconnue : %s\n", interface);
+        return -1;
+    }
+    snprintf(chemin, sizeof(chemin), "/sys/class/net/%s/device/numa_node", interface);
+    p->noeud = lire_fichier(chemin, texte, sizeof(texte)) == 0 ? atoi(texte) : -1;
+    if (p->noeud < 0) {
+        p->noeud = -1;
+        return sched_getaffinity(0, sizeof(p->cpus), &p->cpus);
+    }
+    snprintf(chemin, sizeof(chemin), "/sys/devices/system/node/node%d/cpulist", p->noeud);
+    if (lire_fichier(chemin, texte, sizeof(texte)) < 0 || lire_liste(texte, &p->cpus) < 0) {
+        fprintf(stderr, "cpu: CPU du nœud %d illisibles\n", p->noeud);
+        return -1;
+    }
+    return 0;
+}
+
+// Lit l'argument de -C ; -1 si la liste est invalide
+int cpu_profil_lire(cpu_profil_t *p, const char *spec) {
+    p->actif = true;
+    p->noeud = -1;
+    if (strncmp(spec, "numa:", 5) == 0) return lire_numa(p, spec + 5);
+    return lire_liste(spec, &p->cpus);
+}
+
+// Épingle le thread appelant sur les CPU du profil ('un_coeur' : sur le
+// premier seulement, pour un réacteur mono-thread)
+int cpu_epingler(const cpu_profil_t *p, bool un_coeur) {
+    if (!p->actif) return 0;
+    cpu_set_t cpus = p->cpus;
+    if (un_coeur) {
+        int premier = 0;
+        while (!CPU_ISSET(premier, &p->cpus)) premier++;
+        CPU_ZERO(&cpus);
+        CPU_SET(premier, &cpus);
+    }
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    if (err) fprintf(stderr, "cpu: affinité refusée (%s)\n", strerror(err));
+    return err ? -1 : 0;
+}
+
+// Au démarrage, avant de créer les autres threads, qui héritent de
+// l'affinité et de la politique mémoire du thread principal
+int cpu_appliquer(const cpu_profil_t *p, bool un_coeur) {
+    if (!p->actif) return 0;
+    if (p->noeud >= 0 && p->noeud < (int)(8 * sizeof(unsigned long))) {
+        unsigned long masque = 1UL << p->noeud;
+        if (syscall(SYS_set_mempolicy, MPOL_PREFERRED, &masque, 8 * sizeof(masque) + 1) < 0)
+            perror("cpu: set_mempolicy");
+    }
+    return cpu_epingler(p, un_coeur);
+}
+
+// Épingle le thread sur le CPU qui reçoit les paquets de 'sockfd', s'il
+// fait partie du profil. Renvoie ce CPU, -1 si le thread ne bouge pas.
+int cpu_suivre(const cpu_profil_t *p, int sockfd) {
+    if (!p->actif) return -1;
+    int cpu = -1;
+    socklen_t len = sizeof(cpu);
+    if (getsockopt(sockfd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &len) < 0 || cpu < 0 || cpu >= CPU_SETSIZE ||
+        !CPU_ISSET(cpu, &p->cpus))
+        return -1;
+    cpu_set_t un;
+    CPU_ZERO(&un);
+    CPU_SET(cpu, &un);
+    return pthread_setaffinity_np(pthread_self(), sizeof(un), &un) == 0 ? cpu : -1;
+}
+
+// -L : un nombre de microsecondes, seul ; pas de valeur négative
+int cpu_busy_poll_lire(cpu_profil_t *p, const char *texte) {
+    char *fin;
+    errno = 0;
+    long us = strtol(texte, &fin, 10);
+    if (fin == texte || *fin || errno || us < 0 || us > INT_MAX) return -1;
+    p->busy_poll = (int)us;
+    return 0;
+}
+
+// recvfrom (et select/poll si net.core.busy_poll est non nul) interroge
+// la file de la carte pendant p->busy_poll µs avant de dormir : moins de
+// latence par bloc, au prix d'un cœur occupé
+void cpu_busy_poll(const cpu_profil_t *p, int sockfd) {
+    if (p->busy_poll > 0 && setsockopt(sockfd, SOL_SOCKET, SO_BUSY_POLL, &p->busy_poll, sizeof(p->busy_poll)) < 0)
+        perror("cpu: SO_BUSY_POLL");
+}
+
+// "CPU 2-5, nœud 0" pour le journal de démarrage
+void cpu_decrire(const cpu_profil_t *p, char *texte, size_t cap) {
+    size_t n = snprintf(texte, cap, "CPU ");
+    for (int c = 0; c < CPU_SETSIZE && n < cap; c++) {
+        if (!CPU_ISSET(c, &p->cpus) || (c > 0 && CPU_ISSET(c - 1, &p->cpus))) continue;
+        int fin = c;
+        while (fin + 1 < CPU_SETSIZE && CPU_ISSET(fin + 1, &p->cpus)) fin++;
+        n += snprintf(texte + n, cap - n, fin > c ? "%s%d-%d" : "%s%d", n > 4 ? "," : "", c, fin);
+    }
+    if (p->noeud >= 0 && n < cap) snprintf(texte + n, cap - n, ", nœud %d", p->noeud);
+}
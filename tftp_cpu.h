@@ -0,0 +1,36 @@
+#ifndef TFTP_CPU_H
+#define TFTP_CPU_H
+
+#include <sched.h>
+#include <stdbool.h>
+
+// Profil de placement des serveurs (-C, -L) : sur quels cœurs tournent
+// les threads, sur quel nœud NUMA vont leurs allocations, et attente
+// active (busy-poll) sur les sockets.
+//
+// -C accepte une liste de CPU ("2-5,8") ou "numa:<interface>" : les CPU
+// du nœud NUMA de la carte réseau, dont la mémoire est alors préférée
+// pour les allocations (set_mempolicy). Les tampons de session sont sur
+// la pile des threads, touchés après l'épinglage : ils sont locaux.
+//
+// Pendant une session, un thread peut suivre la file RSS de son flux :
+// SO_INCOMING_CPU donne le CPU qui a traité ses derniers paquets (celui
+// de l'IRQ de la file) et le thread s'y épingle, les données restant
+// dans le même cache.
+
+typedef struct {
+    bool actif;                 // -C donné
+    cpu_set_t cpus;
+    int noeud;                  // Nœud NUMA préféré pour la mémoire, -1 : aucun
+    int busy_poll;              // Microsecondes d'attente active (SO_BUSY_POLL), 0 : aucune
+} cpu_profil_t;
+
+int  cpu_profil_lire(cpu_profil_t *p, const char *spec);
+int  cpu_busy_poll_lire(cpu_profil_t *p, const char *texte);
+int  cpu_appliquer(const cpu_profil_t *p, bool un_coeur);
+int  cpu_epingler(const cpu_profil_t *p, bool un_coeur);
+int  cpu_suivre(const cpu_profil_t *p, int sockfd);
+void cpu_busy_poll(const cpu_profil_t *p, int sockfd);
+void cpu_decrire(const cpu_profil_t *p, char *texte, size_t cap);
+
+#endif
@@ -0,0 +1,223 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "tftp_durabilite.h"
+
+#define LOT_DOSSIERS_MAX 16     // Répertoires distincts regroupés dans un lot
+
+static durabilite_mode_t mode_actif = DURABILITE_AUCUNE;
+
+// File du thread de validation, et demandes asynchrones déjà publiées
+static pthread_mutex_t verrou = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t travail = PTHREAD_COND_INITIALIZER;  // Le thread de validation attend une demande
+static pthread_cond_t valide = PTHREAD_COND_INITIALIZER;   // Les threads bloqués attendent leur lot
+static durabilite_demande_t *file = NULL;
+static durabilite_demande_t *terminees = NULL;
+static int evfd = -1;
+
+static const char *noms[] = { "none", "close", "group" };
+
+int durabilite_lire(const char *texte, durabilite_mode_t *mode) {
+    for (int i = 0; i < 3; i++) {
+        if (strcmp(texte, noms[i]) == 0) {
+            *mode = (durabilite_mode_t)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const char *durabilite_nom(durabilite_mode_t mode) {
+    return noms[mode];
+}
+
+durabilite_mode_t durabilite_mode(void) {
+    return mode_actif;
+}
+
+// Répertoire de 'chemin', qui contient l'entrée créée par rename()
+static void dossier(const char *chemin, char *out, size_t len) {
+    const char *fin = strrchr(chemin, '/');
+    if (!fin) snprintf(out, len, ".");
+    else snprintf(out, len, "%.*s", (int)(fin - chemin + 1), chemin);
+}
+
+static int synchroniser_dossier(const char *chemin) {
+    int fd = open(chemin, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0 || fsync(fd) < 0) {
+        perror(chemin);
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    close(fd);
+    return 0;
+}
+
+// Mode close : données, rename(), puis l'entrée du répertoire
+static int publier_seule(version_t *v) {
+    if (v->fd >= 0 && fdatasync(v->fd) < 0) {
+        perror("fdatasync");
+        version_abort(v);
+        return -1;
+    }
+    if (version_publish(v) < 0) return -1;
+    char d[512];
+    dossier(v->chemin, d, sizeof(d));
+    return synchroniser_dossier(d);
+}
+
+// Un lot : deux validations du journal quel que soit le nombre d'uploads,
+// une pour les contenus, une pour les répertoires
+static void valider_lot(durabilite_demande_t *lot) {
+    // Contenus : l'écriture de tous les fichiers du lot est lancée avant
+    // d'en attendre aucun ; le premier fdatasync valide le journal pour
+    // tous, les suivants n'ont plus rien à vider. Contrairement à syncfs,
+    // les autres données du système de fichiers ne sont pas touchées.
+    for (durabilite_demande_t *d = lot; d; d = d->suivant) {
+        d->resultat = d->avant ? d->avant(d->arg) : 0;
+        if (d->resultat == 0) sync_file_range(d->ver->fd, 0, 0, SYNC_FILE_RANGE_WRITE);
+    }
+    for (durabilite_demande_t *d = lot; d; d = d->suivant) {
+        if (d->resultat < 0) continue;
+        d->resultat = fdatasync(d->ver->fd);
+        if (d->resultat < 0) perror("fdatasync");
+    }
+
+    // Publication, puis un fsync par répertoire touché
+    char dossiers[LOT_DOSSIERS_MAX][512];
+    int dossiers_res[LOT_DOSSIERS_MAX], nb_dossiers = 0;
+    for (durabilite_demande_t *d = lot; d; d = d->suivant) {
+        if (d->resultat < 0) {
+            version_abort(d->ver);
+            continue;
+        }
+        if ((d->resultat = version_publish(d->ver)) < 0) continue;
+        char nom[512];
+        dossier(d->ver->chemin, nom, sizeof(nom));
+        int i = 0;
+        while (i < nb_dossiers && strcmp(dossiers[i], nom) != 0) i++;
+        if (i == LOT_DOSSIERS_MAX) {
+            d->resultat = synchroniser_dossier(nom);
+            continue;
+        }
+        if (i == nb_dossiers) {
+            snprintf(dossiers[i], sizeof(dossiers[i]), "%s", nom);
+            dossiers_res[nb_dossiers++] = synchroniser_dossier(nom);
+        }
+        d->resultat = dossiers_res[i];
+    }
+
+    // Une demande attendue disparaît dès que son thread est réveillé :
+    // 'suivant' est lu avant de la marquer faite
+    bool signaler = false;
+    pthread_mutex_lock(&verrou);
+    for (durabilite_demande_t *d = lot, *suivant; d; d = suivant) {
+        suivant = d->suivant;
+        if (!d->attente) {
+            d->suivant = terminees;
+            terminees = d;
+            signaler = true;
+        }
+        d->fait = true;
+    }
+    pthread_cond_broadcast(&valide);
+    pthread_mutex_unlock(&verrou);
+    if (signaler) {
+        uint64_t un = 1;
+        if (write(evfd, &un, sizeof(un)) < 0) perror("eventfd");
+    }
+}
+
+// Thread de validation : les uploads finis pendant qu'un lot s'écrit
+// attendent dans la file et forment le lot suivant
+static void *valideur(void *arg) {
+    (void)arg;
+    for (;;) {
+        pthread_mutex_lock(&verrou);
+        while (!file) pthread_cond_wait(&travail, &verrou);
+        durabilite_demande_t *lot = file;
+        file = NULL;
+        pthread_mutex_unlock(&verrou);
+        valider_lot(lot);
+    }
+    return NULL;
+}
+
+// Au démarrage du serveur ; -1 si le mode group ne peut pas démarrer
+int durabilite_demarrer(durabilite_mode_t mode) {
+    mode_actif = mode;
+    if (mode != DURABILITE_GROUPE) return 0;
+    // Pas de repli silencieux sur "none" : le client croirait ses uploads
+    // sur disque. L'appelant s'arrête.
+    evfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (evfd < 0) {
+        perror("durabilite: eventfd");
+        return -1;
+    }
+    pthread_t t;
+    int err = pthread_create(&t, NULL, valideur, NULL);
+    if (err != 0) {
+        fprintf(stderr, "durabilite: thread de validation : %s\n", strerror(err));
+        close(evfd);
+        evfd = -1;
+        return -1;
+    }
+    pthread_detach(t);
+    return 0;
+}
+
+static void deposer(durabilite_demande_t *d) {
+    d->fait = false;
+    d->suivant = file;
+    file = d;
+    pthread_cond_signal(&travail);
+}
+
+// Publie 'v' selon le mode, en bloquant jusqu'à ce qu'elle soit durable ;
+// 0 ou -1 comme version_publish
+int durabilite_publier(version_t *v) {
+    if (mode_actif == DURABILITE_AUCUNE) return version_publish(v);
+    if (mode_actif == DURABILITE_FERMETURE) return publier_seule(v);
+
+    durabilite_demande_t d = { .ver = v, .resultat = -1, .attente = true };
+    pthread_mutex_lock(&verrou);
+    deposer(&d);
+    while (!d.fait) pthread_cond_wait(&valide, &verrou);
+    pthread_mutex_unlock(&verrou);
+    return d.resultat;
+}
+
+// Mode group, sans bloquer : 'd' revient par durabilite_terminees() quand
+// durabilite_fd() devient lisible
+void durabilite_soumettre(durabilite_demande_t *d) {
+    d->attente = false;
+    d->resultat = -1;
+    pthread_mutex_lock(&verrou);
+    deposer(d);
+    pthread_mutex_unlock(&verrou);
+}
+
+int durabilite_fd(void) {
+    return evfd;
+}
+
+// Demandes asynchrones publiées depuis le dernier appel, chaînées par
+// 'suivant'
+durabilite_demande_t *durabilite_terminees(void) {
+    uint64_t n;
+    // Compteur remis à zéro avant de prendre la liste : une demande publiée
+    // entre les deux le relance
+    if (read(evfd, &n, sizeof(n)) < 0 && errno != EAGAIN) perror("eventfd");
+    pthread_mutex_lock(&verrou);
+    durabilite_demande_t *liste = terminees;
+    terminees = NULL;
+    pthread_mutex_unlock(&verrou);
+    return liste;
+}
@@ -0,0 +1,56 @@
+#ifndef TFTP_DURABILITE_H
+#define TFTP_DURABILITE_H
+
+#include <stdbool.h>
+
+#include "tftp_version.h"
+
+// Durabilité des uploads (option -D des serveurs) : quand l'ACK final
+// d'un WRQ part-il ?
+//
+//   none  : dès le rename(), le contenu est encore dans le cache de pages
+//           (comportement historique) ;
+//   close : chaque upload est écrit sur disque (fdatasync) avant son
+//           rename(), puis le répertoire (fsync), par le thread de la session ;
+//   group : les uploads terminés sont confiés à un thread de validation qui
+//           les traite par lots : écriture lancée pour tout le lot
+//           (sync_file_range) puis fdatasync, les rename(), puis un fsync
+//           par répertoire. Les uploads finis pendant qu'un lot s'écrit
+//           forment le suivant.
+//
+// Avec close et group, l'ACK final n'est envoyé qu'une fois la version et
+// son nom sur disque : un client qui l'a reçu retrouve son fichier après
+// une panne.
+
+typedef enum {
+    DURABILITE_AUCUNE,
+    DURABILITE_FERMETURE,
+    DURABILITE_GROUPE
+} durabilite_mode_t;
+
+// Demande asynchrone (mode group, moteur non bloquant) : 'ver' est publiée
+// par le thread de validation, puis la demande passe dans la liste rendue
+// par durabilite_terminees(). 'avant', s'il est donné, y termine d'abord
+// l'écriture de la version (-1 : elle est abandonnée).
+typedef struct durabilite_demande {
+    version_t *ver;
+    int (*avant)(void *arg);
+    void *arg;
+    int resultat;                       // Celui de version_publish
+    void *ctx;                          // Libre pour le moteur
+    bool attente;                       // Interne : un thread bloqué l'attend
+    bool fait;
+    struct durabilite_demande *suivant;
+} durabilite_demande_t;
+
+int  durabilite_lire(const char *texte, durabilite_mode_t *mode);
+const char *durabilite_nom(durabilite_mode_t mode);
+int  durabilite_demarrer(durabilite_mode_t mode);
+durabilite_mode_t durabilite_mode(void);
+
+int  durabilite_publier(version_t *v);
+void durabilite_soumettre(durabilite_demande_t *d);
+int  durabilite_fd(void);
+durabilite_demande_t *durabilite_terminees(void);
+
+#endif
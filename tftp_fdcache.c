@@ -0,0 +1,193 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "tftp_fdcache.h"
+
+#define FDCACHE_MAX 64  // Descripteurs gardés ouverts au maximum
+
+static fdcache_entry_t *entrees = NULL;
+static int nb_entrees = 0;
+static unsigned long horloge = 0;
+static pthread_mutex_t fdcache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void detacher(fdcache_entry_t *e) {
+    for (fdcache_entry_t **pp = &entrees; *pp; pp = &(*pp)->suivant) {
+        if (*pp == e) {
+            *pp = e->suivant;
+            nb_entrees--;
+            return;
+        }
+    }
+}
+
+static void fermer(fdcache_entry_t *e) {
+    close(e->fd);
+    free(e);
+}
+
+// Libère la place de l'entrée inutilisée la plus ancienne
+static void evincer_lru(void) {
+    fdcache_entry_t *lru = NULL;
+    for (fdcache_entry_t *e = entrees; e; e = e->suivant) {
+        if (e->refs == 0 && (!lru || e->dernier_usage < lru->dernier_usage)) lru = e;
+    }
+    if (lru) {
+        detacher(lru);
+        fermer(lru);
+    }
+}
+
+fdcache_entry_t *fdcache_acquire(const char *chemin) {
+    struct stat st;
+    if (stat(chemin, &st) < 0) return NULL;
+    if (!S_ISREG(st.st_mode)) {
+        errno = EISDIR;
+        return NULL;
+    }
+
+    pthread_mutex_lock(&fdcache_mutex);
+    for (fdcache_entry_t *e = entrees; e; e = e->suivant) {
+        if (e->obsolete || strcmp(e->chemin, chemin) != 0) continue;
+        if (e->dev == st.st_dev && e->inode == st.st_ino) {
+            // Même fichier : la taille a pu changer (écriture sur place)
+            e->size = st.st_size;
+            e->mtime = st.st_mtime;
+            e->refs++;
+            e->dernier_usage = ++horloge;
+            pthread_mutex_unlock(&fdcache_mutex);
+            return e;
+        }
+        // Le chemin désigne désormais un autre inode
+        e->obsolete = true;
+        if (e->refs == 0) {
+            detacher(e);
+            fermer(e);
+        }
+        break;
+    }
+    pthread_mutex_unlock(&fdcache_mutex);
+
+    int fd = open(chemin, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return NULL;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return NULL;
+    }
+
+    fdcache_entry_t *e = calloc(1, sizeof(*e));
+    if (!e) {
+        close(fd);
+        return NULL;
+    }
+    strncpy(e->chemin, chemin, sizeof(e->chemin) - 1);
+    e->dev = st.st_dev;
+    e->inode = st.st_ino;
+    e->mtime = st.st_mtime;
+    e->size = st.st_size;
+    e->fd = fd;
+    e->refs = 1;
+
+    pthread_mutex_lock(&fdcache_mutex);
+    // Un autre thread a pu ouvrir le même fichier entre-temps
+    for (fdcache_entry_t *x = entrees; x; x = x->suivant) {
+        if (!x->obsolete && x->dev == e->dev && x->inode == e->inode && strcmp(x->chemin, chemin) == 0) {
+            x->refs++;
+            x->dernier_usage = ++horloge;
+            pthread_mutex_unlock(&fdcache_mutex);
+            fermer(e);
+            return x;
+        }
+    }
+    if (nb_entrees >= FDCACHE_MAX) evincer_lru();
+    e->dernier_usage = ++horloge;
+    e->suivant = entrees;
+    entrees = e;
+    nb_entrees++;
+    pthread_mutex_unlock(&fdcache_mutex);
+    return e;
+}
+
+// Descripteur ouvert ailleurs (session reprise d'un autre processus, -H)
+// sur 'chemin' : rejoint l'entrée du même inode s'il y en a une. S'il ne
+// désigne plus la version publiée, l'entrée reste hors du cache, fermée
+// au dernier release. Le descripteur appartient ensuite au cache.
+fdcache_entry_t *fdcache_adopter(const char *chemin, int fd) {
+    struct stat st, actuel;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return NULL;
+    }
+    bool publie = stat(chemin, &actuel) == 0 && actuel.st_dev == st.st_dev && actuel.st_ino == st.st_ino;
+
+    pthread_mutex_lock(&fdcache_mutex);
+    for (fdcache_entry_t *x = entrees; publie && x; x = x->suivant) {
+        if (!x->obsolete && x->dev == st.st_dev && x->inode == st.st_ino && strcmp(x->chemin, chemin) == 0) {
+            x->refs++;
+            x->dernier_usage = ++horloge;
+            pthread_mutex_unlock(&fdcache_mutex);
+            close(fd);
+            return x;
+        }
+    }
+    fdcache_entry_t *e = calloc(1, sizeof(*e));
+    if (!e) {
+        pthread_mutex_unlock(&fdcache_mutex);
+        close(fd);
+        return NULL;
+    }
+    strncpy(e->chemin, chemin, sizeof(e->chemin) - 1);
+    e->dev = st.st_dev;
+    e->inode = st.st_ino;
+    e->mtime = st.st_mtime;
+    e->size = st.st_size;
+    e->fd = fd;
+    e->refs = 1;
+    e->dernier_usage = ++horloge;
+    e->obsolete = !publie;
+    if (publie) {
+        if (nb_entrees >= FDCACHE_MAX) evincer_lru();
+        e->suivant = entrees;
+        entrees = e;
+        nb_entrees++;
+    }
+    pthread_mutex_unlock(&fdcache_mutex);
+    return e;
+}
+
+void fdcache_release(fdcache_entry_t *e) {
+    if (!e) return;
+    pthread_mutex_lock(&fdcache_mutex);
+    e->refs--;
+    if (e->refs == 0 && e->obsolete) {
+        detacher(e);
+        fermer(e);
+    } else if (e->refs == 0 && nb_entrees > FDCACHE_MAX) {
+        evincer_lru();
+    }
+    pthread_mutex_unlock(&fdcache_mutex);
+}
+
+// Appelé quand un WRQ remplace le fichier : les lecteurs en cours gardent
+// leur descripteur, les suivants rouvriront le nouveau contenu.
+void fdcache_invalidate(const char *chemin) {
+    pthread_mutex_lock(&fdcache_mutex);
+    fdcache_entry_t *e = entrees;
+    while (e) {
+        fdcache_entry_t *suivant = e->suivant;
+        if (strcmp(e->chemin, chemin) == 0) {
+            e->obsolete = true;
+            if (e->refs == 0) {
+                detacher(e);
+                fermer(e);
+            }
+        }
+        e = suivant;
+    }
+    pthread_mutex_unlock(&fdcache_mutex);
+}
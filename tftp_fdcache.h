@@ -0,0 +1,31 @@
+#ifndef TFTP_FDCACHE_H
+#define TFTP_FDCACHE_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+#include <time.h>
+
+// Cache de descripteurs ouverts en lecture, partagés entre sessions.
+// Une entrée est identifiée par son chemin et son inode : toutes les
+// sessions qui lisent le même fichier utilisent le même fd avec pread(),
+// sans fopen/fclose ni position de lecture propre.
+
+typedef struct fdcache_entry {
+    char chemin[512];
+    dev_t dev;
+    ino_t inode;
+    time_t mtime;
+    off_t size;
+    int fd;
+    int refs;                   // Sessions utilisant l'entrée
+    bool obsolete;              // Fichier remplacé : fermé au dernier release
+    unsigned long dernier_usage;
+    struct fdcache_entry *suivant;
+} fdcache_entry_t;
+
+fdcache_entry_t *fdcache_acquire(const char *chemin);
+fdcache_entry_t *fdcache_adopter(const char *chemin, int fd);
+void fdcache_release(fdcache_entry_t *e);
+void fdcache_invalidate(const char *chemin);
+
+#endif
@@ -0,0 +1,155 @@
+#include <errno.h>
+#include <linux/filter.h>
+#include <linux/sock_diag.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+
+#include "tftp_bpf.h"
+#include "tftp_filtre.h"
+
+#define UDP_ENTETE 8            // Le filtre voit le datagramme depuis l'en-tête UDP
+
+static int carte = -1;          // Compteurs par cause (filtre eBPF), -1 : filtre classique
+
+// r7 = longueur, r8 = cause ; chaque test saute au comptage avec sa cause.
+// Le paquet entier est gardé (r0 = longueur) ou jeté (r0 = 0).
+static int assembler(struct bpf_insn *p, int table) {
+    int n = 0, vers_compte[4], nb_sauts = 0;
+
+    p[n++] = MOV_REG(6, 1);                                 // r6 = struct __sk_buff *
+    p[n++] = CHARGER(BPF_W, 7, 6, 0);                       // r7 = len
+    p[n++] = MOV_IMM(8, FILTRE_COURT);
+    vers_compte[nb_sauts++] = n;
+    p[n++] = SAUT_IMM(BPF_JLT, 7, UDP_ENTETE + 4);
+    p[n++] = PAQUET(BPF_H, UDP_ENTETE);                     // r0 = opcode
+    p[n++] = MOV_IMM(8, FILTRE_OPCODE);
+    p[n++] = INSN(BPF_JMP | BPF_JEQ | BPF_K, 0, 0, 1, 1);   // RRQ : saute le test WRQ
+    vers_compte[nb_sauts++] = n;
+    p[n++] = SAUT_IMM(BPF_JNE, 0, 2);
+    p[n++] = MOV_REG(9, 7);
+    p[n++] = ALU_IMM(BPF_ADD, 9, -1);
+    p[n++] = PAQUET_IND(BPF_B, 9, 0);                       // r0 = dernier octet
+    p[n++] = MOV_IMM(8, FILTRE_NON_TERMINE);
+    vers_compte[nb_sauts++] = n;
+    p[n++] = SAUT_IMM(BPF_JNE, 0, 0);
+    p[n++] = MOV_IMM(8, FILTRE_ACCEPTE);
+
+    for (int i = 0; i < nb_sauts; i++) p[vers_compte[i]].off = n - vers_compte[i] - 1;
+    p[n++] = STOCKER(BPF_W, 10, 8, -4);                     // Clé sur la pile
+    p[n++] = MOV_REG(2, 10);
+    p[n++] = ALU_IMM(BPF_ADD, 2, -4);
+    p[n++] = CARTE(1, table);
+    p[n++] = SUITE();
+    p[n++] = APPEL(BPF_FUNC_map_lookup_elem);
+    p[n++] = INSN(BPF_JMP | BPF_JEQ | BPF_K, 0, 0, 2, 0);   // Introuvable : pas de comptage
+    p[n++] = MOV_IMM(1, 1);
+    p[n++] = AJOUTER(BPF_DW, 0, 1, 0);
+    p[n++] = MOV_IMM(0, 0);
+    p[n++] = INSN(BPF_JMP | BPF_JNE | BPF_K, 8, 0, 1, FILTRE_ACCEPTE);
+    p[n++] = MOV_REG(0, 7);
+    p[n++] = SORTIE();
+    return n;
+}
+
+static int attacher_ebpf(int sockfd) {
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.map_type = BPF_MAP_TYPE_ARRAY;
+    attr.key_size = sizeof(uint32_t);
+    attr.value_size = sizeof(uint64_t);
+    attr.max_entries = FILTRE_CAUSES;
+    int table = bpf(BPF_MAP_CREATE, &attr);
+    if (table < 0) return -1;
+
+    struct bpf_insn insns[40];
+    memset(&attr, 0, sizeof(attr));
+    attr.prog_type = BPF_PROG_TYPE_SOCKET_FILTER;
+    attr.insns = (uintptr_t)insns;
+    attr.insn_cnt = assembler(insns, table);
+    attr.license = (uintptr_t)"GPL";
+    int prog = bpf(BPF_PROG_LOAD, &attr);
+    // La socket garde une référence au programme, qui garde la table
+    if (prog < 0 || setsockopt(sockfd, SOL_SOCKET, SO_ATTACH_BPF, &prog, sizeof(prog)) < 0) {
+        if (prog >= 0) close(prog);
+        close(table);
+        return -1;
+    }
+    close(prog);
+    carte = table;
+    return 0;
+}
+
+// Même test en BPF classique : A = longueur, puis opcode, puis dernier octet
+static int attacher_classique(int sockfd) {
+    struct sock_filter code[] = {
+        { BPF_LD | BPF_W | BPF_LEN, 0, 0, 0 },
+        { BPF_JMP | BPF_JGE | BPF_K, 0, 9, UDP_ENTETE + 4 },
+        { BPF_LD | BPF_H | BPF_ABS, 0, 0, UDP_ENTETE },
+        { BPF_JMP | BPF_JEQ | BPF_K, 1, 0, 1 },
+        { BPF_JMP | BPF_JEQ | BPF_K, 0, 6, 2 },
+        { BPF_LD | BPF_W | BPF_LEN, 0, 0, 0 },
+        { BPF_ALU | BPF_SUB | BPF_K, 0, 0, 1 },
+        { BPF_MISC | BPF_TAX, 0, 0, 0 },
+        { BPF_LD | BPF_B | BPF_IND, 0, 0, 0 },
+        { BPF_JMP | BPF_JEQ | BPF_K, 0, 1, 0 },
+        { BPF_RET | BPF_K, 0, 0, 0xffffffff },
+        { BPF_RET | BPF_K, 0, 0, 0 },
+    };
+    struct sock_fprog prog = { .len = sizeof(code) / sizeof(code[0]), .filter = code };
+    return setsockopt(sockfd, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog));
+}
+
+// Attache le filtre à la socket d'écoute. 1 : eBPF avec compteurs par
+// cause, 0 : BPF classique, -1 : aucun filtre (tout arrive au serveur).
+int filtre_attacher(int sockfd) {
+    if (attacher_ebpf(sockfd) == 0) return 1;
+    if (attacher_classique(sockfd) == 0) return 0;
+    perror("SO_ATTACH_FILTER");
+    return -1;
+}
+
+void filtre_lire(int sockfd, filtre_compteurs_t *c) {
+    memset(c, 0, sizeof(*c));
+    c->detail = carte >= 0;
+    for (uint32_t cle = 0; c->detail && cle < FILTRE_CAUSES; cle++) {
+        union bpf_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.map_fd = carte;
+        attr.key = (uintptr_t)&cle;
+        attr.value = (uintptr_t)&c->par_cause[cle];
+        bpf(BPF_MAP_LOOKUP_ELEM, &attr);
+        if (cle != FILTRE_ACCEPTE) c->rejetes += c->par_cause[cle];
+    }
+    if (c->detail) return;
+
+    // Filtre classique : les rejets comptent dans les pertes de la socket,
+    // avec les débordements du tampon de réception
+    uint32_t info[SK_MEMINFO_VARS];
+    socklen_t len = sizeof(info);
+    if (getsockopt(sockfd, SOL_SOCKET, SO_MEMINFO, info, &len) == 0 && len > SK_MEMINFO_DROPS * sizeof(uint32_t))
+        c->rejetes = info[SK_MEMINFO_DROPS];
+}
+
+// Bilan des rejets, au plus toutes les FILTRE_PERIODE secondes et
+// seulement s'il a changé. À appeler depuis la boucle du thread d'écoute.
+void filtre_bilan(int sockfd, const char *prefixe) {
+    static time_t dernier = 0;
+    static unsigned long long deja = 0;
+    time_t maintenant = time(NULL);
+    if (maintenant - dernier < FILTRE_PERIODE) return;
+    dernier = maintenant;
+
+    filtre_compteurs_t c;
+    filtre_lire(sockfd, &c);
+    if (c.rejetes == deja) return;
+    deja = c.rejetes;
+    if (c.detail)
+        printf("%s Filter dropped %llu packets: %llu runts, %llu non-requests, %llu unterminated (%llu requests passed)\n",
+               prefixe, c.rejetes, c.par_cause[FILTRE_COURT], c.par_cause[FILTRE_OPCODE],
+               c.par_cause[FILTRE_NON_TERMINE], c.par_cause[FILTRE_ACCEPTE]);
+    else
+        printf("%s Filter dropped %llu packets (with receive buffer overflows)\n", prefixe, c.rejetes);
+}
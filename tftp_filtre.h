@@ -0,0 +1,39 @@
+#ifndef TFTP_FILTRE_H
+#define TFTP_FILTRE_H
+
+#include <stdbool.h>
+
+// Filtre de la socket d'écoute (port 69) : le noyau jette, avant tout
+// réveil du processus et tout recvfrom, ce qui ne peut pas être une
+// requête :
+//   - datagramme de moins de 4 octets ;
+//   - opcode autre que RRQ (1) ou WRQ (2) : ACK/DATA égarés, balayages ;
+//   - dernier octet non nul : nom, mode ou option tronqué.
+// Les requêtes qui passent sont encore validées en détail par le serveur.
+//
+// Le filtre est un programme eBPF (SO_ATTACH_BPF) qui compte les rejets
+// par cause dans une table. Si eBPF est refusé (noyau ancien, bpf
+// interdit), le même test est attaché en BPF classique (SO_ATTACH_FILTER),
+// sans détail : seul le total des paquets jetés sur la socket est connu.
+
+#define FILTRE_PERIODE 60       // Secondes entre deux bilans des rejets
+
+typedef enum {
+    FILTRE_COURT,
+    FILTRE_OPCODE,
+    FILTRE_NON_TERMINE,
+    FILTRE_ACCEPTE,
+    FILTRE_CAUSES
+} filtre_cause_t;
+
+typedef struct {
+    bool detail;                                // Compteurs par cause (eBPF)
+    unsigned long long par_cause[FILTRE_CAUSES];
+    unsigned long long rejetes;                 // Total jeté sur la socket
+} filtre_compteurs_t;
+
+int  filtre_attacher(int sockfd);
+void filtre_lire(int sockfd, filtre_compteurs_t *c);
+void filtre_bilan(int sockfd, const char *prefixe);
+
+#endif
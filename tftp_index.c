@@ -0,0 +1,387 @@
+#include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "tftp_index.h"
+#include "tftp_version.h"
+
+#define INDEX_BUCKETS_INIT 256
+#define INDEX_WATCH_MASK (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | \
+                          IN_CLOSE_WRITE | IN_ATTRIB | IN_DELETE_SELF | IN_ONLYDIR)
+
+typedef enum {
+    NOEUD_FICHIER,
+    NOEUD_DOSSIER,
+    NOEUD_OPAQUE    // Lien symbolique ou dossier non surveillé : le disque fait foi
+} noeud_type_t;
+
+typedef struct index_noeud {
+    char *nom;                  // Chemin relatif à la racine ("pxelinux.cfg/default")
+    noeud_type_t type;
+    index_entry_t info;
+    struct index_noeud *suivant;
+} index_noeud_t;
+
+typedef struct {
+    int wd;
+    char *dossier;              // "" pour la racine
+} index_watch_t;
+
+static struct {
+    char racine[256];
+    int inotify_fd;
+    // Écrit sous le verrou en écriture, lu aussi sans verrou par le test
+    // rapide des lookups : accès atomiques (relaxed, le verrou ordonne le reste)
+    bool actif;
+
+    index_noeud_t **buckets;
+    size_t nb_buckets;
+    size_t nb_entrees;
+
+    index_watch_t *watches;
+    size_t nb_watches;
+    size_t cap_watches;
+
+    pthread_rwlock_t lock;
+} idx = { .inotify_fd = -1, .lock = PTHREAD_RWLOCK_INITIALIZER };
+
+// --- Table de hachage ---
+
+static uint32_t hash_nom(const char *nom) {
+    uint32_t h = 2166136261u; // FNV-1a
+    while (*nom) {
+        h ^= (unsigned char)*nom++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static index_noeud_t *table_find(const char *nom) {
+    if (!idx.buckets) return NULL;
+    index_noeud_t *n = idx.buckets[hash_nom(nom) & (idx.nb_buckets - 1)];
+    while (n && strcmp(n->nom, nom) != 0) n = n->suivant;
+    return n;
+}
+
+static void table_grow(void) {
+    size_t nb = idx.nb_buckets ? idx.nb_buckets * 2 : INDEX_BUCKETS_INIT;
+    index_noeud_t **b = calloc(nb, sizeof(*b));
+    if (!b) return; // On garde l'ancienne table, simplement plus chargée
+    for (size_t i = 0; i < idx.nb_buckets; i++) {
+        index_noeud_t *n = idx.buckets[i];
+        while (n) {
+            index_noeud_t *suivant = n->suivant;
+            uint32_t h = hash_nom(n->nom) & (nb - 1);
+            n->suivant = b[h];
+            b[h] = n;
+            n = suivant;
+        }
+    }
+    free(idx.buckets);
+    idx.buckets = b;
+    idx.nb_buckets = nb;
+}
+
+static void table_put(const char *nom, noeud_type_t type, const struct stat *st) {
+    index_noeud_t *n = table_find(nom);
+    if (!n) {
+        if (idx.nb_entrees >= idx.nb_buckets * 2) table_grow();
+        if (!idx.buckets) return;
+        n = calloc(1, sizeof(*n));
+        if (!n) return;
+        n->nom = strdup(nom);
+        if (!n->nom) { free(n); return; }
+        uint32_t h = hash_nom(nom) & (idx.nb_buckets - 1);
+        n->suivant = idx.buckets[h];
+        idx.buckets[h] = n;
+        idx.nb_entrees++;
+    }
+    n->type = type;
+    n->info.size = st->st_size;
+    n->info.inode = st->st_ino;
+    n->info.mtime = st->st_mtime;
+}
+
+static void table_remove(const char *nom) {
+    if (!idx.buckets) return;
+    index_noeud_t **pp = &idx.buckets[hash_nom(nom) & (idx.nb_buckets - 1)];
+    while (*pp) {
+        if (strcmp((*pp)->nom, nom) == 0) {
+            index_noeud_t *n = *pp;
+            *pp = n->suivant;
+            free(n->nom);
+            free(n);
+            idx.nb_entrees--;
+            return;
+        }
+        pp = &(*pp)->suivant;
+    }
+}
+
+static void table_clear(void) {
+    for (size_t i = 0; i < idx.nb_buckets; i++) {
+        index_noeud_t *n = idx.buckets[i];
+        while (n) {
+            index_noeud_t *suivant = n->suivant;
+            free(n->nom);
+            free(n);
+            n = suivant;
+        }
+        idx.buckets[i] = NULL;
+    }
+    idx.nb_entrees = 0;
+}
+
+// --- Surveillance inotify ---
+
+static const char *watch_dossier(int wd) {
+    for (size_t i = 0; i < idx.nb_watches; i++)
+        if (idx.watches[i].wd == wd) return idx.watches[i].dossier;
+    return NULL;
+}
+
+static int watch_add(const char *rel) {
+    char chemin[512];
+    snprintf(chemin, sizeof(chemin), "%s/%s", idx.racine, rel);
+    int wd = inotify_add_watch(idx.inotify_fd, chemin, INDEX_WATCH_MASK);
+    if (wd < 0) return -1;
+
+    if (watch_dossier(wd)) return 0; // Déjà surveillé
+    if (idx.nb_watches == idx.cap_watches) {
+        size_t cap = idx.cap_watches ? idx.cap_watches * 2 : 16;
+        index_watch_t *w = realloc(idx.watches, cap * sizeof(*w));
+        if (!w) { inotify_rm_watch(idx.inotify_fd, wd); return -1; }
+        idx.watches = w;
+        idx.cap_watches = cap;
+    }
+    idx.watches[idx.nb_watches].wd = wd;
+    idx.watches[idx.nb_watches].dossier = strdup(rel);
+    idx.nb_watches++;
+    return 0;
+}
+
+static void watch_remove(int wd) {
+    for (size_t i = 0; i < idx.nb_watches; i++) {
+        if (idx.watches[i].wd == wd) {
+            free(idx.watches[i].dossier);
+            idx.watches[i] = idx.watches[--idx.nb_watches];
+            return;
+        }
+    }
+}
+
+static void watch_clear(void) {
+    for (size_t i = 0; i < idx.nb_watches; i++) {
+        inotify_rm_watch(idx.inotify_fd, idx.watches[i].wd);
+        free(idx.watches[i].dossier);
+    }
+    idx.nb_watches = 0;
+}
+
+// --- Parcours du répertoire ---
+
+static void chemin_relatif(char *out, size_t len, const char *dossier, const char *nom) {
+    if (dossier[0]) snprintf(out, len, "%s/%s", dossier, nom);
+    else snprintf(out, len, "%s", nom);
+}
+
+static void refresh_locked(const char *rel);
+
+static void scan_dossier(const char *rel) {
+    char chemin[512];
+    snprintf(chemin, sizeof(chemin), "%s/%s", idx.racine, rel);
+
+    // Un dossier que l'on ne peut pas surveiller reste opaque : ses noms
+    // seront toujours vérifiés sur le disque.
+    if (watch_add(rel) < 0) {
+        struct stat st;
+        if (rel[0] && lstat(chemin, &st) == 0) table_put(rel, NOEUD_OPAQUE, &st);
+        return;
+    }
+
+    DIR *d = opendir(chemin);
+    if (!d) return;
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL) {
+        if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0) continue;
+        char sous[512];
+        chemin_relatif(sous, sizeof(sous), rel, e->d_name);
+        refresh_locked(sous);
+    }
+    closedir(d);
+}
+
+static void refresh_locked(const char *rel) {
+    char chemin[512];
+    struct stat st;
+    snprintf(chemin, sizeof(chemin), "%s/%s", idx.racine, rel);
+
+    // Versions en cours d'écriture : jamais servies
+    if (lstat(chemin, &st) < 0 || version_interne(rel)) {
+        table_remove(rel);
+        return;
+    }
+    if (S_ISREG(st.st_mode)) {
+        table_put(rel, NOEUD_FICHIER, &st);
+    } else if (S_ISDIR(st.st_mode)) {
+        bool nouveau = table_find(rel) == NULL;
+        table_put(rel, NOEUD_DOSSIER, &st);
+        if (nouveau) scan_dossier(rel);
+    } else {
+        table_put(rel, NOEUD_OPAQUE, &st);
+    }
+}
+
+static void rescan_locked(void) {
+    watch_clear();
+    table_clear();
+    if (watch_add("") < 0) {
+        // La racine a disparu : on retombe sur l'accès disque classique
+        __atomic_store_n(&idx.actif, false, __ATOMIC_RELAXED);
+        return;
+    }
+    scan_dossier("");
+    __atomic_store_n(&idx.actif, true, __ATOMIC_RELAXED);
+}
+
+// --- API ---
+
+int index_init(const char *racine) {
+    strncpy(idx.racine, racine, sizeof(idx.racine) - 1);
+    size_t l = strlen(idx.racine);
+    while (l > 1 && idx.racine[l - 1] == '/') idx.racine[--l] = '\0';
+
+    idx.inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (idx.inotify_fd < 0) {
+        perror("inotify_init1");
+        return -1;
+    }
+
+    pthread_rwlock_wrlock(&idx.lock);
+    table_grow();
+    rescan_locked();
+    bool actif = idx.actif;
+    size_t nb = idx.nb_entrees;
+    pthread_rwlock_unlock(&idx.lock);
+
+    if (!actif) {
+        close(idx.inotify_fd);
+        idx.inotify_fd = -1;
+        return -1;
+    }
+    printf("[INDEX] %zu entrées indexées dans '%s'\n", nb, idx.racine);
+    return 0;
+}
+
+int index_fd(void) {
+    return idx.inotify_fd;
+}
+
+void index_process_events(void) {
+    char buf[8192] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    if (idx.inotify_fd < 0) return;
+
+    for (;;) {
+        ssize_t len = read(idx.inotify_fd, buf, sizeof(buf));
+        if (len <= 0) break; // EAGAIN : plus rien à lire
+
+        bool rescan = false;
+        pthread_rwlock_wrlock(&idx.lock);
+        for (char *p = buf; p < buf + len; ) {
+            struct inotify_event *ev = (struct inotify_event *)p;
+            p += sizeof(*ev) + ev->len;
+
+            if (ev->mask & IN_Q_OVERFLOW) { rescan = true; continue; }
+            if (ev->mask & IN_IGNORED) { watch_remove(ev->wd); continue; }
+            const char *dossier = watch_dossier(ev->wd);
+            if (!dossier) continue;
+            if (ev->mask & IN_DELETE_SELF) {
+                if (dossier[0] == '\0') rescan = true; // Racine supprimée
+                continue;
+            }
+            if (ev->len == 0) continue;
+
+            // Les déplacements de dossiers invalident les chemins des watches
+            // existantes : on reconstruit tout, c'est rare.
+            if ((ev->mask & IN_ISDIR) && (ev->mask & (IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE))) {
+                rescan = true;
+                continue;
+            }
+
+            char rel[512];
+            chemin_relatif(rel, sizeof(rel), dossier, ev->name);
+            refresh_locked(rel);
+        }
+        if (rescan) rescan_locked();
+        pthread_rwlock_unlock(&idx.lock);
+    }
+}
+
+// Seuls les noms sous forme canonique ("a/b/c") sont résolus par l'index ;
+// "/a", "a//b", "./a" désignent le même fichier mais passent par le disque.
+static bool nom_canonique(const char *nom) {
+    if (nom[0] == '\0' || nom[0] == '/') return false;
+    const char *composant = nom;
+    for (const char *p = nom; ; p++) {
+        if (*p == '/' || *p == '\0') {
+            size_t l = p - composant;
+            if (l == 0) return false;
+            if (l == 1 && composant[0] == '.') return false;
+            if (l == 2 && composant[0] == '.' && composant[1] == '.') return false;
+            if (*p == '\0') return true;
+            composant = p + 1;
+        }
+    }
+}
+
+int index_lookup(const char *filename, index_entry_t *out) {
+    if (!__atomic_load_n(&idx.actif, __ATOMIC_RELAXED) || !nom_canonique(filename)) return INDEX_INCONNU;
+
+    int res = INDEX_ABSENT;
+    pthread_rwlock_rdlock(&idx.lock);
+    if (!idx.actif) {
+        res = INDEX_INCONNU;
+    } else {
+        index_noeud_t *n = table_find(filename);
+        if (n) {
+            if (n->type == NOEUD_FICHIER) {
+                if (out) *out = n->info;
+                res = INDEX_PRESENT;
+            } else if (n->type == NOEUD_OPAQUE) {
+                res = INDEX_INCONNU;
+            }
+        } else {
+            // Nom absent : la réponse n'est fiable que si aucun dossier parent
+            // n'est un lien symbolique ou un dossier non surveillé.
+            char prefixe[512];
+            strncpy(prefixe, filename, sizeof(prefixe) - 1);
+            prefixe[sizeof(prefixe) - 1] = '\0';
+            for (char *s = strchr(prefixe, '/'); s; s = strchr(s + 1, '/')) {
+                *s = '\0';
+                index_noeud_t *parent = table_find(prefixe);
+                *s = '/';
+                if (!parent) break;
+                if (parent->type == NOEUD_OPAQUE) { res = INDEX_INCONNU; break; }
+            }
+        }
+    }
+    pthread_rwlock_unlock(&idx.lock);
+    return res;
+}
+
+// Mise à jour immédiate après une écriture locale (WRQ), sans attendre
+// que l'événement inotify correspondant soit traité.
+void index_refresh(const char *filename) {
+    if (!__atomic_load_n(&idx.actif, __ATOMIC_RELAXED) || !nom_canonique(filename)) return;
+    pthread_rwlock_wrlock(&idx.lock);
+    if (idx.actif) refresh_locked(filename);
+    pthread_rwlock_unlock(&idx.lock);
+}
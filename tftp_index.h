@@ -0,0 +1,29 @@
+#ifndef TFTP_INDEX_H
+#define TFTP_INDEX_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+#include <time.h>
+
+// Index en mémoire du répertoire servi (nom -> taille, inode, mtime).
+// Construit au démarrage puis tenu à jour par inotify, il permet de
+// répondre "File not found" depuis le listener sans toucher au disque.
+
+typedef struct {
+    off_t size;
+    ino_t inode;
+    time_t mtime;
+} index_entry_t;
+
+// Résultats de index_lookup()
+#define INDEX_INCONNU  -1   // Index inactif ou nom hors index : interroger le disque
+#define INDEX_ABSENT    0   // Le fichier n'existe pas (réponse fiable)
+#define INDEX_PRESENT   1   // Fichier régulier présent, 'out' est rempli
+
+int  index_init(const char *racine);
+int  index_fd(void);
+void index_process_events(void);
+int  index_lookup(const char *filename, index_entry_t *out);
+void index_refresh(const char *filename);
+
+#endif
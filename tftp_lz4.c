@@ -0,0 +1,195 @@
+#include <arpa/inet.h>
+#include <string.h>
+
+#include "tftp_lz4.h"
+
+#define MINMATCH 4
+#define MFLIMIT 12              // Pas de correspondance commençant dans les 12 derniers octets
+#define LASTLITERALS 5          // Les 5 derniers octets sont toujours des littéraux
+#define HASH_LOG 12
+#define DISTANCE_MAX 65535
+
+static uint32_t lire32(const unsigned char *p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static uint32_t hacher(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - HASH_LOG);
+}
+
+// Longueur au-delà de 15 : octets 255 puis le reste
+static unsigned char *longueur(unsigned char *op, size_t l) {
+    for (; l >= 255; l -= 255) *op++ = 255;
+    *op++ = (unsigned char)l;
+    return op;
+}
+
+// Séquence : jeton (littéraux << 4 | correspondance - 4), littéraux,
+// distance sur 16 bits petit-boutiste, puis les longueurs étendues
+static unsigned char *sequence(unsigned char *op, const unsigned char *lit, size_t nb_lit,
+                               size_t distance, size_t corresp) {
+    unsigned char *jeton = op++;
+    *jeton = (unsigned char)((nb_lit >= 15 ? 15 : nb_lit) << 4);
+    if (nb_lit >= 15) op = longueur(op, nb_lit - 15);
+    memcpy(op, lit, nb_lit);
+    op += nb_lit;
+    if (corresp == 0) return op; // Dernière séquence : littéraux seuls
+    *op++ = (unsigned char)(distance & 0xff);
+    *op++ = (unsigned char)(distance >> 8);
+    size_t ml = corresp - MINMATCH;
+    *jeton |= (unsigned char)(ml >= 15 ? 15 : ml);
+    if (ml >= 15) op = longueur(op, ml - 15);
+    return op;
+}
+
+// Compresseur glouton à une table de hachage (comme LZ4 "fast") ; 'dst'
+// doit contenir LZ4_BORNE(n) octets
+static size_t compresser(const unsigned char *src, size_t n, unsigned char *dst) {
+    uint16_t table[1 << HASH_LOG];
+    memset(table, 0, sizeof(table));
+    unsigned char *op = dst;
+    size_t ip = 0, ancre = 0;
+
+    if (n >= MFLIMIT + 1) {
+        size_t limite = n - MFLIMIT, fin_corresp = n - LASTLITERALS;
+        while (ip < limite) {
+            uint32_t seq = lire32(src + ip);
+            uint32_t h = hacher(seq);
+            size_t ref = table[h];
+            table[h] = (uint16_t)ip; // n <= LZ4_BLOC : les positions tiennent sur 16 bits
+            if (ref >= ip || ip - ref > DISTANCE_MAX || lire32(src + ref) != seq) {
+                ip++;
+                continue;
+            }
+            size_t l = MINMATCH;
+            while (ip + l < fin_corresp && src[ref + l] == src[ip + l]) l++;
+            // La correspondance déborde souvent sur les littéraux qui précèdent
+            while (ip > ancre && ref > 0 && src[ip - 1] == src[ref - 1]) {
+                ip--;
+                ref--;
+                l++;
+            }
+            op = sequence(op, src + ancre, ip - ancre, ip - ref, l);
+            ip += l;
+            ancre = ip;
+        }
+    }
+    op = sequence(op, src + ancre, n - ancre, 0, 0);
+    return op - dst;
+}
+
+size_t lz4_trame(const char *src, size_t n, char *dst) {
+    size_t charge = compresser((const unsigned char *)src, n, (unsigned char *)dst + LZ4_ENTETE);
+    uint32_t drapeau = 0;
+    if (charge >= n) {
+        memcpy(dst + LZ4_ENTETE, src, n);
+        charge = n;
+        drapeau = LZ4_STOCKE;
+    }
+    uint32_t c = htonl((uint32_t)charge | drapeau), b = htonl((uint32_t)n);
+    memcpy(dst, &c, 4);
+    memcpy(dst + 4, &b, 4);
+    return LZ4_ENTETE + charge;
+}
+
+// Décodage d'un bloc, borné des deux côtés : -1 si le bloc est corrompu
+static ssize_t decompresser(const unsigned char *src, size_t n, unsigned char *dst, size_t cap) {
+    size_t ip = 0, op = 0;
+    while (ip < n) {
+        unsigned jeton = src[ip++];
+        size_t nb_lit = jeton >> 4;
+        if (nb_lit == 15) {
+            unsigned char b;
+            do {
+                if (ip >= n) return -1;
+                b = src[ip++];
+                nb_lit += b;
+            } while (b == 255);
+        }
+        if (nb_lit > n - ip || nb_lit > cap - op) return -1;
+        memcpy(dst + op, src + ip, nb_lit);
+        ip += nb_lit;
+        op += nb_lit;
+        if (ip == n) break;
+
+        if (n - ip < 2) return -1;
+        size_t distance = src[ip] | (size_t)src[ip + 1] << 8;
+        ip += 2;
+        if (distance == 0 || distance > op) return -1;
+        size_t l = jeton & 15;
+        if (l == 15) {
+            unsigned char b;
+            do {
+                if (ip >= n) return -1;
+                b = src[ip++];
+                l += b;
+            } while (b == 255);
+        }
+        l += MINMATCH;
+        if (l > cap - op) return -1;
+        // Octet par octet : la copie peut recouvrir ce qu'elle écrit
+        for (size_t i = 0; i < l; i++, op++) dst[op] = dst[op - distance];
+    }
+    return op;
+}
+
+void lz4_flux_init(lz4_flux_t *f) {
+    f->entete_len = 0;
+    f->recu = 0;
+}
+
+// Consomme donnees[0..len) ; -1 si le flux est corrompu ou si 'ecrire'
+// échoue
+int lz4_flux_decoder(lz4_flux_t *f, const char *donnees, size_t len, lz4_ecrire_t ecrire, void *ctx) {
+    for (;;) {
+        if (f->entete_len < LZ4_ENTETE) {
+            if (len == 0) return 0;
+            size_t n = LZ4_ENTETE - f->entete_len;
+            if (n > len) n = len;
+            memcpy(f->entete + f->entete_len, donnees, n);
+            f->entete_len += n;
+            donnees += n;
+            len -= n;
+            if (f->entete_len < LZ4_ENTETE) return 0;
+
+            uint32_t c, b;
+            memcpy(&c, f->entete, 4);
+            memcpy(&b, f->entete + 4, 4);
+            c = ntohl(c);
+            f->brut = ntohl(b);
+            f->stocke = (c & LZ4_STOCKE) != 0;
+            f->charge = c & ~LZ4_STOCKE;
+            f->recu = 0;
+            if (f->brut > LZ4_BLOC || f->charge > LZ4_BORNE(LZ4_BLOC) || (f->stocke && f->charge != f->brut))
+                return -1;
+        }
+
+        size_t n = f->charge - f->recu;
+        if (n > len) n = len;
+        if (f->stocke) {
+            // Charge brute : transmise sans copie, au fil des paquets
+            if (n && ecrire(ctx, donnees, n) != (ssize_t)n) return -1;
+        } else {
+            memcpy(f->tampon + f->recu, donnees, n);
+        }
+        f->recu += n;
+        donnees += n;
+        len -= n;
+        if (f->recu < f->charge) return 0;
+
+        if (!f->stocke) {
+            ssize_t produit = decompresser((unsigned char *)f->tampon, f->charge, (unsigned char *)f->sortie, f->brut);
+            if (produit != (ssize_t)f->brut) return -1;
+            if (produit && ecrire(ctx, f->sortie, produit) != produit) return -1;
+        }
+        f->entete_len = 0;
+        f->recu = 0;
+    }
+}
+
+// Fin du transfert : faux si la dernière trame est incomplète
+bool lz4_flux_complet(const lz4_flux_t *f) {
+    return f->entete_len == 0;
+}
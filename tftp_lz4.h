@@ -0,0 +1,50 @@
+#ifndef TFTP_LZ4_H
+#define TFTP_LZ4_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+// Flux compressé de l'option "compress" (valeur "lz4") : une suite de
+// trames indépendantes, chacune portant au plus LZ4_BLOC octets du fichier.
+//
+//   trame : longueur de la charge (32 bits réseau, bit de poids fort :
+//           charge stockée telle quelle), longueur décompressée (32 bits
+//           réseau), puis la charge, un bloc au format LZ4 (lz4 block format)
+//
+// Une trame qui ne gagne rien est stockée brute : le flux ne dépasse pas
+// le fichier de plus de LZ4_ENTETE octets par bloc. Ce module n'a ni
+// dépendance ni allocation ; le compresseur sert au cache des variantes
+// du serveur (tftp_variantes.c), le décodeur au client.
+
+#define LZ4_BLOC 65536                          // Octets du fichier par trame au plus
+#define LZ4_ENTETE 8
+#define LZ4_BORNE(n) ((n) + (n) / 255 + 16)     // Bloc compressé le plus long pour n octets
+#define LZ4_TRAME_MAX (LZ4_ENTETE + LZ4_BORNE(LZ4_BLOC))
+#define LZ4_STOCKE 0x80000000u
+
+// Trame complète pour src[0..n) (n <= LZ4_BLOC) dans dst, de taille au
+// moins LZ4_TRAME_MAX ; renvoie sa longueur
+size_t lz4_trame(const char *src, size_t n, char *dst);
+
+// Décodage en flux : les octets reçus, découpés n'importe comment, sont
+// rendus décompressés à 'ecrire' trame par trame
+typedef ssize_t (*lz4_ecrire_t)(void *ctx, const char *donnees, size_t len);
+
+typedef struct {
+    unsigned char entete[LZ4_ENTETE];
+    size_t entete_len;
+    uint32_t charge;            // Longueur de la charge de la trame en cours
+    uint32_t brut;              // Longueur décompressée annoncée
+    bool stocke;
+    size_t recu;                // Octets de la charge déjà reçus
+    char tampon[LZ4_BORNE(LZ4_BLOC)];
+    char sortie[LZ4_BLOC];
+} lz4_flux_t;
+
+void lz4_flux_init(lz4_flux_t *f);
+int  lz4_flux_decoder(lz4_flux_t *f, const char *donnees, size_t len, lz4_ecrire_t ecrire, void *ctx);
+bool lz4_flux_complet(const lz4_flux_t *f);
+
+#endif
@@ -0,0 +1,124 @@
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "tftp_netascii.h"
+
+void netascii_enc_init(netascii_enc_t *st) {
+    st->attente = -1;
+}
+
+void netascii_dec_init(netascii_dec_t *st) {
+    st->cr = false;
+}
+
+#ifdef __SSE2__
+// Masque des octets égaux à 'a' ou 'b' parmi les 16 octets en 'p'
+static inline unsigned masque2(const char *p, __m128i a, __m128i b) {
+    __m128i v = _mm_loadu_si128((const __m128i *)p);
+    return (unsigned)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, a), _mm_cmpeq_epi8(v, b)));
+}
+#endif
+
+// Texte local -> netascii : LF devient CR LF, CR devient CR NUL. Remplit au
+// plus 'cap' octets ; *consomme reçoit le nombre d'octets de 'in' utilisés.
+// Le résultat est plus court que 'cap' seulement si toute l'entrée est
+// consommée sans paire en attente : c'est alors le dernier bloc.
+size_t netascii_encode(netascii_enc_t *st, const char *in, size_t len, size_t *consomme, char *out, size_t cap) {
+    size_t i = 0, o = 0;
+
+    if (st->attente >= 0 && o < cap) {
+        out[o++] = (char)st->attente;
+        st->attente = -1;
+    }
+
+    while (i < len && o < cap) {
+#ifdef __SSE2__
+        // Les segments de 16 octets sans CR ni LF sont copiés tels quels
+        const __m128i lf = _mm_set1_epi8('\n'), cr = _mm_set1_epi8('\r');
+        while (i + 16 <= len && o + 16 <= cap) {
+            unsigned m = masque2(in + i, lf, cr);
+            _mm_storeu_si128((__m128i *)(out + o), _mm_loadu_si128((const __m128i *)(in + i)));
+            if (!m) {
+                i += 16;
+                o += 16;
+                continue;
+            }
+            unsigned n = __builtin_ctz(m);
+            i += n;
+            o += n;
+            break;
+        }
+        if (i >= len || o >= cap) break;
+#endif
+        char c = in[i++];
+        if (c != '\n' && c != '\r') {
+            out[o++] = c;
+            continue;
+        }
+        out[o++] = '\r';
+        char second = c == '\n' ? '\n' : '\0';
+        if (o < cap)
+            out[o++] = second;
+        else
+            st->attente = (unsigned char)second; // Paire coupée par la fin du bloc
+    }
+
+    *consomme = i;
+    return o;
+}
+
+// Netascii -> texte local : CR LF devient LF, CR NUL devient CR. Un CR en
+// fin de bloc est résolu avec le premier octet du bloc suivant. 'out' doit
+// pouvoir recevoir len + 1 octets.
+size_t netascii_decode(netascii_dec_t *st, const char *in, size_t len, char *out) {
+    size_t i = 0, o = 0;
+
+    while (i < len) {
+        if (st->cr) {
+            char c = in[i];
+            st->cr = false;
+            if (c == '\n' || c == '\0') {
+                out[o++] = c == '\n' ? '\n' : '\r';
+                i++;
+                continue;
+            }
+            out[o++] = '\r'; // CR suivi d'autre chose : conservé tel quel
+        }
+#ifdef __SSE2__
+        // Seul le CR demande un traitement : copie par 16 jusqu'au prochain
+        const __m128i cr = _mm_set1_epi8('\r');
+        while (i + 16 <= len) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+            unsigned m = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, cr));
+            _mm_storeu_si128((__m128i *)(out + o), v);
+            if (!m) {
+                i += 16;
+                o += 16;
+                continue;
+            }
+            unsigned n = __builtin_ctz(m);
+            i += n;
+            o += n;
+            break;
+        }
+        if (i >= len) break;
+#endif
+        char c = in[i++];
+        if (c == '\r')
+            st->cr = true;
+        else
+            out[o++] = c;
+    }
+    return o;
+}
+
+// Fin du transfert : un CR final sans suite est conservé
+size_t netascii_decode_end(netascii_dec_t *st, char *out) {
+    if (!st->cr) return 0;
+    st->cr = false;
+    out[0] = '\r';
+    return 1;
+}
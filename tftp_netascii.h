@@ -0,0 +1,26 @@
+#ifndef TFTP_NETASCII_H
+#define TFTP_NETASCII_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Mode netascii (RFC 1350/764) : sur le fil, une fin de ligne est CR LF et
+// un CR isolé est CR NUL. Les conversions sont faites en flux, bloc par
+// bloc : une paire coupée en fin de bloc est reportée au bloc suivant.
+
+typedef struct {
+    int attente;    // Second octet d'une paire à émettre en tête du bloc suivant, -1 si aucun
+} netascii_enc_t;
+
+typedef struct {
+    bool cr;        // Le bloc précédent finissait par un CR
+} netascii_dec_t;
+
+void   netascii_enc_init(netascii_enc_t *st);
+size_t netascii_encode(netascii_enc_t *st, const char *in, size_t len, size_t *consomme, char *out, size_t cap);
+
+void   netascii_dec_init(netascii_dec_t *st);
+size_t netascii_decode(netascii_dec_t *st, const char *in, size_t len, char *out);
+size_t netascii_decode_end(netascii_dec_t *st, char *out);
+
+#endif
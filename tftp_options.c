@@ -0,0 +1,156 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "tftp_options.h"
+
+static int lire_entier(const char *valeur, uint64_t *out) {
+    if (valeur[0] < '0' || valeur[0] > '9') return -1;
+    char *fin;
+    errno = 0;
+    unsigned long long v = strtoull(valeur, &fin, 10);
+    if (errno || *fin) return -1;
+    *out = v;
+    return 0;
+}
+
+// Valeur de l'option multicast : vide dans une requête, "addr,port,mc"
+// dans un OACK. Les champs addr et port peuvent être vides dans un OACK
+// qui ne fait que changer le client maître.
+static int lire_multicast(const char *valeur, tftp_options_t *opts) {
+    if (!*valeur) return 0;
+    const char *v1 = strchr(valeur, ',');
+    const char *v2 = v1 ? strchr(v1 + 1, ',') : NULL;
+    if (!v2 || (size_t)(v1 - valeur) >= sizeof(opts->mc_addr)) return -1;
+
+    uint64_t port = 0, mc;
+    char champ[8];
+    memcpy(opts->mc_addr, valeur, v1 - valeur);
+    opts->mc_addr[v1 - valeur] = '\0';
+    if (v2 - v1 - 1 >= (ptrdiff_t)sizeof(champ)) return -1;
+    memcpy(champ, v1 + 1, v2 - v1 - 1);
+    champ[v2 - v1 - 1] = '\0';
+    if ((*champ && (lire_entier(champ, &port) < 0 || port > UINT16_MAX)) ||
+        lire_entier(v2 + 1, &mc) < 0 || mc > 1)
+        return -1;
+    opts->mc_port = (uint16_t)port;
+    opts->mc_master = (int)mc;
+    return 0;
+}
+
+// Analyse les options contenues dans buf[0..len). Les options inconnues ou
+// dont la valeur est invalide sont ignorées (RFC 2347) ; -1 si le paquet
+// est mal formé (nom ou valeur sans terminateur nul).
+int options_parse(const char *buf, size_t len, tftp_options_t *opts) {
+    memset(opts, 0, sizeof(*opts));
+    const char *p = buf;
+    const char *fin = buf + len;
+
+    while (p < fin) {
+        const char *nom = p;
+        while (p < fin && *p) p++;
+        if (p >= fin) return -1;
+        if (p == nom) break; // Bourrage nul en fin de paquet
+        const char *valeur = ++p;
+        while (p < fin && *p) p++;
+        if (p >= fin) return -1;
+        p++;
+
+        uint64_t v;
+        if (strcasecmp(nom, "tsize") == 0) {
+            if (lire_entier(valeur, &v) == 0) {
+                opts->tsize = v;
+                opts->presentes |= TFTP_OPT_TSIZE;
+            }
+        } else if (strcasecmp(nom, "timeout") == 0) {
+            if (lire_entier(valeur, &v) == 0 && v >= TFTP_TIMEOUT_MIN && v <= TFTP_TIMEOUT_MAX) {
+                opts->timeout = (int)v;
+                opts->presentes |= TFTP_OPT_TIMEOUT;
+            }
+        } else if (strcasecmp(nom, "rollover") == 0) {
+            if (lire_entier(valeur, &v) == 0 && v <= 1) {
+                opts->rollover = (int)v;
+                opts->presentes |= TFTP_OPT_ROLLOVER;
+            }
+        } else if (strcasecmp(nom, "blksize") == 0) {
+            if (lire_entier(valeur, &v) == 0 && v >= TFTP_BLKSIZE_MIN && v <= TFTP_BLKSIZE_MAX) {
+                opts->blksize = (int)v;
+                opts->presentes |= TFTP_OPT_BLKSIZE;
+            }
+        } else if (strcasecmp(nom, "offset") == 0) {
+            if (lire_entier(valeur, &v) == 0) {
+                opts->offset = v;
+                opts->presentes |= TFTP_OPT_OFFSET;
+            }
+        } else if (strcasecmp(nom, "length") == 0) {
+            if (lire_entier(valeur, &v) == 0) {
+                opts->length = v;
+                opts->presentes |= TFTP_OPT_LENGTH;
+            }
+        } else if (strcasecmp(nom, "compress") == 0) {
+            if (strcasecmp(valeur, "lz4") == 0) opts->presentes |= TFTP_OPT_COMPRESS;
+        } else if (strcasecmp(nom, "multicast") == 0) {
+            if (lire_multicast(valeur, opts) == 0)
+                opts->presentes |= TFTP_OPT_MULTICAST;
+        }
+    }
+    return 0;
+}
+
+// Écrit les options présentes sous forme "nom\0valeur\0" ; renvoie le
+// nombre d'octets écrits (0 si aucune option ou si la place manque).
+size_t options_write(char *buf, size_t len, const tftp_options_t *opts) {
+    size_t idx = 0;
+    int n;
+
+    if (opts->presentes & TFTP_OPT_TSIZE) {
+        n = snprintf(buf + idx, len - idx, "tsize%c%llu", '\0', (unsigned long long)opts->tsize);
+        if (n < 0 || (size_t)n + 1 > len - idx) return 0;
+        idx += n + 1;
+    }
+    if (opts->presentes & TFTP_OPT_TIMEOUT) {
+        n = snprintf(buf + idx, len - idx, "timeout%c%d", '\0', opts->timeout);
+        if (n < 0 || (size_t)n + 1 > len - idx) return 0;
+        idx += n + 1;
+    }
+    if (opts->presentes & TFTP_OPT_ROLLOVER) {
+        n = snprintf(buf + idx, len - idx, "rollover%c%d", '\0', opts->rollover);
+        if (n < 0 || (size_t)n + 1 > len - idx) return 0;
+        idx += n + 1;
+    }
+    if (opts->presentes & TFTP_OPT_BLKSIZE) {
+        n = snprintf(buf + idx, len - idx, "blksize%c%d", '\0', opts->blksize);
+        if (n < 0 || (size_t)n + 1 > len - idx) return 0;
+        idx += n + 1;
+    }
+    if (opts->presentes & TFTP_OPT_OFFSET) {
+        n = snprintf(buf + idx, len - idx, "offset%c%llu", '\0', (unsigned long long)opts->offset);
+        if (n < 0 || (size_t)n + 1 > len - idx) return 0;
+        idx += n + 1;
+    }
+    if (opts->presentes & TFTP_OPT_LENGTH) {
+        n = snprintf(buf + idx, len - idx, "length%c%llu", '\0', (unsigned long long)opts->length);
+        if (n < 0 || (size_t)n + 1 > len - idx) return 0;
+        idx += n + 1;
+    }
+    if (opts->presentes & TFTP_OPT_COMPRESS) {
+        n = snprintf(buf + idx, len - idx, "compress%clz4", '\0');
+        if (n < 0 || (size_t)n + 1 > len - idx) return 0;
+        idx += n + 1;
+    }
+    if (opts->presentes & TFTP_OPT_MULTICAST) {
+        if (opts->mc_addr[0])
+            n = snprintf(buf + idx, len - idx, "multicast%c%s,%u,%d", '\0', opts->mc_addr, opts->mc_port, opts->mc_master);
+        else
+            n = snprintf(buf + idx, len - idx, "multicast%c", '\0');
+        if (n < 0 || (size_t)n + 1 > len - idx) return 0;
+        idx += n + 1;
+    }
+    return idx;
+}
+
+uint16_t bloc_suivant(uint16_t bloc, int rollover) {
+    return bloc == UINT16_MAX ? (uint16_t)rollover : (uint16_t)(bloc + 1);
+}
@@ -0,0 +1,48 @@
+#ifndef TFTP_OPTIONS_H
+#define TFTP_OPTIONS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Options TFTP (RFC 2347) : paires "nom\0valeur\0" après le mode d'un
+// RRQ/WRQ, et dans le paquet OACK (opcode 6) renvoyé par le serveur.
+
+#define TFTP_OACK 6
+
+#define TFTP_OPT_TSIZE    0x01  // RFC 2349 : taille du transfert
+#define TFTP_OPT_TIMEOUT  0x02  // RFC 2349 : délai de retransmission (s)
+#define TFTP_OPT_ROLLOVER 0x04  // Bloc suivant 65535 : 0 ou 1
+#define TFTP_OPT_MULTICAST 0x08 // RFC 2090 : "" dans la requête, "addr,port,mc" dans l'OACK
+#define TFTP_OPT_BLKSIZE  0x10  // RFC 2348 : taille des blocs DATA
+#define TFTP_OPT_OFFSET   0x20  // RRQ : premier octet envoyé (reprise, segments)
+#define TFTP_OPT_LENGTH   0x40  // RRQ : nombre d'octets envoyés à partir de offset
+#define TFTP_OPT_COMPRESS 0x80  // RRQ : données en flux lz4 (tftp_lz4.h), tsize est alors sa taille
+
+#define TFTP_TIMEOUT_MIN 1
+#define TFTP_TIMEOUT_MAX 255
+
+#define TFTP_BLKSIZE_DEFAUT 512
+#define TFTP_BLKSIZE_MIN 8
+#define TFTP_BLKSIZE_MAX 65464
+
+typedef struct {
+    unsigned int presentes;     // Masque des options reconnues (TFTP_OPT_*)
+    uint64_t tsize;
+    int timeout;
+    int rollover;
+    int blksize;
+    uint64_t offset;
+    uint64_t length;
+    char mc_addr[16];           // Groupe multicast ("" si non précisé)
+    uint16_t mc_port;
+    int mc_master;              // 1 si le client doit acquitter les blocs
+} tftp_options_t;
+
+int    options_parse(const char *buf, size_t len, tftp_options_t *opts);
+size_t options_write(char *buf, size_t len, const tftp_options_t *opts);
+
+// Numéro de bloc suivant sur le fil : après 65535 on repart à 'rollover'
+// (0 par défaut, 1 si négocié), ce qui permet des fichiers > 32 Mo.
+uint16_t bloc_suivant(uint16_t bloc, int rollover);
+
+#endif
@@ -0,0 +1,59 @@
+#include <stdlib.h>
+#include <time.h>
+
+#include "tftp_pacer.h"
+
+double pacer_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// "500k", "10M", "1G" : octets par seconde (suffixes en puissances de 1000)
+double pacer_parse_rate(const char *texte) {
+    char *fin;
+    double v = strtod(texte, &fin);
+    switch (*fin) {
+    case 'k': case 'K': v *= 1e3; break;
+    case 'm': case 'M': v *= 1e6; break;
+    case 'g': case 'G': v *= 1e9; break;
+    default: break;
+    }
+    return v > 0 ? v : 0;
+}
+
+void bucket_init(token_bucket_t *b, double rate, double burst) {
+    b->rate = rate;
+    b->burst = burst;
+    b->tokens = burst;
+    b->last = pacer_now();
+}
+
+static void bucket_refill(token_bucket_t *b, double now) {
+    if (now > b->last) {
+        b->tokens += (now - b->last) * b->rate;
+        if (b->tokens > b->burst) b->tokens = b->burst;
+    }
+    b->last = now;
+}
+
+// Change le débit sans perdre les jetons accumulés au débit précédent
+void bucket_set_rate(token_bucket_t *b, double rate, double now) {
+    bucket_refill(b, now);
+    b->rate = rate;
+}
+
+// Délai (s) avant de pouvoir envoyer 'len' octets ; 0 si c'est possible tout de suite
+double bucket_wait(token_bucket_t *b, size_t len, double now) {
+    if (b->rate <= 0) return 0;
+    bucket_refill(b, now);
+    // Un paquet plus gros que le seau passe dès que celui-ci est plein
+    double besoin = (double)len < b->burst ? (double)len : b->burst;
+    if (b->tokens >= besoin) return 0;
+    return (besoin - b->tokens) / b->rate;
+}
+
+void bucket_take(token_bucket_t *b, size_t len) {
+    if (b->rate <= 0) return;
+    b->tokens -= len;
+}
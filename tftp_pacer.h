@@ -0,0 +1,25 @@
+#ifndef TFTP_PACER_H
+#define TFTP_PACER_H
+
+#include <stddef.h>
+
+// Seau à jetons pour limiter le débit des paquets DATA. Les jetons sont
+// des octets ; un seau peu profond espace les paquets au lieu de les
+// envoyer en rafale.
+
+typedef struct {
+    double rate;    // Octets par seconde, 0 = pas de limite
+    double burst;   // Capacité du seau en octets
+    double tokens;
+    double last;    // Dernier remplissage (secondes, horloge monotone)
+} token_bucket_t;
+
+double pacer_now(void);
+double pacer_parse_rate(const char *texte);
+
+void   bucket_init(token_bucket_t *b, double rate, double burst);
+void   bucket_set_rate(token_bucket_t *b, double rate, double now);
+double bucket_wait(token_bucket_t *b, size_t len, double now);
+void   bucket_take(token_bucket_t *b, size_t len);
+
+#endif
@@ -0,0 +1,107 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "tftp_options.h"
+#include "tftp_pmtu.h"
+
+#define PMTU_PAIRS 64           // Pairs mémorisés au maximum
+#define PMTU_DUREE 600          // Durée de vie d'un repli (s), comme le réessai de la RFC 1191
+#define PMTU_ETHERNET 1500
+
+typedef struct {
+    in_addr_t addr;
+    int blksize;
+    time_t expire;              // 0 : entrée libre
+} pmtu_pair_t;
+
+static pmtu_pair_t pairs[PMTU_PAIRS];
+static pthread_mutex_t pmtu_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Paliers de MTU courants (RFC 1191, table 7)
+static const int paliers[] = {65535, 32000, 17914, 8166, 4352, 2002, 1500, 1492, 1006, 576};
+
+// MTU du chemin vers 'pair', 0 s'il est inconnu. La socket connectée
+// n'émet rien : elle sert seulement à consulter la route du noyau.
+int pmtu_mesurer(const struct sockaddr_in *pair) {
+    int s = socket(AF_INET, SOCK_DGRAM, 0);
+    if (s < 0) return 0;
+    int mtu = 0;
+    socklen_t len = sizeof(mtu);
+    int val = IP_PMTUDISC_DO;
+    if (setsockopt(s, IPPROTO_IP, IP_MTU_DISCOVER, &val, sizeof(val)) < 0 ||
+        connect(s, (const struct sockaddr *)pair, sizeof(*pair)) < 0 ||
+        getsockopt(s, IPPROTO_IP, IP_MTU, &mtu, &len) < 0)
+        mtu = 0;
+    close(s);
+    return mtu;
+}
+
+// Plus grand blksize sans fragmentation pour ce MTU, jamais sous les
+// 512 octets du protocole de base
+int pmtu_blksize(int mtu) {
+    int b = mtu - PMTU_ENTETES;
+    if (b < TFTP_BLKSIZE_DEFAUT) return TFTP_BLKSIZE_DEFAUT;
+    return b > TFTP_BLKSIZE_MAX ? TFTP_BLKSIZE_MAX : b;
+}
+
+// Bit DF des DATA émis sur 'sockfd' : avec IP_PMTUDISC_DO, un paquet plus
+// gros que le MTU connu échoue en EMSGSIZE au lieu d'être fragmenté
+void pmtu_fragmentation(int sockfd, bool autorisee) {
+    int val = autorisee ? IP_PMTUDISC_DONT : IP_PMTUDISC_DO;
+    setsockopt(sockfd, IPPROTO_IP, IP_MTU_DISCOVER, &val, sizeof(val));
+}
+
+static pmtu_pair_t *trouver(in_addr_t addr, time_t now) {
+    for (int i = 0; i < PMTU_PAIRS; i++)
+        if (pairs[i].expire > now && pairs[i].addr == addr) return &pairs[i];
+    return NULL;
+}
+
+// Taille de bloc accordée à 'pair' qui demande 'demande' : le MTU mesuré,
+// abaissé par un repli encore valide
+int pmtu_choisir(const struct sockaddr_in *pair, int demande) {
+    int b = pmtu_blksize(pmtu_mesurer(pair));
+    pthread_mutex_lock(&pmtu_mutex);
+    pmtu_pair_t *p = trouver(pair->sin_addr.s_addr, time(NULL));
+    if (p && p->blksize < b) b = p->blksize;
+    pthread_mutex_unlock(&pmtu_mutex);
+    return demande < b ? demande : b;
+}
+
+// Des blocs de 'blksize' octets se perdent : les prochains transferts avec
+// ce pair passent d'abord au palier Ethernet, où se trouvent la plupart des
+// goulets, puis de palier en palier
+void pmtu_signaler_perte(const struct sockaddr_in *pair, int blksize) {
+    if (blksize <= TFTP_BLKSIZE_DEFAUT) return;
+    int repli = TFTP_BLKSIZE_DEFAUT;
+    if (blksize > pmtu_blksize(PMTU_ETHERNET)) {
+        repli = pmtu_blksize(PMTU_ETHERNET);
+    } else {
+        for (size_t i = 0; i < sizeof(paliers) / sizeof(paliers[0]); i++) {
+            if (pmtu_blksize(paliers[i]) < blksize) {
+                repli = pmtu_blksize(paliers[i]);
+                break;
+            }
+        }
+    }
+
+    time_t now = time(NULL);
+    pthread_mutex_lock(&pmtu_mutex);
+    pmtu_pair_t *p = trouver(pair->sin_addr.s_addr, now);
+    if (!p) {
+        // Entrée libre ou expirée, sinon celle qui expire le plus tôt
+        p = &pairs[0];
+        for (int i = 1; i < PMTU_PAIRS && p->expire > now; i++)
+            if (pairs[i].expire < p->expire) p = &pairs[i];
+        p->addr = pair->sin_addr.s_addr;
+        p->blksize = repli;
+    } else if (repli < p->blksize) {
+        p->blksize = repli;
+    }
+    p->expire = now + PMTU_DUREE;
+    pthread_mutex_unlock(&pmtu_mutex);
+}
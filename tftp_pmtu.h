@@ -0,0 +1,27 @@
+#ifndef TFTP_PMTU_H
+#define TFTP_PMTU_H
+
+#include <netinet/in.h>
+#include <stdbool.h>
+
+// Taille de bloc (RFC 2348) choisie d'après le MTU du chemin vers le pair :
+// le plus grand blksize dont le paquet DATA tient dans un datagramme IP non
+// fragmenté. Le MTU est lu par IP_MTU sur une socket connectée au pair ;
+// le noyau y reporte ce qu'il a appris des ICMP "fragmentation needed".
+//
+// Côté serveur, le choix est gardé par pair (adresse IPv4) quelques
+// minutes. Quand des blocs trop gros se perdent (trou noir PMTU : ICMP
+// filtrés, paquets DF jetés en silence), le pair descend au palier de MTU
+// inférieur (RFC 1191) pour les transferts suivants.
+
+#define PMTU_ENTETES 32         // IPv4 (20) + UDP (8) + en-tête DATA (4)
+#define PMTU_PERTES_MAX 3       // Pertes d'un même gros bloc (timeout ou ACK en double) avant repli
+
+int  pmtu_mesurer(const struct sockaddr_in *pair);
+int  pmtu_blksize(int mtu);
+void pmtu_fragmentation(int sockfd, bool autorisee);
+
+int  pmtu_choisir(const struct sockaddr_in *pair, int demande);
+void pmtu_signaler_perte(const struct sockaddr_in *pair, int blksize);
+
+#endif
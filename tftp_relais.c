@@ -0,0 +1,142 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "tftp_relais.h"
+
+static int adresse(const char *chemin, struct sockaddr_un *sa) {
+    memset(sa, 0, sizeof(*sa));
+    sa->sun_family = AF_UNIX;
+    if (strlen(chemin) >= sizeof(sa->sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    strcpy(sa->sun_path, chemin);
+    return 0;
+}
+
+// Les deux côtés bornent leurs attentes : un processus bloqué ou tué ne
+// fige pas l'autre
+static void delai(int sock) {
+    struct timeval tv = { RELAIS_DELAI_SEC, 0 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+}
+
+// Seul un processus du même utilisateur peut prendre ou donner le port 69
+// et les sessions : le chemin peut être accessible à d'autres comptes
+static int meme_utilisateur(int sock) {
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    if (getsockopt(sock, SOL_SOCKET, SO_PEERCRED, &cred, &len) < 0) {
+        perror("SO_PEERCRED");
+        return 0;
+    }
+    if (cred.uid == geteuid()) return 1;
+    fprintf(stderr, "[RELAIS] Refusé : pid %d, uid %u (attendu %u)\n",
+            (int)cred.pid, (unsigned)cred.uid, (unsigned)geteuid());
+    return 0;
+}
+
+// Connexion à l'ancien processus ; -1 s'il n'y en a pas (chemin absent,
+// ou laissé par un processus arrêté)
+int relais_connecter(const char *chemin) {
+    struct sockaddr_un sa;
+    if (adresse(chemin, &sa) < 0) return -1;
+    int sock = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (sock < 0) return -1;
+    if (connect(sock, (struct sockaddr *)&sa, sizeof(sa)) < 0) {
+        if (errno != ENOENT && errno != ECONNREFUSED) perror(chemin);
+        close(sock);
+        return -1;
+    }
+    if (!meme_utilisateur(sock)) {
+        close(sock);
+        return -1;
+    }
+    delai(sock);
+    return sock;
+}
+
+// Écoute des demandes de relais : le chemin d'un processus précédent est
+// remplacé
+int relais_ecouter(const char *chemin) {
+    struct sockaddr_un sa;
+    if (adresse(chemin, &sa) < 0) {
+        perror(chemin);
+        return -1;
+    }
+    int sock = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (sock < 0) return -1;
+    unlink(chemin);
+    if (bind(sock, (struct sockaddr *)&sa, sizeof(sa)) < 0 || listen(sock, 1) < 0) {
+        perror(chemin);
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+// -1 si aucune demande n'attend, ou si elle vient d'un autre utilisateur
+int relais_accepter(int ecoute) {
+    int sock = accept4(ecoute, NULL, NULL, SOCK_CLOEXEC);
+    if (sock < 0) return -1;
+    if (!meme_utilisateur(sock)) {
+        close(sock);
+        return -1;
+    }
+    delai(sock);
+    return sock;
+}
+
+// Un message et jusqu'à RELAIS_FDS_MAX descripteurs, dupliqués dans
+// l'autre processus
+int relais_envoyer(int sock, const void *msg, size_t len, const int *fds, int nb_fds) {
+    struct iovec iov = { (void *)msg, len };
+    struct msghdr mh = { .msg_iov = &iov, .msg_iovlen = 1 };
+    char ctrl[CMSG_SPACE(sizeof(int) * RELAIS_FDS_MAX)];
+    if (nb_fds > 0) {
+        memset(ctrl, 0, sizeof(ctrl));
+        mh.msg_control = ctrl;
+        mh.msg_controllen = CMSG_SPACE(sizeof(int) * nb_fds);
+        struct cmsghdr *cm = CMSG_FIRSTHDR(&mh);
+        cm->cmsg_level = SOL_SOCKET;
+        cm->cmsg_type = SCM_RIGHTS;
+        cm->cmsg_len = CMSG_LEN(sizeof(int) * nb_fds);
+        memcpy(CMSG_DATA(cm), fds, sizeof(int) * nb_fds);
+    }
+    ssize_t n = sendmsg(sock, &mh, MSG_NOSIGNAL);
+    return n == (ssize_t)len ? 0 : -1;
+}
+
+// Reçoit un message d'exactement 'len' octets ; ses descripteurs vont dans
+// fds[*nb_fds]. -1 si le message manque ou n'a pas la taille attendue.
+int relais_recevoir(int sock, void *msg, size_t len, int *fds, int *nb_fds) {
+    struct iovec iov = { msg, len };
+    char ctrl[CMSG_SPACE(sizeof(int) * RELAIS_FDS_MAX)];
+    struct msghdr mh = { .msg_iov = &iov, .msg_iovlen = 1, .msg_control = ctrl, .msg_controllen = sizeof(ctrl) };
+    ssize_t n = recvmsg(sock, &mh, MSG_CMSG_CLOEXEC);
+    int recus = 0;
+    for (struct cmsghdr *cm = CMSG_FIRSTHDR(&mh); n >= 0 && cm; cm = CMSG_NXTHDR(&mh, cm)) {
+        if (cm->cmsg_level != SOL_SOCKET || cm->cmsg_type != SCM_RIGHTS) continue;
+        int nb = (cm->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        for (int i = 0; i < nb; i++) {
+            int fd;
+            memcpy(&fd, CMSG_DATA(cm) + i * sizeof(int), sizeof(int));
+            if (recus < RELAIS_FDS_MAX) fds[recus++] = fd;
+            else close(fd);
+        }
+    }
+    if (n != (ssize_t)len || (mh.msg_flags & (MSG_TRUNC | MSG_CTRUNC))) {
+        while (recus > 0) close(fds[--recus]);
+        *nb_fds = 0;
+        return -1;
+    }
+    *nb_fds = recus;
+    return 0;
+}
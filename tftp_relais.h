@@ -0,0 +1,50 @@
+#ifndef TFTP_RELAIS_H
+#define TFTP_RELAIS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Redémarrage à chaud (option -H <socket unix> des serveurs). Un serveur
+// lancé avec -H commence par se connecter à ce chemin : si un ancien
+// processus y écoute, il lui passe sa socket du port 69 (SCM_RIGHTS) au
+// lieu d'en lier une nouvelle, puis ses sessions. Le nouveau processus
+// écoute ensuite lui-même sur le chemin, pour le redémarrage suivant.
+//
+// Échange, en messages SOCK_SEQPACKET :
+//   ancien -> nouveau : relais_entete_t + socket du port 69
+//   nouveau -> ancien : un octet, 1 pour recevoir les sessions, 0 sinon
+//   ancien -> nouveau : si 1, les enregistrements annoncés dans l'entête,
+//                       chacun avec ses descripteurs ; l'ancien s'arrête
+//
+// Les sessions ne passent qu'entre deux moteurs identiques, de même format
+// (version, taille des enregistrements). Sinon le nouveau répond 0 :
+// l'ancien cesse de recevoir des requêtes et termine ses transferts en
+// cours avant de s'arrêter (vidange).
+
+#define RELAIS_MAGIE 0x54465248u    // "TFRH"
+#define RELAIS_VERSION 1
+#define RELAIS_FDS_MAX 4            // Descripteurs par message au plus
+#define RELAIS_DELAI_SEC 5          // Attente d'une réponse de l'autre processus
+
+#define RELAIS_THREAD 1
+#define RELAIS_SELECT 2
+
+typedef struct {
+    uint32_t magie;
+    uint32_t version;
+    uint32_t moteur;            // RELAIS_THREAD, RELAIS_SELECT
+    uint32_t taille_session;    // Taille d'un enregistrement de session, 0 : aucune
+    uint32_t taille_groupe;     // Taille d'un enregistrement de groupe multicast
+    uint32_t sessions;          // Enregistrements qui suivent si le nouveau accepte
+    uint32_t groupes;
+    uint32_t groupes_actifs;    // Masque des groupes multicast en cours chez l'ancien
+} relais_entete_t;
+
+int relais_connecter(const char *chemin);
+int relais_ecouter(const char *chemin);
+int relais_accepter(int ecoute);
+
+int relais_envoyer(int sock, const void *msg, size_t len, const int *fds, int nb_fds);
+int relais_recevoir(int sock, void *msg, size_t len, int *fds, int *nb_fds);
+
+#endif
@@ -0,0 +1,77 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tftp_ring.h"
+
+#define LIGNE 64    // Ligne de cache : deux cases ne la partagent pas
+
+// Le numéro d'une case dit à qui elle est : égal à la position, elle est
+// libre pour le producteur de ce tour ; égal à position + 1, elle est
+// pleine pour le consommateur ; le consommateur la rend au tour suivant
+// en y écrivant position + capacité.
+static size_t *numero(ring_t *r, size_t pos) {
+    return (size_t *)(r->cases + (pos & (r->capacite - 1)) * r->pas);
+}
+
+int ring_init(ring_t *r, size_t capacite, size_t taille) {
+    size_t n = 2;
+    while (n < capacite) n <<= 1;
+    r->capacite = n;
+    r->taille = taille;
+    r->pas = (sizeof(size_t) + taille + LIGNE - 1) & ~(size_t)(LIGNE - 1);
+    r->cases = aligned_alloc(LIGNE, n * r->pas);
+    if (!r->cases) return -1;
+    for (size_t i = 0; i < n; i++) *numero(r, i) = i;
+    r->ecriture = 0;
+    r->lecture = 0;
+    return 0;
+}
+
+void ring_free(ring_t *r) {
+    free(r->cases);
+    r->cases = NULL;
+}
+
+bool ring_push(ring_t *r, const void *desc) {
+    size_t pos = __atomic_load_n(&r->ecriture, __ATOMIC_RELAXED);
+    size_t *num;
+    for (;;) {
+        num = numero(r, pos);
+        intptr_t ecart = (intptr_t)__atomic_load_n(num, __ATOMIC_ACQUIRE) - (intptr_t)pos;
+        if (ecart == 0) {
+            // Case libre : la réserver en avançant la position d'écriture
+            if (__atomic_compare_exchange_n(&r->ecriture, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        } else if (ecart < 0) {
+            return false;   // Pas encore vidée depuis le tour précédent : pleine
+        } else {
+            pos = __atomic_load_n(&r->ecriture, __ATOMIC_RELAXED);
+        }
+    }
+    memcpy(num + 1, desc, r->taille);
+    __atomic_store_n(num, pos + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool ring_pop(ring_t *r, void *desc) {
+    size_t pos = __atomic_load_n(&r->lecture, __ATOMIC_RELAXED);
+    size_t *num;
+    for (;;) {
+        num = numero(r, pos);
+        intptr_t ecart = (intptr_t)__atomic_load_n(num, __ATOMIC_ACQUIRE) - (intptr_t)(pos + 1);
+        if (ecart == 0) {
+            if (__atomic_compare_exchange_n(&r->lecture, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        } else if (ecart < 0) {
+            return false;   // Case pas encore publiée : vide
+        } else {
+            pos = __atomic_load_n(&r->lecture, __ATOMIC_RELAXED);
+        }
+    }
+    memcpy(desc, num + 1, r->taille);
+    __atomic_store_n(num, pos + r->capacite, __ATOMIC_RELEASE);
+    return true;
+}
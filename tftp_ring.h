@@ -0,0 +1,31 @@
+#ifndef TFTP_RING_H
+#define TFTP_RING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// File bornée sans verrou, plusieurs producteurs et plusieurs consommateurs
+// (anneau à numéros de séquence de D. Vyukov). Chaque case porte un
+// descripteur de taille fixe, copié à l'entrée et à la sortie : un dépôt
+// ou un retrait coûte une comparaison-échange et deux accès atomiques,
+// sans malloc ni appel système.
+//
+// La file ne fait pas attendre : ring_push échoue si elle est pleine,
+// ring_pop si elle est vide. L'attente d'un consommateur se fait à côté
+// (sémaphore compté par le producteur dans server_thread.c).
+
+typedef struct {
+    size_t capacite;        // Nombre de cases, puissance de 2
+    size_t taille;          // Octets d'un descripteur
+    size_t pas;             // Octets d'une case (numéro + descripteur), multiple de 64
+    unsigned char *cases;
+    size_t ecriture __attribute__((aligned(64)));   // Prochaine case à remplir
+    size_t lecture __attribute__((aligned(64)));    // Prochaine case à vider
+} ring_t;
+
+int  ring_init(ring_t *r, size_t capacite, size_t taille);
+void ring_free(ring_t *r);
+bool ring_push(ring_t *r, const void *desc);
+bool ring_pop(ring_t *r, void *desc);
+
+#endif
@@ -0,0 +1,55 @@
+#include <string.h>
+#include <strings.h>
+
+#include "tftp_sched.h"
+
+static int comparer(unsigned long long a, unsigned long long b) {
+    return a < b ? -1 : a > b;
+}
+
+// Premier arrivé, premier servi
+int sched_fifo(const sched_key_t *a, const sched_key_t *b) {
+    return comparer(a->arrival, b->arrival);
+}
+
+// Tourniquet : la session servie il y a le plus longtemps passe d'abord
+int sched_round_robin(const sched_key_t *a, const sched_key_t *b) {
+    int c = comparer(a->last_served, b->last_served);
+    return c ? c : sched_fifo(a, b);
+}
+
+// Plus petit reste d'abord : les petits fichiers (configurations de boot)
+// ne font pas la queue derrière les images
+int sched_shortest_first(const sched_key_t *a, const sched_key_t *b) {
+    int c = comparer(a->remaining, b->remaining);
+    return c ? c : sched_fifo(a, b);
+}
+
+static const struct {
+    const char *nom;
+    sched_policy_t policy;
+} politiques[] = {
+    { "fifo", sched_fifo },
+    { "rr",   sched_round_robin },
+    { "srf",  sched_shortest_first },
+};
+
+sched_policy_t sched_lookup(const char *nom) {
+    for (size_t i = 0; i < sizeof(politiques) / sizeof(politiques[0]); i++)
+        if (strcasecmp(nom, politiques[i].nom) == 0) return politiques[i].policy;
+    return NULL;
+}
+
+// Tri par insertion des identifiants de session : il y en a au plus
+// quelques dizaines
+void sched_sort(int *ids, int n, const sched_key_t *keys, sched_policy_t policy) {
+    for (int i = 1; i < n; i++) {
+        int id = ids[i];
+        int j = i - 1;
+        while (j >= 0 && policy(&keys[id], &keys[ids[j]]) < 0) {
+            ids[j + 1] = ids[j];
+            j--;
+        }
+        ids[j + 1] = id;
+    }
+}
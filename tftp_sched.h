@@ -0,0 +1,24 @@
+#ifndef TFTP_SCHED_H
+#define TFTP_SCHED_H
+
+// Ordonnancement des sessions : quand plusieurs sessions ont un paquet
+// DATA prêt, la politique décide laquelle reçoit d'abord les jetons du
+// limiteur de débit (et donc le droit d'envoyer).
+
+typedef struct {
+    unsigned long long arrival;     // Numéro d'arrivée de la session
+    unsigned long long last_served; // Instant (compteur) du dernier envoi accordé
+    unsigned long long remaining;   // Octets restant à envoyer, d'après la taille du fichier
+} sched_key_t;
+
+// Négatif si 'a' doit être servie avant 'b'
+typedef int (*sched_policy_t)(const sched_key_t *a, const sched_key_t *b);
+
+int sched_fifo(const sched_key_t *a, const sched_key_t *b);
+int sched_round_robin(const sched_key_t *a, const sched_key_t *b);
+int sched_shortest_first(const sched_key_t *a, const sched_key_t *b);
+
+sched_policy_t sched_lookup(const char *nom);
+void sched_sort(int *ids, int n, const sched_key_t *keys, sched_policy_t policy);
+
+#endif
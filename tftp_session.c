@@ -0,0 +1,240 @@
+#define _GNU_SOURCE
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "tftp_pmtu.h"
+#include "tftp_session.h"
+#include "tftp_trace.h"
+
+static void entete(session_t *s, uint16_t opcode, uint16_t bloc) {
+    uint16_t op = htons(opcode);
+    uint16_t blk = htons(bloc);
+    memcpy(s->paquet, &op, 2);
+    memcpy(s->paquet + 2, &blk, 2);
+}
+
+static int envoyer_oack(session_t *s, const tftp_options_t *opts) {
+    uint16_t op = htons(TFTP_OACK);
+    memcpy(s->paquet, &op, 2);
+    s->paquet_len = 2 + options_write(s->paquet + 2, sizeof(s->paquet) - 2, opts);
+    return SESSION_ENVOYER;
+}
+
+// DATA du bloc s->bloc lu à s->offset. En netascii les octets sont
+// convertis : un bloc plein porte alors moins d'octets du fichier, et
+// s->consomme est ce dont l'ACK fera avancer s->offset.
+static int charger_bloc(session_t *s) {
+    char brut[TFTP_BLKSIZE_MAX];
+    entete(s, 3, s->bloc);
+    size_t a_lire = s->blksize;
+    if (s->fin >= 0 && s->fin - s->offset < (off_t)a_lire) a_lire = s->fin - s->offset;
+    char *dst = s->netascii ? brut : s->paquet + 4;
+    ssize_t lu = a_lire ? stockage_lire(&s->src, dst, a_lire, s->offset) : 0;
+    size_t len = lu > 0 ? (size_t)lu : 0;
+    TRACE_DISK_READ(s->id, (long long)s->offset, (long)lu);
+    s->consomme = len;
+    if (s->netascii)
+        len = netascii_encode(&s->enc, brut, len, &s->consomme, s->paquet + 4, s->blksize);
+    s->paquet_len = len + 4;
+    s->essais = 0;
+    s->pertes = 0;
+    return SESSION_ENVOYER | SESSION_DATA;
+}
+
+// Gros bloc perdu plusieurs fois : probable trou noir PMTU (paquets DF
+// jetés sans ICMP). La session continue en fragments, les suivantes avec
+// ce pair auront des blocs plus petits.
+static int compter_perte(session_t *s) {
+    if (++s->pertes >= PMTU_PERTES_MAX && s->df) return session_emsgsize(s);
+    return 0;
+}
+
+static void init(session_t *s, session_type_t type, unsigned long long id, const struct sockaddr_in *client,
+                 bool netascii, const tftp_options_t *opts) {
+    s->type = type;
+    s->id = id;
+    s->client = *client;
+    memset(&s->src, 0, sizeof(s->src));
+    s->src.fd = -1;
+    s->dst = NULL;
+    s->taille = 0;
+    s->bloc = 0;
+    s->oack = false;
+    s->rollover = (opts->presentes & TFTP_OPT_ROLLOVER) ? opts->rollover : 0;
+    s->blksize = TFTP_BLKSIZE_DEFAUT;
+    s->timeout = (opts->presentes & TFTP_OPT_TIMEOUT) ? opts->timeout : SESSION_TIMEOUT_DEFAUT;
+    s->essais = 0;
+    s->pertes = 0;
+    s->df = false;
+    s->offset = 0;
+    s->fin = -1;
+    s->consomme = 0;
+    s->netascii = netascii;
+    netascii_enc_init(&s->enc);
+    netascii_dec_init(&s->dec);
+    s->quota = 0;
+    s->transferes = 0;
+    s->termine = false;
+    s->paquet_len = 0;
+}
+
+// Lecture de l'objet 'src' (tftp_stockage.h), gardé ouvert par le moteur
+// jusqu'à la fin de la session. Les options acceptées (bornées au
+// fichier) sont renvoyées dans un OACK acquitté par l'ACK 0 ; sinon le
+// bloc 1 part tout de suite.
+int session_rrq(session_t *s, unsigned long long id, const struct sockaddr_in *client,
+                const stockage_objet_t *src, bool netascii, tftp_options_t *opts) {
+    off_t taille = src->taille;
+    // En netascii la taille sur le fil dépend du contenu : ni tsize ni plages
+    if (netascii) opts->presentes &= ~(TFTP_OPT_TSIZE | TFTP_OPT_OFFSET | TFTP_OPT_LENGTH);
+    init(s, SESSION_RRQ, id, client, netascii, opts);
+    s->src = *src;
+    s->taille = taille;
+
+    if (opts->presentes & TFTP_OPT_TSIZE) opts->tsize = taille;
+    if (opts->presentes & TFTP_OPT_OFFSET) {
+        if (opts->offset > (uint64_t)taille) opts->offset = taille;
+        s->offset = opts->offset;
+    }
+    if (opts->presentes & TFTP_OPT_LENGTH) {
+        if (opts->length > (uint64_t)(taille - s->offset)) opts->length = taille - s->offset;
+        s->fin = s->offset + opts->length;
+    }
+    // blksize : au plus ce que le chemin vers le client porte sans fragmenter
+    if (opts->presentes & TFTP_OPT_BLKSIZE) opts->blksize = s->blksize = pmtu_choisir(client, opts->blksize);
+    // Gros blocs envoyés avec DF : un MTU trop petit se voit (EMSGSIZE ou
+    // pertes répétées) au lieu de fragmenter en silence
+    s->df = s->blksize > TFTP_BLKSIZE_DEFAUT;
+
+    if (opts->presentes) {
+        s->oack = true;
+        return envoyer_oack(s, opts);
+    }
+    s->bloc = 1;
+    return charger_bloc(s);
+}
+
+// Écriture de l'objet 'dst' (nouvelle version, vide), gardé par le moteur
+// jusqu'à la fin de la session. Première réponse : OACK si des options
+// sont acceptées, sinon ACK 0.
+int session_wrq(session_t *s, unsigned long long id, const struct sockaddr_in *client,
+                stockage_objet_t *dst, bool netascii, unsigned long long quota, tftp_options_t *opts) {
+    opts->presentes &= ~(TFTP_OPT_OFFSET | TFTP_OPT_LENGTH | TFTP_OPT_COMPRESS); // Lecture seulement
+    init(s, SESSION_WRQ, id, client, netascii, opts);
+    s->dst = dst;
+    s->quota = quota;
+    if (opts->presentes & TFTP_OPT_BLKSIZE) opts->blksize = s->blksize = pmtu_choisir(client, opts->blksize);
+    if (opts->presentes) return envoyer_oack(s, opts);
+    entete(s, 4, 0);
+    s->paquet_len = 4;
+    return SESSION_ENVOYER;
+}
+
+static int recevoir_ack(session_t *s, uint16_t bloc) {
+    TRACE_ACK_RECV(s->id, bloc);
+    if (bloc == s->bloc) {
+        if (s->oack) {
+            s->oack = false;
+            s->bloc = 1;
+            return charger_bloc(s);
+        }
+        s->offset += s->consomme;
+        // Bloc court : c'était le dernier
+        if (s->paquet_len - 4 < (size_t)s->blksize) {
+            s->termine = true;
+            return SESSION_FIN;
+        }
+        s->bloc = bloc_suivant(s->bloc, s->rollover);
+        return charger_bloc(s);
+    }
+    // Le client réclame encore le bloc courant : il ne l'a pas reçu
+    if (!s->oack && bloc_suivant(bloc, s->rollover) == s->bloc) return compter_perte(s);
+    return 0;
+}
+
+static int recevoir_data(session_t *s, uint16_t bloc, const char *donnees, size_t len) {
+    if (bloc == s->bloc) return SESSION_ENVOYER; // Doublon : renvoyer la dernière réponse
+    if (bloc != bloc_suivant(s->bloc, s->rollover)) return 0;
+
+    bool dernier = len < (size_t)s->blksize;
+    char texte[TFTP_BLKSIZE_MAX + 1]; // Bloc converti depuis netascii (+1 : CR reporté)
+    size_t taille = len;
+    TRACE_DATA_RECV(s->id, bloc, (long)len);
+    if (s->netascii) {
+        taille = netascii_decode(&s->dec, donnees, len, texte);
+        if (dernier) taille += netascii_decode_end(&s->dec, texte + taille);
+        donnees = texte;
+    }
+    // Quota appliqué même sans tsize annoncé
+    if (s->quota && s->transferes + taille > s->quota)
+        return session_erreur(s, 3, "Disk full or allocation exceeded");
+    if (stockage_ecrire(s->dst, donnees, taille, s->transferes) != (ssize_t)taille) {
+        perror("write");
+        return session_erreur(s, 3, "Disk full or allocation exceeded");
+    }
+    TRACE_DISK_WRITE(s->id, (long long)s->transferes, (long)taille);
+    s->transferes += taille;
+    s->bloc = bloc;
+    s->essais = 0;
+
+    entete(s, 4, bloc);
+    s->paquet_len = 4;
+    if (!dernier) return SESSION_ENVOYER;
+    // Dernier bloc : la version est publiée avant l'ACK final, un GET
+    // lancé juste après le PUT voit donc le nouveau contenu
+    s->termine = true;
+    return SESSION_PUBLIER | SESSION_ENVOYER | SESSION_FIN;
+}
+
+int session_paquet(session_t *s, const char *buf, size_t n, const struct sockaddr_in *emetteur) {
+    if (n < 4) return 0;
+    if (emetteur->sin_addr.s_addr != s->client.sin_addr.s_addr || emetteur->sin_port != s->client.sin_port) {
+        TRACE_TID_REJECT(s->id, ntohs(emetteur->sin_port));
+        return SESSION_TID;
+    }
+    uint16_t opcode = ntohs(*(const uint16_t *)buf);
+    uint16_t bloc = ntohs(*(const uint16_t *)(buf + 2));
+    if (opcode == 5) return SESSION_FIN; // Le client abandonne (ex: OACK refusé)
+    if (s->type == SESSION_RRQ && opcode == 4) return recevoir_ack(s, bloc);
+    if (s->type == SESSION_WRQ && opcode == 3) return recevoir_data(s, bloc, buf + 4, n - 4);
+    return 0;
+}
+
+// Rien reçu depuis s->timeout secondes : le dernier paquet est renvoyé,
+// jusqu'à SESSION_ESSAIS_MAX fois
+int session_timeout(session_t *s) {
+    if (++s->essais > SESSION_ESSAIS_MAX) return SESSION_FIN;
+    TRACE_RETRANSMIT(s->id, s->bloc, s->essais);
+    if (s->type == SESSION_RRQ && !s->oack)
+        return compter_perte(s) | SESSION_ENVOYER | SESSION_DATA;
+    // Uploads : le client émet les gros blocs, on retient seulement les pertes
+    if (s->type == SESSION_WRQ && s->essais == PMTU_PERTES_MAX) pmtu_signaler_perte(&s->client, s->blksize);
+    return SESSION_ENVOYER;
+}
+
+// Le noyau a appris un MTU plus petit (ICMP), ou les pertes l'indiquent :
+// la suite part en fragments et le pair descend d'un palier
+int session_emsgsize(session_t *s) {
+    if (!s->df) return 0;
+    s->df = false;
+    pmtu_signaler_perte(&s->client, s->blksize);
+    return SESSION_FRAGMENTER;
+}
+
+int session_erreur(session_t *s, uint16_t code, const char *msg) {
+    entete(s, 5, code);
+    size_t len = strlen(msg);
+    if (len > TFTP_BLKSIZE_DEFAUT - 1) len = TFTP_BLKSIZE_DEFAUT - 1;
+    memcpy(s->paquet + 4, msg, len);
+    s->paquet[4 + len] = '\0';
+    s->paquet_len = 4 + len + 1;
+    s->termine = false;
+    return SESSION_ENVOYER | SESSION_FIN;
+}
+
+// Octets transférés : position atteinte (RRQ) ou écrits (WRQ)
+unsigned long long session_octets(const session_t *s) {
+    return s->type == SESSION_RRQ ? (unsigned long long)s->offset : s->transferes;
+}
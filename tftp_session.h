@@ -0,0 +1,88 @@
+#ifndef TFTP_SESSION_H
+#define TFTP_SESSION_H
+
+#include <netinet/in.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "tftp_netascii.h"
+#include "tftp_options.h"
+#include "tftp_stockage.h"
+
+// Machine à états d'une session unicast RRQ/WRQ, commune aux moteurs
+// (thread par requête, réacteur select). Elle ne bloque pas et n'alloue
+// rien : le moteur lui passe les paquets reçus et les expirations de son
+// minuteur, et elle répond par des actions (SESSION_*) à exécuter.
+//
+// La machine tient le protocole : numéros de bloc et rollover, OACK,
+// blksize, plages offset/length, netascii, retransmissions, pertes et
+// repli PMTU, quota d'upload. Elle lit l'objet d'un RRQ par stockage_lire
+// et écrit celui d'un WRQ par stockage_ecrire (tftp_stockage.h) : pread
+// ou copie depuis une image en mémoire, selon l'objet et son magasin.
+// Le moteur garde les sockets, le minuteur de s->timeout secondes, le
+// limiteur de débit, les verrous et la validation des objets écrits.
+//
+// Ordre d'exécution des actions : SESSION_TID, SESSION_FRAGMENTER,
+// SESSION_PUBLIER, SESSION_ENVOYER, puis SESSION_FIN.
+
+#define SESSION_TIMEOUT_DEFAUT 5
+#define SESSION_ESSAIS_MAX 5        // Retransmissions d'un même paquet avant abandon
+
+#define SESSION_ENVOYER    0x01     // Émettre s->paquet vers le client
+#define SESSION_DATA       0x02     // Ce paquet est un DATA : il passe par le limiteur de débit
+#define SESSION_PUBLIER    0x04     // Dernier bloc écrit : publier la version avant l'ACK
+#define SESSION_FRAGMENTER 0x08     // Gros blocs perdus : lever DF sur la socket
+#define SESSION_TID        0x10     // Paquet d'un TID inconnu : ERROR 5 à son émetteur
+#define SESSION_FIN        0x20     // Session terminée (s->termine si réussie)
+
+typedef enum {
+    SESSION_RRQ = 1,
+    SESSION_WRQ = 2
+} session_type_t;
+
+typedef struct {
+    session_type_t type;
+    unsigned long long id;      // Identifiant porté par les sondes de trace
+    struct sockaddr_in client;  // TID du client
+    stockage_objet_t src;       // RRQ : source (copie de l'objet du moteur, qui le ferme)
+    stockage_objet_t *dst;      // WRQ : nouvelle version, écrite par stockage_ecrire
+    off_t taille;               // RRQ : taille du fichier
+
+    uint16_t bloc;              // Sur le fil : DATA courant (RRQ) ou dernier acquitté (WRQ)
+    bool oack;                  // RRQ : OACK envoyé, en attente de l'ACK 0
+    int rollover;               // Bloc qui suit 65535 (0 ou 1)
+    int blksize;                // RFC 2348, 512 par défaut
+    int timeout;                // Délai de retransmission (option timeout)
+    int essais;                 // Retransmissions du paquet courant
+    int pertes;                 // RRQ : DATA courant non acquitté (timeouts, ACK en double)
+    bool df;                    // RRQ : gros DATA envoyés avec DF
+
+    off_t offset;               // RRQ : position du bloc courant dans le fichier
+    off_t fin;                  // RRQ : fin de la plage (length), -1 : fin du fichier
+    size_t consomme;            // RRQ : octets du fichier portés par le bloc courant
+    bool netascii;
+    netascii_enc_t enc;
+    netascii_dec_t dec;
+
+    unsigned long long quota;       // WRQ : taille maximale (0 : illimitée)
+    unsigned long long transferes;  // WRQ : octets écrits
+    bool termine;
+
+    char paquet[TFTP_BLKSIZE_MAX + 4];  // Dernier paquet à émettre, gardé pour les retransmissions
+    size_t paquet_len;
+} session_t;
+
+int session_rrq(session_t *s, unsigned long long id, const struct sockaddr_in *client,
+                const stockage_objet_t *src, bool netascii, tftp_options_t *opts);
+int session_wrq(session_t *s, unsigned long long id, const struct sockaddr_in *client,
+                stockage_objet_t *dst, bool netascii, unsigned long long quota, tftp_options_t *opts);
+
+int session_paquet(session_t *s, const char *buf, size_t n, const struct sockaddr_in *emetteur);
+int session_timeout(session_t *s);
+int session_emsgsize(session_t *s);
+int session_erreur(session_t *s, uint16_t code, const char *msg);
+
+unsigned long long session_octets(const session_t *s);
+
+#endif
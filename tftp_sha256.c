@@ -0,0 +1,108 @@
+#include <string.h>
+
+#include "tftp_sha256.h"
+
+static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static uint32_t rotr(uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+static void compresser(uint32_t etat[8], const unsigned char *bloc) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++)
+        w[i] = (uint32_t)bloc[4 * i] << 24 | (uint32_t)bloc[4 * i + 1] << 16 |
+               (uint32_t)bloc[4 * i + 2] << 8 | bloc[4 * i + 3];
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    uint32_t a = etat[0], b = etat[1], c = etat[2], d = etat[3];
+    uint32_t e = etat[4], f = etat[5], g = etat[6], h = etat[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+        uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    etat[0] += a;
+    etat[1] += b;
+    etat[2] += c;
+    etat[3] += d;
+    etat[4] += e;
+    etat[5] += f;
+    etat[6] += g;
+    etat[7] += h;
+}
+
+void sha256_init(sha256_t *h) {
+    static const uint32_t initial[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    memcpy(h->etat, initial, sizeof(initial));
+    h->longueur = 0;
+    h->rempli = 0;
+}
+
+void sha256_ajouter(sha256_t *h, const void *donnees, size_t len) {
+    const unsigned char *p = donnees;
+    h->longueur += len;
+    if (h->rempli > 0) {
+        size_t n = 64 - h->rempli < len ? 64 - h->rempli : len;
+        memcpy(h->bloc + h->rempli, p, n);
+        h->rempli += n;
+        p += n;
+        len -= n;
+        if (h->rempli < 64) return;
+        compresser(h->etat, h->bloc);
+        h->rempli = 0;
+    }
+    // Blocs complets lus sur place, sans copie
+    for (; len >= 64; p += 64, len -= 64) compresser(h->etat, p);
+    memcpy(h->bloc, p, len);
+    h->rempli = len;
+}
+
+void sha256_finir(sha256_t *h, unsigned char empreinte[SHA256_TAILLE]) {
+    uint64_t bits = h->longueur * 8;
+    h->bloc[h->rempli++] = 0x80;
+    if (h->rempli > 56) {
+        memset(h->bloc + h->rempli, 0, 64 - h->rempli);
+        compresser(h->etat, h->bloc);
+        h->rempli = 0;
+    }
+    memset(h->bloc + h->rempli, 0, 56 - h->rempli);
+    for (int i = 0; i < 8; i++) h->bloc[56 + i] = (unsigned char)(bits >> (56 - 8 * i));
+    compresser(h->etat, h->bloc);
+    for (int i = 0; i < 8; i++) {
+        empreinte[4 * i] = (unsigned char)(h->etat[i] >> 24);
+        empreinte[4 * i + 1] = (unsigned char)(h->etat[i] >> 16);
+        empreinte[4 * i + 2] = (unsigned char)(h->etat[i] >> 8);
+        empreinte[4 * i + 3] = (unsigned char)h->etat[i];
+    }
+}
+
+void sha256_hex(const unsigned char empreinte[SHA256_TAILLE], char texte[SHA256_HEX]) {
+    static const char chiffres[] = "0123456789abcdef";
+    for (int i = 0; i < SHA256_TAILLE; i++) {
+        texte[2 * i] = chiffres[empreinte[i] >> 4];
+        texte[2 * i + 1] = chiffres[empreinte[i] & 15];
+    }
+    texte[2 * SHA256_TAILLE] = '\0';
+}
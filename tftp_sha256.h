@@ -0,0 +1,26 @@
+#ifndef TFTP_SHA256_H
+#define TFTP_SHA256_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// SHA-256 (FIPS 180-4), calculé en flux : les octets sont ajoutés dans
+// l'ordre, découpés n'importe comment. Sert d'identité des contenus au
+// magasin cas (tftp_stockage.c) ; ni dépendance ni allocation.
+
+#define SHA256_TAILLE 32
+#define SHA256_HEX (2 * SHA256_TAILLE + 1)
+
+typedef struct {
+    uint32_t etat[8];
+    uint64_t longueur;          // Octets ajoutés
+    unsigned char bloc[64];     // Bloc de 64 octets en cours
+    size_t rempli;
+} sha256_t;
+
+void sha256_init(sha256_t *h);
+void sha256_ajouter(sha256_t *h, const void *donnees, size_t len);
+void sha256_finir(sha256_t *h, unsigned char empreinte[SHA256_TAILLE]);
+void sha256_hex(const unsigned char empreinte[SHA256_TAILLE], char texte[SHA256_HEX]);
+
+#endif
@@ -0,0 +1,657 @@
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+
+#include "tftp_durabilite.h"
+#include "tftp_sha256.h"
+#include "tftp_stockage.h"
+
+// --- Magasin dir : le répertoire servi ---
+
+static int dossier_ouvrir(stockage_objet_t *o, const char *chemin) {
+    fdcache_entry_t *e = fdcache_acquire(chemin);
+    if (!e) return -1;
+    o->taille = e->size;
+    o->fd = e->fd;
+    o->dev = e->dev;
+    o->inode = e->inode;
+    o->mtime = e->mtime;
+    o->priv = e;
+    return 0;
+}
+
+static void dossier_fermer(stockage_objet_t *o) {
+    fdcache_release(o->priv);
+}
+
+static int dossier_creer(stockage_objet_t *o, const char *chemin, off_t prevue) {
+    version_t *v = malloc(sizeof(*v));
+    if (!v || version_begin(v, chemin) < 0) {
+        free(v);
+        return -1;
+    }
+    // Préallocation : moins de fragmentation sur disque
+    if (prevue > 0) fallocate(v->fd, FALLOC_FL_KEEP_SIZE, 0, prevue);
+    o->fd = v->fd;
+    o->priv = v;
+    return 0;
+}
+
+static version_t *dossier_preparer(stockage_objet_t *o) {
+    return o->priv;
+}
+
+// Publiée ou perdue : les nouveaux lecteurs rouvrent le nom
+static int dossier_publiee(stockage_objet_t *o, int resultat) {
+    version_t *v = o->priv;
+    fdcache_invalidate(v->chemin);
+    return resultat;
+}
+
+// Version durable selon -D, en une fois (dir et cas)
+static int valider_version(stockage_objet_t *o) {
+    version_t *v = o->magasin->preparer(o);
+    if (v && stockage_completer(o) < 0) {
+        version_abort(v);
+        v = NULL;
+    }
+    return o->magasin->publiee(o, v ? durabilite_publier(v) : -1);
+}
+
+// Espace libre du système de fichiers de 'racine' (dir et cas)
+static bool place_disque(const char *racine, unsigned long long taille) {
+    struct statvfs vfs;
+    return statvfs(racine, &vfs) < 0 || taille <= (unsigned long long)vfs.f_bavail * vfs.f_frsize;
+}
+
+static void dossier_abandonner(stockage_objet_t *o) {
+    version_abort(o->priv); // Sans effet si la version a été publiée
+    free(o->priv);
+}
+
+const stockage_t stockage_dossier = {
+    "dir", NULL, dossier_ouvrir, dossier_fermer, NULL, dossier_creer, NULL, valider_version, dossier_abandonner,
+    dossier_preparer, NULL, dossier_publiee, place_disque
+};
+
+fdcache_entry_t *stockage_dossier_entree(const stockage_objet_t *o) {
+    return o->magasin == &stockage_dossier && o->priv ? o->priv : NULL;
+}
+
+version_t *stockage_dossier_version(const stockage_objet_t *o) {
+    return o->magasin == &stockage_dossier ? o->priv : NULL;
+}
+
+// Descripteur de lecture reçu d'un autre processus
+int stockage_dossier_adopter(stockage_objet_t *o, const char *chemin, int fd) {
+    fdcache_entry_t *e = fdcache_adopter(chemin, fd);
+    memset(o, 0, sizeof(*o));
+    o->fd = -1;
+    if (!e) return -1;
+    o->magasin = &stockage_dossier;
+    o->taille = e->size;
+    o->fd = e->fd;
+    o->dev = e->dev;
+    o->inode = e->inode;
+    o->mtime = e->mtime;
+    o->priv = e;
+    return 0;
+}
+
+// Version en cours d'écriture reçue d'un autre processus, sur 'fd'
+int stockage_dossier_reprendre(stockage_objet_t *o, const version_t *v, int fd) {
+    memset(o, 0, sizeof(*o));
+    o->fd = -1;
+    version_t *copie = malloc(sizeof(*copie));
+    if (!copie) {
+        close(fd);
+        return -1;
+    }
+    *copie = *v;
+    version_reprendre(copie, fd);
+    o->fd = fd;
+    o->magasin = &stockage_dossier;
+    o->priv = copie;
+    return 0;
+}
+
+// --- Magasin mem : table en mémoire ---
+
+#define MEMOIRE_SEAUX 1024
+
+typedef struct memoire_fichier {
+    char *nom;
+    char *donnees;              // Projection du memfd de l'upload (NULL si vide)
+    size_t taille;
+    ino_t generation;           // Version : tient lieu d'inode
+    time_t mtime;
+    int refs;                   // Lecteurs, plus un tant que le fichier est publié
+    struct memoire_fichier *suivant;
+} memoire_fichier_t;
+
+typedef struct {
+    int fd;
+    char nom[];
+} memoire_ecriture_t;
+
+static pthread_mutex_t memoire_verrou = PTHREAD_MUTEX_INITIALIZER;
+static memoire_fichier_t *seaux[MEMOIRE_SEAUX];
+static ino_t generations = 0;
+
+static memoire_fichier_t **seau(const char *nom) {
+    uint32_t h = 2166136261u; // FNV-1a, comme tftp_index.c
+    while (*nom) {
+        h ^= (unsigned char)*nom++;
+        h *= 16777619u;
+    }
+    return &seaux[h % MEMOIRE_SEAUX];
+}
+
+static void liberer(memoire_fichier_t *f) {
+    if (f->donnees) munmap(f->donnees, f->taille);
+    free(f->nom);
+    free(f);
+}
+
+static int memoire_ouvrir(stockage_objet_t *o, const char *chemin) {
+    pthread_mutex_lock(&memoire_verrou);
+    memoire_fichier_t *f = *seau(chemin);
+    while (f && strcmp(f->nom, chemin) != 0) f = f->suivant;
+    if (f) f->refs++;
+    pthread_mutex_unlock(&memoire_verrou);
+    if (!f) {
+        errno = ENOENT;
+        return -1;
+    }
+    o->taille = f->taille;
+    o->image = f->donnees ? f->donnees : "";
+    o->inode = f->generation;
+    o->mtime = f->mtime;
+    o->priv = f;
+    return 0;
+}
+
+static void memoire_fermer(stockage_objet_t *o) {
+    memoire_fichier_t *f = o->priv;
+    pthread_mutex_lock(&memoire_verrou);
+    bool dernier = --f->refs == 0;
+    pthread_mutex_unlock(&memoire_verrou);
+    if (dernier) liberer(f);
+}
+
+static int memoire_creer(stockage_objet_t *o, const char *chemin, off_t prevue) {
+    (void)prevue; // Pages allouées à l'écriture : rien à réserver
+    size_t len = strlen(chemin) + 1;
+    memoire_ecriture_t *w = malloc(sizeof(*w) + len);
+    if (!w) return -1;
+    memcpy(w->nom, chemin, len);
+    w->fd = memfd_create("tftp", MFD_CLOEXEC);
+    if (w->fd < 0) {
+        free(w);
+        return -1;
+    }
+    o->fd = w->fd;
+    o->priv = w;
+    return 0;
+}
+
+// Projette le contenu écrit et remplace la version publiée du nom ; les
+// lecteurs de l'ancienne la gardent jusqu'à leur fermeture
+static int memoire_valider(stockage_objet_t *o) {
+    memoire_ecriture_t *w = o->priv;
+    memoire_fichier_t *f = calloc(1, sizeof(*f));
+    struct stat st;
+    if (!f || !(f->nom = strdup(w->nom)) || fstat(w->fd, &st) < 0) goto echec;
+    f->taille = st.st_size;
+    if (f->taille > 0) {
+        f->donnees = mmap(NULL, f->taille, PROT_READ, MAP_SHARED, w->fd, 0);
+        if (f->donnees == MAP_FAILED) {
+            f->donnees = NULL;
+            goto echec;
+        }
+    }
+    f->mtime = time(NULL);
+    f->refs = 1;
+    close(w->fd);
+    free(w);
+    o->priv = NULL;
+
+    memoire_fichier_t *ancien = NULL;
+    pthread_mutex_lock(&memoire_verrou);
+    f->generation = ++generations;
+    memoire_fichier_t **p = seau(f->nom);
+    while (*p && strcmp((*p)->nom, f->nom) != 0) p = &(*p)->suivant;
+    if (*p) {
+        ancien = *p;
+        *p = ancien->suivant;
+        if (--ancien->refs > 0) ancien = NULL;
+    }
+    f->suivant = *seau(f->nom);
+    *seau(f->nom) = f;
+    pthread_mutex_unlock(&memoire_verrou);
+    if (ancien) liberer(ancien);
+    return 0;
+
+echec:
+    perror("stockage mem");
+    if (f) liberer(f);
+    return -1;
+}
+
+// Un upload tient en mémoire (pages du memfd, en RAM ou en swap) s'il ne
+// dépasse pas MemAvailable ; le disque sous 'racine' n'est jamais écrit
+static bool memoire_place(const char *racine, unsigned long long taille) {
+    (void)racine;
+    FILE *f = fopen("/proc/meminfo", "r");
+    if (!f) return true;
+    char ligne[128];
+    unsigned long long ko = 0;
+    bool trouve = false;
+    while (!trouve && fgets(ligne, sizeof(ligne), f))
+        trouve = sscanf(ligne, "MemAvailable: %llu kB", &ko) == 1;
+    fclose(f);
+    return !trouve || taille <= ko * 1024;
+}
+
+static void memoire_abandonner(stockage_objet_t *o) {
+    memoire_ecriture_t *w = o->priv;
+    if (!w) return; // Validée
+    close(w->fd);
+    free(w);
+}
+
+const stockage_t stockage_memoire = {
+    "mem", NULL, memoire_ouvrir, memoire_fermer, NULL, memoire_creer, NULL, memoire_valider, memoire_abandonner,
+    NULL, NULL, NULL, memoire_place
+};
+
+// --- Magasin cas : le répertoire, dédupliqué par contenu ---
+
+#define CAS_SEAUX 1024
+#define CAS_COMPARAISON 4096        // Octets comparés à la fois avec la version publiée
+#define CAS_RECOPIE (1 << 20)       // Partie identique recopiée à chaque bloc reçu après l'écart
+#define CAS_CHEMIN (sizeof(CAS_DOSSIER) + SHA256_HEX)
+
+// Contenus de CAS_DOSSIER, par inode : quand un nom change de contenu,
+// l'ancien est effacé s'il n'est plus servi sous aucun nom
+typedef struct cas_contenu {
+    dev_t dev;
+    ino_t inode;
+    char chemin[CAS_CHEMIN];
+    struct cas_contenu *suivant;
+} cas_contenu_t;
+
+typedef struct {
+    version_t ver;              // Nouvelle version, écrite à partir du premier écart
+    sha256_t empreinte;
+    off_t hachees;              // Octets reçus dans l'ordre, passés à l'empreinte
+    bool en_ordre;              // Faux si une écriture a sauté : pas d'empreinte
+    bool echec;
+    int courant;                // Version publiée du nom, comparée puis recopiée (-1 : écartée ou recopiée)
+    off_t courant_taille;
+    off_t identiques;           // Octets reçus égaux à la version publiée, non écrits
+    bool ecart;                 // Fin de la comparaison : les identiques sont à recopier
+    off_t recopies;             // Partie des identiques déjà recopiée
+    dev_t ancien_dev;           // Contenu remplacé par l'upload (inode 0 : aucun)
+    ino_t ancien_inode;
+    bool nouveau;               // Contenu à ajouter à CAS_DOSSIER une fois publié
+    char corps[CAS_CHEMIN];     // Son chemin d'après l'empreinte
+} cas_ecriture_t;
+
+static pthread_mutex_t cas_verrou = PTHREAD_MUTEX_INITIALIZER;
+static cas_contenu_t *cas_seaux[CAS_SEAUX];
+
+static cas_contenu_t **cas_seau(dev_t dev, ino_t inode) {
+    return &cas_seaux[(inode ^ dev) % CAS_SEAUX];
+}
+
+static void cas_noter(const char *chemin) {
+    struct stat st;
+    cas_contenu_t *c = malloc(sizeof(*c));
+    if (!c || stat(chemin, &st) < 0) {
+        free(c);
+        return;
+    }
+    c->dev = st.st_dev;
+    c->inode = st.st_ino;
+    snprintf(c->chemin, sizeof(c->chemin), "%s", chemin);
+    pthread_mutex_lock(&cas_verrou);
+    cas_contenu_t **p = cas_seau(c->dev, c->inode);
+    c->suivant = *p;
+    *p = c;
+    pthread_mutex_unlock(&cas_verrou);
+}
+
+// Contenu remplacé : effacé si son lien dans CAS_DOSSIER est le dernier
+static void cas_oublier(dev_t dev, ino_t inode) {
+    struct stat st;
+    pthread_mutex_lock(&cas_verrou);
+    cas_contenu_t **p = cas_seau(dev, inode);
+    while (*p && ((*p)->dev != dev || (*p)->inode != inode)) p = &(*p)->suivant;
+    cas_contenu_t *c = *p;
+    if (c && stat(c->chemin, &st) == 0 && st.st_ino == inode && st.st_nlink == 1) {
+        unlink(c->chemin);
+        *p = c->suivant;
+    } else
+        c = NULL;
+    pthread_mutex_unlock(&cas_verrou);
+    free(c);
+}
+
+// Contenus existants notés ; ceux dont tous les noms ont été effacés hors
+// du serveur sont supprimés
+static int cas_demarrer(void) {
+    mkdir(CAS_DOSSIER, 0777);
+    DIR *d = opendir(CAS_DOSSIER);
+    if (!d) {
+        perror(CAS_DOSSIER);
+        return -1;
+    }
+    int gardes = 0, effaces = 0;
+    struct dirent *de;
+    while ((de = readdir(d))) {
+        if (de->d_name[0] == '.') continue;
+        char sous[512];
+        snprintf(sous, sizeof(sous), CAS_DOSSIER "%s", de->d_name);
+        DIR *ds = opendir(sous);
+        struct dirent *f;
+        while (ds && (f = readdir(ds))) {
+            char chemin[1024];
+            struct stat st;
+            snprintf(chemin, sizeof(chemin), "%s/%s", sous, f->d_name);
+            if (f->d_name[0] == '.' || lstat(chemin, &st) < 0 || !S_ISREG(st.st_mode)) continue;
+            if (st.st_nlink > 1) {
+                cas_noter(chemin);
+                gardes++;
+            } else if (unlink(chemin) == 0)
+                effaces++;
+        }
+        if (ds) closedir(ds);
+        rmdir(sous); // Vide : tous ses contenus effacés
+    }
+    closedir(d);
+    printf("[CAS] %d contenus, %d orphelins effacés\n", gardes, effaces);
+    return 0;
+}
+
+static int cas_creer(stockage_objet_t *o, const char *chemin, off_t prevue) {
+    cas_ecriture_t *w = calloc(1, sizeof(*w));
+    if (!w || version_begin(&w->ver, chemin) < 0) {
+        free(w);
+        return -1;
+    }
+    sha256_init(&w->empreinte);
+    w->en_ordre = true;
+    // Version publiée du nom : tant que l'upload la répète, rien n'est
+    // écrit. Une taille annoncée différente l'écarte d'emblée.
+    struct stat st;
+    w->courant = open(chemin, O_RDONLY | O_CLOEXEC);
+    if (w->courant >= 0 && (fstat(w->courant, &st) < 0 || !S_ISREG(st.st_mode))) {
+        close(w->courant);
+        w->courant = -1;
+    }
+    if (w->courant >= 0) {
+        w->courant_taille = st.st_size;
+        w->ancien_dev = st.st_dev;
+        w->ancien_inode = st.st_ino;
+        if (prevue > 0 && prevue != st.st_size) {
+            close(w->courant);
+            w->courant = -1;
+        }
+    }
+    if (w->courant < 0 && prevue > 0) fallocate(w->ver.fd, FALLOC_FL_KEEP_SIZE, 0, prevue);
+    o->fd = w->ver.fd;
+    o->priv = w;
+    return 0;
+}
+
+static bool cas_repete(cas_ecriture_t *w, const char *buf, size_t n, off_t position) {
+    if (position + (off_t)n > w->courant_taille) return false;
+    char lu[CAS_COMPARAISON];
+    for (size_t fait = 0; fait < n;) {
+        size_t k = n - fait < sizeof(lu) ? n - fait : sizeof(lu);
+        if (pread(w->courant, lu, k, position + fait) != (ssize_t)k || memcmp(lu, buf + fait, k) != 0) return false;
+        fait += k;
+    }
+    return true;
+}
+
+// Après l'écart : au plus 'max' octets de plus de la partie identique
+// sont recopiés de la version publiée, dans le noyau (copy_file_range) si
+// possible. Par tranches, pour qu'un long préfixe identique ne bloque pas
+// le moteur sur un seul bloc ; le reste est recopié par stockage_completer.
+static int cas_recopier(cas_ecriture_t *w, off_t max) {
+    loff_t lu = w->recopies, ecrit = w->recopies;
+    loff_t fin = w->identiques - lu > max ? lu + max : w->identiques;
+    char tampon[CAS_COMPARAISON];
+    while (lu < fin) {
+        if (copy_file_range(w->courant, &lu, w->ver.fd, &ecrit, fin - lu, 0) > 0) continue;
+        size_t n = fin - lu < (loff_t)sizeof(tampon) ? (size_t)(fin - lu) : sizeof(tampon);
+        ssize_t k = pread(w->courant, tampon, n, lu);
+        if (k <= 0 || pwrite(w->ver.fd, tampon, k, ecrit) != k) break;
+        lu += k;
+        ecrit += k;
+    }
+    w->recopies = lu;
+    if (lu == fin && lu < w->identiques) return 0;
+    close(w->courant);
+    w->courant = -1;
+    if (lu == fin) return 0;
+    perror("cas");
+    w->echec = true;
+    return -1;
+}
+
+// Bloc reçu : passé à l'empreinte, puis comparé à la version publiée tant
+// qu'il la répète ; au premier écart, l'upload s'écrit normalement
+static ssize_t cas_ecrire(stockage_objet_t *o, const void *buf, size_t n, off_t position) {
+    cas_ecriture_t *w = o->priv;
+    if (position == w->hachees) {
+        sha256_ajouter(&w->empreinte, buf, n);
+        w->hachees += n;
+    } else
+        w->en_ordre = false;
+    if (w->courant >= 0 && !w->ecart) {
+        if (position == w->identiques && cas_repete(w, buf, n, position)) {
+            w->identiques += n;
+            return n;
+        }
+        w->ecart = true;
+    }
+    if (w->courant >= 0 && cas_recopier(w, CAS_RECOPIE) < 0) return -1;
+    return pwrite(w->ver.fd, buf, n, position);
+}
+
+// Contenu inchangé, ou déjà stocké sous un autre nom : la version publiée
+// est un lien vers lui, et ce qui a été écrit est jeté. Sinon la version
+// écrite est publiée, une fois complétée (cas_completer), puis ajoutée à
+// CAS_DOSSIER.
+static version_t *cas_preparer(stockage_objet_t *o) {
+    cas_ecriture_t *w = o->priv;
+    if (w->echec) return NULL;
+    w->ecart = true; // Plus rien à comparer
+    if (!w->en_ordre) return &w->ver;
+
+    unsigned char empreinte[SHA256_TAILLE];
+    char hex[SHA256_HEX];
+    sha256_finir(&w->empreinte, empreinte);
+    sha256_hex(empreinte, hex);
+    snprintf(w->corps, sizeof(w->corps), CAS_DOSSIER "%.2s/%s", hex, hex + 2);
+
+    // Tout le flux a répété toute la version publiée
+    bool identique = w->courant >= 0 && w->hachees == w->identiques && w->identiques == w->courant_taille;
+    char courant[64];
+    const char *source = NULL;
+    version_t lien;
+    // Sous cas_verrou : cas_oublier ne peut pas effacer le contenu trouvé
+    // avant qu'il soit lié
+    pthread_mutex_lock(&cas_verrou);
+    if (access(w->corps, F_OK) == 0)
+        source = w->corps;
+    else if (identique) {
+        snprintf(courant, sizeof(courant), "/proc/self/fd/%d", w->courant);
+        source = courant;
+    }
+    bool lie = source && version_lier(&lien, w->ver.chemin, source) >= 0;
+    pthread_mutex_unlock(&cas_verrou);
+    if (lie) {
+        printf("[CAS] '%s' : %s (%.12s)\n", w->ver.chemin, identique ? "inchangé" : "contenu déjà stocké", hex);
+        version_abort(&w->ver);
+        w->ver = lien;
+        w->nouveau = source != w->corps;
+        if (w->courant >= 0) close(w->courant);
+        w->courant = -1;
+        return &w->ver;
+    }
+    w->nouveau = true;
+    return &w->ver;
+}
+
+// Reste de la partie identique, hors du moteur avec -D group
+static int cas_completer(stockage_objet_t *o) {
+    cas_ecriture_t *w = o->priv;
+    return w->courant >= 0 ? cas_recopier(w, w->identiques) : 0;
+}
+
+// Le même contenu, nouveau pour deux uploads simultanés sous deux noms,
+// a été lié dans CAS_DOSSIER par l'autre : le nom est lié à ce contenu à
+// son tour, et le corps écrit par cet upload disparaît avec son dernier nom
+static bool cas_rejoindre(cas_ecriture_t *w) {
+    version_t lien;
+    pthread_mutex_lock(&cas_verrou);
+    bool lie = version_lier(&lien, w->ver.chemin, w->corps) >= 0 && version_publish(&lien) == 0;
+    pthread_mutex_unlock(&cas_verrou);
+    if (!lie) return false;
+    fdcache_invalidate(w->ver.chemin);
+    printf("[CAS] '%s' : contenu stocké entre-temps\n", w->ver.chemin);
+    return true;
+}
+
+static int cas_publiee(stockage_objet_t *o, int resultat) {
+    cas_ecriture_t *w = o->priv;
+    fdcache_invalidate(w->ver.chemin);
+    struct stat st;
+    if (resultat < 0 || stat(w->ver.chemin, &st) < 0) return resultat;
+    // rename() entre deux liens d'un même fichier (contenu inchangé) ne
+    // fait rien et laisse le nom temporaire
+    unlink(w->ver.temp);
+    if (w->nouveau && w->corps[0]) {
+        char sous[CAS_CHEMIN];
+        snprintf(sous, sizeof(sous), "%.*s", (int)sizeof(CAS_DOSSIER) + 1, w->corps);
+        mkdir(CAS_DOSSIER, 0777);
+        mkdir(sous, 0777);
+        if (link(w->ver.chemin, w->corps) == 0)
+            cas_noter(w->corps);
+        else if (errno != EEXIST)
+            perror(w->corps);
+        else if (cas_rejoindre(w))
+            stat(w->ver.chemin, &st);
+    }
+    if (w->ancien_inode && (w->ancien_inode != st.st_ino || w->ancien_dev != st.st_dev))
+        cas_oublier(w->ancien_dev, w->ancien_inode);
+    return resultat;
+}
+
+static void cas_abandonner(stockage_objet_t *o) {
+    cas_ecriture_t *w = o->priv;
+    version_abort(&w->ver); // Sans effet si la version a été publiée
+    if (w->courant >= 0) close(w->courant);
+    free(w);
+}
+
+const stockage_t stockage_cas = {
+    "cas", cas_demarrer, dossier_ouvrir, dossier_fermer, NULL, cas_creer, cas_ecrire, valider_version, cas_abandonner,
+    cas_preparer, cas_completer, cas_publiee, place_disque
+};
+
+// --- Interface commune ---
+
+const stockage_t *stockage_chercher(const char *nom) {
+    if (strcmp(nom, stockage_dossier.nom) == 0) return &stockage_dossier;
+    if (strcmp(nom, stockage_memoire.nom) == 0) return &stockage_memoire;
+    if (strcmp(nom, stockage_cas.nom) == 0) return &stockage_cas;
+    return NULL;
+}
+
+// Au démarrage du serveur, avant la première requête
+int stockage_demarrer(const stockage_t *m) {
+    return m->demarrer ? m->demarrer() : 0;
+}
+
+bool stockage_place(const stockage_t *m, const char *racine, unsigned long long taille) {
+    return !m->place || m->place(racine, taille);
+}
+
+int stockage_ouvrir(const stockage_t *m, stockage_objet_t *o, const char *chemin) {
+    memset(o, 0, sizeof(*o));
+    o->fd = -1;
+    if (m->ouvrir(o, chemin) < 0) return -1;
+    o->magasin = m;
+    return 0;
+}
+
+ssize_t stockage_lire(const stockage_objet_t *o, void *buf, size_t n, off_t position) {
+    if (position >= o->taille) return 0;
+    if ((off_t)n > o->taille - position) n = o->taille - position;
+    if (o->magasin && o->magasin->lire) return o->magasin->lire(o, buf, n, position);
+    if (!o->image) return pread(o->fd, buf, n, position);
+    memcpy(buf, o->image + position, n);
+    return n;
+}
+
+void stockage_fermer(stockage_objet_t *o) {
+    if (o->magasin) o->magasin->fermer(o);
+    o->magasin = NULL;
+}
+
+int stockage_creer(const stockage_t *m, stockage_objet_t *o, const char *chemin, off_t prevue) {
+    memset(o, 0, sizeof(*o));
+    o->fd = -1;
+    if (m->creer(o, chemin, prevue) < 0) return -1;
+    o->magasin = m;
+    return 0;
+}
+
+ssize_t stockage_ecrire(stockage_objet_t *o, const void *buf, size_t n, off_t position) {
+    if (o->magasin && o->magasin->ecrire) return o->magasin->ecrire(o, buf, n, position);
+    return pwrite(o->fd, buf, n, position);
+}
+
+// Après validation, réussie ou non, l'objet n'écrit plus : le dernier
+// stockage_abandonner libère ce qui reste
+int stockage_valider(stockage_objet_t *o) {
+    int res = o->magasin->valider(o);
+    o->fd = -1;
+    return res;
+}
+
+version_t *stockage_preparer(stockage_objet_t *o) {
+    if (!o->magasin || !o->magasin->preparer) return NULL;
+    o->fd = -1;
+    return o->magasin->preparer(o);
+}
+
+int stockage_completer(stockage_objet_t *o) {
+    return o->magasin->completer ? o->magasin->completer(o) : 0;
+}
+
+int stockage_publiee(stockage_objet_t *o, int resultat) {
+    return o->magasin->publiee(o, resultat);
+}
+
+void stockage_abandonner(stockage_objet_t *o) {
+    if (o->magasin) o->magasin->abandonner(o);
+    o->magasin = NULL;
+    o->fd = -1;
+}
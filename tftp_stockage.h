@@ -0,0 +1,114 @@
+#ifndef TFTP_STOCKAGE_H
+#define TFTP_STOCKAGE_H
+
+#include <sys/types.h>
+#include <time.h>
+
+#include "tftp_fdcache.h"
+#include "tftp_version.h"
+
+#define CAS_DOSSIER ".tftp_objets/"     // Contenus du magasin cas, hors de .tftp/ (même système de fichiers)
+
+// Magasins des fichiers servis (option -M des serveurs) : les RRQ ouvrent
+// et lisent, les WRQ créent, écrivent puis valident ou abandonnent leurs
+// fichiers par l'un d'eux.
+//
+//   dir : le répertoire servi (historique). Lecture par le cache de
+//         descripteurs (tftp_fdcache.c), écriture d'une nouvelle version
+//         publiée par rename() selon la durabilité -D (tftp_version.c) ;
+//   mem : une table en mémoire, vide au démarrage et remplie par les WRQ.
+//         Chaque upload s'écrit dans un memfd, projeté à sa validation : les
+//         RRQ copient leurs blocs depuis la projection. Rien ne touche le
+//         disque, pour mesurer les moteurs sans le système de fichiers ;
+//   cas : le répertoire servi, dédupliqué. Chaque contenu est stocké une
+//         fois dans CAS_DOSSIER sous son empreinte SHA-256, calculée pendant
+//         l'upload, et les noms de .tftp/ en sont des liens durs. Un upload
+//         identique à la version publiée du nom n'est pas écrit du tout ;
+//         un contenu déjà stocké sous un autre nom est lié au lieu d'être
+//         gardé, et ses pages écrites sont jetées avant d'atteindre le disque.
+//
+// Un objet ouvert expose son contenu par un descripteur (pread, pwrite) ou
+// par une image en mémoire (lecture seule). La machine à états le lit par
+// stockage_lire et l'écrit par stockage_ecrire : un magasin sans opération
+// propre (NULL) y est lu et écrit directement, sans appel indirect. Un
+// fichier de l'archive (-A) ou une variante lz4 est un objet hors magasin :
+// son image ou son descripteur, rien à fermer.
+
+typedef struct stockage stockage_t;
+
+typedef struct {
+    const stockage_t *magasin;  // NULL : objet fermé, ou hors magasin
+    off_t taille;               // Lecture : taille du contenu
+    int fd;                     // Contenu lu ou écrit sur fd, -1 : aucun
+    const char *image;          // Lecture : contenu en mémoire au lieu de fd
+    dev_t dev;                  // Lecture : version du contenu (nom des variantes lz4)
+    ino_t inode;
+    time_t mtime;
+    void *priv;                 // Propre au magasin
+} stockage_objet_t;
+
+struct stockage {
+    const char *nom;
+    int     (*demarrer)(void);                                  // NULL : rien à préparer
+    int     (*ouvrir)(stockage_objet_t *o, const char *chemin); // -1 et errno (ENOENT...)
+    void    (*fermer)(stockage_objet_t *o);
+    ssize_t (*lire)(const stockage_objet_t *o, void *buf, size_t n, off_t position); // NULL : pread sur fd, ou copie de l'image
+    int     (*creer)(stockage_objet_t *o, const char *chemin, off_t prevue);
+    ssize_t (*ecrire)(stockage_objet_t *o, const void *buf, size_t n, off_t position); // NULL : pwrite sur fd
+    int     (*valider)(stockage_objet_t *o);                    // -1 : rien n'est publié
+    void    (*abandonner)(stockage_objet_t *o);
+    // Validation en deux temps des magasins sur le répertoire (NULL pour
+    // mem) : version à publier, fin de son écriture (NULL : rien, -1 :
+    // abandonnée), puis suite de sa publication
+    version_t *(*preparer)(stockage_objet_t *o);
+    int     (*completer)(stockage_objet_t *o);
+    int     (*publiee)(stockage_objet_t *o, int resultat);
+    // Place pour un upload de 'taille' octets sous 'racine' (dir et cas :
+    // le disque, mem : la mémoire disponible)
+    bool    (*place)(const char *racine, unsigned long long taille);
+};
+
+extern const stockage_t stockage_dossier;
+extern const stockage_t stockage_memoire;
+extern const stockage_t stockage_cas;
+
+const stockage_t *stockage_chercher(const char *nom);
+int stockage_demarrer(const stockage_t *m);
+
+// Refus anticipé d'un WRQ dont la taille annoncée (tsize) ne tient pas
+// dans le magasin ; le quota -q est vérifié à part par le moteur
+bool stockage_place(const stockage_t *m, const char *racine, unsigned long long taille);
+
+// Lecture d'une version publiée, gardée jusqu'à stockage_fermer même si un
+// WRQ la remplace
+int     stockage_ouvrir(const stockage_t *m, stockage_objet_t *o, const char *chemin);
+ssize_t stockage_lire(const stockage_objet_t *o, void *buf, size_t n, off_t position);
+void    stockage_fermer(stockage_objet_t *o);
+
+// Écriture d'une nouvelle version ('prevue' : taille annoncée, 0 si
+// inconnue), invisible des lecteurs jusqu'à stockage_valider.
+// stockage_abandonner est sans effet une fois la version validée.
+int     stockage_creer(const stockage_t *m, stockage_objet_t *o, const char *chemin, off_t prevue);
+ssize_t stockage_ecrire(stockage_objet_t *o, const void *buf, size_t n, off_t position);
+int     stockage_valider(stockage_objet_t *o);
+void    stockage_abandonner(stockage_objet_t *o);
+
+// Validation d'un moteur qui confie lui-même la version à la validation
+// par lots (-D group, tftp_durabilite.h) : stockage_preparer, puis
+// stockage_publiee avec le résultat de la publication, au lieu de
+// stockage_valider. NULL : le magasin n'a pas de version à confier.
+// stockage_completer, qui peut recopier une partie du contenu, est passé
+// au thread de validation (durabilite_demande_t.avant) : pas au moteur.
+version_t *stockage_preparer(stockage_objet_t *o);
+int        stockage_completer(stockage_objet_t *o);
+int        stockage_publiee(stockage_objet_t *o, int resultat);
+
+// Magasin dir : entrée du cache d'un objet ouvert, version d'un objet
+// écrit, et reprise des objets passés par un redémarrage à chaud (-H).
+// NULL pour un autre magasin.
+fdcache_entry_t *stockage_dossier_entree(const stockage_objet_t *o);
+version_t *stockage_dossier_version(const stockage_objet_t *o);
+int stockage_dossier_adopter(stockage_objet_t *o, const char *chemin, int fd);
+int stockage_dossier_reprendre(stockage_objet_t *o, const version_t *v, int fd);
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef TFTP_TRACE_H
+#define TFTP_TRACE_H
+
+// Points de trace statiques (USDT, fournisseur "tftp") sur le cycle de vie
+// des sessions et des paquets. Avec <sys/sdt.h> (paquet systemtap-sdt-dev),
+// chaque sonde est une instruction nop notée dans la section .note.stapsdt
+// du binaire, activable à chaud :
+//   bpftrace -e 'usdt:./server_select:tftp:data__send { @[arg0] = count(); }'
+// Sans cet en-tête, les sondes disparaissent à la compilation.
+//
+// Toutes les sondes ont l'identifiant de session en premier argument :
+//   session__start  (id, opcode, nom, taille)  taille du fichier ou tsize annoncé
+//   session__end    (id, ok, octets)
+//   data__send      (id, bloc, octets, renvoi) DATA émis (RRQ) ; renvoi : 0 au premier envoi,
+//                                              sinon le numéro de la retransmission
+//   data__recv      (id, bloc, octets)         DATA accepté (WRQ)
+//   ack__recv       (id, bloc)
+//   retransmit      (id, bloc, tentative)      dernier paquet renvoyé après timeout
+//   tid__reject     (id, port)                 paquet d'un TID inconnu
+//   lock__wait__start (id, nom)
+//   lock__wait__done  (id, nom, obtenu)
+//   disk__read      (id, offset, octets)
+//   disk__write     (id, offset, octets)
+
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define TFTP_TRACE_USDT 1
+#endif
+#endif
+
+#ifdef TFTP_TRACE_USDT
+#define TRACE2(nom, a, b)          DTRACE_PROBE2(tftp, nom, a, b)
+#define TRACE3(nom, a, b, c)       DTRACE_PROBE3(tftp, nom, a, b, c)
+#define TRACE4(nom, a, b, c, d)    DTRACE_PROBE4(tftp, nom, a, b, c, d)
+#else
+#define TRACE2(nom, a, b)          do { (void)(a); (void)(b); } while (0)
+#define TRACE3(nom, a, b, c)       do { (void)(a); (void)(b); (void)(c); } while (0)
+#define TRACE4(nom, a, b, c, d)    do { (void)(a); (void)(b); (void)(c); (void)(d); } while (0)
+#endif
+
+#define TRACE_SESSION_START(id, op, nom, taille) TRACE4(session__start, id, op, nom, taille)
+#define TRACE_SESSION_END(id, ok, octets)        TRACE3(session__end, id, ok, octets)
+#define TRACE_DATA_SEND(id, bloc, octets, renvoi) TRACE4(data__send, id, bloc, octets, renvoi)
+#define TRACE_DATA_RECV(id, bloc, octets)        TRACE3(data__recv, id, bloc, octets)
+#define TRACE_ACK_RECV(id, bloc)                 TRACE2(ack__recv, id, bloc)
+#define TRACE_RETRANSMIT(id, bloc, tentative)    TRACE3(retransmit, id, bloc, tentative)
+#define TRACE_TID_REJECT(id, port)               TRACE2(tid__reject, id, port)
+#define TRACE_LOCK_WAIT_START(id, nom)           TRACE2(lock__wait__start, id, nom)
+#define TRACE_LOCK_WAIT_DONE(id, nom, obtenu)    TRACE3(lock__wait__done, id, nom, obtenu)
+#define TRACE_DISK_READ(id, offset, octets)      TRACE3(disk__read, id, offset, octets)
+#define TRACE_DISK_WRITE(id, offset, octets)     TRACE3(disk__write, id, offset, octets)
+
+#endif
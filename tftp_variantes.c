@@ -0,0 +1,406 @@
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "tftp_archive.h"
+#include "tftp_lz4.h"
+#include "tftp_variantes.h"
+#include "tftp_version.h"
+
+#define SUIVIS_SEAUX 256
+
+// Variantes connues sans être dans le cache : en construction, ou refusées
+typedef enum {
+    VARIANTE_EN_COURS = 1,
+    VARIANTE_REFUSEE
+} variante_etat_t;
+
+typedef struct suivi {
+    char base[128];             // Nom de la variante, sans extension
+    variante_etat_t etat;
+    struct suivi *suivant;
+} suivi_t;
+
+// Construction confiée au thread : la source est lue par son propre
+// descripteur (dup), ou dans la projection de l'archive, gardée jusqu'à
+// la fin du processus
+typedef struct travail {
+    char base[128];
+    char source[512];
+    uint32_t h;
+    int fd;
+    const char *image;
+    off_t taille;
+    struct travail *suivant;
+} travail_t;
+
+static bool actives = false;
+static char racine_servie[256];
+
+static pthread_mutex_t verrou = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t a_construire = PTHREAD_COND_INITIALIZER;
+static travail_t *file_tete = NULL, *file_queue = NULL;
+static int file_len = 0;
+static suivi_t *suivis[SUIVIS_SEAUX];
+static int refusees = 0;
+
+static uint32_t hacher(const char *nom) {
+    uint32_t h = 2166136261u; // FNV-1a
+    while (*nom) {
+        h ^= (unsigned char)*nom++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static int ecrire_tout(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+// --- Variantes suivies en mémoire (sous verrou) ---
+
+static suivi_t **trouver(const char *base) {
+    suivi_t **p = &suivis[hacher(base) % SUIVIS_SEAUX];
+    while (*p && strcmp((*p)->base, base) != 0) p = &(*p)->suivant;
+    return p;
+}
+
+static void oublier(const char *base) {
+    suivi_t **p = trouver(base);
+    suivi_t *s = *p;
+    if (!s) return;
+    if (s->etat == VARIANTE_REFUSEE) refusees--;
+    *p = s->suivant;
+    free(s);
+}
+
+// Une refusée de plus que VARIANTES_SUIVIES n'est pas gardée : sa marque
+// sur le disque suffit
+static void suivre(const char *base, variante_etat_t etat) {
+    suivi_t **p = trouver(base);
+    if (etat == VARIANTE_REFUSEE && refusees >= VARIANTES_SUIVIES) {
+        oublier(base);
+        return;
+    }
+    if (!*p) {
+        suivi_t *s = calloc(1, sizeof(*s));
+        if (!s) return;
+        snprintf(s->base, sizeof(s->base), "%s", base);
+        *p = s;
+    } else if ((*p)->etat == VARIANTE_REFUSEE)
+        refusees--;
+    (*p)->etat = etat;
+    if (etat == VARIANTE_REFUSEE) refusees++;
+}
+
+// --- Construction ---
+
+// Compresse la source trame par trame dans une nouvelle version de
+// 'chemin'. 0 : publiée ; 1 : ne gagne pas assez, abandonnée ; -1 : erreur.
+static int construire(const stockage_objet_t *src, const char *chemin, off_t *taille) {
+    char *brut = malloc(LZ4_BLOC), *trame = malloc(LZ4_TRAME_MAX);
+    version_t v;
+    int ret = -1;
+    if (!brut || !trame || version_begin(&v, chemin) < 0) goto fin;
+
+    off_t position = 0;
+    *taille = 0;
+    while (position < src->taille) {
+        size_t n = src->taille - position < LZ4_BLOC ? src->taille - position : LZ4_BLOC;
+        const char *bloc = src->image ? src->image + position : brut;
+        if (!src->image && stockage_lire(src, brut, n, position) != (ssize_t)n) break;
+        size_t len = lz4_trame(bloc, n, trame);
+        if (ecrire_tout(v.fd, trame, len) < 0) break;
+        position += n;
+        *taille += len;
+    }
+    if (position < src->taille) version_abort(&v);
+    else if (*taille > src->taille - src->taille / VARIANTES_GAIN_MIN) {
+        version_abort(&v);
+        ret = 1;
+    } else
+        ret = version_publish(&v);
+fin:
+    free(brut);
+    free(trame);
+    return ret;
+}
+
+// Efface les variantes et marques du même nom autres que 'garder'
+static void purger(uint32_t h, const char *garder) {
+    DIR *d = opendir(VARIANTES_DOSSIER);
+    if (!d) return;
+    char prefixe[16];
+    snprintf(prefixe, sizeof(prefixe), "%08x-", h);
+    struct dirent *de;
+    while ((de = readdir(d))) {
+        if (strncmp(de->d_name, prefixe, strlen(prefixe)) != 0 || strcmp(de->d_name, garder) == 0) continue;
+        if (strstr(de->d_name, ".~")) continue; // Construction d'un autre processus (-H)
+        unlinkat(dirfd(d), de->d_name, 0);
+    }
+    closedir(d);
+}
+
+static void traiter(travail_t *t) {
+    char nom[160], chemin[512];
+    snprintf(nom, sizeof(nom), "%s.lz4", t->base);
+    snprintf(chemin, sizeof(chemin), VARIANTES_DOSSIER "%s", nom);
+    stockage_objet_t src = { .fd = t->fd, .image = t->image, .taille = t->taille };
+    off_t taille = 0;
+    // Déjà construite entre la demande et son tour
+    int res = access(chemin, F_OK) == 0 ? 0 : construire(&src, chemin, &taille);
+    if (res == 0 && taille > 0) {
+        purger(t->h, nom);
+        printf("[VARIANTE] '%s' : %llu -> %llu octets (lz4)\n", t->source, (unsigned long long)t->taille,
+               (unsigned long long)taille);
+    } else if (res > 0) {
+        snprintf(nom, sizeof(nom), "%s.non", t->base);
+        snprintf(chemin, sizeof(chemin), VARIANTES_DOSSIER "%s", nom);
+        int fd = open(chemin, O_WRONLY | O_CREAT | O_CLOEXEC, 0666);
+        if (fd >= 0) close(fd);
+        purger(t->h, nom);
+        printf("[VARIANTE] '%s' : gain lz4 insuffisant, servi tel quel\n", t->source);
+    }
+    pthread_mutex_lock(&verrou);
+    // Erreur : rien n'est retenu, un prochain RRQ réessaiera
+    if (res > 0) suivre(t->base, VARIANTE_REFUSEE);
+    else oublier(t->base);
+    pthread_mutex_unlock(&verrou);
+    if (t->fd >= 0) close(t->fd);
+    free(t);
+}
+
+// Confie la construction au thread, si elle n'est ni en cours ni refusée
+static void lancer(const char *base, uint32_t h, const char *source, const stockage_objet_t *src) {
+    travail_t *t = calloc(1, sizeof(*t));
+    if (!t) return;
+    snprintf(t->base, sizeof(t->base), "%s", base);
+    snprintf(t->source, sizeof(t->source), "%s", source);
+    t->h = h;
+    t->image = src->image;
+    t->taille = src->taille;
+    t->fd = src->image ? -1 : fcntl(src->fd, F_DUPFD_CLOEXEC, 0);
+    if (!t->image && t->fd < 0) {
+        free(t);
+        return;
+    }
+    pthread_mutex_lock(&verrou);
+    if (*trouver(base) || file_len >= VARIANTES_FILE_MAX) {
+        pthread_mutex_unlock(&verrou);
+        if (t->fd >= 0) close(t->fd);
+        free(t);
+        return;
+    }
+    suivre(base, VARIANTE_EN_COURS);
+    if (file_queue) file_queue->suivant = t;
+    else file_tete = t;
+    file_queue = t;
+    file_len++;
+    pthread_cond_signal(&a_construire);
+    pthread_mutex_unlock(&verrou);
+}
+
+// --- Ramasse-miettes ---
+
+typedef struct {
+    dev_t dev;
+    ino_t inode;
+    time_t mtime;
+    off_t taille;
+} source_t;
+
+typedef struct {
+    source_t *v;
+    size_t nb, cap;
+} sources_t;
+
+static int comparer_sources(const void *a, const void *b) {
+    const source_t *x = a, *y = b;
+    if (x->dev != y->dev) return x->dev < y->dev ? -1 : 1;
+    if (x->inode != y->inode) return x->inode < y->inode ? -1 : 1;
+    if (x->mtime != y->mtime) return x->mtime < y->mtime ? -1 : 1;
+    if (x->taille != y->taille) return x->taille < y->taille ? -1 : 1;
+    return 0;
+}
+
+// Versions des fichiers servis sous 'relatif' ; les liens sont suivis
+// comme le serveur le fait
+static void recenser(sources_t *s, const char *relatif) {
+    char dossier[4096];
+    snprintf(dossier, sizeof(dossier), "%s%s", racine_servie, relatif);
+    DIR *d = opendir(dossier);
+    if (!d) return;
+    struct dirent *de;
+    while ((de = readdir(d))) {
+        if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0) continue;
+        if (!*relatif && strcmp(de->d_name, VERSION_ENCOURS) == 0) continue;
+        char nom[4096];
+        struct stat st;
+        snprintf(nom, sizeof(nom), "%s%s%s", relatif, *relatif ? "/" : "", de->d_name);
+        if (fstatat(dirfd(d), de->d_name, &st, 0) < 0) continue;
+        if (S_ISDIR(st.st_mode)) {
+            recenser(s, nom);
+            continue;
+        }
+        if (!S_ISREG(st.st_mode)) continue;
+        if (s->nb == s->cap) {
+            size_t cap = s->cap ? s->cap * 2 : 256;
+            source_t *v = realloc(s->v, cap * sizeof(*v));
+            if (!v) break;
+            s->v = v;
+            s->cap = cap;
+        }
+        s->v[s->nb++] = (source_t){ st.st_dev, st.st_ino, st.st_mtime, st.st_size };
+    }
+    closedir(d);
+}
+
+// Efface les variantes et marques dont la source n'est plus servie, et
+// les constructions interrompues d'un processus mort
+static void ramasser(void) {
+    sources_t s = { NULL, 0, 0 };
+    recenser(&s, "");
+    if (s.nb) qsort(s.v, s.nb, sizeof(*s.v), comparer_sources);
+    source_t archive = { 0, 0, 0, 0 };
+    bool avec_archive = archive_version(&archive.dev, &archive.inode, &archive.mtime);
+
+    DIR *d = opendir(VARIANTES_DOSSIER);
+    if (!d) {
+        free(s.v);
+        return;
+    }
+    int effacees = 0;
+    struct dirent *de;
+    while ((de = readdir(d))) {
+        unsigned int h;
+        unsigned long dev, inode;
+        unsigned long long mtime, taille;
+        char ext[4], reste;
+        int pid;
+        const char *temp = strstr(de->d_name, ".~");
+        if (temp) {
+            if (sscanf(temp, ".~%d.", &pid) == 1 && pid > 0 && kill(pid, 0) < 0 && errno == ESRCH &&
+                unlinkat(dirfd(d), de->d_name, 0) == 0)
+                effacees++;
+            continue;
+        }
+        if (sscanf(de->d_name, "%8x-%lx-%lx-%llx-%llx.%3s%c", &h, &dev, &inode, &mtime, &taille, ext, &reste) != 6 ||
+            (strcmp(ext, "lz4") != 0 && strcmp(ext, "non") != 0))
+            continue;
+        source_t v = { (dev_t)dev, (ino_t)inode, (time_t)mtime, (off_t)taille };
+        if (avec_archive && v.dev == archive.dev && v.inode == archive.inode && v.mtime == archive.mtime) continue;
+        if (s.nb && bsearch(&v, s.v, s.nb, sizeof(*s.v), comparer_sources)) continue;
+        if (unlinkat(dirfd(d), de->d_name, 0) < 0) continue;
+        effacees++;
+        char base[128];
+        snprintf(base, sizeof(base), "%.*s", (int)(strlen(de->d_name) - 4), de->d_name);
+        pthread_mutex_lock(&verrou);
+        oublier(base);
+        pthread_mutex_unlock(&verrou);
+    }
+    closedir(d);
+    free(s.v);
+    if (effacees) printf("[VARIANTE] %d variante(s) sans source effacée(s)\n", effacees);
+}
+
+// Thread de construction : une variante à la fois, dans l'ordre des
+// demandes ; le ramasse-miettes entre deux
+static void *constructeur(void *arg) {
+    (void)arg;
+    ramasser();
+    time_t prochain = time(NULL) + VARIANTES_GC_SEC;
+    for (;;) {
+        pthread_mutex_lock(&verrou);
+        struct timespec echeance = { prochain, 0 };
+        while (!file_tete && time(NULL) < prochain)
+            pthread_cond_timedwait(&a_construire, &verrou, &echeance);
+        travail_t *t = file_tete;
+        if (t) {
+            file_tete = t->suivant;
+            if (!file_tete) file_queue = NULL;
+            file_len--;
+        }
+        pthread_mutex_unlock(&verrou);
+        if (t) traiter(t);
+        if (time(NULL) >= prochain) {
+            ramasser();
+            prochain = time(NULL) + VARIANTES_GC_SEC;
+        }
+    }
+    return NULL;
+}
+
+int variantes_demarrer(const char *racine) {
+    snprintf(racine_servie, sizeof(racine_servie), "%s", racine);
+    if (mkdir(VARIANTES_DOSSIER, 0777) < 0 && errno != EEXIST) {
+        perror(VARIANTES_DOSSIER);
+        return -1;
+    }
+    pthread_t t;
+    int err = pthread_create(&t, NULL, constructeur, NULL);
+    if (err != 0) {
+        fprintf(stderr, "variantes : %s\n", strerror(err));
+        return -1;
+    }
+    pthread_detach(t);
+    actives = true;
+    return 0;
+}
+
+// RRQ avec l'option compress : renvoie la variante lz4 de la source, à
+// relâcher par fdcache_release. NULL si elle ne s'applique pas (cache non
+// démarré, netascii, plage), ne gagne rien, ou n'est pas encore construite
+// (la construction est alors lancée) : l'option est retirée de 'opts' et
+// le fichier part tel quel.
+fdcache_entry_t *variante_lz4(tftp_options_t *opts, bool netascii, const char *source, const stockage_objet_t *src) {
+    if (!(opts->presentes & TFTP_OPT_COMPRESS)) return NULL;
+    opts->presentes &= ~TFTP_OPT_COMPRESS;
+    if (!actives || netascii || (opts->presentes & (TFTP_OPT_OFFSET | TFTP_OPT_LENGTH)) || src->taille == 0) return NULL;
+
+    uint32_t h = hacher(source);
+    char base[128], chemin[512];
+    snprintf(base, sizeof(base), "%08x-%lx-%lx-%llx-%llx", h, (unsigned long)src->dev,
+             (unsigned long)src->inode, (unsigned long long)src->mtime, (unsigned long long)src->taille);
+
+    pthread_mutex_lock(&verrou);
+    bool suivie = *trouver(base) != NULL;
+    pthread_mutex_unlock(&verrou);
+    if (suivie) return NULL; // En construction, ou refusée
+
+    snprintf(chemin, sizeof(chemin), VARIANTES_DOSSIER "%s.lz4", base);
+    fdcache_entry_t *v = fdcache_acquire(chemin);
+    if (v) {
+        // Cache d'une version antérieure du serveur, qui gardait les refus
+        if (v->size > src->taille - src->taille / VARIANTES_GAIN_MIN) {
+            fdcache_release(v);
+            return NULL;
+        }
+        opts->presentes |= TFTP_OPT_COMPRESS;
+        return v;
+    }
+    snprintf(chemin, sizeof(chemin), VARIANTES_DOSSIER "%s.non", base);
+    if (access(chemin, F_OK) == 0) {
+        pthread_mutex_lock(&verrou);
+        suivre(base, VARIANTE_REFUSEE);
+        pthread_mutex_unlock(&verrou);
+        return NULL;
+    }
+    lancer(base, h, source, src);
+    return NULL;
+}
@@ -0,0 +1,45 @@
+#ifndef TFTP_VARIANTES_H
+#define TFTP_VARIANTES_H
+
+#include <stdbool.h>
+
+#include "tftp_fdcache.h"
+#include "tftp_options.h"
+#include "tftp_stockage.h"
+
+// Cache des variantes compressées (option "compress", tftp_lz4.h) : chaque
+// fichier servi compressé l'est une seule fois, dans VARIANTES_DOSSIER. Le
+// premier RRQ qui la demande confie la construction à un thread dédié et
+// reçoit le fichier tel quel, comme ceux qui arrivent pendant qu'elle
+// dure : le moteur ne compresse jamais lui-même, et une variante n'est
+// construite qu'une fois même demandée par plusieurs sessions à la fois.
+// Les suivants lisent la variante comme un fichier ordinaire, par le
+// cache de descripteurs.
+//
+// Une variante est nommée d'après sa source (nom et version : inode,
+// mtime, taille) : une source modifiée en produit une nouvelle, et les
+// variantes périmées du même nom sont effacées à ce moment. Une variante
+// qui ne gagne pas VARIANTES_GAIN_MIN n'est pas gardée : une marque vide
+// (".non" au lieu de ".lz4") s'en souvient, et les RRQ suivants ne la
+// recompressent ni ne la rouvrent. Au démarrage, puis toutes les
+// VARIANTES_GC_SEC, les variantes et marques dont la source n'existe plus
+// sont effacées.
+//
+// Le cache n'existe qu'une fois variantes_demarrer() appelé : le magasin
+// mem ne touche pas le disque, et ses RRQ compress reçoivent le fichier
+// tel quel.
+
+#define VARIANTES_DOSSIER ".tftp_cache/"    // Hors de .tftp/ : jamais servi ni indexé
+#define VARIANTES_GAIN_MIN 16               // Variante gardée si elle fait gagner au moins 1/16
+#define VARIANTES_FILE_MAX 64               // Constructions en attente au plus
+#define VARIANTES_SUIVIES 4096              // Refus gardés en mémoire au plus (la marque reste)
+#define VARIANTES_GC_SEC 3600
+
+// 'racine' : le répertoire servi, parcouru pour trouver les sources
+int variantes_demarrer(const char *racine);
+
+// 'source' nomme la source (chemin, ou nom dans l'archive) ; sa version
+// est celle de 'src' : le fichier, ou l'archive qui le contient
+fdcache_entry_t *variante_lz4(tftp_options_t *opts, bool netascii, const char *source, const stockage_objet_t *src);
+
+#endif
@@ -0,0 +1,145 @@
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "tftp_version.h"
+
+static unsigned int compteur = 0;
+static char racine_servie[256];   // Vide tant que version_demarrer() n'a pas été appelé
+static char encours[300];         // racine_servie VERSION_ENCOURS "/"
+
+static void nommer(version_t *v, const char *chemin) {
+    unsigned int n = __atomic_add_fetch(&compteur, 1, __ATOMIC_RELAXED);
+    snprintf(v->chemin, sizeof(v->chemin), "%s", chemin);
+    if (racine_servie[0] && strncmp(chemin, racine_servie, strlen(racine_servie)) == 0)
+        snprintf(v->temp, sizeof(v->temp), "%s%d.%u", encours, (int)getpid(), n);
+    else
+        snprintf(v->temp, sizeof(v->temp), "%s.~%d.%u", chemin, (int)getpid(), n);
+}
+
+// Crée le répertoire des versions en cours sous 'racine' (terminée par
+// '/') et efface celles laissées par un processus mort : "<pid>.<n>"
+// dont le pid n'existe plus. Celles d'un processus vivant (redémarrage à
+// chaud, -H) restent à lui.
+int version_demarrer(const char *racine) {
+    snprintf(racine_servie, sizeof(racine_servie), "%s", racine);
+    snprintf(encours, sizeof(encours), "%s" VERSION_ENCOURS "/", racine);
+    if (mkdir(encours, 0777) < 0 && errno != EEXIST) {
+        perror(encours);
+        racine_servie[0] = '\0';
+        return -1;
+    }
+    DIR *d = opendir(encours);
+    if (!d) return 0;
+    int effacees = 0;
+    struct dirent *de;
+    while ((de = readdir(d))) {
+        int pid;
+        unsigned int n;
+        char reste;
+        if (sscanf(de->d_name, "%d.%u%c", &pid, &n, &reste) != 2 || pid <= 0) continue;
+        if (kill(pid, 0) == 0 || errno != ESRCH) continue;
+        if (unlinkat(dirfd(d), de->d_name, 0) == 0) effacees++;
+    }
+    closedir(d);
+    if (effacees) printf("[VERSION] %d version(s) interrompue(s) effacée(s)\n", effacees);
+    return 0;
+}
+
+// Vrai si 'nom', relatif à la racine servie, désigne le répertoire des
+// versions en cours ou son contenu : refusé aux RRQ/WRQ
+bool version_interne(const char *nom) {
+    for (;;) {
+        if (*nom == '/') nom++;
+        else if (nom[0] == '.' && (nom[1] == '/' || nom[1] == '\0')) nom++;
+        else break;
+    }
+    size_t l = strlen(VERSION_ENCOURS);
+    return strncmp(nom, VERSION_ENCOURS, l) == 0 && (nom[l] == '\0' || nom[l] == '/');
+}
+
+// Crée la nouvelle version sur le même système de fichiers que 'chemin'
+// (rename() atomique) ; renvoie son fd. Sans nom si le système de fichiers
+// le permet : rien à effacer si le processus meurt en cours de route.
+int version_begin(version_t *v, const char *chemin) {
+    nommer(v, chemin);
+    char dossier[sizeof(v->temp)];
+    snprintf(dossier, sizeof(dossier), "%s", v->temp);
+    char *fin = strrchr(dossier, '/');
+    if (fin) *fin = '\0';
+    else snprintf(dossier, sizeof(dossier), ".");
+    v->fd = open(dossier, O_TMPFILE | O_RDWR | O_CLOEXEC, 0666);
+    if (v->fd < 0 && errno == ENOENT && racine_servie[0] && mkdir(dossier, 0777) == 0)
+        v->fd = open(dossier, O_TMPFILE | O_RDWR | O_CLOEXEC, 0666); // Dépôt recréé depuis le démarrage
+    v->anonyme = v->fd >= 0;
+    if (v->fd < 0)
+        v->fd = open(v->temp, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+    return v->fd;
+}
+
+// Nouvelle version reprenant le contenu du fichier 'source' (lien dur) :
+// rien n'est écrit. Son fd, en lecture seule, sert aux fdatasync de la
+// durabilité.
+int version_lier(version_t *v, const char *chemin, const char *source) {
+    nommer(v, chemin);
+    v->fd = -1;
+    v->anonyme = false;
+    if (linkat(AT_FDCWD, source, AT_FDCWD, v->temp, AT_SYMLINK_FOLLOW) < 0) return -1;
+    v->fd = open(v->temp, O_RDONLY | O_CLOEXEC);
+    if (v->fd < 0) unlink(v->temp);
+    return v->fd;
+}
+
+// Version reçue d'un autre processus (-H) sur 'fd' : elle prend un nom à
+// notre pid, pour que version_demarrer() ne l'efface pas à la mort de
+// l'ancien processus
+void version_reprendre(version_t *v, int fd) {
+    char ancien[sizeof(v->temp)], chemin[sizeof(v->chemin)];
+    snprintf(ancien, sizeof(ancien), "%s", v->temp);
+    // nommer() réécrit v->chemin : il lit une copie
+    snprintf(chemin, sizeof(chemin), "%s", v->chemin);
+    bool anonyme = v->anonyme;
+    nommer(v, chemin);
+    v->fd = fd;
+    v->anonyme = anonyme;
+    if (!anonyme && rename(ancien, v->temp) < 0)
+        snprintf(v->temp, sizeof(v->temp), "%s", ancien);
+}
+
+// Donne son nom temporaire à une version anonyme
+static int nommer_anonyme(version_t *v) {
+    char lien[32];
+    snprintf(lien, sizeof(lien), "/proc/self/fd/%d", v->fd);
+    if (linkat(AT_FDCWD, lien, AT_FDCWD, v->temp, AT_SYMLINK_FOLLOW) == 0) return 0;
+    // Sans /proc : AT_EMPTY_PATH (CAP_DAC_READ_SEARCH)
+    return linkat(v->fd, "", AT_FDCWD, v->temp, AT_EMPTY_PATH);
+}
+
+// Remplace atomiquement la version publiée : les nouveaux lecteurs voient
+// le nouveau fichier, ceux en cours finissent sur l'ancien
+int version_publish(version_t *v) {
+    if (v->fd < 0) return -1;
+    int res = v->anonyme ? nommer_anonyme(v) : 0;
+    bool nommee = res == 0;
+    v->anonyme = false;
+    if (close(v->fd) < 0) res = -1;
+    v->fd = -1;
+    if (res == 0 && rename(v->temp, v->chemin) == 0) return 0;
+    perror("version_publish");
+    if (nommee) unlink(v->temp);
+    return -1;
+}
+
+// Transfert interrompu : la version publiée reste intacte
+void version_abort(version_t *v) {
+    if (v->fd < 0) return;
+    close(v->fd);
+    if (!v->anonyme) unlink(v->temp);
+    v->fd = -1;
+}
@@ -0,0 +1,34 @@
+#ifndef TFTP_VERSION_H
+#define TFTP_VERSION_H
+
+#include <stdbool.h>
+
+// Copie sur écriture : un WRQ écrit une nouvelle version à côté du fichier
+// et la publie par rename() une fois complète. Un RRQ garde l'inode qu'il
+// a ouvert (cache de descripteurs) jusqu'à la fin : il ne voit jamais une
+// version partielle et n'attend jamais un écrivain. L'ancienne version est
+// libérée par le noyau à la fermeture de son dernier descripteur.
+//
+// Les versions en cours d'écriture sous la racine servie vivent dans son
+// sous-répertoire VERSION_ENCOURS (même système de fichiers), de préférence
+// sans nom (O_TMPFILE) jusqu'à la publication : ni l'index, ni les RRQ, ni
+// l'archiveur ne les voient.
+
+#define VERSION_ENCOURS ".encours"
+
+typedef struct {
+    char chemin[512];   // Nom publié
+    char temp[544];     // Nouvelle version en cours d'écriture
+    int fd;             // -1 hors écriture
+    bool anonyme;       // O_TMPFILE : 'temp' est le nom qu'elle prendra avant le rename()
+} version_t;
+
+int  version_demarrer(const char *racine);
+bool version_interne(const char *nom);
+int  version_begin(version_t *v, const char *chemin);
+int  version_lier(version_t *v, const char *chemin, const char *source);
+void version_reprendre(version_t *v, int fd);
+int  version_publish(version_t *v);
+void version_abort(version_t *v);
+
+#endif
@@ -0,0 +1,394 @@
+#define _GNU_SOURCE
+#include <arpa/inet.h>
+#include <errno.h>
+#include <linux/if_ether.h>
+#include <linux/if_link.h>
+#include <linux/if_xdp.h>
+#include <net/if.h>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "tftp_bpf.h"
+#include "tftp_xdp.h"
+
+#define XDP_ANNEAU (XDP_TRAMES / 2)     // Entrées de chaque anneau
+#define XDP_FILES_MAX 64
+
+// --- Programme XDP ---
+
+// Redirige vers la socket de la file de réception (XSKMAP 'carte') les
+// datagrammes UDP/IPv4 non fragmentés pour 'port' ou [base, base + nb[ ;
+// XDP_PASS pour tout le reste, et si la file n'a pas de socket.
+static int assembler(struct bpf_insn *p, int carte, uint16_t port, uint16_t base, int nb) {
+    int n = 0, vers_pile[8], nb_pile = 0;
+
+    p[n++] = MOV_REG(6, 1);                                 // r6 = struct xdp_md *
+    p[n++] = CHARGER(BPF_W, 2, 6, 0);                       // r2 = data
+    p[n++] = CHARGER(BPF_W, 3, 6, 4);                       // r3 = data_end
+    p[n++] = MOV_REG(4, 2);
+    p[n++] = ALU_IMM(BPF_ADD, 4, XDP_ENTETES);
+    vers_pile[nb_pile++] = n;
+    p[n++] = SAUT_REG(BPF_JGT, 4, 3);                       // Trame trop courte
+    p[n++] = CHARGER(BPF_H, 4, 2, 12);
+    p[n++] = BE16(4);
+    vers_pile[nb_pile++] = n;
+    p[n++] = SAUT_IMM(BPF_JNE, 4, ETH_P_IP);
+    p[n++] = CHARGER(BPF_B, 4, 2, 14);
+    vers_pile[nb_pile++] = n;
+    p[n++] = SAUT_IMM(BPF_JNE, 4, 0x45);                    // IPv4 sans options
+    p[n++] = CHARGER(BPF_B, 4, 2, 23);
+    vers_pile[nb_pile++] = n;
+    p[n++] = SAUT_IMM(BPF_JNE, 4, IPPROTO_UDP);
+    p[n++] = CHARGER(BPF_H, 4, 2, 20);
+    p[n++] = BE16(4);
+    p[n++] = ALU_IMM(BPF_AND, 4, IP_MF | IP_OFFMASK);
+    vers_pile[nb_pile++] = n;
+    p[n++] = SAUT_IMM(BPF_JNE, 4, 0);                       // Fragment : le noyau réassemble
+    p[n++] = CHARGER(BPF_H, 4, 2, 36);                      // Port UDP de destination
+    p[n++] = BE16(4);
+    int vers_redirection = n;
+    p[n++] = SAUT_IMM(BPF_JEQ, 4, port);
+    vers_pile[nb_pile++] = n;
+    p[n++] = SAUT_IMM(BPF_JLT, 4, base);
+    vers_pile[nb_pile++] = n;
+    p[n++] = SAUT_IMM(BPF_JGE, 4, base + nb);
+
+    p[vers_redirection].off = n - vers_redirection - 1;
+    p[n++] = CHARGER(BPF_W, 2, 6, 16);                      // r2 = rx_queue_index
+    p[n++] = CARTE(1, carte);
+    p[n++] = SUITE();
+    p[n++] = MOV_IMM(3, XDP_PASS);                          // Sans socket sur la file
+    p[n++] = APPEL(BPF_FUNC_redirect_map);
+    p[n++] = SORTIE();
+
+    for (int i = 0; i < nb_pile; i++) p[vers_pile[i]].off = n - vers_pile[i] - 1;
+    p[n++] = MOV_IMM(0, XDP_PASS);
+    p[n++] = SORTIE();
+    return n;
+}
+
+static int charger_programme(int carte, uint16_t port, uint16_t base, int nb) {
+    struct bpf_insn insns[64];
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.prog_type = BPF_PROG_TYPE_XDP;
+    attr.insns = (uintptr_t)insns;
+    attr.insn_cnt = assembler(insns, carte, port, base, nb);
+    attr.license = (uintptr_t)"GPL";
+    int fd = bpf(BPF_PROG_LOAD, &attr);
+    if (fd >= 0) return fd;
+
+    // Refusé : le journal du vérificateur dit pourquoi
+    char journal[8192] = "";
+    int erreur = errno;
+    attr.log_buf = (uintptr_t)journal;
+    attr.log_size = sizeof(journal);
+    attr.log_level = 1;
+    bpf(BPF_PROG_LOAD, &attr);
+    fprintf(stderr, "xdp: programme refusé (%s)\n%s", strerror(erreur), journal);
+    errno = erreur;
+    return -1;
+}
+
+// --- Anneaux ---
+
+static int projeter(int fd, xdp_anneau_t *a, const struct xdp_ring_offset *off, size_t taille_desc, off_t page) {
+    a->zone_len = off->desc + XDP_ANNEAU * taille_desc;
+    a->zone = mmap(NULL, a->zone_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, page);
+    if (a->zone == MAP_FAILED) {
+        a->zone = NULL;
+        return -1;
+    }
+    a->producteur = (uint32_t *)((char *)a->zone + off->producer);
+    a->consommateur = (uint32_t *)((char *)a->zone + off->consumer);
+    a->flags = (uint32_t *)((char *)a->zone + off->flags);
+    a->desc = (char *)a->zone + off->desc;
+    a->masque = XDP_ANNEAU - 1;
+    return 0;
+}
+
+static int creer_anneaux(xdp_port_t *x) {
+    int taille = XDP_ANNEAU;
+    if (setsockopt(x->fd, SOL_XDP, XDP_UMEM_FILL_RING, &taille, sizeof(taille)) < 0 ||
+        setsockopt(x->fd, SOL_XDP, XDP_UMEM_COMPLETION_RING, &taille, sizeof(taille)) < 0 ||
+        setsockopt(x->fd, SOL_XDP, XDP_RX_RING, &taille, sizeof(taille)) < 0 ||
+        setsockopt(x->fd, SOL_XDP, XDP_TX_RING, &taille, sizeof(taille)) < 0)
+        return -1;
+
+    struct xdp_mmap_offsets off;
+    socklen_t len = sizeof(off);
+    if (getsockopt(x->fd, SOL_XDP, XDP_MMAP_OFFSETS, &off, &len) < 0) return -1;
+    if (projeter(x->fd, &x->rx, &off.rx, sizeof(struct xdp_desc), XDP_PGOFF_RX_RING) < 0 ||
+        projeter(x->fd, &x->tx, &off.tx, sizeof(struct xdp_desc), XDP_PGOFF_TX_RING) < 0 ||
+        projeter(x->fd, &x->remplissage, &off.fr, sizeof(uint64_t), XDP_UMEM_PGOFF_FILL_RING) < 0 ||
+        projeter(x->fd, &x->completion, &off.cr, sizeof(uint64_t), XDP_UMEM_PGOFF_COMPLETION_RING) < 0)
+        return -1;
+
+    // Première moitié de l'UMEM au noyau pour la réception, seconde
+    // moitié gardée pour l'émission
+    uint64_t *adresses = x->remplissage.desc;
+    for (int i = 0; i < XDP_ANNEAU; i++) adresses[i] = (uint64_t)i * XDP_TRAME;
+    __atomic_store_n(x->remplissage.producteur, XDP_ANNEAU, __ATOMIC_RELEASE);
+    for (int i = 0; i < XDP_TRAMES / 2; i++) x->libres[i] = (uint64_t)(XDP_ANNEAU + i) * XDP_TRAME;
+    x->nb_libres = XDP_TRAMES / 2;
+    return 0;
+}
+
+static int mtu_interface(const char *interface) {
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "%s", interface);
+    int s = socket(AF_INET, SOCK_DGRAM, 0);
+    int mtu = (s >= 0 && ioctl(s, SIOCGIFMTU, &ifr) == 0) ? ifr.ifr_mtu : ETH_DATA_LEN;
+    if (s >= 0) close(s);
+    return mtu;
+}
+
+// Ouvre la file 'file' de 'interface' pour 'port' et les 'nb_ports' ports
+// à partir de 'base'. 'generique' force le mode XDP générique (skb), qui
+// marche partout ; sinon le mode natif est essayé d'abord.
+int xdp_ouvrir(xdp_port_t *x, const char *interface, int file, uint16_t port, uint16_t base, int nb_ports,
+               bool generique) {
+    memset(x, 0, sizeof(*x));
+    x->fd = x->carte = x->programme = x->lien = -1;
+    int ifindex = if_nametoindex(interface);
+    if (!ifindex || file < 0 || file >= XDP_FILES_MAX) {
+        fprintf(stderr, "xdp: interface ou file invalide : %s:%d\n", interface, file);
+        return -1;
+    }
+    int mtu = mtu_interface(interface);
+    x->donnees_max = mtu - 28 < XDP_TRAME - XDP_ENTETES ? mtu - 28 : XDP_TRAME - XDP_ENTETES;
+
+    x->fd = socket(AF_XDP, SOCK_RAW | SOCK_CLOEXEC, 0);
+    if (x->fd < 0) {
+        perror("xdp: socket AF_XDP");
+        goto echec;
+    }
+    x->umem_len = (size_t)XDP_TRAMES * XDP_TRAME;
+    x->umem = mmap(NULL, x->umem_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (x->umem == MAP_FAILED) {
+        x->umem = NULL;
+        perror("xdp: mmap UMEM");
+        goto echec;
+    }
+    struct xdp_umem_reg reg = { .addr = (uintptr_t)x->umem, .len = x->umem_len, .chunk_size = XDP_TRAME };
+    if (setsockopt(x->fd, SOL_XDP, XDP_UMEM_REG, &reg, sizeof(reg)) < 0 || creer_anneaux(x) < 0) {
+        perror("xdp: UMEM");
+        goto echec;
+    }
+    // Sans XDP_COPY ni XDP_ZEROCOPY, le noyau prend le zéro-copie si le
+    // pilote le permet, la copie sinon
+    struct sockaddr_xdp sxdp = { .sxdp_family = AF_XDP, .sxdp_ifindex = ifindex, .sxdp_queue_id = file,
+                                 .sxdp_flags = XDP_USE_NEED_WAKEUP };
+    if (bind(x->fd, (struct sockaddr *)&sxdp, sizeof(sxdp)) < 0) {
+        perror("xdp: bind");
+        goto echec;
+    }
+
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.map_type = BPF_MAP_TYPE_XSKMAP;
+    attr.key_size = sizeof(uint32_t);
+    attr.value_size = sizeof(uint32_t);
+    attr.max_entries = XDP_FILES_MAX;
+    x->carte = bpf(BPF_MAP_CREATE, &attr);
+    if (x->carte < 0) {
+        perror("xdp: XSKMAP");
+        goto echec;
+    }
+    uint32_t cle = file, valeur = x->fd;
+    memset(&attr, 0, sizeof(attr));
+    attr.map_fd = x->carte;
+    attr.key = (uintptr_t)&cle;
+    attr.value = (uintptr_t)&valeur;
+    if (bpf(BPF_MAP_UPDATE_ELEM, &attr) < 0) {
+        perror("xdp: XSKMAP");
+        goto echec;
+    }
+
+    x->programme = charger_programme(x->carte, port, base, nb_ports);
+    if (x->programme < 0) goto echec;
+    memset(&attr, 0, sizeof(attr));
+    attr.link_create.prog_fd = x->programme;
+    attr.link_create.target_ifindex = ifindex;
+    attr.link_create.attach_type = BPF_XDP;
+    attr.link_create.flags = generique ? XDP_FLAGS_SKB_MODE : XDP_FLAGS_DRV_MODE;
+    x->lien = bpf(BPF_LINK_CREATE, &attr);
+    if (x->lien < 0 && !generique) {
+        generique = true;
+        attr.link_create.flags = XDP_FLAGS_SKB_MODE;
+        x->lien = bpf(BPF_LINK_CREATE, &attr);
+    }
+    if (x->lien < 0) {
+        perror("xdp: attache du programme");
+        goto echec;
+    }
+    printf("[XDP] %s file %d : mode %s, ports %u et %u-%u\n", interface, file, generique ? "générique" : "natif",
+           port, base, base + nb_ports - 1);
+    return 0;
+
+echec:
+    xdp_fermer(x);
+    return -1;
+}
+
+// --- Réception ---
+
+static void analyser(const char *trame, size_t len, xdp_rappel_t rappel, void *ctx) {
+    if (len < XDP_ENTETES) return;
+    const struct ethhdr *eth = (const struct ethhdr *)trame;
+    const struct iphdr *ip = (const struct iphdr *)(trame + sizeof(*eth));
+    const struct udphdr *udp = (const struct udphdr *)(trame + sizeof(*eth) + sizeof(*ip));
+    // Longueurs IP et UDP, pas celle de la trame : Ethernet complète les petites trames
+    size_t ip_len = ntohs(ip->tot_len);
+    size_t udp_len = ntohs(udp->len);
+    if (ip_len < sizeof(*ip) + sizeof(*udp) || sizeof(*eth) + ip_len > len) return;
+    if (udp_len < sizeof(*udp) || udp_len > ip_len - sizeof(*ip)) return;
+
+    xdp_chemin_t chemin;
+    memcpy(chemin.mac_local, eth->h_dest, ETH_ALEN);
+    memcpy(chemin.mac_distant, eth->h_source, ETH_ALEN);
+    chemin.ip_local = ip->daddr;
+    chemin.port_local = udp->dest;
+    memset(&chemin.distant, 0, sizeof(chemin.distant));
+    chemin.distant.sin_family = AF_INET;
+    chemin.distant.sin_addr.s_addr = ip->saddr;
+    chemin.distant.sin_port = udp->source;
+    rappel(ctx, &chemin, trame + XDP_ENTETES, udp_len - sizeof(*udp));
+}
+
+// Passe au plus XDP_LOT datagrammes reçus à 'rappel', en place dans
+// l'UMEM, puis rend leurs trames au noyau. Renvoie le nombre traité.
+int xdp_recevoir(xdp_port_t *x, xdp_rappel_t rappel, void *ctx) {
+    uint32_t cons = *x->rx.consommateur;
+    uint32_t n = __atomic_load_n(x->rx.producteur, __ATOMIC_ACQUIRE) - cons;
+    if (n > XDP_LOT) n = XDP_LOT;
+    if (n == 0) return 0;
+
+    struct xdp_desc *desc = x->rx.desc;
+    uint64_t *adresses = x->remplissage.desc;
+    uint32_t prod = *x->remplissage.producteur;
+    for (uint32_t i = 0; i < n; i++) {
+        const struct xdp_desc *d = &desc[(cons + i) & x->rx.masque];
+        analyser(x->umem + d->addr, d->len, rappel, ctx);
+        // L'adresse pointe après la marge de tête : la trame commence plus tôt
+        adresses[(prod + i) & x->remplissage.masque] = d->addr & ~(uint64_t)(XDP_TRAME - 1);
+    }
+    __atomic_store_n(x->rx.consommateur, cons + n, __ATOMIC_RELEASE);
+    __atomic_store_n(x->remplissage.producteur, prod + n, __ATOMIC_RELEASE);
+    return n;
+}
+
+// --- Émission ---
+
+static uint32_t additionner(const void *donnees, size_t len, uint32_t somme) {
+    const uint8_t *p = donnees;
+    for (; len > 1; len -= 2, p += 2) somme += (p[0] << 8) | p[1];
+    if (len) somme += p[0] << 8;
+    return somme;
+}
+
+static uint16_t replier(uint32_t somme) {
+    while (somme >> 16) somme = (somme & 0xffff) + (somme >> 16);
+    return htons(~somme & 0xffff);
+}
+
+// Trames d'émission que le noyau a fini d'envoyer
+static void recuperer(xdp_port_t *x) {
+    uint32_t cons = *x->completion.consommateur;
+    uint32_t n = __atomic_load_n(x->completion.producteur, __ATOMIC_ACQUIRE) - cons;
+    uint64_t *adresses = x->completion.desc;
+    for (uint32_t i = 0; i < n; i++) x->libres[x->nb_libres++] = adresses[(cons + i) & x->completion.masque];
+    __atomic_store_n(x->completion.consommateur, cons + n, __ATOMIC_RELEASE);
+}
+
+// Poste un datagramme vers chemin->distant depuis chemin->port_local. Il
+// part au prochain xdp_emettre (ou tout de suite par lots de XDP_LOT).
+// -1 : trop gros pour le MTU (EMSGSIZE) ou plus de trame libre (ENOBUFS).
+int xdp_envoyer(xdp_port_t *x, const xdp_chemin_t *chemin, const void *donnees, size_t len) {
+    if (len > (size_t)x->donnees_max) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+    if (x->nb_libres == 0) recuperer(x);
+    if (x->nb_libres == 0) {
+        xdp_emettre(x);
+        recuperer(x);
+    }
+    if (x->nb_libres == 0) {
+        errno = ENOBUFS;
+        return -1;
+    }
+
+    uint64_t adresse = x->libres[--x->nb_libres];
+    char *trame = x->umem + adresse;
+    struct ethhdr *eth = (struct ethhdr *)trame;
+    struct iphdr *ip = (struct iphdr *)(trame + sizeof(*eth));
+    struct udphdr *udp = (struct udphdr *)(trame + sizeof(*eth) + sizeof(*ip));
+
+    memcpy(eth->h_dest, chemin->mac_distant, ETH_ALEN);
+    memcpy(eth->h_source, chemin->mac_local, ETH_ALEN);
+    eth->h_proto = htons(ETH_P_IP);
+
+    memset(ip, 0, sizeof(*ip));
+    ip->version = 4;
+    ip->ihl = 5;
+    ip->tot_len = htons(sizeof(*ip) + sizeof(*udp) + len);
+    ip->id = htons(x->ip_id++);
+    ip->frag_off = htons(IP_DF);
+    ip->ttl = 64;
+    ip->protocol = IPPROTO_UDP;
+    ip->saddr = chemin->ip_local;
+    ip->daddr = chemin->distant.sin_addr.s_addr;
+    ip->check = replier(additionner(ip, sizeof(*ip), 0));
+
+    udp->source = chemin->port_local;
+    udp->dest = chemin->distant.sin_port;
+    udp->len = htons(sizeof(*udp) + len);
+    udp->check = 0;
+    memcpy(trame + XDP_ENTETES, donnees, len);
+    // Somme UDP sur le pseudo-en-tête IP ; 0 voudrait dire "pas de somme"
+    uint32_t somme = additionner(&ip->saddr, 8, IPPROTO_UDP + sizeof(*udp) + len);
+    udp->check = replier(additionner(udp, sizeof(*udp) + len, somme));
+    if (udp->check == 0) udp->check = 0xffff;
+
+    uint32_t prod = *x->tx.producteur;
+    struct xdp_desc *d = &((struct xdp_desc *)x->tx.desc)[prod & x->tx.masque];
+    d->addr = adresse;
+    d->len = XDP_ENTETES + len;
+    d->options = 0;
+    __atomic_store_n(x->tx.producteur, prod + 1, __ATOMIC_RELEASE);
+    if (++x->en_attente >= XDP_LOT) xdp_emettre(x);
+    return len;
+}
+
+// Réveille le noyau pour les trames postées. En mode copie il en envoie au
+// plus 32 par appel et répond EAGAIN s'il en reste.
+void xdp_emettre(xdp_port_t *x) {
+    if (!x->en_attente) return;
+    uint32_t attente = x->en_attente;
+    x->en_attente = 0;
+    if (!(__atomic_load_n(x->tx.flags, __ATOMIC_ACQUIRE) & XDP_RING_NEED_WAKEUP)) return;
+    for (uint32_t i = 0; i <= attente / 32; i++)
+        if (sendto(x->fd, NULL, 0, MSG_DONTWAIT, NULL, 0) >= 0 || (errno != EAGAIN && errno != EBUSY)) break;
+}
+
+void xdp_fermer(xdp_port_t *x) {
+    // Fermer le lien détache le programme de l'interface
+    if (x->lien >= 0) close(x->lien);
+    if (x->programme >= 0) close(x->programme);
+    if (x->carte >= 0) close(x->carte);
+    xdp_anneau_t *anneaux[] = { &x->rx, &x->tx, &x->remplissage, &x->completion };
+    for (int i = 0; i < 4; i++)
+        if (anneaux[i]->zone) munmap(anneaux[i]->zone, anneaux[i]->zone_len);
+    if (x->fd >= 0) close(x->fd);
+    if (x->umem) munmap(x->umem, x->umem_len);
+    memset(x, 0, sizeof(*x));
+    x->fd = x->carte = x->programme = x->lien = -1;
+}
@@ -0,0 +1,75 @@
+#ifndef TFTP_XDP_H
+#define TFTP_XDP_H
+
+#include <netinet/in.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Chemin de paquets AF_XDP, sans la pile UDP du noyau. Un programme XDP
+// (eBPF assemblé ici, chargé par l'appel système bpf, sans libbpf)
+// redirige vers une socket AF_XDP les datagrammes UDP/IPv4 destinés au
+// port d'écoute ou à la plage des ports de session ; le reste (ARP, ICMP,
+// fragments IP, autres ports, autres files de la carte) suit la pile
+// normale. Les trames arrivent dans une zone mémoire partagée (UMEM) par
+// des anneaux producteur/consommateur ; l'appelant lit la charge utile en
+// place et construit lui-même Ethernet/IPv4/UDP pour répondre.
+//
+// Le programme est attaché en mode natif si le pilote le gère, sinon en
+// mode générique (veth, cartes sans support XDP). Il est détaché à la
+// fermeture de la socket ou à la mort du processus.
+//
+// Limites : IPv4 sans options, pas de VLAN, une seule file de réception
+// (les autres passent par le noyau), pas de fragmentation : un paquet
+// émis doit tenir dans une trame et dans le MTU de l'interface.
+
+#define XDP_TRAME 4096          // Taille d'une trame de l'UMEM
+#define XDP_TRAMES 4096         // Moitié pour la réception, moitié pour l'émission
+#define XDP_LOT 64              // Trames traitées par appel à xdp_recevoir
+#define XDP_ENTETES 42          // Ethernet (14) + IPv4 sans options (20) + UDP (8)
+
+// Adresses d'un échange, apprises de la trame reçue : la réponse repart
+// par le même chemin, sans table ARP ni routage
+typedef struct {
+    uint8_t mac_local[6];
+    uint8_t mac_distant[6];
+    uint32_t ip_local;          // Ordre réseau
+    uint16_t port_local;        // Ordre réseau
+    struct sockaddr_in distant;
+} xdp_chemin_t;
+
+typedef struct {
+    uint32_t *producteur;       // Partagés avec le noyau
+    uint32_t *consommateur;
+    uint32_t *flags;
+    void *desc;
+    uint32_t masque;
+    void *zone;
+    size_t zone_len;
+} xdp_anneau_t;
+
+typedef struct {
+    int fd;                     // Socket AF_XDP
+    int carte;                  // XSKMAP : file de réception -> socket
+    int programme;
+    int lien;                   // Attache du programme à l'interface
+    char *umem;
+    size_t umem_len;
+    xdp_anneau_t rx, tx, remplissage, completion;
+    uint64_t libres[XDP_TRAMES / 2];    // Trames d'émission disponibles
+    int nb_libres;
+    uint32_t en_attente;        // Trames postées depuis le dernier réveil du noyau
+    int donnees_max;            // Charge UDP maximale d'un envoi (MTU de l'interface)
+    uint16_t ip_id;
+} xdp_port_t;
+
+typedef void (*xdp_rappel_t)(void *ctx, const xdp_chemin_t *chemin, const char *donnees, size_t len);
+
+int  xdp_ouvrir(xdp_port_t *x, const char *interface, int file, uint16_t port, uint16_t base, int nb_ports,
+                bool generique);
+int  xdp_recevoir(xdp_port_t *x, xdp_rappel_t rappel, void *ctx);
+int  xdp_envoyer(xdp_port_t *x, const xdp_chemin_t *chemin, const void *donnees, size_t len);
+void xdp_emettre(xdp_port_t *x);
+void xdp_fermer(xdp_port_t *x);
+
+#endif